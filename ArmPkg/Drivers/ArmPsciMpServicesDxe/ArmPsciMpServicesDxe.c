@@ -0,0 +1,1069 @@
+/** @file
+*  MP Services Protocol for AArch64 using PSCI.
+*
+*  The secondary cores are started with PSCI CPU_ON into a loop that runs the
+*  procedures handed to them through the MP Services Protocol, and are turned
+*  off again with PSCI CPU_OFF before the OS takes over, so that the OS can
+*  start them itself.
+*
+*  Procedures run on the APs with the translation regime of the boot processor
+*  and with interrupts masked. As required by the PI specification, they must
+*  not call any UEFI service.
+*
+*  Copyright (c) 2018, The EDK II Contributors. All rights reserved.
+*
+*  This program and the accompanying materials
+*  are licensed and made available under the terms and conditions of the BSD
+*  License which accompanies this distribution.  The full text of the license
+*  may be found at http://opensource.org/licenses/bsd-license.php
+*
+*  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+*
+**/
+
+#include <PiDxe.h>
+
+#include <Chipset/AArch64.h>
+#include <Guid/ArmMpCoreInfo.h>
+#include <IndustryStandard/ArmStdSmc.h>
+#include <Library/ArmHvcLib.h>
+#include <Library/ArmLib.h>
+#include <Library/ArmSmcLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/CacheMaintenanceLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include <Protocol/LoadedImage.h>
+#include <Protocol/MpService.h>
+
+#include "ArmPsciMpServicesInternal.h"
+
+STATIC CPU_AP_DATA          *mCpuData;
+STATIC UINTN                mNumberOfProcessors;
+STATIC UINTN                mBspIndex;
+STATIC EFI_EVENT            mCheckApsEvent;
+STATIC BOOLEAN              mCheckApsTimerRunning;
+
+//
+// Copy of PcdArmMpServicesPsciUseHvc, which the APs cannot read themselves.
+//
+STATIC BOOLEAN              mPsciUseHvc;
+
+//
+// State of a non-blocking StartupAllAPs () call.
+//
+STATIC EFI_EVENT            mAllApsWaitEvent;
+STATIC EFI_AP_PROCEDURE     mAllApsProcedure;
+STATIC VOID                 *mAllApsArgument;
+STATIC BOOLEAN              mAllApsSingleThread;
+STATIC UINTN                mAllApsNext;
+STATIC UINT64               mAllApsTimeoutTicks;
+
+/**
+  Issue a PSCI call through the conduit selected by PcdArmMpServicesPsciUseHvc.
+  It is also called on the APs.
+
+  @param  Function      The PSCI function ID.
+  @param  Arg1          The first argument.
+  @param  Arg2          The second argument.
+  @param  Arg3          The third argument.
+
+  @return The value returned in x0.
+
+**/
+STATIC
+INTN
+PsciCall (
+  IN UINTN              Function,
+  IN UINTN              Arg1,
+  IN UINTN              Arg2,
+  IN UINTN              Arg3
+  )
+{
+  ARM_SMC_ARGS          SmcArgs;
+  ARM_HVC_ARGS          HvcArgs;
+
+  if (mPsciUseHvc) {
+    ZeroMem (&HvcArgs, sizeof (HvcArgs));
+    HvcArgs.Arg0 = Function;
+    HvcArgs.Arg1 = Arg1;
+    HvcArgs.Arg2 = Arg2;
+    HvcArgs.Arg3 = Arg3;
+    ArmCallHvc (&HvcArgs);
+    return (INTN) HvcArgs.Arg0;
+  }
+
+  ZeroMem (&SmcArgs, sizeof (SmcArgs));
+  SmcArgs.Arg0 = Function;
+  SmcArgs.Arg1 = Arg1;
+  SmcArgs.Arg2 = Arg2;
+  SmcArgs.Arg3 = Arg3;
+  ArmCallSmc (&SmcArgs);
+  return (INTN) SmcArgs.Arg0;
+}
+
+/**
+  Convert a timeout in microseconds to a performance counter deadline.
+
+  @param  TimeoutInMicroseconds   The timeout, 0 meaning infinite.
+
+  @return The deadline, or 0 if there is none.
+
+**/
+STATIC
+UINT64
+TimeoutToDeadline (
+  IN UINTN              TimeoutInMicroseconds
+  )
+{
+  if (TimeoutInMicroseconds == 0) {
+    return 0;
+  }
+  return GetPerformanceCounter () +
+         DivU64x32 (MultU64x64 (GetPerformanceCounterProperties (NULL, NULL), TimeoutInMicroseconds), 1000000);
+}
+
+/**
+  Check whether a deadline returned by TimeoutToDeadline () has passed.
+
+  @param  Deadline      The deadline, 0 meaning infinite.
+
+  @retval TRUE          The deadline has passed.
+  @retval FALSE         The deadline has not passed.
+
+**/
+STATIC
+BOOLEAN
+DeadlinePassed (
+  IN UINT64             Deadline
+  )
+{
+  return (BOOLEAN) (Deadline != 0 && GetPerformanceCounter () > Deadline);
+}
+
+/**
+  C entry point of an AP. Wait for procedures from the BSP and run them.
+
+  @param  CpuData       The CPU_AP_DATA of the AP.
+
+**/
+VOID
+EFIAPI
+ArmPsciMpApMain (
+  IN CPU_AP_DATA        *CpuData
+  )
+{
+  EFI_AP_PROCEDURE      Procedure;
+
+  CpuData->State = CpuStateIdle;
+  ArmDataSynchronizationBarrier ();
+  ArmCallSEV ();
+
+  for (;;) {
+    while (CpuData->State != CpuStateBusy) {
+      ArmCallWFE ();
+    }
+    MemoryFence ();
+
+    Procedure = CpuData->Procedure;
+    Procedure (CpuData->Argument);
+
+    MemoryFence ();
+    CpuData->State = CpuStateFinished;
+    ArmDataSynchronizationBarrier ();
+    ArmCallSEV ();
+  }
+}
+
+/**
+  Procedure run on each AP at ExitBootServices () to hand it back to the
+  firmware with PSCI CPU_OFF. It does not return.
+
+  @param  Buffer        Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+ApPowerOff (
+  IN VOID               *Buffer
+  )
+{
+  PsciCall (ARM_SMC_ID_PSCI_CPU_OFF, 0, 0, 0);
+
+  //
+  // CPU_OFF only returns on failure.
+  //
+  for (;;) {
+    ArmCallWFI ();
+  }
+}
+
+/**
+  Hand a procedure to an idle AP.
+
+  @param  CpuData       The CPU_AP_DATA of the AP.
+  @param  Procedure     The procedure to run.
+  @param  Argument      The argument of the procedure.
+
+**/
+STATIC
+VOID
+DispatchToAp (
+  IN CPU_AP_DATA        *CpuData,
+  IN EFI_AP_PROCEDURE   Procedure,
+  IN VOID               *Argument
+  )
+{
+  ASSERT (CpuData->State == CpuStateIdle);
+
+  CpuData->Procedure = Procedure;
+  CpuData->Argument  = Argument;
+  MemoryFence ();
+  CpuData->State     = CpuStateBusy;
+  ArmDataSynchronizationBarrier ();
+  ArmCallSEV ();
+}
+
+/**
+  Check whether an AP is enabled and idle.
+
+  @param  Index         The processor number.
+
+  @retval TRUE          The AP can take a procedure.
+  @retval FALSE         The AP cannot take a procedure.
+
+**/
+STATIC
+BOOLEAN
+IsApReady (
+  IN UINTN              Index
+  )
+{
+  return (BOOLEAN) (Index != mBspIndex &&
+                    mCpuData[Index].Enabled &&
+                    mCpuData[Index].State == CpuStateIdle);
+}
+
+/**
+  Start the periodic timer that reaps non-blocking work, if not yet running.
+
+**/
+STATIC
+VOID
+StartCheckApsTimer (
+  VOID
+  )
+{
+  if (!mCheckApsTimerRunning) {
+    gBS->SetTimer (mCheckApsEvent, TimerPeriodic, AP_CHECK_INTERVAL);
+    mCheckApsTimerRunning = TRUE;
+  }
+}
+
+/**
+  Timer notification function that completes non-blocking StartupThisAP ()
+  and StartupAllAPs () calls.
+
+  @param  Event         The timer event.
+  @param  Context       Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+CheckApsStatus (
+  IN EFI_EVENT          Event,
+  IN VOID               *Context
+  )
+{
+  UINTN                 Index;
+  CPU_AP_DATA           *CpuData;
+  BOOLEAN               Pending;
+  BOOLEAN               AllDone;
+
+  Pending = FALSE;
+
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    CpuData = &mCpuData[Index];
+    if (CpuData->TimedOut) {
+      if (CpuData->State == CpuStateFinished) {
+        CpuData->State    = CpuStateIdle;
+        CpuData->TimedOut = FALSE;
+      } else {
+        Pending = TRUE;
+      }
+      continue;
+    }
+    if (CpuData->WaitEvent == NULL) {
+      continue;
+    }
+    if (CpuData->State == CpuStateFinished) {
+      CpuData->State = CpuStateIdle;
+      if (CpuData->Finished != NULL) {
+        *CpuData->Finished = TRUE;
+      }
+      gBS->SignalEvent (CpuData->WaitEvent);
+      CpuData->WaitEvent = NULL;
+    } else if (DeadlinePassed (CpuData->TimeoutTicks)) {
+      //
+      // The AP cannot be stopped. Keep tracking it so that it is reaped, and
+      // can take new work, once it returns.
+      //
+      if (CpuData->Finished != NULL) {
+        *CpuData->Finished = FALSE;
+      }
+      gBS->SignalEvent (CpuData->WaitEvent);
+      CpuData->WaitEvent = NULL;
+      CpuData->TimedOut  = TRUE;
+      Pending            = TRUE;
+    } else {
+      Pending = TRUE;
+    }
+  }
+
+  //
+  // Reap the APs of the last StartupAllAPs () call, including those still
+  // running after its timeout expired. Other APs are left alone: a blocking
+  // StartupThisAP () reaps its own AP, or marks it TimedOut for the loop above.
+  //
+  AllDone = TRUE;
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    CpuData = &mCpuData[Index];
+    if (!CpuData->AllApsMember) {
+      continue;
+    }
+    if (CpuData->State == CpuStateFinished) {
+      CpuData->State        = CpuStateIdle;
+      CpuData->AllApsMember = FALSE;
+    } else {
+      AllDone = FALSE;
+    }
+  }
+
+  if (mAllApsWaitEvent != NULL) {
+    if (AllDone && mAllApsSingleThread) {
+      while (mAllApsNext < mNumberOfProcessors && !IsApReady (mAllApsNext)) {
+        mAllApsNext++;
+      }
+      if (mAllApsNext < mNumberOfProcessors) {
+        mCpuData[mAllApsNext].AllApsMember = TRUE;
+        DispatchToAp (&mCpuData[mAllApsNext], mAllApsProcedure, mAllApsArgument);
+        mAllApsNext++;
+        AllDone = FALSE;
+      }
+    }
+
+    if (AllDone || DeadlinePassed (mAllApsTimeoutTicks)) {
+      gBS->SignalEvent (mAllApsWaitEvent);
+      mAllApsWaitEvent = NULL;
+    }
+  }
+
+  if (!AllDone) {
+    Pending = TRUE;
+  }
+
+  if (!Pending) {
+    gBS->SetTimer (mCheckApsEvent, TimerCancel, 0);
+    mCheckApsTimerRunning = FALSE;
+  }
+}
+
+/**
+  This service retrieves the number of logical processor in the platform
+  and the number of those logical processors that are enabled on this boot.
+
+  @param[in]  This                        A pointer to the EFI_MP_SERVICES_PROTOCOL instance.
+  @param[out] NumberOfProcessors          Pointer to the total number of logical processors.
+  @param[out] NumberOfEnabledProcessors   Pointer to the number of enabled logical processors.
+
+  @retval EFI_SUCCESS             The number of logical processors and enabled
+                                  logical processors was retrieved.
+  @retval EFI_DEVICE_ERROR        The calling processor is an AP.
+  @retval EFI_INVALID_PARAMETER   NumberOfProcessors is NULL.
+  @retval EFI_INVALID_PARAMETER   NumberOfEnabledProcessors is NULL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+GetNumberOfProcessors (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  OUT UINTN                     *NumberOfProcessors,
+  OUT UINTN                     *NumberOfEnabledProcessors
+  )
+{
+  UINTN                         Index;
+
+  if (NumberOfProcessors == NULL || NumberOfEnabledProcessors == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *NumberOfProcessors        = mNumberOfProcessors;
+  *NumberOfEnabledProcessors = 0;
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    if (mCpuData[Index].Enabled) {
+      (*NumberOfEnabledProcessors)++;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Gets detailed MP-related information on the requested processor at the
+  instant this call is made.
+
+  @param[in]  This                  A pointer to the EFI_MP_SERVICES_PROTOCOL instance.
+  @param[in]  ProcessorNumber       The handle number of processor.
+  @param[out] ProcessorInfoBuffer   A pointer to the buffer where information for
+                                    the requested processor is deposited.
+
+  @retval EFI_SUCCESS             Processor information was returned.
+  @retval EFI_INVALID_PARAMETER   ProcessorInfoBuffer is NULL.
+  @retval EFI_NOT_FOUND           The processor with the handle specified by
+                                  ProcessorNumber does not exist in the platform.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+GetProcessorInfo (
+  IN  EFI_MP_SERVICES_PROTOCOL   *This,
+  IN  UINTN                      ProcessorNumber,
+  OUT EFI_PROCESSOR_INFORMATION  *ProcessorInfoBuffer
+  )
+{
+  CPU_AP_DATA                    *CpuData;
+
+  if (ProcessorInfoBuffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (ProcessorNumber >= mNumberOfProcessors) {
+    return EFI_NOT_FOUND;
+  }
+
+  CpuData = &mCpuData[ProcessorNumber];
+  ProcessorInfoBuffer->ProcessorId = CpuData->Mpidr;
+  ProcessorInfoBuffer->StatusFlag  = PROCESSOR_HEALTH_STATUS_BIT;
+  if (ProcessorNumber == mBspIndex) {
+    ProcessorInfoBuffer->StatusFlag |= PROCESSOR_AS_BSP_BIT;
+  }
+  if (CpuData->Enabled) {
+    ProcessorInfoBuffer->StatusFlag |= PROCESSOR_ENABLED_BIT;
+  }
+  ProcessorInfoBuffer->Location.Package = (UINT32) ((CpuData->Mpidr >> 16) & 0xFF);
+  ProcessorInfoBuffer->Location.Core    = (UINT32) (CpuData->Mpidr & 0xFFFF);
+  ProcessorInfoBuffer->Location.Thread  = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  This service executes a caller provided function on all enabled APs.
+
+  @param[in]  This                    A pointer to the EFI_MP_SERVICES_PROTOCOL instance.
+  @param[in]  Procedure               A pointer to the function to be run on enabled APs.
+  @param[in]  SingleThread            If TRUE, then all the enabled APs execute the
+                                      function one by one, in ascending order of
+                                      processor handle number.
+  @param[in]  WaitEvent               The event created by the caller with CreateEvent(),
+                                      or NULL to execute in blocking mode.
+  @param[in]  TimeoutInMicroseconds   Indicates the time limit in microseconds for
+                                      APs to return from Procedure, 0 meaning infinity.
+  @param[in]  ProcedureArgument       The parameter passed into Procedure for all APs.
+  @param[out] FailedCpuList           Not supported, always set to NULL.
+
+  @retval EFI_SUCCESS             All APs finished, or the non-blocking call started.
+  @retval EFI_DEVICE_ERROR        Caller processor is AP.
+  @retval EFI_NOT_STARTED         No enabled APs exist in the system.
+  @retval EFI_NOT_READY           Any enabled APs are busy.
+  @retval EFI_TIMEOUT             In blocking mode, the timeout expired before
+                                  all enabled APs have finished.
+  @retval EFI_INVALID_PARAMETER   Procedure is NULL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+StartupAllAPs (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  EFI_AP_PROCEDURE          Procedure,
+  IN  BOOLEAN                   SingleThread,
+  IN  EFI_EVENT                 WaitEvent               OPTIONAL,
+  IN  UINTN                     TimeoutInMicroseconds,
+  IN  VOID                      *ProcedureArgument      OPTIONAL,
+  OUT UINTN                     **FailedCpuList         OPTIONAL
+  )
+{
+  UINTN                         Index;
+  UINTN                         ApCount;
+  UINT64                        Deadline;
+  BOOLEAN                       Busy;
+
+  if (FailedCpuList != NULL) {
+    *FailedCpuList = NULL;
+  }
+  if (Procedure == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (mAllApsWaitEvent != NULL) {
+    return EFI_NOT_READY;
+  }
+
+  ApCount = 0;
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    if (Index == mBspIndex || !mCpuData[Index].Enabled) {
+      continue;
+    }
+    if (mCpuData[Index].State != CpuStateIdle) {
+      return EFI_NOT_READY;
+    }
+    ApCount++;
+  }
+  if (ApCount == 0) {
+    return EFI_NOT_STARTED;
+  }
+
+  Deadline = TimeoutToDeadline (TimeoutInMicroseconds);
+
+  if (WaitEvent != NULL) {
+    mAllApsWaitEvent    = WaitEvent;
+    mAllApsProcedure    = Procedure;
+    mAllApsArgument     = ProcedureArgument;
+    mAllApsSingleThread = SingleThread;
+    mAllApsNext         = 0;
+    mAllApsTimeoutTicks = Deadline;
+    if (!SingleThread) {
+      for (Index = 0; Index < mNumberOfProcessors; Index++) {
+        if (IsApReady (Index)) {
+          mCpuData[Index].AllApsMember = TRUE;
+          DispatchToAp (&mCpuData[Index], Procedure, ProcedureArgument);
+        }
+      }
+    }
+    StartCheckApsTimer ();
+    return EFI_SUCCESS;
+  }
+
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    if (!IsApReady (Index)) {
+      continue;
+    }
+    mCpuData[Index].AllApsMember = TRUE;
+    DispatchToAp (&mCpuData[Index], Procedure, ProcedureArgument);
+    if (SingleThread) {
+      while (mCpuData[Index].State != CpuStateFinished) {
+        if (DeadlinePassed (Deadline)) {
+          //
+          // Let the timer reap the AP when it returns.
+          //
+          StartCheckApsTimer ();
+          return EFI_TIMEOUT;
+        }
+        CpuPause ();
+      }
+      mCpuData[Index].State        = CpuStateIdle;
+      mCpuData[Index].AllApsMember = FALSE;
+    }
+  }
+
+  do {
+    Busy = FALSE;
+    for (Index = 0; Index < mNumberOfProcessors; Index++) {
+      if (!mCpuData[Index].AllApsMember) {
+        continue;
+      }
+      if (mCpuData[Index].State == CpuStateFinished) {
+        mCpuData[Index].State        = CpuStateIdle;
+        mCpuData[Index].AllApsMember = FALSE;
+      } else {
+        Busy = TRUE;
+      }
+    }
+    if (Busy && DeadlinePassed (Deadline)) {
+      StartCheckApsTimer ();
+      return EFI_TIMEOUT;
+    }
+  } while (Busy);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  This service lets the caller get one enabled AP to execute a caller-provided
+  function.
+
+  @param[in]  This                    A pointer to the EFI_MP_SERVICES_PROTOCOL instance.
+  @param[in]  Procedure               A pointer to the function to be run on the AP.
+  @param[in]  ProcessorNumber         The handle number of the AP.
+  @param[in]  WaitEvent               The event created by the caller with CreateEvent(),
+                                      or NULL to execute in blocking mode.
+  @param[in]  TimeoutInMicroseconds   Indicates the time limit in microseconds for
+                                      the AP to return from Procedure, 0 meaning infinity.
+  @param[in]  ProcedureArgument       The parameter passed into Procedure on the AP.
+  @param[out] Finished                If not NULL, set to TRUE if the AP has finished
+                                      before the timeout expired, FALSE otherwise.
+
+  @retval EFI_SUCCESS             The AP finished, or the non-blocking call started.
+  @retval EFI_DEVICE_ERROR        The calling processor is an AP.
+  @retval EFI_TIMEOUT             In blocking mode, the timeout expired before the
+                                  AP has finished.
+  @retval EFI_NOT_READY           The AP is busy.
+  @retval EFI_NOT_FOUND           The processor does not exist.
+  @retval EFI_INVALID_PARAMETER   ProcessorNumber specifies the BSP or a disabled AP.
+  @retval EFI_INVALID_PARAMETER   Procedure is NULL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+StartupThisAP (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  EFI_AP_PROCEDURE          Procedure,
+  IN  UINTN                     ProcessorNumber,
+  IN  EFI_EVENT                 WaitEvent               OPTIONAL,
+  IN  UINTN                     TimeoutInMicroseconds,
+  IN  VOID                      *ProcedureArgument      OPTIONAL,
+  OUT BOOLEAN                   *Finished               OPTIONAL
+  )
+{
+  CPU_AP_DATA                   *CpuData;
+  UINT64                        Deadline;
+
+  if (Procedure == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (ProcessorNumber >= mNumberOfProcessors) {
+    return EFI_NOT_FOUND;
+  }
+
+  CpuData = &mCpuData[ProcessorNumber];
+  if (ProcessorNumber == mBspIndex || !CpuData->Enabled) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (CpuData->State != CpuStateIdle || CpuData->WaitEvent != NULL) {
+    return EFI_NOT_READY;
+  }
+
+  if (Finished != NULL) {
+    *Finished = FALSE;
+  }
+
+  Deadline = TimeoutToDeadline (TimeoutInMicroseconds);
+  DispatchToAp (CpuData, Procedure, ProcedureArgument);
+
+  if (WaitEvent != NULL) {
+    CpuData->WaitEvent    = WaitEvent;
+    CpuData->Finished     = Finished;
+    CpuData->TimeoutTicks = Deadline;
+    StartCheckApsTimer ();
+    return EFI_SUCCESS;
+  }
+
+  while (CpuData->State != CpuStateFinished) {
+    if (DeadlinePassed (Deadline)) {
+      //
+      // Let the timer reap the AP when it returns.
+      //
+      CpuData->TimedOut = TRUE;
+      StartCheckApsTimer ();
+      return EFI_TIMEOUT;
+    }
+    CpuPause ();
+  }
+  CpuData->State = CpuStateIdle;
+  if (Finished != NULL) {
+    *Finished = TRUE;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Switching the BSP is not supported.
+
+  @param[in] This              A pointer to the EFI_MP_SERVICES_PROTOCOL instance.
+  @param[in] ProcessorNumber   The handle number of AP that is to become the new BSP.
+  @param[in] EnableOldBSP      Whether the old BSP should be enabled as an AP.
+
+  @retval EFI_UNSUPPORTED      Switching the BSP is not supported.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SwitchBSP (
+  IN EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  UINTN                    ProcessorNumber,
+  IN  BOOLEAN                  EnableOldBSP
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  This service lets the caller enable or disable an AP from this point onward.
+
+  @param[in] This              A pointer to the EFI_MP_SERVICES_PROTOCOL instance.
+  @param[in] ProcessorNumber   The handle number of AP.
+  @param[in] EnableAP          Specifies the new state for the processor.
+  @param[in] HealthFlag        Ignored.
+
+  @retval EFI_SUCCESS             The specified AP was enabled or disabled.
+  @retval EFI_UNSUPPORTED         The AP was not started by this driver.
+  @retval EFI_NOT_FOUND           The processor does not exist.
+  @retval EFI_INVALID_PARAMETER   ProcessorNumber specifies the BSP.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+EnableDisableAP (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  UINTN                     ProcessorNumber,
+  IN  BOOLEAN                   EnableAP,
+  IN  UINT32                    *HealthFlag OPTIONAL
+  )
+{
+  if (ProcessorNumber >= mNumberOfProcessors) {
+    return EFI_NOT_FOUND;
+  }
+  if (ProcessorNumber == mBspIndex) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (mCpuData[ProcessorNumber].State == CpuStateOff) {
+    return EFI_UNSUPPORTED;
+  }
+
+  mCpuData[ProcessorNumber].Enabled = EnableAP;
+  return EFI_SUCCESS;
+}
+
+/**
+  This return the handle number for the calling processor.
+
+  @param[in]  This              A pointer to the EFI_MP_SERVICES_PROTOCOL instance.
+  @param[out] ProcessorNumber   Pointer to the handle number of the calling processor.
+
+  @retval EFI_SUCCESS             The current processor handle number was returned.
+  @retval EFI_INVALID_PARAMETER   ProcessorNumber is NULL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+WhoAmI (
+  IN EFI_MP_SERVICES_PROTOCOL  *This,
+  OUT UINTN                    *ProcessorNumber
+  )
+{
+  UINT64                       Mpidr;
+  UINTN                        Index;
+
+  if (ProcessorNumber == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Mpidr = ArmReadMpidr () & MPIDR_AFFINITY_MASK;
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    if (mCpuData[Index].Mpidr == Mpidr) {
+      *ProcessorNumber = Index;
+      return EFI_SUCCESS;
+    }
+  }
+
+  *ProcessorNumber = mBspIndex;
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_MP_SERVICES_PROTOCOL mMpServicesProtocol = {
+  GetNumberOfProcessors,
+  GetProcessorInfo,
+  StartupAllAPs,
+  StartupThisAP,
+  SwitchBSP,
+  EnableDisableAP,
+  WhoAmI
+};
+
+/**
+  Turn the APs off with PSCI CPU_OFF so that the OS can start them.
+
+  @param  Event         The ExitBootServices event.
+  @param  Context       Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+ExitBootServicesCallback (
+  IN EFI_EVENT          Event,
+  IN VOID               *Context
+  )
+{
+  UINTN                 Index;
+  UINTN                 Retry;
+  INTN                  Result;
+
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    if (Index == mBspIndex || mCpuData[Index].State == CpuStateOff) {
+      continue;
+    }
+
+    //
+    // Give a busy AP some time to return, it cannot be interrupted.
+    //
+    for (Retry = 0; Retry < 1000 && mCpuData[Index].State == CpuStateBusy; Retry++) {
+      MicroSecondDelay (1000);
+    }
+    if (mCpuData[Index].State == CpuStateBusy) {
+      DEBUG ((DEBUG_ERROR, "%a: CPU 0x%lx still busy, not turned off\n", __FUNCTION__, mCpuData[Index].Mpidr));
+      continue;
+    }
+
+    mCpuData[Index].State = CpuStateIdle;
+    DispatchToAp (&mCpuData[Index], ApPowerOff, NULL);
+
+    for (Retry = 0; Retry < 1000; Retry++) {
+      Result = PsciCall (ARM_SMC_ID_PSCI_AFFINITY_INFO_AARCH64, (UINTN) mCpuData[Index].Mpidr, 0, 0);
+      if (Result == ARM_SMC_ID_PSCI_AFFINITY_INFO_OFF) {
+        mCpuData[Index].State = CpuStateOff;
+        break;
+      }
+      MicroSecondDelay (100);
+    }
+  }
+}
+
+/**
+  Build the list of processors, from PcdArmMpServicesMpidrs if the platform
+  has set it, from the ARM MP core info HOB if there is one, or else by probing
+  affinity values with PSCI AFFINITY_INFO.
+
+  @retval EFI_SUCCESS           mCpuData and mNumberOfProcessors are set.
+  @retval EFI_OUT_OF_RESOURCES  The processor list could not be allocated.
+
+**/
+STATIC
+EFI_STATUS
+DiscoverProcessors (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE     *Hob;
+  ARM_CORE_INFO         *CoreInfo;
+  CONST UINT64          *PcdMpidr;
+  UINT64                Mpidr[MAX_PROBED_CLUSTERS * MAX_PROBED_CORES_PER_CLUSTER];
+  UINTN                 Count;
+  UINTN                 Cluster;
+  UINTN                 Core;
+  UINTN                 ClusterCores;
+  UINTN                 Index;
+
+  Count = 0;
+  PcdMpidr = PcdGetPtr (PcdArmMpServicesMpidrs);
+  for (Index = 0; Index < PcdGetSize (PcdArmMpServicesMpidrs) / sizeof (UINT64) &&
+                  Count < ARRAY_SIZE (Mpidr); Index++) {
+    Mpidr[Count++] = ReadUnaligned64 (&PcdMpidr[Index]) & MPIDR_AFFINITY_MASK;
+  }
+
+  //
+  // The list set by the platform, typically from the device tree, describes
+  // the actual machine better than a static HOB or the probe.
+  //
+  Hob = NULL;
+  if (Count == 0) {
+    Hob = GetFirstGuidHob (&gArmMpCoreInfoGuid);
+  }
+  if (Hob != NULL) {
+    CoreInfo = GET_GUID_HOB_DATA (Hob);
+    for (Index = 0; Index < GET_GUID_HOB_DATA_SIZE (Hob) / sizeof (ARM_CORE_INFO) &&
+                    Count < ARRAY_SIZE (Mpidr); Index++) {
+      Mpidr[Count++] = GET_MPID (CoreInfo[Index].ClusterId, CoreInfo[Index].CoreId);
+    }
+  } else if (Count == 0) {
+    for (Cluster = 0; Cluster < MAX_PROBED_CLUSTERS; Cluster++) {
+      ClusterCores = 0;
+      for (Core = 0; Core < MAX_PROBED_CORES_PER_CLUSTER; Core++) {
+        if (PsciCall (ARM_SMC_ID_PSCI_AFFINITY_INFO_AARCH64, GET_MPID (Cluster, Core), 0, 0) < 0) {
+          break;
+        }
+        Mpidr[Count++] = GET_MPID (Cluster, Core);
+        ClusterCores++;
+      }
+      if (ClusterCores == 0) {
+        break;
+      }
+    }
+  }
+
+  if (Count == 0) {
+    Mpidr[Count++] = ArmReadMpidr () & MPIDR_AFFINITY_MASK;
+  }
+
+  mCpuData = AllocateZeroPool (Count * sizeof (CPU_AP_DATA));
+  if (mCpuData == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mNumberOfProcessors = Count;
+  mBspIndex = 0;
+  for (Index = 0; Index < Count; Index++) {
+    mCpuData[Index].Mpidr = Mpidr[Index];
+    mCpuData[Index].State = CpuStateOff;
+    if (Mpidr[Index] == (ArmReadMpidr () & MPIDR_AFFINITY_MASK)) {
+      mBspIndex                = Index;
+      mCpuData[Index].Enabled  = TRUE;
+      mCpuData[Index].State    = CpuStateBusy;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Start the APs with PSCI CPU_ON and wait for them to reach their idle loop.
+
+  @param  ImageHandle   The image handle of this driver.
+
+**/
+STATIC
+VOID
+StartAps (
+  IN EFI_HANDLE         ImageHandle
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_LOADED_IMAGE_PROTOCOL   *LoadedImage;
+  CPU_AP_DATA                 *CpuData;
+  VOID                        *Stacks;
+  UINTN                       Index;
+  UINTN                       Retry;
+  INTN                        Result;
+
+  Stacks = AllocatePages (EFI_SIZE_TO_PAGES (mNumberOfProcessors * AP_STACK_SIZE));
+  if (Stacks == NULL) {
+    return;
+  }
+
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    CpuData = &mCpuData[Index];
+    CpuData->Boot.Mair     = ArmGetMAIR ();
+    CpuData->Boot.Tcr      = ArmGetTCR ();
+    CpuData->Boot.Ttbr0    = ArmGetTTBR0BaseAddress ();
+    CpuData->Boot.Sctlr    = ArmReadSctlr ();
+    CpuData->Boot.Vbar     = ArmReadVBar ();
+    CpuData->Boot.StackTop = (UINTN) Stacks + (Index + 1) * AP_STACK_SIZE;
+  }
+
+  //
+  // The APs run this image and read their CPU_AP_DATA with the MMU off.
+  //
+  Status = gBS->HandleProtocol (ImageHandle, &gEfiLoadedImageProtocolGuid, (VOID **) &LoadedImage);
+  ASSERT_EFI_ERROR (Status);
+  WriteBackDataCacheRange (LoadedImage->ImageBase, (UINTN) LoadedImage->ImageSize);
+  WriteBackDataCacheRange (mCpuData, mNumberOfProcessors * sizeof (CPU_AP_DATA));
+
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    if (Index == mBspIndex) {
+      continue;
+    }
+
+    Result = PsciCall (
+               ARM_SMC_ID_PSCI_CPU_ON_AARCH64,
+               (UINTN) mCpuData[Index].Mpidr,
+               (UINTN) ArmPsciMpApEntry,
+               (UINTN) &mCpuData[Index]
+               );
+    if (Result != ARM_SMC_PSCI_RET_SUCCESS) {
+      DEBUG ((DEBUG_WARN, "%a: CPU_ON 0x%lx failed (%d)\n", __FUNCTION__, mCpuData[Index].Mpidr, Result));
+      continue;
+    }
+
+    for (Retry = 0; Retry < 1000 && mCpuData[Index].State != CpuStateIdle; Retry++) {
+      MicroSecondDelay (100);
+    }
+    if (mCpuData[Index].State == CpuStateIdle) {
+      mCpuData[Index].Enabled = TRUE;
+    } else {
+      DEBUG ((DEBUG_WARN, "%a: CPU 0x%lx did not come up\n", __FUNCTION__, mCpuData[Index].Mpidr));
+    }
+  }
+}
+
+/**
+  Entry point of the driver.
+
+  @param  ImageHandle   The image handle of this driver.
+  @param  SystemTable   The EFI system table.
+
+  @retval EFI_SUCCESS   The MP Services Protocol is installed.
+  @retval other         The driver failed to initialize.
+
+**/
+EFI_STATUS
+EFIAPI
+ArmPsciMpServicesDxeInitialize (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  )
+{
+  EFI_STATUS            Status;
+  EFI_EVENT             ExitBootServicesEvent;
+  EFI_HANDLE            Handle;
+  UINTN                 Index;
+  UINTN                 Enabled;
+
+  mPsciUseHvc = PcdGetBool (PcdArmMpServicesPsciUseHvc);
+
+  Status = DiscoverProcessors ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  CheckApsStatus,
+                  NULL,
+                  &mCheckApsEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                  TPL_CALLBACK,
+                  ExitBootServicesCallback,
+                  NULL,
+                  &ExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  StartAps (ImageHandle);
+
+  Enabled = 0;
+  for (Index = 0; Index < mNumberOfProcessors; Index++) {
+    if (mCpuData[Index].Enabled) {
+      Enabled++;
+    }
+  }
+  DEBUG ((DEBUG_INFO, "%a: %d processors, %d enabled\n", __FUNCTION__, mNumberOfProcessors, Enabled));
+
+  Handle = NULL;
+  return gBS->InstallMultipleProtocolInterfaces (
+                &Handle,
+                &gEfiMpServiceProtocolGuid,
+                &mMpServicesProtocol,
+                NULL
+                );
+}
@@ -0,0 +1,121 @@
+/** @file
+*
+*  Copyright (c) 2018, The EDK II Contributors. All rights reserved.
+*
+*  This program and the accompanying materials
+*  are licensed and made available under the terms and conditions of the BSD
+*  License which accompanies this distribution.  The full text of the license
+*  may be found at http://opensource.org/licenses/bsd-license.php
+*
+*  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+*
+**/
+
+#ifndef __ARM_PSCI_MP_SERVICES_INTERNAL_H__
+#define __ARM_PSCI_MP_SERVICES_INTERNAL_H__
+
+#define AP_STACK_SIZE                     SIZE_16KB
+
+//
+// Interval of the timer that reaps non-blocking AP work, in 100ns units.
+//
+#define AP_CHECK_INTERVAL                 10000
+
+#define MPIDR_AFFINITY_MASK               0xFF00FFFFFFULL
+
+//
+// Bounds of the PSCI AFFINITY_INFO probe used to discover the processors
+// when no ARM MP core info HOB is available.
+//
+#define MAX_PROBED_CLUSTERS               16
+#define MAX_PROBED_CORES_PER_CLUSTER      16
+
+typedef enum {
+  //
+  // The AP is not running UEFI code.
+  //
+  CpuStateOff,
+  //
+  // The AP waits for work.
+  //
+  CpuStateIdle,
+  //
+  // The BSP has handed a procedure to the AP.
+  //
+  CpuStateBusy,
+  //
+  // The AP has returned from the procedure and waits for the BSP to reap it.
+  //
+  CpuStateFinished
+} CPU_STATE;
+
+///
+/// Values the AP entry code loads into its system registers before it turns
+/// on the MMU. The AP reads them with the MMU and the caches off, so they must
+/// be cleaned to the point of coherency before the AP is started.
+/// The layout is shared with AArch64/MpFuncs.S.
+///
+typedef struct {
+  UINT64                  Mair;
+  UINT64                  Tcr;
+  UINT64                  Ttbr0;
+  UINT64                  Sctlr;
+  UINT64                  Vbar;
+  UINT64                  StackTop;
+} AP_BOOT_CONTEXT;
+
+typedef struct {
+  ///
+  /// Must be the first field; the AP entry code receives a pointer to it.
+  ///
+  AP_BOOT_CONTEXT         Boot;
+  UINT64                  Mpidr;
+  BOOLEAN                 Enabled;
+  volatile UINTN          State;
+  volatile EFI_AP_PROCEDURE Procedure;
+  VOID * volatile         Argument;
+  ///
+  /// Non-blocking StartupThisAP() bookkeeping.
+  ///
+  EFI_EVENT               WaitEvent;
+  BOOLEAN                 *Finished;
+  UINT64                  TimeoutTicks;
+  ///
+  /// Set when a StartupThisAP () call timed out while the AP was still
+  /// running the procedure, so that the AP is reaped when it returns.
+  ///
+  BOOLEAN                 TimedOut;
+  ///
+  /// Set while the AP runs the procedure of a StartupAllAPs () call, so that
+  /// only the APs of that call are reaped on its behalf.
+  ///
+  BOOLEAN                 AllApsMember;
+} CPU_AP_DATA;
+
+/**
+  Entry point of the APs, passed to PSCI CPU_ON.
+
+  @param  Context         The AP_BOOT_CONTEXT of the AP (in x0).
+
+**/
+VOID
+EFIAPI
+ArmPsciMpApEntry (
+  IN AP_BOOT_CONTEXT      *Context
+  );
+
+/**
+  C entry point of an AP, called by ArmPsciMpApEntry () once the MMU is on
+  and the stack is set up. It never returns.
+
+  @param  CpuData         The CPU_AP_DATA of the AP.
+
+**/
+VOID
+EFIAPI
+ArmPsciMpApMain (
+  IN CPU_AP_DATA          *CpuData
+  );
+
+#endif // __ARM_PSCI_MP_SERVICES_INTERNAL_H__
@@ -0,0 +1,185 @@
+/** @file
+  FDT client library for ARM's PSCI MP Services driver
+
+  Takes the PSCI conduit and the list of processors from the device tree, so
+  that ArmPsciMpServicesDxe starts the processors of the VM that is actually
+  running, through the conduit its hypervisor or firmware expects.
+
+  Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/PcdLib.h>
+#include <libfdt.h>
+
+#include <Guid/FdtHob.h>
+
+//
+// Must match the maximum size of PcdArmMpServicesMpidrs set by the platform
+// DSC, in UINT64 units.
+//
+#define MAX_FDT_CPUS    256
+
+/**
+  Set PcdArmMpServicesPsciUseHvc from the "method" property of the PSCI node.
+
+  @param  DeviceTreeBase  The device tree.
+
+**/
+STATIC
+VOID
+SetPsciConduit (
+  IN CONST VOID     *DeviceTreeBase
+  )
+{
+  INT32             Node;
+  CONST CHAR8       *Method;
+  INT32             Len;
+  RETURN_STATUS     PcdStatus;
+
+  Node = fdt_node_offset_by_compatible (DeviceTreeBase, -1, "arm,psci-0.2");
+  if (Node < 0) {
+    DEBUG ((DEBUG_WARN, "%a: no PSCI 0.2 node\n", __FUNCTION__));
+    return;
+  }
+
+  Method = fdt_getprop (DeviceTreeBase, Node, "method", &Len);
+  if (Method == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a: no PSCI method\n", __FUNCTION__));
+    return;
+  }
+
+  if (AsciiStrnCmp (Method, "hvc", 3) == 0) {
+    PcdStatus = PcdSetBoolS (PcdArmMpServicesPsciUseHvc, TRUE);
+  } else if (AsciiStrnCmp (Method, "smc", 3) == 0) {
+    PcdStatus = PcdSetBoolS (PcdArmMpServicesPsciUseHvc, FALSE);
+  } else {
+    DEBUG ((DEBUG_ERROR, "%a: Unknown PSCI method \"%a\"\n", __FUNCTION__,
+      Method));
+    return;
+  }
+  ASSERT_RETURN_ERROR (PcdStatus);
+}
+
+/**
+  Set PcdArmMpServicesMpidrs from the "reg" properties of the enabled "cpu"
+  nodes under /cpus.
+
+  @param  DeviceTreeBase  The device tree.
+
+**/
+STATIC
+VOID
+SetProcessors (
+  IN CONST VOID     *DeviceTreeBase
+  )
+{
+  INT32             CpusNode;
+  INT32             Node;
+  CONST VOID        *Prop;
+  INT32             Len;
+  UINT32            AddressCells;
+  UINT64            Mpidr[MAX_FDT_CPUS];
+  UINTN             Count;
+  UINTN             Size;
+  RETURN_STATUS     PcdStatus;
+
+  CpusNode = fdt_path_offset (DeviceTreeBase, "/cpus");
+  if (CpusNode < 0) {
+    DEBUG ((DEBUG_WARN, "%a: no /cpus node\n", __FUNCTION__));
+    return;
+  }
+
+  //
+  // The MPIDR affinity fields are in 1 cell, or in 2 cells if Aff3 is used.
+  //
+  AddressCells = 1;
+  Prop = fdt_getprop (DeviceTreeBase, CpusNode, "#address-cells", &Len);
+  if (Prop != NULL && Len == sizeof (UINT32)) {
+    AddressCells = fdt32_to_cpu (ReadUnaligned32 (Prop));
+  }
+  if (AddressCells != 1 && AddressCells != 2) {
+    DEBUG ((DEBUG_ERROR, "%a: unsupported #address-cells %d in /cpus\n",
+      __FUNCTION__, AddressCells));
+    return;
+  }
+
+  Count = 0;
+  fdt_for_each_subnode (Node, DeviceTreeBase, CpusNode) {
+    if (Count == MAX_FDT_CPUS) {
+      DEBUG ((DEBUG_WARN, "%a: only the first %d CPUs are used\n",
+        __FUNCTION__, MAX_FDT_CPUS));
+      break;
+    }
+
+    Prop = fdt_getprop (DeviceTreeBase, Node, "device_type", &Len);
+    if (Prop == NULL || AsciiStrCmp (Prop, "cpu") != 0) {
+      continue;
+    }
+    Prop = fdt_getprop (DeviceTreeBase, Node, "status", &Len);
+    if (Prop != NULL && AsciiStrCmp (Prop, "okay") != 0) {
+      continue;
+    }
+
+    Prop = fdt_getprop (DeviceTreeBase, Node, "reg", &Len);
+    if (Prop == NULL || Len < (INT32) (AddressCells * sizeof (UINT32))) {
+      continue;
+    }
+    if (AddressCells == 2) {
+      Mpidr[Count++] = fdt64_to_cpu (ReadUnaligned64 (Prop));
+    } else {
+      Mpidr[Count++] = fdt32_to_cpu (ReadUnaligned32 (Prop));
+    }
+  }
+
+  if (Count == 0) {
+    return;
+  }
+
+  DEBUG ((DEBUG_INFO, "%a: %d CPUs in the device tree\n", __FUNCTION__,
+    Count));
+
+  Size = Count * sizeof (UINT64);
+  PcdStatus = PcdSetPtrS (PcdArmMpServicesMpidrs, &Size, Mpidr);
+  ASSERT_RETURN_ERROR (PcdStatus);
+}
+
+RETURN_STATUS
+EFIAPI
+ArmVirtPsciMpServicesFdtClientLibConstructor (
+  VOID
+  )
+{
+  VOID              *Hob;
+  VOID              *DeviceTreeBase;
+
+  Hob = GetFirstGuidHob (&gFdtHobGuid);
+  if (Hob == NULL || GET_GUID_HOB_DATA_SIZE (Hob) != sizeof (UINT64)) {
+    return RETURN_SUCCESS;
+  }
+  DeviceTreeBase = (VOID *)(UINTN)*(UINT64 *)GET_GUID_HOB_DATA (Hob);
+
+  if (fdt_check_header (DeviceTreeBase) != 0) {
+    DEBUG ((DEBUG_ERROR, "%a: No DTB found @ 0x%p\n", __FUNCTION__,
+      DeviceTreeBase));
+    return RETURN_SUCCESS;
+  }
+
+  SetPsciConduit (DeviceTreeBase);
+  SetProcessors (DeviceTreeBase);
+
+  return RETURN_SUCCESS;
+}
@@ -1,7 +1,7 @@
 /** @file
   Cache implementation for EFI FAT File system driver.
 
-Copyright (c) 2005 - 2013, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2005 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials are licensed and made available
 under the terms and conditions of the BSD License which accompanies this
 distribution. The full text of the license may be found at
@@ -14,6 +14,106 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include "Fat.h"
 
+/**
+
+  Get the address in the cache buffer of the page of a cache tag.
+
+  @param  DiskCache             - The disk cache.
+  @param  CacheTag              - The Cache Tag of the page.
+
+  @return The address of the cache page.
+
+**/
+STATIC
+UINT8 *
+FatCachePageAddress (
+  IN DISK_CACHE         *DiskCache,
+  IN CACHE_TAG          *CacheTag
+  )
+{
+  return DiskCache->CacheBase + ((UINTN) (CacheTag - DiskCache->CacheTag) << DiskCache->PageAlignment);
+}
+
+/**
+
+  Find a page in the cache. A page can be in any way of its group, the
+  tag of way Way of group GroupNo is CacheTag[Way * GroupCount + GroupNo],
+  so that consecutive pages in the same way are also consecutive in the
+  cache buffer.
+
+  @param  DiskCache             - The disk cache.
+  @param  PageNo                - PageNo to match with the cache.
+
+  @return The Cache Tag of the page, or NULL if the page is not in the cache.
+
+**/
+STATIC
+CACHE_TAG *
+FatLookupCachePage (
+  IN DISK_CACHE         *DiskCache,
+  IN UINTN              PageNo
+  )
+{
+  UINTN       GroupNo;
+  UINTN       GroupCount;
+  UINTN       Way;
+  CACHE_TAG   *CacheTag;
+
+  GroupNo    = PageNo & DiskCache->GroupMask;
+  GroupCount = DiskCache->GroupMask + 1;
+
+  for (Way = 0; Way < DiskCache->WayCount; Way++) {
+    CacheTag = &DiskCache->CacheTag[Way * GroupCount + GroupNo];
+    if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo) {
+      return CacheTag;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+
+  Select the cache page to replace with a page: an empty page of its group if
+  any, otherwise the least recently used one.
+
+  @param  DiskCache             - The disk cache.
+  @param  PageNo                - PageNo to load in the cache.
+
+  @return The Cache Tag of the page to replace.
+
+**/
+STATIC
+CACHE_TAG *
+FatSelectCachePage (
+  IN DISK_CACHE         *DiskCache,
+  IN UINTN              PageNo
+  )
+{
+  UINTN       GroupNo;
+  UINTN       GroupCount;
+  UINTN       Way;
+  CACHE_TAG   *CacheTag;
+  CACHE_TAG   *Victim;
+
+  GroupNo    = PageNo & DiskCache->GroupMask;
+  GroupCount = DiskCache->GroupMask + 1;
+  Victim     = &DiskCache->CacheTag[GroupNo];
+
+  for (Way = 0; Way < DiskCache->WayCount; Way++) {
+    CacheTag = &DiskCache->CacheTag[Way * GroupCount + GroupNo];
+    if (CacheTag->RealSize == 0) {
+      return CacheTag;
+    }
+
+    if (CacheTag->LastUse < Victim->LastUse) {
+      Victim = CacheTag;
+    }
+  }
+
+  return Victim;
+}
+
 /**
 
   This function is used by the Data Cache.
@@ -43,25 +143,25 @@ FatFlushDataCacheRange (
   OUT UINT8              *Buffer
   )
 {
-  UINTN       PageNo;
-  UINTN       GroupNo;
-  UINTN       GroupMask;
+  UINTN       Index;
+  UINTN       PageCount;
   UINTN       PageSize;
   UINT8       PageAlignment;
   DISK_CACHE  *DiskCache;
   CACHE_TAG   *CacheTag;
-  UINT8       *BaseAddress;
 
   DiskCache     = &Volume->DiskCache[CacheData];
-  BaseAddress   = DiskCache->CacheBase;
-  GroupMask     = DiskCache->GroupMask;
   PageAlignment = DiskCache->PageAlignment;
   PageSize      = (UINTN)1 << PageAlignment;
+  PageCount     = (DiskCache->GroupMask + 1) * DiskCache->WayCount;
 
-  for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
-    GroupNo   = PageNo & GroupMask;
-    CacheTag  = &DiskCache->CacheTag[GroupNo];
-    if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo) {
+  //
+  // The range can be much larger than the cache, so check the pages
+  // in the cache against the range rather than the other way round.
+  //
+  for (Index = 0; Index < PageCount; Index++) {
+    CacheTag = &DiskCache->CacheTag[Index];
+    if (CacheTag->RealSize > 0 && CacheTag->PageNo >= StartPageNo && CacheTag->PageNo < EndPageNo) {
       //
       // When reading data form disk directly, if some dirty data
       // in cache is in this rang, this data in the Buffer need to
@@ -70,8 +170,8 @@ FatFlushDataCacheRange (
       if (IoMode == ReadDisk) {
         if (CacheTag->Dirty) {
           CopyMem (
-            Buffer + ((PageNo - StartPageNo) << PageAlignment),
-            BaseAddress + (GroupNo << PageAlignment),
+            Buffer + ((CacheTag->PageNo - StartPageNo) << PageAlignment),
+            FatCachePageAddress (DiskCache, CacheTag),
             PageSize
             );
         }
@@ -87,16 +187,18 @@ FatFlushDataCacheRange (
 
 /**
 
-  Exchange the cache page with the image on the disk
+  Exchange the cache pages with the image on the disk
 
   @param  Volume                - FAT file system volume.
   @param  DataType              - Indicate the cache type.
-  @param  IoMode                - Indicate whether to load this page from disk or store this page to disk.
-  @param  CacheTag              - The Cache Tag for the current cache page.
+  @param  IoMode                - Indicate whether to load these pages from disk or store these pages to disk.
+  @param  CacheTag              - The Cache Tag of the first cache page. The following PageCount - 1
+                                  tags are for the following pages on the disk.
+  @param  PageCount             - The number of cache pages to exchange.
   @param  Task                    point to task instance.
 
-  @retval EFI_SUCCESS           - Cache page exchanged successfully.
-  @return Others                - An error occurred when exchanging cache page.
+  @retval EFI_SUCCESS           - Cache pages exchanged successfully.
+  @return Others                - An error occurred when exchanging cache pages.
 
 **/
 STATIC
@@ -106,14 +208,15 @@ FatExchangeCachePage (
   IN CACHE_DATA_TYPE    DataType,
   IN IO_MODE            IoMode,
   IN CACHE_TAG          *CacheTag,
+  IN UINTN              PageCount,
   IN FAT_TASK           *Task
   )
 {
   EFI_STATUS  Status;
-  UINTN       GroupNo;
   UINTN       PageNo;
   UINTN       WriteCount;
   UINTN       RealSize;
+  UINTN       Index;
   UINT64      EntryPos;
   UINT64      MaxSize;
   DISK_CACHE  *DiskCache;
@@ -122,13 +225,12 @@ FatExchangeCachePage (
 
   DiskCache     = &Volume->DiskCache[DataType];
   PageNo        = CacheTag->PageNo;
-  GroupNo       = PageNo & DiskCache->GroupMask;
   PageAlignment = DiskCache->PageAlignment;
-  PageAddress   = DiskCache->CacheBase + (GroupNo << PageAlignment);
+  PageAddress   = FatCachePageAddress (DiskCache, CacheTag);
   EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
-  RealSize      = CacheTag->RealSize;
+  RealSize      = ((PageCount - 1) << PageAlignment) + CacheTag[PageCount - 1].RealSize;
   if (IoMode == ReadDisk) {
-    RealSize  = (UINTN)1 << PageAlignment;
+    RealSize  = PageCount << PageAlignment;
     MaxSize   = DiskCache->LimitAddress - EntryPos;
     if (MaxSize < RealSize) {
       DEBUG ((EFI_D_INFO, "FatDiskIo: Cache Page OutBound occurred! \n"));
@@ -153,19 +255,85 @@ FatExchangeCachePage (
     EntryPos += Volume->FatSize;
   } while (--WriteCount > 0);
 
-  CacheTag->Dirty     = FALSE;
-  CacheTag->RealSize  = RealSize;
+  for (Index = 0; Index < PageCount; Index++) {
+    CacheTag[Index].Dirty    = FALSE;
+    CacheTag[Index].RealSize = MIN ((UINTN)1 << PageAlignment, RealSize - (Index << PageAlignment));
+  }
+
   return EFI_SUCCESS;
 }
 
+/**
+
+  Load a page missing from the data cache, and read ahead the pages which
+  follow it on the disk, in one disk access.
+
+  The pages read ahead are loaded in the same way as the missing page, in the
+  following groups, so that they are consecutive in the cache buffer. The read
+  ahead stops at a page already in the cache, at a dirty page which would have
+  to be written back first, at the end of the cache and at the end of the volume.
+
+  @param  Volume                - FAT file system volume.
+  @param  PageNo                - The missing PageNo.
+  @param  CacheTag              - The Cache Tag to load the missing page into.
+
+  @retval EFI_SUCCESS           - The pages are loaded.
+  @return Others                - An error occurred when reading the pages.
+
+**/
+STATIC
+EFI_STATUS
+FatReadAheadCachePages (
+  IN FAT_VOLUME         *Volume,
+  IN UINTN              PageNo,
+  IN CACHE_TAG          *CacheTag
+  )
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *Next;
+  UINTN       GroupNo;
+  UINTN       PageCount;
+  UINTN       Index;
+
+  DiskCache = &Volume->DiskCache[CacheData];
+  GroupNo   = PageNo & DiskCache->GroupMask;
+
+  PageCount = 1;
+  while (PageCount < FAT_DATACACHE_READ_AHEAD_COUNT && GroupNo + PageCount <= DiskCache->GroupMask) {
+    Next = CacheTag + PageCount;
+    if ((Next->RealSize > 0 && Next->Dirty) ||
+        FatLookupCachePage (DiskCache, PageNo + PageCount) != NULL ||
+        DiskCache->BaseAddress + LShiftU64 (PageNo + PageCount, DiskCache->PageAlignment) >= DiskCache->LimitAddress) {
+      break;
+    }
+
+    PageCount++;
+  }
+
+  for (Index = 0; Index < PageCount; Index++) {
+    CacheTag[Index].PageNo   = PageNo + Index;
+    CacheTag[Index].RealSize = 0;
+    CacheTag[Index].LastUse  = DiskCache->UseCounter;
+  }
+
+  Status = FatExchangeCachePage (Volume, CacheData, ReadDisk, CacheTag, PageCount, NULL);
+  if (!EFI_ERROR (Status)) {
+    DiskCache->ReadAheadCount += PageCount - 1;
+  }
+
+  return Status;
+}
+
 /**
 
   Get one cache page by specified PageNo.
 
   @param  Volume                - FAT file system volume.
   @param  CacheDataType         - The cache type: CACHE_FAT or CACHE_DATA.
+  @param  IoMode                - Indicate the type of disk access the page is got for.
   @param  PageNo                - PageNo to match with the cache.
-  @param  CacheTag              - The Cache Tag for the current cache page.
+  @param  CacheTag              - Return the Cache Tag for the cache page.
 
   @retval EFI_SUCCESS           - Get the cache page successfully.
   @return other                 - An error occurred when accessing data.
@@ -174,38 +342,66 @@ FatExchangeCachePage (
 STATIC
 EFI_STATUS
 FatGetCachePage (
-  IN FAT_VOLUME         *Volume,
-  IN CACHE_DATA_TYPE    CacheDataType,
-  IN UINTN              PageNo,
-  IN CACHE_TAG          *CacheTag
+  IN  FAT_VOLUME         *Volume,
+  IN  CACHE_DATA_TYPE    CacheDataType,
+  IN  IO_MODE            IoMode,
+  IN  UINTN              PageNo,
+  OUT CACHE_TAG          **CacheTag
   )
 {
   EFI_STATUS  Status;
-  UINTN       OldPageNo;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *Tag;
+  BOOLEAN     Sequential;
 
-  OldPageNo = CacheTag->PageNo;
-  if (CacheTag->RealSize > 0 && OldPageNo == PageNo) {
+  DiskCache = &Volume->DiskCache[CacheDataType];
+  DiskCache->UseCounter++;
+
+  Tag = FatLookupCachePage (DiskCache, PageNo);
+  if (Tag != NULL) {
     //
     // Cache Hit occurred
     //
+    DiskCache->HitCount++;
+    DiskCache->NextPageNo = PageNo + 1;
+    Tag->LastUse          = DiskCache->UseCounter;
+    *CacheTag             = Tag;
     return EFI_SUCCESS;
   }
 
+  DiskCache->MissCount++;
+  Tag = FatSelectCachePage (DiskCache, PageNo);
+
   //
   // Write dirty cache page back to disk
   //
-  if (CacheTag->RealSize > 0 && CacheTag->Dirty) {
-    Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, CacheTag, NULL);
+  if (Tag->RealSize > 0 && Tag->Dirty) {
+    Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, Tag, 1, NULL);
     if (EFI_ERROR (Status)) {
       return Status;
     }
   }
+
+  //
+  // A read of the data cache which misses the page following the last page
+  // accessed is part of a sequential read, like loading a large file.
+  //
+  Sequential = (BOOLEAN) (CacheDataType == CacheData && IoMode == ReadDisk && PageNo == DiskCache->NextPageNo);
+  DiskCache->NextPageNo = PageNo + 1;
+
   //
   // Load new data from disk;
   //
-  CacheTag->PageNo  = PageNo;
-  Status            = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, CacheTag, NULL);
+  if (Sequential) {
+    Status = FatReadAheadCachePages (Volume, PageNo, Tag);
+  } else {
+    Tag->PageNo   = PageNo;
+    Tag->RealSize = 0;
+    Tag->LastUse  = DiskCache->UseCounter;
+    Status        = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, Tag, 1, NULL);
+  }
 
+  *CacheTag = Tag;
   return Status;
 }
 
@@ -243,14 +439,11 @@ FatAccessUnalignedCachePage (
   VOID        *Destination;
   DISK_CACHE  *DiskCache;
   CACHE_TAG   *CacheTag;
-  UINTN       GroupNo;
 
   DiskCache = &Volume->DiskCache[CacheDataType];
-  GroupNo   = PageNo & DiskCache->GroupMask;
-  CacheTag  = &DiskCache->CacheTag[GroupNo];
-  Status    = FatGetCachePage (Volume, CacheDataType, PageNo, CacheTag);
+  Status    = FatGetCachePage (Volume, CacheDataType, IoMode, PageNo, &CacheTag);
   if (!EFI_ERROR (Status)) {
-    Source      = DiskCache->CacheBase + (GroupNo << DiskCache->PageAlignment) + Offset;
+    Source      = FatCachePageAddress (DiskCache, CacheTag) + Offset;
     Destination = Buffer;
     if (IoMode != ReadDisk) {
       CacheTag->Dirty   = TRUE;
@@ -366,6 +559,7 @@ FatAccessCache (
     // to be updated.
     //
     FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer);
+    DiskCache->NextPageNo = OverRunPageNo;
     Buffer      += AlignedSize;
     BufferSize  -= AlignedSize;
   }
@@ -403,7 +597,10 @@ FatVolumeFlushCache (
   EFI_STATUS      Status;
   CACHE_DATA_TYPE CacheDataType;
   UINTN           GroupIndex;
-  UINTN           GroupMask;
+  UINTN           GroupCount;
+  UINTN           Way;
+  UINTN           PageCount;
+  UINTN           PageSize;
   DISK_CACHE      *DiskCache;
   CACHE_TAG       *CacheTag;
 
@@ -413,14 +610,32 @@ FatVolumeFlushCache (
       //
       // Data cache or fat cache is dirty, write the dirty data back
       //
-      GroupMask = DiskCache->GroupMask;
-      for (GroupIndex = 0; GroupIndex <= GroupMask; GroupIndex++) {
-        CacheTag = &DiskCache->CacheTag[GroupIndex];
-        if (CacheTag->RealSize > 0 && CacheTag->Dirty) {
+      GroupCount = DiskCache->GroupMask + 1;
+      PageSize   = (UINTN)1 << DiskCache->PageAlignment;
+      for (Way = 0; Way < DiskCache->WayCount; Way++) {
+        for (GroupIndex = 0; GroupIndex < GroupCount; GroupIndex += PageCount) {
+          CacheTag  = &DiskCache->CacheTag[Way * GroupCount + GroupIndex];
+          PageCount = 1;
+          if (CacheTag->RealSize == 0 || !CacheTag->Dirty) {
+            continue;
+          }
+
+          //
+          // Write back the dirty pages of the way which follow this one on the
+          // disk, and so in the cache buffer, in the same disk access.
+          //
+          while (GroupIndex + PageCount < GroupCount &&
+                 CacheTag[PageCount - 1].RealSize == PageSize &&
+                 CacheTag[PageCount].RealSize > 0 &&
+                 CacheTag[PageCount].Dirty &&
+                 CacheTag[PageCount].PageNo == CacheTag->PageNo + PageCount) {
+            PageCount++;
+          }
+
           //
           // Write back all Dirty Data Cache Page to disk
           //
-          Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, CacheTag, Task);
+          Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, CacheTag, PageCount, Task);
           if (EFI_ERROR (Status)) {
             return Status;
           }
@@ -454,6 +669,7 @@ FatInitializeDiskCache (
 {
   DISK_CACHE  *DiskCache;
   UINTN       FatCacheGroupCount;
+  UINTN       FatCacheWayCount;
   UINTN       DataCacheSize;
   UINTN       FatCacheSize;
   UINT8       *CacheBuffer;
@@ -472,10 +688,14 @@ FatInitializeDiskCache (
     DiskCache[CacheData].PageAlignment = FAT_DATACACHE_PAGE_MAX_ALIGNMENT;
   }
 
-  DiskCache[CacheData].GroupMask     = FAT_DATACACHE_GROUP_COUNT - 1;
+  FatCacheWayCount = MIN (FatCacheGroupCount, FAT_FATCACHE_WAY_COUNT);
+
+  DiskCache[CacheData].WayCount      = FAT_DATACACHE_WAY_COUNT;
+  DiskCache[CacheData].GroupMask     = FAT_DATACACHE_GROUP_COUNT / FAT_DATACACHE_WAY_COUNT - 1;
   DiskCache[CacheData].BaseAddress   = Volume->RootPos;
   DiskCache[CacheData].LimitAddress  = Volume->VolumeSize;
-  DiskCache[CacheFat].GroupMask      = FatCacheGroupCount - 1;
+  DiskCache[CacheFat].WayCount       = FatCacheWayCount;
+  DiskCache[CacheFat].GroupMask      = FatCacheGroupCount / FatCacheWayCount - 1;
   DiskCache[CacheFat].BaseAddress    = Volume->FatPos;
   DiskCache[CacheFat].LimitAddress   = Volume->FatPos + Volume->FatSize;
   FatCacheSize                        = FatCacheGroupCount << DiskCache[CacheFat].PageAlignment;
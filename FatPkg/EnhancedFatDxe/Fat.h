@@ -90,6 +90,15 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define FAT_FATCACHE_GROUP_MIN_COUNT      1
 #define FAT_FATCACHE_GROUP_MAX_COUNT      16
 
+//
+// The caches are set associative: a page can be cached in any of the ways of
+// its group. The GROUP_COUNT values above are the total number of cache pages.
+// A sequential read of the data cache reads ahead up to READ_AHEAD_COUNT pages.
+//
+#define FAT_DATACACHE_WAY_COUNT           4
+#define FAT_FATCACHE_WAY_COUNT            4
+#define FAT_DATACACHE_READ_AHEAD_COUNT    4
+
 //
 // Used in 8.3 generation algorithm
 //
@@ -112,6 +121,15 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #define FAT_MAX_DIR_CACHE_COUNT 8
 #define FAT_MAX_DIRENTRY_COUNT  0xFFFF
+
+//
+// The cluster chain of an open file is cached in up to FAT_MAX_EXTENT_COUNT
+// runs of consecutive clusters. The free cluster bitmap of a volume is only
+// built if it is not larger than FAT_MAX_FREE_BITMAP_SIZE bytes.
+//
+#define FAT_MIN_EXTENT_COUNT      8
+#define FAT_MAX_EXTENT_COUNT      1024
+#define FAT_MAX_FREE_BITMAP_SIZE  0x40000
 typedef CHAR8                   LC_ISO_639_2;
 
 //
@@ -153,6 +171,7 @@ typedef struct {
   UINTN   PageNo;
   UINTN   RealSize;
   BOOLEAN Dirty;
+  UINTN   LastUse;          // Value of UseCounter when the page was last accessed
 } CACHE_TAG;
 
 typedef struct {
@@ -162,9 +181,24 @@ typedef struct {
   BOOLEAN   Dirty;
   UINT8     PageAlignment;
   UINTN     GroupMask;
+  UINTN     WayCount;
+  UINTN     UseCounter;
+  UINTN     NextPageNo;     // The page following the last page accessed
+  UINT64    HitCount;
+  UINT64    MissCount;
+  UINT64    ReadAheadCount;
   CACHE_TAG CacheTag[FAT_DATACACHE_GROUP_COUNT];
 } DISK_CACHE;
 
+//
+// A run of consecutive clusters in the cluster chain of a file
+//
+typedef struct {
+  UINTN   FileCluster;      // The index in the file of the first cluster of the run
+  UINTN   Cluster;          // The first cluster of the run
+  UINTN   Count;            // The number of clusters in the run
+} FAT_EXTENT;
+
 //
 // Hash table size
 //
@@ -259,6 +293,15 @@ struct _FAT_OFILE {
   UINTN               FileCurrentCluster;
   UINTN               FileLastCluster;
 
+  //
+  // The cached beginning of the cluster chain, ExtentClusters is the
+  // number of clusters in the ExtentCount runs of Extents
+  //
+  FAT_EXTENT          *Extents;
+  UINTN               ExtentCount;
+  UINTN               ExtentMaxCount;
+  UINTN               ExtentClusters;
+
   //
   // Dirty is set if there have been any updates to the
   // file
@@ -341,6 +384,7 @@ struct _FAT_VOLUME {
   FAT_INFO_SECTOR                 FatInfoSector;  // Free cluster info
   UINTN                           FreeInfoPos;    // Pos with the free cluster info
   BOOLEAN                         FreeInfoValid;  // If free cluster info is valid
+  UINT8                           *FreeBitmap;    // A bit set for each free cluster, built on the first allocation
   //
   // Unpacked Fat BPB info
   //
@@ -1,7 +1,7 @@
 /** @file
   Routines dealing with disk spaces and FAT table entries.
 
-Copyright (c) 2005 - 2013, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2005 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials are licensed and made available
 under the terms and conditions of the BSD License which accompanies this
 distribution. The full text of the license may be found at
@@ -166,10 +166,18 @@ FatSetFatEntry (
     if (Index < Volume->FatInfoSector.FreeInfo.NextCluster) {
       Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
     }
+
+    if (Volume->FreeBitmap != NULL) {
+      Volume->FreeBitmap[Index / 8] |= (UINT8) (1 << (Index % 8));
+    }
   } else if (Value != FAT_CLUSTER_FREE && OriginalVal == FAT_CLUSTER_FREE) {
     if (Volume->FatInfoSector.FreeInfo.ClusterCount != 0) {
       Volume->FatInfoSector.FreeInfo.ClusterCount -= 1;
     }
+
+    if (Volume->FreeBitmap != NULL) {
+      Volume->FreeBitmap[Index / 8] &= (UINT8) ~(1 << (Index % 8));
+    }
   }
   //
   // Make sure the entry is in memory
@@ -262,11 +270,160 @@ FatFreeClusters (
   return EFI_SUCCESS;
 }
 
+/**
+
+  Build the bitmap of the free clusters of the volume, and update the free
+  cluster info of the volume as FatComputeFreeInfo() does.
+
+  The bitmap is not built if it is larger than FAT_MAX_FREE_BITMAP_SIZE, or
+  if it can't be allocated; the free clusters are then searched in the FAT.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+STATIC
+VOID
+FatBuildFreeBitmap (
+  IN FAT_VOLUME   *Volume
+  )
+{
+  UINTN   Size;
+  UINTN   Index;
+  UINTN   ClusterCount;
+  UINTN   NextCluster;
+  UINT8   *FreeBitmap;
+
+  Size = (Volume->MaxCluster + 2 + 7) / 8;
+  if (Size > FAT_MAX_FREE_BITMAP_SIZE) {
+    return;
+  }
+
+  FreeBitmap = AllocateZeroPool (Size);
+  if (FreeBitmap == NULL) {
+    return;
+  }
+
+  ClusterCount = 0;
+  NextCluster  = Volume->MaxCluster + 2;
+  for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
+    if (Volume->DiskError) {
+      FreePool (FreeBitmap);
+      return;
+    }
+
+    if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
+      FreeBitmap[Index / 8] |= (UINT8) (1 << (Index % 8));
+      ClusterCount += 1;
+      NextCluster   = Index;
+    }
+  }
+
+  Volume->FreeBitmap                           = FreeBitmap;
+  Volume->FreeInfoValid                        = TRUE;
+  Volume->FatInfoSector.FreeInfo.ClusterCount  = (UINT32) ClusterCount;
+  Volume->FatInfoSector.FreeInfo.NextCluster   = (UINT32) NextCluster;
+  Volume->FatInfoSector.Signature              = FAT_INFO_SIGNATURE;
+  Volume->FatInfoSector.InfoBeginSignature     = FAT_INFO_BEGIN_SIGNATURE;
+  Volume->FatInfoSector.InfoEndSignature       = FAT_INFO_END_SIGNATURE;
+}
+
+/**
+
+  Find free clusters in the free cluster bitmap of the volume.
+
+  The cluster following LastCluster is preferred, so that the file stays
+  contiguous. Otherwise the first run of Count free clusters from NextCluster
+  is found, or the longest run if there is no run of Count free clusters.
+
+  @param  Volume                - FAT file system volume.
+  @param  LastCluster           - The last cluster of the file, or FAT_CLUSTER_FREE.
+  @param  Count                 - The number of clusters the file needs.
+
+  @return The index of the first free cluster found, or FAT_CLUSTER_FREE if there
+          is no free cluster.
+
+**/
+STATIC
+UINTN
+FatFindFreeClusters (
+  IN FAT_VOLUME   *Volume,
+  IN UINTN        LastCluster,
+  IN UINTN        Count
+  )
+{
+  UINT8   *FreeBitmap;
+  UINTN   MaxIndex;
+  UINTN   Index;
+  UINTN   Scanned;
+  UINTN   RunStart;
+  UINTN   RunLength;
+  UINTN   BestStart;
+  UINTN   BestLength;
+
+  FreeBitmap = Volume->FreeBitmap;
+  MaxIndex   = Volume->MaxCluster + 1;
+
+  if (LastCluster >= FAT_MIN_CLUSTER && LastCluster < MaxIndex &&
+      (FreeBitmap[(LastCluster + 1) / 8] & (1 << ((LastCluster + 1) % 8))) != 0) {
+    return LastCluster + 1;
+  }
+
+  Index = Volume->FatInfoSector.FreeInfo.NextCluster;
+  if (Index < FAT_MIN_CLUSTER || Index > MaxIndex) {
+    Index = FAT_MIN_CLUSTER;
+  }
+
+  RunStart   = FAT_CLUSTER_FREE;
+  RunLength  = 0;
+  BestStart  = FAT_CLUSTER_FREE;
+  BestLength = 0;
+  for (Scanned = 0; Scanned <= MaxIndex - FAT_MIN_CLUSTER; Scanned++, Index++) {
+    if (Index > MaxIndex) {
+      //
+      // Wrap round to the first cluster, a run can't go on across the end
+      //
+      Index     = FAT_MIN_CLUSTER;
+      RunLength = 0;
+    }
+
+    if (RunLength == 0 && (Index % 8) == 0 && Index + 7 <= MaxIndex && FreeBitmap[Index / 8] == 0) {
+      //
+      // Skip 8 allocated clusters at once
+      //
+      Scanned += 7;
+      Index   += 7;
+      continue;
+    }
+
+    if ((FreeBitmap[Index / 8] & (1 << (Index % 8))) == 0) {
+      RunLength = 0;
+      continue;
+    }
+
+    if (RunLength == 0) {
+      RunStart = Index;
+    }
+
+    RunLength++;
+    if (RunLength > BestLength) {
+      BestStart  = RunStart;
+      BestLength = RunLength;
+      if (BestLength >= Count) {
+        break;
+      }
+    }
+  }
+
+  return BestStart;
+}
+
 /**
 
   Allocate a free cluster and return the cluster index.
 
   @param  Volume                - FAT file system volume.
+  @param  LastCluster           - The last cluster of the file, or FAT_CLUSTER_FREE.
+  @param  Count                 - The number of clusters the file needs.
 
   @return The index of the free cluster
 
@@ -274,7 +431,9 @@ FatFreeClusters (
 STATIC
 UINTN
 FatAllocateCluster (
-  IN FAT_VOLUME   *Volume
+  IN FAT_VOLUME   *Volume,
+  IN UINTN        LastCluster,
+  IN UINTN        Count
   )
 {
   UINTN Cluster;
@@ -286,6 +445,24 @@ FatAllocateCluster (
     return (UINTN) FAT_CLUSTER_LAST;
   }
 
+  if (Volume->FreeBitmap != NULL) {
+    Cluster = FatFindFreeClusters (Volume, LastCluster, Count);
+    if (Cluster == FAT_CLUSTER_FREE) {
+      return (UINTN) FAT_CLUSTER_LAST;
+    }
+
+    //
+    // The FAT entry of the cluster is only set when the next cluster is
+    // allocated, clear its bit now so that it is not allocated again.
+    //
+    Volume->FreeBitmap[Cluster / 8] &= (UINT8) ~(1 << (Cluster % 8));
+    if (Cluster == Volume->FatInfoSector.FreeInfo.NextCluster) {
+      Volume->FatInfoSector.FreeInfo.NextCluster += 1;
+    }
+
+    return Cluster;
+  }
+
   for (;;) {
     //
     // If the end of the list, return no available cluster
@@ -343,6 +520,206 @@ FatSizeToClusters (
   return Clusters;
 }
 
+/**
+
+  Add a run of consecutive clusters at the end of the cached cluster chain of
+  the open file. Nothing is cached once FAT_MAX_EXTENT_COUNT runs are cached,
+  or if the runs can't be allocated.
+
+  @param  OFile                 - The open file.
+  @param  Cluster               - The first cluster of the run.
+  @param  Count                 - The number of clusters in the run.
+
+**/
+STATIC
+VOID
+FatAppendExtent (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                Cluster,
+  IN UINTN                Count
+  )
+{
+  FAT_EXTENT  *Extent;
+  FAT_EXTENT  *Extents;
+  UINTN       MaxCount;
+
+  if (OFile->ExtentCount != 0) {
+    Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    if (Extent->Cluster + Extent->Count == Cluster) {
+      //
+      // The file has grown from the end of the last run
+      //
+      Extent->Count          += Count;
+      OFile->ExtentClusters  += Count;
+      return;
+    }
+  }
+
+  if (OFile->ExtentCount == OFile->ExtentMaxCount) {
+    if (OFile->ExtentMaxCount == FAT_MAX_EXTENT_COUNT) {
+      return;
+    }
+
+    MaxCount = MAX (OFile->ExtentMaxCount * 2, FAT_MIN_EXTENT_COUNT);
+    MaxCount = MIN (MaxCount, FAT_MAX_EXTENT_COUNT);
+    Extents  = ReallocatePool (
+                 OFile->ExtentMaxCount * sizeof (FAT_EXTENT),
+                 MaxCount * sizeof (FAT_EXTENT),
+                 OFile->Extents
+                 );
+    if (Extents == NULL) {
+      return;
+    }
+
+    OFile->Extents        = Extents;
+    OFile->ExtentMaxCount = MaxCount;
+  }
+
+  Extent              = &OFile->Extents[OFile->ExtentCount];
+  Extent->FileCluster = OFile->ExtentClusters;
+  Extent->Cluster     = Cluster;
+  Extent->Count       = Count;
+  OFile->ExtentCount++;
+  OFile->ExtentClusters += Count;
+}
+
+/**
+
+  Drop the clusters from ClusterCount on from the cached cluster chain of the
+  open file, when its cluster chain is shrunk.
+
+  @param  OFile                 - The open file.
+  @param  ClusterCount          - The number of clusters left in the file.
+
+**/
+STATIC
+VOID
+FatTruncateExtents (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                ClusterCount
+  )
+{
+  FAT_EXTENT  *Extent;
+
+  while (OFile->ExtentCount != 0 && OFile->Extents[OFile->ExtentCount - 1].FileCluster >= ClusterCount) {
+    OFile->ExtentCount--;
+  }
+
+  OFile->ExtentClusters = 0;
+  if (OFile->ExtentCount != 0) {
+    Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    if (Extent->FileCluster + Extent->Count > ClusterCount) {
+      Extent->Count = ClusterCount - Extent->FileCluster;
+    }
+
+    OFile->ExtentClusters = Extent->FileCluster + Extent->Count;
+  }
+}
+
+/**
+
+  Get the cluster at an index in the cluster chain of the open file, from the
+  cached runs of the cluster chain if possible. Otherwise the cluster chain is
+  walked from the end of the cached runs, and the runs walked are cached.
+
+  @param  OFile                 - The open file.
+  @param  ClusterIndex          - The index of the cluster in the file.
+  @param  Cluster               - Return the cluster. If ClusterIndex is just past the
+                                  end of the cluster chain, the end of chain mark is
+                                  returned.
+  @param  RunCount              - Return the number of consecutive clusters from Cluster.
+
+  @retval EFI_SUCCESS           - The cluster is returned.
+  @retval EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+
+**/
+STATIC
+EFI_STATUS
+FatGetExtentCluster (
+  IN  FAT_OFILE           *OFile,
+  IN  UINTN               ClusterIndex,
+  OUT UINTN               *Cluster,
+  OUT UINTN               *RunCount
+  )
+{
+  FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  UINTN       Low;
+  UINTN       High;
+  UINTN       Middle;
+  UINTN       Index;
+  UINTN       Start;
+  UINTN       Count;
+  UINTN       Next;
+
+  Volume = OFile->Volume;
+
+  if (ClusterIndex < OFile->ExtentClusters) {
+    //
+    // Binary search the run containing the cluster
+    //
+    Low  = 0;
+    High = OFile->ExtentCount - 1;
+    while (Low < High) {
+      Middle = (Low + High + 1) / 2;
+      if (OFile->Extents[Middle].FileCluster <= ClusterIndex) {
+        Low = Middle;
+      } else {
+        High = Middle - 1;
+      }
+    }
+
+    Extent    = &OFile->Extents[Low];
+    *Cluster  = Extent->Cluster + ClusterIndex - Extent->FileCluster;
+    *RunCount = Extent->Count - (ClusterIndex - Extent->FileCluster);
+    return EFI_SUCCESS;
+  }
+
+  Index = OFile->ExtentClusters;
+  if (OFile->ExtentCount == 0) {
+    Next = OFile->FileCluster;
+  } else {
+    Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    Next   = FatGetFatEntry (Volume, Extent->Cluster + Extent->Count - 1);
+  }
+
+  for (;;) {
+    if (Index == ClusterIndex && FAT_END_OF_FAT_CHAIN (Next)) {
+      *Cluster  = Next;
+      *RunCount = 1;
+      return EFI_SUCCESS;
+    }
+
+    if (Next < FAT_MIN_CLUSTER || Next >= FAT_CLUSTER_SPECIAL) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatGetExtentCluster: cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    //
+    // Walk the run of consecutive clusters from Next
+    //
+    Start = Next;
+    Count = 1;
+    Next  = FatGetFatEntry (Volume, Start);
+    while (Next == Start + Count) {
+      Count++;
+      Next = FatGetFatEntry (Volume, Next);
+    }
+
+    if (Index == OFile->ExtentClusters) {
+      FatAppendExtent (OFile, Start, Count);
+    }
+
+    if (ClusterIndex < Index + Count) {
+      *Cluster  = Start + ClusterIndex - Index;
+      *RunCount = Count - (ClusterIndex - Index);
+      return EFI_SUCCESS;
+    }
+
+    Index += Count;
+  }
+}
+
 /**
 
   Shrink the end of the open file base on the file size.
@@ -360,9 +737,10 @@ FatShrinkEof (
 {
   FAT_VOLUME  *Volume;
   UINTN       NewSize;
-  UINTN       CurSize;
+  UINTN       RunCount;
   UINTN       Cluster;
   UINTN       LastCluster;
+  EFI_STATUS  Status;
 
   Volume  = OFile->Volume;
   ASSERT_VOLUME_LOCKED (Volume);
@@ -377,17 +755,14 @@ FatShrinkEof (
 
   if (NewSize != 0) {
 
-    for (CurSize = 0; CurSize < NewSize; CurSize++) {
-      if (Cluster == FAT_CLUSTER_FREE || Cluster >= FAT_CLUSTER_SPECIAL) {
-
-        DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatShrinkEof: cluster chain corrupt\n"));
-        return EFI_VOLUME_CORRUPTED;
-      }
-
-      LastCluster = Cluster;
-      Cluster     = FatGetFatEntry (Volume, Cluster);
+    Status = FatGetExtentCluster (OFile, NewSize - 1, &LastCluster, &RunCount);
+    if (EFI_ERROR (Status) || FAT_END_OF_FAT_CHAIN (LastCluster)) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatShrinkEof: cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
     }
 
+    Cluster = FatGetFatEntry (Volume, LastCluster);
+    FatTruncateExtents (OFile, NewSize);
     FatSetFatEntry (Volume, LastCluster, (UINTN) FAT_CLUSTER_LAST);
 
   } else {
@@ -401,6 +776,7 @@ FatShrinkEof (
     // The file is being completely truncated.
     //
     OFile->FileCluster      = FAT_CLUSTER_FREE;
+    FatTruncateExtents (OFile, 0);
   }
   //
   // Set CurrentCluster == FileCluster
@@ -441,7 +817,7 @@ FatGrowEof (
   UINTN       NewSize;
   UINTN       LastCluster;
   UINTN       NewCluster;
-  UINTN       ClusterCount;
+  UINTN       RunCount;
 
   //
   // For FAT file system, the max file is 4GB.
@@ -463,26 +839,22 @@ FatGrowEof (
     // If we haven't found the files last cluster do it now
     //
     if ((OFile->FileCluster != 0) && (OFile->FileLastCluster == 0)) {
-      Cluster       = OFile->FileCluster;
-      ClusterCount  = 0;
-
-      while (!FAT_END_OF_FAT_CHAIN (Cluster)) {
-        if (Cluster == FAT_CLUSTER_FREE || Cluster >= FAT_CLUSTER_SPECIAL) {
-
-          DEBUG (
-            (EFI_D_INIT | EFI_D_ERROR,
-            "FatGrowEof: cluster chain corrupt\n")
-            );
-          Status = EFI_VOLUME_CORRUPTED;
-          goto Done;
-        }
+      Status = EFI_VOLUME_CORRUPTED;
+      if (CurSize != 0) {
+        Status = FatGetExtentCluster (OFile, CurSize - 1, &Cluster, &RunCount);
+      }
 
-        ClusterCount++;
-        OFile->FileLastCluster  = Cluster;
-        Cluster                 = FatGetFatEntry (Volume, Cluster);
+      if (EFI_ERROR (Status) || FAT_END_OF_FAT_CHAIN (Cluster)) {
+        DEBUG (
+          (EFI_D_INIT | EFI_D_ERROR,
+          "FatGrowEof: cluster chain corrupt\n")
+          );
+        Status = EFI_VOLUME_CORRUPTED;
+        goto Done;
       }
 
-      if (ClusterCount != CurSize) {
+      OFile->FileLastCluster = Cluster;
+      if (!FAT_END_OF_FAT_CHAIN (FatGetFatEntry (Volume, Cluster))) {
         DEBUG (
           (EFI_D_INIT | EFI_D_ERROR,
           "FatGrowEof: cluster chain size does not match file size\n")
@@ -497,8 +869,12 @@ FatGrowEof (
     //
     LastCluster = OFile->FileLastCluster;
 
+    if (Volume->FreeBitmap == NULL) {
+      FatBuildFreeBitmap (Volume);
+    }
+
     while (CurSize < NewSize) {
-      NewCluster = FatAllocateCluster (Volume);
+      NewCluster = FatAllocateCluster (Volume, LastCluster, NewSize - CurSize);
       if (FAT_END_OF_FAT_CHAIN (NewCluster)) {
         if (LastCluster != FAT_CLUSTER_FREE) {
           FatSetFatEntry (Volume, LastCluster, (UINTN) FAT_CLUSTER_LAST);
@@ -556,10 +932,12 @@ FatOFilePosition (
   )
 {
   FAT_VOLUME  *Volume;
+  EFI_STATUS  Status;
   UINTN       ClusterSize;
   UINTN       Cluster;
   UINTN       StartPos;
   UINTN       Run;
+  UINTN       RunCount;
 
   Volume      = OFile->Volume;
   ClusterSize = Volume->ClusterSize;
@@ -575,34 +953,17 @@ FatOFilePosition (
     Run             = OFile->FileSize - Position;
   } else {
     //
-    // Run the file's cluster chain to find the current position
-    // If possible, run from the current cluster rather than
-    // start from beginning
-    // Assumption: OFile->Position is always consistent with
-    // OFile->FileCurrentCluster.
-    // OFile->Position is not modified outside this function;
-    // OFile->FileCurrentCluster is modified outside this function
-    // to be the same as OFile->FileCluster
-    // when OFile->FileCluster is updated, so make a check of this
-    // and invalidate the original OFile->Position in this case
+    // Look up the cluster of the current position in the cached runs of the
+    // file's cluster chain, which also gives the number of consecutive
+    // clusters from it. The cluster chain is only walked past the cached runs.
     //
-    Cluster     = OFile->FileCurrentCluster;
-    StartPos    = OFile->Position;
-    if (Position < StartPos || OFile->FileCluster == Cluster) {
-      StartPos  = 0;
-      Cluster   = OFile->FileCluster;
-    }
-
-    while (StartPos + ClusterSize <= Position) {
-      StartPos += ClusterSize;
-      if (Cluster == FAT_CLUSTER_FREE || (Cluster >= FAT_CLUSTER_SPECIAL)) {
-        DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
-        return EFI_VOLUME_CORRUPTED;
-      }
-
-      Cluster = FatGetFatEntry (Volume, Cluster);
+    Status = FatGetExtentCluster (OFile, Position >> Volume->ClusterAlignment, &Cluster, &RunCount);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
+      return Status;
     }
 
+    StartPos = Position & ~(ClusterSize - 1);
     if (Cluster < FAT_MIN_CLUSTER) {
       return EFI_VOLUME_CORRUPTED;
     }
@@ -616,13 +977,11 @@ FatOFilePosition (
     //
     // Compute the number of consecutive clusters in the file
     //
-    Run = StartPos + ClusterSize - Position;
-    if (!FAT_END_OF_FAT_CHAIN (Cluster)) {
-      while ((FatGetFatEntry (Volume, Cluster) == Cluster + 1) && Run < PosLimit) {
-        Run     += ClusterSize;
-        Cluster += 1;
-      }
+    if (RunCount - 1 > (PosLimit >> Volume->ClusterAlignment)) {
+      RunCount = (PosLimit >> Volume->ClusterAlignment) + 1;
     }
+
+    Run = StartPos + ClusterSize - Position + (RunCount - 1) * ClusterSize;
   }
 
   OFile->PosRem = Run;
@@ -468,8 +468,21 @@ FatFreeVolume (
   // Free disk cache
   //
   if (Volume->CacheBuffer != NULL) {
+    DEBUG ((
+      DEBUG_INFO,
+      "FatFreeVolume: Data cache %ld hits, %ld misses, %ld pages read ahead. FAT cache %ld hits, %ld misses\n",
+      Volume->DiskCache[CacheData].HitCount,
+      Volume->DiskCache[CacheData].MissCount,
+      Volume->DiskCache[CacheData].ReadAheadCount,
+      Volume->DiskCache[CacheFat].HitCount,
+      Volume->DiskCache[CacheFat].MissCount
+      ));
     FreePool (Volume->CacheBuffer);
   }
+
+  if (Volume->FreeBitmap != NULL) {
+    FreePool (Volume->FreeBitmap);
+  }
   //
   // Free directory cache
   //
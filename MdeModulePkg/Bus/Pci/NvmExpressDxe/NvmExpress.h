@@ -3,7 +3,7 @@
   NVM Express specification.
 
   (C) Copyright 2016 Hewlett Packard Enterprise Development LP<BR>
-  Copyright (c) 2013 - 2017, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2013 - 2018, Intel Corporation. All rights reserved.<BR>
   This program and the accompanying materials
   are licensed and made available under the terms and conditions of the BSD License
   which accompanies this distribution.  The full text of the license may be found at
@@ -64,8 +64,22 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 #define NVME_ASQ_SIZE                             1     // Number of admin submission queue entries, which is 0-based
 #define NVME_ACQ_SIZE                             1     // Number of admin completion queue entries, which is 0-based
 
-#define NVME_CSQ_SIZE                             1     // Number of I/O submission queue entries, which is 0-based
-#define NVME_CCQ_SIZE                             1     // Number of I/O completion queue entries, which is 0-based
+#define NVME_CSQ_SIZE                             15    // Number of I/O submission queue entries, which is 0-based
+#define NVME_CCQ_SIZE                             15    // Number of I/O completion queue entries, which is 0-based
+
+//
+// The largest transfer of a command sent through the synchronous I/O queue by
+// NvmeSyncIoPassThru(). Such a transfer spans at most 257 memory pages, so its
+// PRP entries fit in the single PRP list page pre-allocated for each entry of
+// the synchronous I/O submission queue.
+//
+#define NVME_SYNC_MAX_TRANSFER_SIZE               SIZE_1MB
+
+//
+// Number of pages of the buffer holding the admin & I/O queues, followed by the
+// PRP lists of the synchronous I/O queue.
+//
+#define NVME_BUFFER_PAGES                         (6 + NVME_CSQ_SIZE + 1)
 
 //
 // Number of asynchronous I/O submission queue entries, which is 0-based.
@@ -121,13 +135,15 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   NVME_ADMIN_CONTROLLER_DATA          *ControllerData;
 
   //
-  // 6 x 4kB aligned buffers will be carved out of this buffer.
+  // NVME_BUFFER_PAGES x 4kB aligned buffers will be carved out of this buffer.
   // 1st 4kB boundary is the start of the admin submission queue.
   // 2nd 4kB boundary is the start of the admin completion queue.
   // 3rd 4kB boundary is the start of I/O submission queue #1.
   // 4th 4kB boundary is the start of I/O completion queue #1.
   // 5th 4kB boundary is the start of I/O submission queue #2.
   // 6th 4kB boundary is the start of I/O completion queue #2.
+  // The following 4kB boundaries are the start of the PRP lists of the
+  // commands in flight in I/O submission queue #1.
   //
   UINT8                               *Buffer;
   UINT8                               *BufferPciAddr;
@@ -147,6 +163,11 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   NVME_CQHDBL                         CqHdbl[NVME_MAX_QUEUES];
   UINT16                              AsyncSqHead;
 
+  //
+  // Number of entries of the synchronous I/O queues, which is 0-based.
+  //
+  UINT16                              SyncQueueSize;
+
   UINT8                               Pt[NVME_MAX_QUEUES];
   UINT16                              Cid[NVME_MAX_QUEUES];
 
@@ -308,6 +329,16 @@ typedef struct {
       NVME_PASS_THRU_ASYNC_REQ_SIG                       \
       )
 
+//
+// A command in flight in the synchronous I/O queue, sent by
+// NvmeSyncIoPassThru().
+//
+typedef struct {
+  EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET *Packet;
+  UINT16                                   CommandId;
+  VOID                                     *MapData;
+} NVME_SYNC_IO_SLOT;
+
 /**
   Retrieves a Unicode string that is the user readable name of the driver.
 
@@ -722,6 +753,37 @@ NvmeDumpStatus (
   IN NVME_CQ             *Cq
   );
 
+/**
+  Sends NVM Express I/O Command Packets to a namespace through the synchronous
+  I/O queue, and waits for all of them to complete. Up to Private->SyncQueueSize
+  commands are kept in flight, so that the controller can process the commands
+  of a large transfer in parallel.
+
+  The packets must not have metadata, and must transfer no more than
+  NVME_SYNC_MAX_TRANSFER_SIZE bytes each.
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]     NamespaceId         The namespace ID the packets are sent to.
+  @param[in,out] Packets             The array of NVM Express Command Packets.
+  @param[in]     PacketCount         The number of packets in Packets.
+
+  @retval EFI_SUCCESS                All the packets were sent and completed successfully.
+  @retval EFI_INVALID_PARAMETER      The contents of a packet are invalid.
+  @retval EFI_OUT_OF_RESOURCES       The data buffer of a packet couldn't be mapped.
+  @retval EFI_DEVICE_ERROR           A packet completed with an error. Its completion is returned
+                                     in its NvmeCompletion. No more packets are sent after it.
+  @retval EFI_TIMEOUT                A timeout occurred while waiting for the packets to execute.
+                                     The controller is reset.
+
+**/
+EFI_STATUS
+NvmeSyncIoPassThru (
+  IN     NVME_CONTROLLER_PRIVATE_DATA                *Private,
+  IN     UINT32                                      NamespaceId,
+  IN OUT EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packets,
+  IN     UINTN                                       PacketCount
+  );
+
 /**
   Register the shutdown notification through the ResetNotification protocol.
 
@@ -2,7 +2,7 @@
   NvmExpressDxe driver is used to manage non-volatile memory subsystem which follows
   NVM Express specification.
 
-  Copyright (c) 2013 - 2016, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2013 - 2018, Intel Corporation. All rights reserved.<BR>
   This program and the accompanying materials
   are licensed and made available under the terms and conditions of the BSD License
   which accompanies this distribution.  The full text of the license may be found at
@@ -147,6 +147,100 @@ WriteSectors (
   return Status;
 }
 
+/**
+  Read or write some blocks of the device with a sequence of commands, which
+  are kept in flight together in the synchronous I/O queue.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Buffer                 The buffer of the data read from or written to the device.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+  @param  TransferBlocks         The maximum block number transferred by each command.
+  @param  IsWrite                Indicates whether the blocks are written.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval EFI_OUT_OF_RESOURCES   The commands couldn't be allocated.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+PipelinedTransferSectors (
+  IN NVME_DEVICE_PRIVATE_DATA           *Device,
+  IN UINT64                             Buffer,
+  IN UINT64                             Lba,
+  IN UINTN                              Blocks,
+  IN UINT32                             TransferBlocks,
+  IN BOOLEAN                            IsWrite
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA             *Private;
+  EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET *CommandPackets;
+  EFI_NVM_EXPRESS_COMMAND                  *Commands;
+  EFI_NVM_EXPRESS_COMPLETION               *Completions;
+  EFI_STATUS                               Status;
+  UINT32                                   BlockSize;
+  UINT32                                   Count;
+  UINTN                                    PacketCount;
+  UINTN                                    Index;
+
+  Private     = Device->Controller;
+  BlockSize   = Device->Media.BlockSize;
+  PacketCount = (Blocks + TransferBlocks - 1) / TransferBlocks;
+
+  CommandPackets = AllocateZeroPool (PacketCount * sizeof (EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
+  Commands       = AllocateZeroPool (PacketCount * sizeof (EFI_NVM_EXPRESS_COMMAND));
+  Completions    = AllocateZeroPool (PacketCount * sizeof (EFI_NVM_EXPRESS_COMPLETION));
+  if ((CommandPackets == NULL) || (Commands == NULL) || (Completions == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  for (Index = 0; Index < PacketCount; Index++) {
+    Count = (UINT32) MIN (Blocks, TransferBlocks);
+
+    CommandPackets[Index].NvmeCmd        = &Commands[Index];
+    CommandPackets[Index].NvmeCompletion = &Completions[Index];
+    CommandPackets[Index].TransferBuffer = (VOID *)(UINTN)Buffer;
+    CommandPackets[Index].TransferLength = Count * BlockSize;
+    CommandPackets[Index].CommandTimeout = NVME_GENERIC_TIMEOUT;
+    CommandPackets[Index].QueueType      = NVME_IO_QUEUE;
+
+    Commands[Index].Nsid  = Device->NamespaceId;
+    Commands[Index].Cdw10 = (UINT32)Lba;
+    Commands[Index].Cdw11 = (UINT32)RShiftU64(Lba, 32);
+    Commands[Index].Flags = CDW10_VALID | CDW11_VALID | CDW12_VALID;
+    if (IsWrite) {
+      Commands[Index].Cdw0.Opcode = NVME_IO_WRITE_OPC;
+      //
+      // Set Force Unit Access bit (bit 30) to use write-through behaviour
+      //
+      Commands[Index].Cdw12       = ((Count - 1) & 0xFFFF) | BIT30;
+    } else {
+      Commands[Index].Cdw0.Opcode = NVME_IO_READ_OPC;
+      Commands[Index].Cdw12       = (Count - 1) & 0xFFFF;
+    }
+
+    Blocks -= Count;
+    Buffer += MultU64x32 (Count, BlockSize);
+    Lba    += Count;
+  }
+
+  Status = NvmeSyncIoPassThru (Private, Device->NamespaceId, CommandPackets, PacketCount);
+
+Exit:
+  if (CommandPackets != NULL) {
+    FreePool (CommandPackets);
+  }
+  if (Commands != NULL) {
+    FreePool (Commands);
+  }
+  if (Completions != NULL) {
+    FreePool (Completions);
+  }
+
+  return Status;
+}
+
 /**
   Read some blocks from the device.
 
@@ -171,6 +265,7 @@ NvmeRead (
   UINT32                           BlockSize;
   NVME_CONTROLLER_PRIVATE_DATA     *Private;
   UINT32                           MaxTransferBlocks;
+  UINT32                           PipelineBlocks;
   UINTN                            OrginalBlocks;
   BOOLEAN                          IsEmpty;
   EFI_TPL                          OldTpl;
@@ -201,7 +296,19 @@ NvmeRead (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
+  //
+  // A transfer which needs more than one command is split into commands which
+  // are kept in flight together, instead of waiting for each one in turn.
+  //
+  PipelineBlocks = MIN (MaxTransferBlocks, NVME_SYNC_MAX_TRANSFER_SIZE / BlockSize);
+  if ((PipelineBlocks != 0) && (Blocks > PipelineBlocks)) {
+    Status = PipelinedTransferSectors (Device, (UINT64)(UINTN)Buffer, Lba, Blocks, PipelineBlocks, FALSE);
+    if (!EFI_ERROR (Status)) {
+      Blocks = 0;
+    }
+  }
+
+  while (!EFI_ERROR (Status) && (Blocks > 0)) {
     if (Blocks > MaxTransferBlocks) {
       Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
 
@@ -249,6 +356,7 @@ NvmeWrite (
   UINT32                           BlockSize;
   NVME_CONTROLLER_PRIVATE_DATA     *Private;
   UINT32                           MaxTransferBlocks;
+  UINT32                           PipelineBlocks;
   UINTN                            OrginalBlocks;
   BOOLEAN                          IsEmpty;
   EFI_TPL                          OldTpl;
@@ -279,7 +387,19 @@ NvmeWrite (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
+  //
+  // A transfer which needs more than one command is split into commands which
+  // are kept in flight together, instead of waiting for each one in turn.
+  //
+  PipelineBlocks = MIN (MaxTransferBlocks, NVME_SYNC_MAX_TRANSFER_SIZE / BlockSize);
+  if ((PipelineBlocks != 0) && (Blocks > PipelineBlocks)) {
+    Status = PipelinedTransferSectors (Device, (UINT64)(UINTN)Buffer, Lba, Blocks, PipelineBlocks, TRUE);
+    if (!EFI_ERROR (Status)) {
+      Blocks = 0;
+    }
+  }
+
+  while (!EFI_ERROR (Status) && (Blocks > 0)) {
     if (Blocks > MaxTransferBlocks) {
       Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
 
@@ -2,7 +2,7 @@
   NvmExpressDxe driver is used to manage non-volatile memory subsystem which follows
   NVM Express specification.
 
-  Copyright (c) 2013 - 2017, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2013 - 2018, Intel Corporation. All rights reserved.<BR>
   This program and the accompanying materials
   are licensed and made available under the terms and conditions of the BSD License
   which accompanies this distribution.  The full text of the license may be found at
@@ -711,7 +711,7 @@ NvmeCreateIoCompletionQueue (
     CommandPacket.QueueType      = NVME_ADMIN_QUEUE;
 
     if (Index == 1) {
-      QueueSize = NVME_CCQ_SIZE;
+      QueueSize = Private->SyncQueueSize;
     } else {
       if (Private->Cap.Mqes > NVME_ASYNC_CCQ_SIZE) {
         QueueSize = NVME_ASYNC_CCQ_SIZE;
@@ -780,7 +780,7 @@ NvmeCreateIoSubmissionQueue (
     CommandPacket.QueueType      = NVME_ADMIN_QUEUE;
 
     if (Index == 1) {
-      QueueSize = NVME_CSQ_SIZE;
+      QueueSize = Private->SyncQueueSize;
     } else {
       if (Private->Cap.Mqes > NVME_ASYNC_CSQ_SIZE) {
         QueueSize = NVME_ASYNC_CSQ_SIZE;
@@ -915,6 +915,12 @@ NvmeControllerInit (
   Private->CqHdbl[2].Cqh = 0;
   Private->AsyncSqHead   = 0;
 
+  //
+  // Keep the synchronous I/O queues within the maximum queue size supported
+  // by the controller.
+  //
+  Private->SyncQueueSize = MIN (NVME_CSQ_SIZE, Private->Cap.Mqes);
+
   Status = NvmeDisableController (Private);
 
   if (EFI_ERROR(Status)) {
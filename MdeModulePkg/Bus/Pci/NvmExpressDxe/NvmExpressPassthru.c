@@ -409,6 +409,57 @@ AbortAsyncPassThruTasks (
   return Status;
 }
 
+/**
+  Reset the NVM Express controller after a timeout occurs for a command, to
+  abort the outstanding commands.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+  @retval EFI_TIMEOUT       The controller is reset.
+  @return Others            Fail to reset the controller.
+
+**/
+EFI_STATUS
+NvmeResetOnTimeout (
+  IN NVME_CONTROLLER_PRIVATE_DATA    *Private
+  )
+{
+  EFI_STATUS                Status;
+
+  //
+  // Disable the timer to trigger the process of async transfers temporarily.
+  //
+  Status = gBS->SetTimer (Private->TimerEvent, TimerCancel, 0);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Reset the NVMe controller.
+  //
+  Status = NvmeControllerInit (Private);
+  if (!EFI_ERROR (Status)) {
+    Status = AbortAsyncPassThruTasks (Private);
+    if (!EFI_ERROR (Status)) {
+      //
+      // Re-enable the timer to trigger the process of async transfers.
+      //
+      Status = gBS->SetTimer (Private->TimerEvent, TimerPeriodic, NVME_HC_ASYNC_TIMER);
+      if (!EFI_ERROR (Status)) {
+        //
+        // Return EFI_TIMEOUT to indicate a timeout occurs for NVMe PassThru command.
+        //
+        Status = EFI_TIMEOUT;
+      }
+    }
+  } else {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  return Status;
+}
+
 
 /**
   Sends an NVM Express Command Packet to an NVM Express controller or namespace. This function supports
@@ -696,6 +747,9 @@ NvmExpressPassThru (
   if ((Event != NULL) && (QueueId != 0)) {
     Private->SqTdbl[QueueId].Sqt =
       (Private->SqTdbl[QueueId].Sqt + 1) % (NVME_ASYNC_CSQ_SIZE + 1);
+  } else if (QueueId != 0) {
+    Private->SqTdbl[QueueId].Sqt =
+      (Private->SqTdbl[QueueId].Sqt + 1) % (Private->SyncQueueSize + 1);
   } else {
     Private->SqTdbl[QueueId].Sqt ^= 1;
   }
@@ -796,40 +850,17 @@ NvmExpressPassThru (
     //
     DEBUG ((DEBUG_ERROR, "NvmExpressPassThru: Timeout occurs for an NVMe command.\n"));
 
-    //
-    // Disable the timer to trigger the process of async transfers temporarily.
-    //
-    Status = gBS->SetTimer (Private->TimerEvent, TimerCancel, 0);
-    if (EFI_ERROR (Status)) {
-      goto EXIT;
-    }
-
-    //
-    // Reset the NVMe controller.
-    //
-    Status = NvmeControllerInit (Private);
-    if (!EFI_ERROR (Status)) {
-      Status = AbortAsyncPassThruTasks (Private);
-      if (!EFI_ERROR (Status)) {
-        //
-        // Re-enable the timer to trigger the process of async transfers.
-        //
-        Status = gBS->SetTimer (Private->TimerEvent, TimerPeriodic, NVME_HC_ASYNC_TIMER);
-        if (!EFI_ERROR (Status)) {
-          //
-          // Return EFI_TIMEOUT to indicate a timeout occurs for NVMe PassThru command.
-          //
-          Status = EFI_TIMEOUT;
-        }
-      }
-    } else {
-      Status = EFI_DEVICE_ERROR;
-    }
-
+    Status = NvmeResetOnTimeout (Private);
     goto EXIT;
   }
 
-  if ((Private->CqHdbl[QueueId].Cqh ^= 1) == 0) {
+  if (QueueId != 0) {
+    Private->CqHdbl[QueueId].Cqh =
+      (Private->CqHdbl[QueueId].Cqh + 1) % (Private->SyncQueueSize + 1);
+    if (Private->CqHdbl[QueueId].Cqh == 0) {
+      Private->Pt[QueueId] ^= 1;
+    }
+  } else if ((Private->CqHdbl[QueueId].Cqh ^= 1) == 0) {
     Private->Pt[QueueId] ^= 1;
   }
 
@@ -888,6 +919,338 @@ EXIT:
   return Status;
 }
 
+/**
+  Place an NVM Express I/O Command Packet in the synchronous I/O submission
+  queue. The doorbell is not rung.
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]     NamespaceId         The namespace ID the packet is sent to.
+  @param[in,out] Packet              The NVM Express Command Packet.
+  @param[in]     SlotIndex           The index of the slot the command is tracked in. It selects
+                                     the pre-allocated PRP list of the command.
+  @param[out]    Slot                The slot the command is tracked in.
+
+  @retval EFI_SUCCESS                The command is placed in the submission queue.
+  @retval EFI_INVALID_PARAMETER      The contents of the packet are invalid.
+  @retval EFI_OUT_OF_RESOURCES       The data buffer of the packet couldn't be mapped.
+
+**/
+STATIC
+EFI_STATUS
+NvmeSubmitSyncIoCommand (
+  IN     NVME_CONTROLLER_PRIVATE_DATA                *Private,
+  IN     UINT32                                      NamespaceId,
+  IN OUT EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packet,
+  IN     UINTN                                       SlotIndex,
+     OUT NVME_SYNC_IO_SLOT                           *Slot
+  )
+{
+  EFI_STATUS                     Status;
+  EFI_PCI_IO_PROTOCOL            *PciIo;
+  NVME_SQ                        *Sq;
+  EFI_PCI_IO_PROTOCOL_OPERATION  Flag;
+  EFI_PHYSICAL_ADDRESS           PhyAddr;
+  UINTN                          MapLength;
+  UINT64                         *PrpList;
+  UINTN                          PrpListOffset;
+  UINTN                          Pages;
+  UINTN                          Index;
+  UINT16                         Offset;
+
+  if ((Packet->NvmeCmd == NULL) || (Packet->NvmeCompletion == NULL) ||
+      (Packet->QueueType != NVME_IO_QUEUE) || (Packet->NvmeCmd->Nsid != NamespaceId) ||
+      (Packet->TransferLength > NVME_SYNC_MAX_TRANSFER_SIZE) ||
+      (Packet->MetadataLength != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  PciIo = Private->PciIo;
+  Sq    = Private->SqBuffer[1] + Private->SqTdbl[1].Sqt;
+
+  ZeroMem (Sq, sizeof (NVME_SQ));
+  Sq->Opc  = (UINT8)Packet->NvmeCmd->Cdw0.Opcode;
+  Sq->Fuse = (UINT8)Packet->NvmeCmd->Cdw0.FusedOperation;
+  Sq->Cid  = Private->Cid[1]++;
+  Sq->Nsid = Packet->NvmeCmd->Nsid;
+
+  Slot->Packet    = Packet;
+  Slot->CommandId = Sq->Cid;
+  Slot->MapData   = NULL;
+
+  if ((Sq->Opc & (BIT0 | BIT1)) != 0) {
+    if ((Packet->TransferLength == 0) || (Packet->TransferBuffer == NULL)) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if ((Sq->Opc & BIT0) != 0) {
+      Flag = EfiPciIoOperationBusMasterRead;
+    } else {
+      Flag = EfiPciIoOperationBusMasterWrite;
+    }
+
+    MapLength = Packet->TransferLength;
+    Status = PciIo->Map (
+                      PciIo,
+                      Flag,
+                      Packet->TransferBuffer,
+                      &MapLength,
+                      &PhyAddr,
+                      &Slot->MapData
+                      );
+    if (EFI_ERROR (Status) || (Packet->TransferLength != MapLength)) {
+      if (!EFI_ERROR (Status)) {
+        PciIo->Unmap (PciIo, Slot->MapData);
+      }
+      Slot->MapData = NULL;
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Sq->Prp[0] = PhyAddr;
+
+    //
+    // If the buffer spans more than two memory pages, fill the PRP list
+    // pre-allocated for this slot, which is large enough for a transfer of
+    // NVME_SYNC_MAX_TRANSFER_SIZE.
+    //
+    Offset = ((UINT16)Sq->Prp[0]) & (EFI_PAGE_SIZE - 1);
+    if ((Offset + Packet->TransferLength) > (EFI_PAGE_SIZE * 2)) {
+      Pages = EFI_SIZE_TO_PAGES (Offset + Packet->TransferLength) - 1;
+      ASSERT (Pages <= EFI_PAGE_SIZE / sizeof (UINT64));
+
+      PrpListOffset = EFI_PAGES_TO_SIZE (6 + SlotIndex);
+      PrpList       = (UINT64 *)(Private->Buffer + PrpListOffset);
+      PhyAddr       = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
+      for (Index = 0; Index < Pages; Index++) {
+        PrpList[Index] = PhyAddr;
+        PhyAddr       += EFI_PAGE_SIZE;
+      }
+
+      Sq->Prp[1] = (UINT64)(UINTN)(Private->BufferPciAddr + PrpListOffset);
+    } else if ((Offset + Packet->TransferLength) > EFI_PAGE_SIZE) {
+      Sq->Prp[1] = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
+    }
+  }
+
+  if(Packet->NvmeCmd->Flags & CDW2_VALID) {
+    Sq->Rsvd2 = (UINT64)Packet->NvmeCmd->Cdw2;
+  }
+  if(Packet->NvmeCmd->Flags & CDW3_VALID) {
+    Sq->Rsvd2 |= LShiftU64 ((UINT64)Packet->NvmeCmd->Cdw3, 32);
+  }
+  if(Packet->NvmeCmd->Flags & CDW10_VALID) {
+    Sq->Payload.Raw.Cdw10 = Packet->NvmeCmd->Cdw10;
+  }
+  if(Packet->NvmeCmd->Flags & CDW11_VALID) {
+    Sq->Payload.Raw.Cdw11 = Packet->NvmeCmd->Cdw11;
+  }
+  if(Packet->NvmeCmd->Flags & CDW12_VALID) {
+    Sq->Payload.Raw.Cdw12 = Packet->NvmeCmd->Cdw12;
+  }
+  if(Packet->NvmeCmd->Flags & CDW13_VALID) {
+    Sq->Payload.Raw.Cdw13 = Packet->NvmeCmd->Cdw13;
+  }
+  if(Packet->NvmeCmd->Flags & CDW14_VALID) {
+    Sq->Payload.Raw.Cdw14 = Packet->NvmeCmd->Cdw14;
+  }
+  if(Packet->NvmeCmd->Flags & CDW15_VALID) {
+    Sq->Payload.Raw.Cdw15 = Packet->NvmeCmd->Cdw15;
+  }
+
+  Private->SqTdbl[1].Sqt = (Private->SqTdbl[1].Sqt + 1) % (Private->SyncQueueSize + 1);
+  return EFI_SUCCESS;
+}
+
+/**
+  Sends NVM Express I/O Command Packets to a namespace through the synchronous
+  I/O queue, and waits for all of them to complete. Up to Private->SyncQueueSize
+  commands are kept in flight, so that the controller can process the commands
+  of a large transfer in parallel.
+
+  The packets must not have metadata, and must transfer no more than
+  NVME_SYNC_MAX_TRANSFER_SIZE bytes each.
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]     NamespaceId         The namespace ID the packets are sent to.
+  @param[in,out] Packets             The array of NVM Express Command Packets.
+  @param[in]     PacketCount         The number of packets in Packets.
+
+  @retval EFI_SUCCESS                All the packets were sent and completed successfully.
+  @retval EFI_INVALID_PARAMETER      The contents of a packet are invalid.
+  @retval EFI_OUT_OF_RESOURCES       The data buffer of a packet couldn't be mapped.
+  @retval EFI_DEVICE_ERROR           A packet completed with an error. Its completion is returned
+                                     in its NvmeCompletion. No more packets are sent after it.
+  @retval EFI_TIMEOUT                A timeout occurred while waiting for the packets to execute.
+                                     The controller is reset.
+
+**/
+EFI_STATUS
+NvmeSyncIoPassThru (
+  IN     NVME_CONTROLLER_PRIVATE_DATA                *Private,
+  IN     UINT32                                      NamespaceId,
+  IN OUT EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packets,
+  IN     UINTN                                       PacketCount
+  )
+{
+  EFI_STATUS                     Status;
+  EFI_STATUS                     WriteStatus;
+  EFI_PCI_IO_PROTOCOL            *PciIo;
+  NVME_SYNC_IO_SLOT              Slots[NVME_CSQ_SIZE + 1];
+  NVME_CQ                        *Cq;
+  EFI_EVENT                      TimerEvent;
+  UINTN                          Submitted;
+  UINTN                          InFlight;
+  UINTN                          Index;
+  BOOLEAN                        Reaped;
+  UINT32                         Data;
+
+  PciIo = Private->PciIo;
+  ZeroMem (Slots, sizeof (Slots));
+
+  if (PacketCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER,
+                  TPL_CALLBACK,
+                  NULL,
+                  NULL,
+                  &TimerEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Submitted = 0;
+  InFlight  = 0;
+
+  while (TRUE) {
+    //
+    // Fill the submission queue, and ring the doorbell once for all the new
+    // commands. No more commands are sent after an error.
+    //
+    if (!EFI_ERROR (Status) && (Submitted < PacketCount) && (InFlight < Private->SyncQueueSize)) {
+      for (Index = 0; Index <= Private->SyncQueueSize; Index++) {
+        if (Slots[Index].Packet != NULL) {
+          continue;
+        }
+
+        Status = NvmeSubmitSyncIoCommand (Private, NamespaceId, &Packets[Submitted], Index, &Slots[Index]);
+        if (EFI_ERROR (Status)) {
+          Slots[Index].Packet = NULL;
+          break;
+        }
+
+        Submitted++;
+        InFlight++;
+        if ((Submitted == PacketCount) || (InFlight == Private->SyncQueueSize)) {
+          break;
+        }
+      }
+
+      Data        = ReadUnaligned32 ((UINT32*)&Private->SqTdbl[1]);
+      WriteStatus = PciIo->Mem.Write (
+                                 PciIo,
+                                 EfiPciIoWidthUint32,
+                                 NVME_BAR,
+                                 NVME_SQTDBL_OFFSET(1, Private->Cap.Dstrd),
+                                 1,
+                                 &Data
+                                 );
+      if (!EFI_ERROR (Status)) {
+        Status = WriteStatus;
+      }
+
+      gBS->SetTimer (TimerEvent, TimerRelative, Packets[0].CommandTimeout);
+    }
+
+    if (InFlight == 0) {
+      break;
+    }
+
+    //
+    // Wait for at least one completion, then reap all the completed commands.
+    //
+    Reaped = FALSE;
+    while (!Reaped) {
+      Cq = Private->CqBuffer[1] + Private->CqHdbl[1].Cqh;
+      while (Cq->Pt != Private->Pt[1]) {
+        for (Index = 0; Index <= Private->SyncQueueSize; Index++) {
+          if ((Slots[Index].Packet != NULL) && (Slots[Index].CommandId == Cq->Cid)) {
+            break;
+          }
+        }
+
+        if (Index <= Private->SyncQueueSize) {
+          if ((Cq->Sct != 0) || (Cq->Sc != 0)) {
+            //
+            // Copy the Respose Queue entry for this command to the callers response buffer
+            //
+            CopyMem (Slots[Index].Packet->NvmeCompletion, Cq, sizeof (EFI_NVM_EXPRESS_COMPLETION));
+            DEBUG_CODE_BEGIN();
+              NvmeDumpStatus (Cq);
+            DEBUG_CODE_END();
+            Status = EFI_DEVICE_ERROR;
+          }
+
+          if (Slots[Index].MapData != NULL) {
+            PciIo->Unmap (PciIo, Slots[Index].MapData);
+          }
+          Slots[Index].Packet  = NULL;
+          Slots[Index].MapData = NULL;
+          InFlight--;
+        }
+
+        Private->CqHdbl[1].Cqh = (Private->CqHdbl[1].Cqh + 1) % (Private->SyncQueueSize + 1);
+        if (Private->CqHdbl[1].Cqh == 0) {
+          Private->Pt[1] ^= 1;
+        }
+
+        Reaped = TRUE;
+        Cq     = Private->CqBuffer[1] + Private->CqHdbl[1].Cqh;
+      }
+
+      if (!Reaped && !EFI_ERROR (gBS->CheckEvent (TimerEvent))) {
+        break;
+      }
+    }
+
+    if (!Reaped) {
+      DEBUG ((DEBUG_ERROR, "NvmeSyncIoPassThru: Timeout occurs for an NVMe command.\n"));
+
+      for (Index = 0; Index <= Private->SyncQueueSize; Index++) {
+        if ((Slots[Index].Packet != NULL) && (Slots[Index].MapData != NULL)) {
+          PciIo->Unmap (PciIo, Slots[Index].MapData);
+        }
+      }
+
+      Status = NvmeResetOnTimeout (Private);
+      break;
+    }
+
+    Data        = ReadUnaligned32 ((UINT32*)&Private->CqHdbl[1]);
+    WriteStatus = PciIo->Mem.Write (
+                               PciIo,
+                               EfiPciIoWidthUint32,
+                               NVME_BAR,
+                               NVME_CQHDBL_OFFSET(1, Private->Cap.Dstrd),
+                               1,
+                               &Data
+                               );
+    if (!EFI_ERROR (Status)) {
+      Status = WriteStatus;
+    }
+
+    //
+    // Restart the timeout for the commands still in flight.
+    //
+    gBS->SetTimer (TimerEvent, TimerRelative, Packets[0].CommandTimeout);
+  }
+
+  gBS->CloseEvent (TimerEvent);
+  return Status;
+}
+
 /**
   Used to retrieve the next namespace ID for this NVM Express controller.
 
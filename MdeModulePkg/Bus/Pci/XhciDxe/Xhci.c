@@ -1,7 +1,7 @@
 /** @file
   The XHCI controller driver.
 
-Copyright (c) 2011 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2011 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -756,61 +756,148 @@ XhcTransfer (
 {
   EFI_STATUS              Status;
   EFI_STATUS              RecoveryStatus;
-  URB                     *Urb;
+  URB                     *Urb[XHC_BULK_MAX_QUEUED_TD];
+  UINTN                   UrbNum;
+  UINTN                   MaxUrbNum;
+  UINTN                   Index;
+  UINTN                   Offset;
+  UINTN                   Length;
+  UINTN                   Completed;
+  UINT32                  Result;
+  BOOLEAN                 Recovered;
+  BOOLEAN                 Done;
 
   ASSERT ((Type == XHC_CTRL_TRANSFER) || (Type == XHC_BULK_TRANSFER) || (Type == XHC_INT_TRANSFER_SYNC));
-  Urb = XhcCreateUrb (
-          Xhc,
-          DeviceAddress,
-          EndPointAddress,
-          DeviceSpeed,
-          MaximumPacketLength,
-          Type,
-          Request,
-          Data,
-          *DataLength,
-          NULL,
-          NULL
-          );
 
-  if (Urb == NULL) {
-    DEBUG ((DEBUG_ERROR, "XhcTransfer[Type=%d]: failed to create URB!\n", Type));
-    return EFI_OUT_OF_RESOURCES;
+  //
+  // A bulk transfer longer than XHC_BULK_TD_MAX_LENGTH is cut into several TDs.
+  // The TDs of an OUT transfer are queued together so that the endpoint goes
+  // from one to the next without waiting for software. The TDs of an IN
+  // transfer are sent one by one, because a short packet ends the transfer and
+  // the next TD would then take data that belongs to the next transfer.
+  //
+  MaxUrbNum = 1;
+  if ((Type == XHC_BULK_TRANSFER) && ((EndPointAddress & 0x80) == 0)) {
+    MaxUrbNum = XHC_BULK_MAX_QUEUED_TD;
   }
 
-  Status = XhcExecTransfer (Xhc, FALSE, Urb, Timeout);
+  Status    = EFI_SUCCESS;
+  Result    = EFI_USB_NOERROR;
+  Completed = 0;
+  Offset    = 0;
+  Done      = FALSE;
 
-  if (Status == EFI_TIMEOUT) {
+  while (!Done) {
     //
-    // The transfer timed out. Abort the transfer by dequeueing of the TD.
+    // Put the next TDs on the transfer ring.
     //
-    RecoveryStatus = XhcDequeueTrbFromEndpoint(Xhc, Urb);
-    if (RecoveryStatus == EFI_ALREADY_STARTED) {
-      //
-      // The URB is finished just before stopping endpoint.
-      // Change returning status from EFI_TIMEOUT to EFI_SUCCESS.
-      //
-      ASSERT (Urb->Result == EFI_USB_NOERROR);
-      Status = EFI_SUCCESS;
-      DEBUG ((DEBUG_ERROR, "XhcTransfer[Type=%d]: pending URB is finished, Length = %d.\n", Type, Urb->Completed));
-    } else if (EFI_ERROR(RecoveryStatus)) {
-      DEBUG((DEBUG_ERROR, "XhcTransfer[Type=%d]: XhcDequeueTrbFromEndpoint failed!\n", Type));
+    UrbNum = 0;
+    do {
+      Length = *DataLength - Offset;
+      if ((Type == XHC_BULK_TRANSFER) && (Length > XHC_BULK_TD_MAX_LENGTH)) {
+        Length = XHC_BULK_TD_MAX_LENGTH;
+      }
+
+      Urb[UrbNum] = XhcCreateUrb (
+                      Xhc,
+                      DeviceAddress,
+                      EndPointAddress,
+                      DeviceSpeed,
+                      MaximumPacketLength,
+                      Type,
+                      Request,
+                      (Data == NULL) ? NULL : (UINT8 *) Data + Offset,
+                      Length,
+                      NULL,
+                      NULL
+                      );
+      if (Urb[UrbNum] == NULL) {
+        break;
+      }
+
+      InsertTailList (&Xhc->QueuedTransfers, &Urb[UrbNum]->UrbList);
+      Offset += Length;
+      UrbNum++;
+    } while ((UrbNum < MaxUrbNum) && (Offset < *DataLength));
+
+    if (UrbNum == 0) {
+      DEBUG ((DEBUG_ERROR, "XhcTransfer[Type=%d]: failed to create URB!\n", Type));
+      Result = EFI_USB_ERR_SYSTEM;
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
     }
-  }
 
-  *TransferResult = Urb->Result;
-  *DataLength     = Urb->Completed;
+    //
+    // Wait for the TDs in order. The events of the later ones are caught while
+    // waiting for the earlier ones, so they are usually finished already.
+    //
+    Recovered = FALSE;
+    for (Index = 0; (Index < UrbNum) && !Done; Index++) {
+      Status = XhcExecTransfer (Xhc, FALSE, Urb[Index], Timeout);
+
+      if (Status == EFI_TIMEOUT) {
+        //
+        // The transfer timed out. Abort the transfer by dequeueing of the TD.
+        // This also removes the TDs queued behind it.
+        //
+        RecoveryStatus = XhcDequeueTrbFromEndpoint(Xhc, Urb[Index]);
+        if (RecoveryStatus == EFI_ALREADY_STARTED) {
+          //
+          // The URB is finished just before stopping endpoint.
+          // Change returning status from EFI_TIMEOUT to EFI_SUCCESS.
+          //
+          ASSERT (Urb[Index]->Result == EFI_USB_NOERROR);
+          Status = EFI_SUCCESS;
+          DEBUG ((DEBUG_ERROR, "XhcTransfer[Type=%d]: pending URB is finished, Length = %d.\n", Type, Urb[Index]->Completed));
+        } else {
+          Recovered = TRUE;
+          if (EFI_ERROR(RecoveryStatus)) {
+            DEBUG((DEBUG_ERROR, "XhcTransfer[Type=%d]: XhcDequeueTrbFromEndpoint failed!\n", Type));
+          }
+        }
+      }
+
+      Result     = Urb[Index]->Result;
+      Completed += Urb[Index]->Completed;
 
-  if ((*TransferResult == EFI_USB_ERR_STALL) || (*TransferResult == EFI_USB_ERR_BABBLE)) {
-    ASSERT (Status == EFI_DEVICE_ERROR);
-    RecoveryStatus = XhcRecoverHaltedEndpoint(Xhc, Urb);
-    if (EFI_ERROR (RecoveryStatus)) {
-      DEBUG ((DEBUG_ERROR, "XhcTransfer[Type=%d]: XhcRecoverHaltedEndpoint failed!\n", Type));
+      if ((Result == EFI_USB_ERR_STALL) || (Result == EFI_USB_ERR_BABBLE)) {
+        ASSERT (Status == EFI_DEVICE_ERROR);
+        RecoveryStatus = XhcRecoverHaltedEndpoint(Xhc, Urb[Index]);
+        if (EFI_ERROR (RecoveryStatus)) {
+          DEBUG ((DEBUG_ERROR, "XhcTransfer[Type=%d]: XhcRecoverHaltedEndpoint failed!\n", Type));
+        }
+        Recovered = TRUE;
+      }
+
+      if (EFI_ERROR (Status) || (Urb[Index]->Completed < Urb[Index]->DataLen)) {
+        //
+        // The transfer ends at a failed or short TD. The TDs queued behind a
+        // failed one must not run once their buffers are unmapped.
+        //
+        if (EFI_ERROR (Status) && !Recovered && (Index + 1 < UrbNum)) {
+          RecoveryStatus = XhcRecoverHaltedEndpoint (Xhc, Urb[Index]);
+          if (EFI_ERROR (RecoveryStatus)) {
+            DEBUG ((DEBUG_ERROR, "XhcTransfer[Type=%d]: XhcRecoverHaltedEndpoint failed!\n", Type));
+          }
+        }
+        Done = TRUE;
+      }
+    }
+
+    Xhc->PciIo->Flush (Xhc->PciIo);
+    for (Index = 0; Index < UrbNum; Index++) {
+      RemoveEntryList (&Urb[Index]->UrbList);
+      XhcFreeUrb (Xhc, Urb[Index]);
+    }
+
+    if (Offset >= *DataLength) {
+      Done = TRUE;
     }
   }
 
-  Xhc->PciIo->Flush (Xhc->PciIo);
-  XhcFreeUrb (Xhc, Urb);
+  *TransferResult = Result;
+  *DataLength     = Completed;
+
   return Status;
 }
 
@@ -1787,11 +1874,13 @@ XhcCreateUsbHc (
   CopyMem (&Xhc->Usb2Hc, &gXhciUsb2HcTemplate, sizeof (EFI_USB2_HC_PROTOCOL));
 
   InitializeListHead (&Xhc->AsyncIntTransfers);
+  InitializeListHead (&Xhc->QueuedTransfers);
 
   //
   // Be caution that the Offset passed to XhcReadCapReg() should be Dword align
   //
   Xhc->CapLength        = XhcReadCapReg8 (Xhc, XHC_CAPLENGTH_OFFSET);
+  Xhc->HciVersion       = (UINT16) (XhcReadCapReg (Xhc, XHC_CAPLENGTH_OFFSET) >> 16);
   Xhc->HcSParams1.Dword = XhcReadCapReg (Xhc, XHC_HCSPARAMS1_OFFSET);
   Xhc->HcSParams2.Dword = XhcReadCapReg (Xhc, XHC_HCSPARAMS2_OFFSET);
   Xhc->HcCParams.Dword  = XhcReadCapReg (Xhc, XHC_HCCPARAMS_OFFSET);
@@ -2,7 +2,7 @@
 
   Provides some data structure definitions used by the XHCI host controller driver.
 
-Copyright (c) 2011 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2011 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -79,6 +79,14 @@ typedef struct _USB_DEV_CONTEXT      USB_DEV_CONTEXT;
 
 #define CMD_RING_TRB_NUMBER          0x100
 #define TR_RING_TRB_NUMBER           0x100
+//
+// A bulk transfer is sent as TDs of at most XHC_BULK_TD_MAX_LENGTH bytes, each
+// made of chained Normal TRBs. Up to XHC_BULK_MAX_QUEUED_TD TDs of a bulk OUT
+// transfer sit on the transfer ring at a time, so a TD needs at most 65 TRBs
+// and three of them leave room in the ring.
+//
+#define XHC_BULK_TD_MAX_LENGTH       SIZE_4MB
+#define XHC_BULK_MAX_QUEUED_TD       3
 #define ERST_NUMBER                  0x01
 #define EVENT_RING_TRB_NUMBER        0x200
 
@@ -223,8 +231,15 @@ struct _USB_XHCI_INSTANCE {
   EFI_EVENT                 ExitBootServiceEvent;
   EFI_EVENT                 PollTimer;
   LIST_ENTRY                AsyncIntTransfers;
+  //
+  // The URBs of the synchronous transfer in progress. A bulk transfer may have
+  // several TDs on the ring, and the events of all of them must be caught while
+  // waiting for the first one.
+  //
+  LIST_ENTRY                QueuedTransfers;
 
   UINT8                     CapLength;    ///< Capability Register Length
+  UINT16                    HciVersion;   ///< Interface Version Number
   XHC_HCSPARAMS1            HcSParams1;   ///< Structural Parameters 1
   XHC_HCSPARAMS2            HcSParams2;   ///< Structural Parameters 2
   XHC_HCCPARAMS             HcCParams;    ///< Capability Parameters
@@ -2,7 +2,7 @@
 
   XHCI transfer scheduling routines.
 
-Copyright (c) 2011 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2011 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -230,9 +230,12 @@ XhcCreateTransferTrb (
   UINT8                         SlotId;
   UINT8                         Dci;
   TRB                           *TrbStart;
+  LINK_TRB                      *LinkTrb;
   UINTN                         TotalLen;
   UINTN                         Len;
   UINTN                         TrbNum;
+  UINTN                         TdPacketCount;
+  UINTN                         Remainder;
   EFI_PCI_IO_PROTOCOL_OPERATION MapOp;
   EFI_PHYSICAL_ADDRESS          PhyAddr;
   VOID                          *Map;
@@ -377,33 +380,85 @@ XhcCreateTransferTrb (
 
     case ED_BULK_OUT:
     case ED_BULK_IN:
+      //
+      // The whole URB is a single TD of chained Normal TRBs, so the xHC moves
+      // from one TRB to the next without software and reports the TD once.
+      // A TRB must not cross a 64KB boundary of the buffer. Only the last TRB
+      // interrupts on completion, and a short packet ends the TD early.
+      //
       TotalLen = 0;
       Len      = 0;
       TrbNum   = 0;
+      TdPacketCount = 0;
+      if (Urb->Ep.MaxPacket != 0) {
+        TdPacketCount = (Urb->DataLen + Urb->Ep.MaxPacket - 1) / Urb->Ep.MaxPacket;
+      }
       TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
       while (TotalLen < Urb->DataLen) {
-        if ((TotalLen + 0x10000) >= Urb->DataLen) {
+        PhyAddr = (EFI_PHYSICAL_ADDRESS) (UINTN) ((UINT8 *) Urb->DataPhy + TotalLen);
+        Len     = (UINTN) (SIZE_64KB - (PhyAddr & (SIZE_64KB - 1)));
+        if (Len > Urb->DataLen - TotalLen) {
           Len = Urb->DataLen - TotalLen;
-        } else {
-          Len = 0x10000;
         }
         TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
+        //
+        // A TD may only cross the Link TRB at a packet boundary, so the TRB in
+        // front of it must end on a multiple of MaxPacket, as xhci_align_td ()
+        // does in Linux. If its first TRB is too short for that, which happens
+        // when the buffer starts just below a 64KB boundary, put a Transfer
+        // No Op TRB there instead and start the TD past the Link TRB.
+        //
+        LinkTrb = (LINK_TRB *) ((TRB_TEMPLATE *) TrbStart + 1);
+        if ((LinkTrb->Type == TRB_TYPE_LINK) && (TotalLen + Len < Urb->DataLen) &&
+            (Urb->Ep.MaxPacket != 0)) {
+          Remainder = (TotalLen + Len) % Urb->Ep.MaxPacket;
+          if (Len > Remainder) {
+            Len -= Remainder;
+          } else {
+            ASSERT (TrbNum == 0);
+            TrbStart->TrbNormal.Type     = TRB_TYPE_NO_OP;
+            TrbStart->TrbNormal.CycleBit = EPRing->RingPCS & BIT0;
+            LinkTrb->CH = 0;
+            XhcSyncTrsRing (Xhc, EPRing);
+            Urb->TrbStart = EPRing->RingEnqueue;
+            continue;
+          }
+        }
         TrbStart->TrbNormal.TRBPtrLo  = XHC_LOW_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
         TrbStart->TrbNormal.TRBPtrHi  = XHC_HIGH_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
         TrbStart->TrbNormal.Length    = (UINT32) Len;
+        TotalLen += Len;
+        //
+        // TD Size is 0 on the last TRB. Before xHCI 1.0 it is the number of
+        // bytes left after this TRB in 1KB units, since 1.0 it is the TD
+        // Packet Count minus the packets sent up to the end of this TRB.
+        //
         TrbStart->TrbNormal.TDSize    = 0;
+        if (TotalLen < Urb->DataLen) {
+          if (Xhc->HciVersion < 0x100) {
+            TrbStart->TrbNormal.TDSize = (UINT32) MIN (31, (Urb->DataLen - TotalLen) >> 10);
+          } else if (Urb->Ep.MaxPacket != 0) {
+            TrbStart->TrbNormal.TDSize = (UINT32) MIN (31, TdPacketCount - TotalLen / Urb->Ep.MaxPacket);
+          }
+        }
         TrbStart->TrbNormal.IntTarget = 0;
         TrbStart->TrbNormal.ISP       = 1;
-        TrbStart->TrbNormal.IOC       = 1;
+        TrbStart->TrbNormal.CH        = (TotalLen < Urb->DataLen) ? 1 : 0;
+        TrbStart->TrbNormal.IOC       = (TotalLen < Urb->DataLen) ? 0 : 1;
         TrbStart->TrbNormal.Type      = TRB_TYPE_NORMAL;
         //
+        // A TD that wraps around the ring carries its chain through the Link TRB.
+        //
+        if (LinkTrb->Type == TRB_TYPE_LINK) {
+          LinkTrb->CH = TrbStart->TrbNormal.CH;
+        }
+        //
         // Update the cycle bit
         //
         TrbStart->TrbNormal.CycleBit = EPRing->RingPCS & BIT0;
 
         XhcSyncTrsRing (Xhc, EPRing);
         TrbNum++;
-        TotalLen += Len;
       }
 
       Urb->TrbNum = TrbNum;
@@ -1036,19 +1091,21 @@ IsTransferRingTrb (
 }
 
 /**
-  Check if the Trb is a transaction of the URBs in XHCI's asynchronous transfer list.
+  Check if the Trb is a transaction of the URBs in a list of URBs.
 
   @param Xhc    The XHCI Instance.
+  @param List   The list of URBs, linked through UrbList.
   @param Trb    The TRB to be checked.
   @param Urb    The pointer to the matched Urb.
 
-  @retval TRUE  The Trb is matched with a transaction of the URBs in the async list.
-  @retval FALSE The Trb is not matched with any URBs in the async list.
+  @retval TRUE  The Trb is matched with a transaction of the URBs in the list.
+  @retval FALSE The Trb is not matched with any URBs in the list.
 
 **/
 BOOLEAN
-IsAsyncIntTrb (
+IsUrbListTrb (
   IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  LIST_ENTRY          *List,
   IN  TRB_TEMPLATE        *Trb,
   OUT URB                 **Urb
   )
@@ -1057,7 +1114,7 @@ IsAsyncIntTrb (
   LIST_ENTRY              *Next;
   URB                     *CheckedUrb;
 
-  EFI_LIST_FOR_EACH_SAFE (Entry, Next, &Xhc->AsyncIntTransfers) {
+  EFI_LIST_FOR_EACH_SAFE (Entry, Next, List) {
     CheckedUrb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
     if (IsTransferRingTrb (Xhc, Trb, CheckedUrb)) {
       *Urb = CheckedUrb;
@@ -1068,50 +1125,89 @@ IsAsyncIntTrb (
   return FALSE;
 }
 
-
 /**
-  Check the URB's execution result and update the URB's
-  result accordingly.
+  Get the number of bytes a bulk URB moved when its TD ended at a TRB.
+
+  A bulk URB is a single TD of chained TRBs, and the xHC only reports the TRB
+  the TD ended at. All the TRBs before that one were transferred in full.
 
   @param  Xhc             The XHCI Instance.
-  @param  Urb             The URB to check result.
+  @param  Urb             The bulk URB.
+  @param  Trb             The TRB the TD ended at.
+  @param  Residual        The number of bytes of Trb not transferred.
 
-  @return Whether the result of URB transfer is finialized.
+  @return The number of bytes transferred by the URB.
 
 **/
-BOOLEAN
-XhcCheckUrbResult (
+UINTN
+XhcGetTdCompletedLength (
   IN  USB_XHCI_INSTANCE   *Xhc,
-  IN  URB                 *Urb
+  IN  URB                 *Urb,
+  IN  TRB_TEMPLATE        *Trb,
+  IN  UINT32              Residual
+  )
+{
+  LINK_TRB                *LinkTrb;
+  TRB_TEMPLATE            *CheckedTrb;
+  UINTN                   Index;
+  UINTN                   Length;
+  EFI_PHYSICAL_ADDRESS    PhyAddr;
+
+  Length     = 0;
+  CheckedTrb = Urb->TrbStart;
+  for (Index = 0; (Index < Urb->TrbNum) && (CheckedTrb != Trb); Index++) {
+    Length += ((TRANSFER_TRB_NORMAL *) CheckedTrb)->Length;
+    CheckedTrb++;
+    if (CheckedTrb->Type == TRB_TYPE_LINK) {
+      LinkTrb = (LINK_TRB *) CheckedTrb;
+      PhyAddr = (EFI_PHYSICAL_ADDRESS)(LinkTrb->PtrLo | LShiftU64 ((UINT64) LinkTrb->PtrHi, 32));
+      CheckedTrb = (TRB_TEMPLATE *)(UINTN) UsbHcGetHostAddrForPciAddr (Xhc->MemPool, (VOID *)(UINTN) PhyAddr, sizeof (TRB_TEMPLATE));
+    }
+  }
+
+  ASSERT (CheckedTrb == Trb);
+  if (Residual < ((TRANSFER_TRB_NORMAL *) Trb)->Length) {
+    Length += ((TRANSFER_TRB_NORMAL *) Trb)->Length - Residual;
+  }
+
+  return Length;
+}
+
+/**
+  Consume the new events of the event ring and update the result of the URBs
+  they belong to.
+
+  This is the only consumer of the event ring. An event may belong to the
+  pending URB, to the URB being waited for, to any URB of the synchronous
+  transfer in progress or to an asynchronous interrupt URB, so none of them is
+  lost whichever URB the caller is waiting for.
+
+  @param  Xhc             The XHCI Instance.
+  @param  Urb             The URB being waited for, or NULL.
+
+**/
+VOID
+XhcProcessEventRing (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  URB                 *Urb  OPTIONAL
   )
 {
   EVT_TRB_TRANSFER        *EvtTrb;
   TRB_TEMPLATE            *TRBPtr;
+  TRB_TEMPLATE            *Dequeue;
   UINTN                   Index;
   UINT8                   TRBType;
   EFI_STATUS              Status;
-  URB                     *AsyncUrb;
+  URB                     *ListUrb;
   URB                     *CheckedUrb;
   UINT64                  XhcDequeue;
   UINT32                  High;
   UINT32                  Low;
   EFI_PHYSICAL_ADDRESS    PhyAddr;
 
-  ASSERT ((Xhc != NULL) && (Urb != NULL));
-
-  Status   = EFI_SUCCESS;
-  AsyncUrb = NULL;
-
-  if (Urb->Finished) {
-    goto EXIT;
-  }
-
-  EvtTrb = NULL;
-
-  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
-    Urb->Result |= EFI_USB_ERR_SYSTEM;
-    goto EXIT;
-  }
+  EvtTrb  = NULL;
+  ListUrb = NULL;
+  Dequeue = Xhc->EventRing.EventRingDequeue;
 
   //
   // Traverse the event ring to find out all new events from the previous check.
@@ -1141,16 +1237,19 @@ XhcCheckUrbResult (
 
     //
     // Update the status of URB including the pending URB, the URB that is currently checked,
-    // and URBs in the XHCI's async interrupt transfer list.
-    // This way is used to avoid that those completed async transfer events don't get
+    // the URBs of the synchronous transfer in progress and URBs in the XHCI's async interrupt
+    // transfer list.
+    // This way is used to avoid that those completed transfer events don't get
     // handled in time and are flushed by newer coming events.
     //
     if (Xhc->PendingUrb != NULL && IsTransferRingTrb (Xhc, TRBPtr, Xhc->PendingUrb)) {
       CheckedUrb = Xhc->PendingUrb;
-    } else if (IsTransferRingTrb (Xhc, TRBPtr, Urb)) {
+    } else if ((Urb != NULL) && IsTransferRingTrb (Xhc, TRBPtr, Urb)) {
       CheckedUrb = Urb;
-    } else if (IsAsyncIntTrb (Xhc, TRBPtr, &AsyncUrb)) {    
-      CheckedUrb = AsyncUrb;
+    } else if (IsUrbListTrb (Xhc, &Xhc->QueuedTransfers, TRBPtr, &ListUrb)) {
+      CheckedUrb = ListUrb;
+    } else if (IsUrbListTrb (Xhc, &Xhc->AsyncIntTransfers, TRBPtr, &ListUrb)) {
+      CheckedUrb = ListUrb;
     } else {
       continue;
     }
@@ -1183,6 +1282,15 @@ XhcCheckUrbResult (
       case TRB_COMPLETION_STOPPED:
       case TRB_COMPLETION_STOPPED_LENGTH_INVALID:
         CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
+        if ((EvtTrb->Completecode == TRB_COMPLETION_STOPPED) &&
+            (CheckedUrb->Ep.Type == XHC_BULK_TRANSFER) &&
+            (TRBPtr->Type == TRB_TYPE_NORMAL) &&
+            !CheckedUrb->Finished) {
+          //
+          // Keep what the stopped TD moved so far.
+          //
+          CheckedUrb->Completed = XhcGetTdCompletedLength (Xhc, CheckedUrb, TRBPtr, EvtTrb->Length);
+        }
         CheckedUrb->Finished = TRUE;
         //
         // The pending URB is timeout and force stopped when stopping endpoint.
@@ -1197,6 +1305,22 @@ XhcCheckUrbResult (
         }
 
         TRBType = (UINT8) (TRBPtr->Type);
+        if ((CheckedUrb->Ep.Type == XHC_BULK_TRANSFER) && (TRBType == TRB_TYPE_NORMAL)) {
+          //
+          // The TD of a bulk URB ends at its last TRB, or earlier at a short
+          // packet. The xHC may report a short TD twice, once for the short TRB
+          // and once for the last TRB, so only the first report counts.
+          //
+          if (!CheckedUrb->Finished) {
+            CheckedUrb->Completed = XhcGetTdCompletedLength (Xhc, CheckedUrb, TRBPtr, EvtTrb->Length);
+            CheckedUrb->StartDone = TRUE;
+            CheckedUrb->EndDone   = TRUE;
+            CheckedUrb->Finished  = TRUE;
+            CheckedUrb->EvtTrb    = (TRB_TEMPLATE *)EvtTrb;
+          }
+          continue;
+        }
+
         if ((TRBType == TRB_TYPE_DATA_STAGE) ||
             (TRBType == TRB_TYPE_NORMAL) ||
             (TRBType == TRB_TYPE_ISOCH)) {
@@ -1231,6 +1355,14 @@ XhcCheckUrbResult (
 
 EXIT:
 
+  //
+  // Nothing to tell the xHC if no event was consumed. This keeps the register
+  // accesses off the polling loops while a transfer is in flight.
+  //
+  if (Xhc->EventRing.EventRingDequeue == Dequeue) {
+    return;
+  }
+
   //
   // Advance event ring to last available entry
   //
@@ -1251,6 +1383,36 @@ EXIT:
     XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET, XHC_LOW_32BIT (PhyAddr) | BIT3);
     XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET + 4, XHC_HIGH_32BIT (PhyAddr));
   }
+}
+
+/**
+  Check the URB's execution result and update the URB's
+  result accordingly.
+
+  @param  Xhc             The XHCI Instance.
+  @param  Urb             The URB to check result.
+
+  @return Whether the result of URB transfer is finialized.
+
+**/
+BOOLEAN
+XhcCheckUrbResult (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  URB                 *Urb
+  )
+{
+  ASSERT ((Xhc != NULL) && (Urb != NULL));
+
+  if (Urb->Finished) {
+    return TRUE;
+  }
+
+  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
+    Urb->Result |= EFI_USB_ERR_SYSTEM;
+    return FALSE;
+  }
+
+  XhcProcessEventRing (Xhc, Urb);
 
   return Urb->Finished;
 }
@@ -1519,6 +1681,14 @@ XhcMonitorAsyncRequests (
 
   Xhc    = (USB_XHCI_INSTANCE*) Context;
 
+  //
+  // Consume the event ring once for all the asynchronous transfers rather
+  // than once per URB.
+  //
+  if (!IsListEmpty (&Xhc->AsyncIntTransfers) && !XhcIsHalt (Xhc) && !XhcIsSysError (Xhc)) {
+    XhcProcessEventRing (Xhc, NULL);
+  }
+
   EFI_LIST_FOR_EACH_SAFE (Entry, Next, &Xhc->AsyncIntTransfers) {
     Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
 
@@ -1531,11 +1701,8 @@ XhcMonitorAsyncRequests (
     }
 
     //
-    // Check the result of URB execution. If it is still
-    // active, check the next one.
+    // If the URB is still active, check the next one.
     //
-    XhcCheckUrbResult (Xhc, Urb);
-
     if (!Urb->Finished) {
       continue;
     }
@@ -2,7 +2,7 @@
   Definition of USB Mass Storage Class and its value, USB Mass Transport Protocol, 
   and other common definitions.
 
-Copyright (c) 2007 - 2014, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2007 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -156,6 +156,20 @@ EFI_STATUS
   IN  VOID                    *Context
   );
 
+/**
+  Get the maximum number of bytes the transport protocol carries in one command.
+
+  @param  Context               The instance of transport protocol.
+
+  @return The maximum number of bytes of one command.
+
+**/
+typedef
+UINT32
+(*USB_MASS_GET_MAX_CARRY_SIZE) (
+  IN  VOID                    *Context
+  );
+
 ///
 /// This structure contains information necessary to select the
 /// proper transport protocol. The mass storage class defines
@@ -171,6 +185,7 @@ struct _USB_MASS_TRANSPORT {
   USB_MASS_RESET          Reset;       ///< Reset the device
   USB_MASS_GET_MAX_LUN    GetMaxLun;   ///< Get max lun, only for bot
   USB_MASS_CLEAN_UP       CleanUp;     ///< Clean up the resources.
+  USB_MASS_GET_MAX_CARRY_SIZE GetMaxCarrySize; ///< Get max bytes of one command, USB_BOOT_MAX_CARRY_SIZE if NULL
 };
 
 struct _USB_MASS_DEVICE {
@@ -188,6 +203,8 @@ struct _USB_MASS_DEVICE {
   EFI_DISK_INFO_PROTOCOL    DiskInfo;
   USB_BOOT_INQUIRY_DATA     InquiryData;
   BOOLEAN                   Cdb16Byte;
+  UINT32                    MaxCarrySize;      ///< Max bytes of one READ/WRITE command
+  UINT32                    MaxTransferBlocks; ///< From the Block Limits VPD page, 0 if no limit
 };
 
 #endif
@@ -668,12 +668,111 @@ UsbBootGetParams (
     Media->BlockSize        = 0x0800;
   }
 
+  UsbBootInitMaxCarrySize (UsbMass);
+
   Status = UsbBootDetectMedia (UsbMass);
 
   return Status;
 }
 
 
+/**
+  Get the number of bytes each READ/WRITE command carries.
+
+  The transport protocol reports how much it can carry in one command. When
+  it is more than USB_BOOT_MAX_CARRY_SIZE, the limit of the device is read
+  from its Block Limits VPD page.
+
+  @param  UsbMass                The device to get the carry size of.
+
+**/
+VOID
+UsbBootInitMaxCarrySize (
+  IN USB_MASS_DEVICE          *UsbMass
+  )
+{
+  USB_MASS_TRANSPORT              *Transport;
+  UINT8                           InquiryCmd[6];
+  EFI_SCSI_BLOCK_LIMITS_VPD_PAGE  BlockLimits;
+  UINT8                           CmdSet;
+  EFI_STATUS                      Status;
+
+  Transport                  = UsbMass->Transport;
+  UsbMass->MaxCarrySize      = USB_BOOT_MAX_CARRY_SIZE;
+  UsbMass->MaxTransferBlocks = 0;
+
+  if (Transport->GetMaxCarrySize != NULL) {
+    UsbMass->MaxCarrySize = Transport->GetMaxCarrySize (UsbMass->Context);
+  }
+
+  //
+  // Some USB keys hang on VPD requests, so only ask the devices which may
+  // carry more than USB_BOOT_MAX_CARRY_SIZE, and claim SPC-3 or later.
+  //
+  CmdSet = ((EFI_USB_INTERFACE_DESCRIPTOR *) (UsbMass->Context))->InterfaceSubClass;
+  if ((UsbMass->MaxCarrySize <= USB_BOOT_MAX_CARRY_SIZE) ||
+      (CmdSet != USB_MASS_STORE_SCSI) ||
+      (UsbMass->Pdt != USB_PDT_DIRECT_ACCESS) ||
+      (UsbMass->InquiryData.Version < USB_BOOT_INQUIRY_VERSION_SPC3)) {
+    return;
+  }
+
+  ZeroMem (InquiryCmd, sizeof (InquiryCmd));
+  ZeroMem (&BlockLimits, sizeof (BlockLimits));
+
+  InquiryCmd[0] = USB_BOOT_INQUIRY_OPCODE;
+  InquiryCmd[1] = (UINT8) (USB_BOOT_LUN (UsbMass->Lun) | BIT0);   // EVPD
+  InquiryCmd[2] = EFI_SCSI_PAGE_CODE_BLOCK_LIMITS_VPD;
+  InquiryCmd[4] = (UINT8) sizeof (BlockLimits);
+
+  //
+  // Don't retry, the command fails on devices without the page.
+  //
+  Status = UsbBootExecCmd (
+             UsbMass,
+             InquiryCmd,
+             (UINT8) sizeof (InquiryCmd),
+             EfiUsbDataIn,
+             &BlockLimits,
+             sizeof (BlockLimits),
+             USB_BOOT_GENERAL_CMD_TIMEOUT
+             );
+  if (!EFI_ERROR (Status) && (BlockLimits.PageCode == EFI_SCSI_PAGE_CODE_BLOCK_LIMITS_VPD)) {
+    UsbMass->MaxTransferBlocks = (BlockLimits.MaximumTransferLength4 << 24) |
+                                 (BlockLimits.MaximumTransferLength3 << 16) |
+                                 (BlockLimits.MaximumTransferLength2 << 8)  |
+                                 BlockLimits.MaximumTransferLength1;
+  }
+
+  DEBUG ((EFI_D_INFO, "UsbBootInitMaxCarrySize: MaxCarrySize 0x%x, MaxTransferBlocks 0x%x\n",
+          UsbMass->MaxCarrySize, UsbMass->MaxTransferBlocks));
+}
+
+
+/**
+  Get the number of blocks each READ/WRITE command carries.
+
+  @param  UsbMass                The device to read from or write to.
+
+  @return The number of blocks, between 1 and MAX_UINT16.
+
+**/
+UINT16
+UsbBootGetMaxCarryBlocks (
+  IN USB_MASS_DEVICE          *UsbMass
+  )
+{
+  UINT32                      Count;
+
+  Count = UsbMass->MaxCarrySize / UsbMass->BlockIoMedia.BlockSize;
+  if ((UsbMass->MaxTransferBlocks != 0) && (UsbMass->MaxTransferBlocks < Count)) {
+    Count = UsbMass->MaxTransferBlocks;
+  }
+
+  return (UINT16) MAX (MIN (Count, MAX_UINT16), 1);
+}
+
+
 /**
   Detect whether the removable media is present and whether it has changed.
 
@@ -820,7 +919,7 @@ UsbBootReadBlocks (
   UINT32                    Timeout;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
-  CountMax = (UINT16)(USB_BOOT_MAX_CARRY_SIZE / BlockSize);
+  CountMax  = UsbBootGetMaxCarryBlocks (UsbMass);
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -898,7 +997,7 @@ UsbBootWriteBlocks (
   UINT32                Timeout;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
-  CountMax = (UINT16)(USB_BOOT_MAX_CARRY_SIZE / BlockSize);
+  CountMax  = UsbBootGetMaxCarryBlocks (UsbMass);
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -976,7 +1075,7 @@ UsbBootReadBlocks16 (
   UINT32                    Timeout;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
-  CountMax = (UINT16)(USB_BOOT_MAX_CARRY_SIZE / BlockSize);
+  CountMax  = UsbBootGetMaxCarryBlocks (UsbMass);
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -1052,7 +1151,7 @@ UsbBootWriteBlocks16 (
   UINT32                Timeout;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
-  CountMax = (UINT16)(USB_BOOT_MAX_CARRY_SIZE / BlockSize);
+  CountMax  = UsbBootGetMaxCarryBlocks (UsbMass);
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -2,7 +2,7 @@
   Definition of the command set of USB Mass Storage Specification
   for Bootability, Revision 1.0.
 
-Copyright (c) 2007 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2007 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -65,9 +65,17 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define USB_PDT_SIMPLE_DIRECT           0x0E       ///< Simplified direct access device
 
 //
-// Other parameters, Max carried size is 64KB.
+// Other parameters. Max carried size is 64KB, which all devices handle.
+// Devices on faster links carry up to 1MB per command, further limited by
+// the MAXIMUM TRANSFER LENGTH of their Block Limits VPD page.
 //
 #define USB_BOOT_MAX_CARRY_SIZE         SIZE_64KB
+#define USB_BOOT_MAX_CARRY_SIZE_LARGE   SIZE_1MB
+
+//
+// The Block Limits VPD page is defined from SPC-3 on
+//
+#define USB_BOOT_INQUIRY_VERSION_SPC3   0x05
 
 //
 // Retry mass command times, set by experience
@@ -107,7 +115,8 @@ typedef struct {
 typedef struct {
   UINT8             Pdt;            ///< Peripheral Device Type (low 5 bits)
   UINT8             Removable;      ///< Removable Media (highest bit)
-  UINT8             Reserved0[2];
+  UINT8             Version;        ///< Version of the command set standard
+  UINT8             Reserved0;
   UINT8             AddLen;         ///< Additional length
   UINT8             Reserved1[3];
   UINT8             VendorID[8];
@@ -243,6 +252,34 @@ UsbBootGetParams (
   IN USB_MASS_DEVICE          *UsbMass
   );
 
+/**
+  Get the number of bytes each READ/WRITE command carries.
+
+  The transport protocol reports how much it can carry in one command. When
+  it is more than USB_BOOT_MAX_CARRY_SIZE, the limit of the device is read
+  from its Block Limits VPD page.
+
+  @param  UsbMass                The device to get the carry size of.
+
+**/
+VOID
+UsbBootInitMaxCarrySize (
+  IN USB_MASS_DEVICE          *UsbMass
+  );
+
+/**
+  Get the number of blocks each READ/WRITE command carries.
+
+  @param  UsbMass                The device to read from or write to.
+
+  @return The number of blocks, between 1 and MAX_UINT16.
+
+**/
+UINT16
+UsbBootGetMaxCarryBlocks (
+  IN USB_MASS_DEVICE          *UsbMass
+  );
+
 /**
   Execute TEST UNIT READY command to check if the device is ready.
 
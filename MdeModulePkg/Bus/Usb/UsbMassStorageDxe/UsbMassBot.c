@@ -2,7 +2,7 @@
   Implementation of the USB mass storage Bulk-Only Transport protocol,
   according to USB Mass Storage Class Bulk-Only Transport, Revision 1.0.
 
-Copyright (c) 2007 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2007 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -24,7 +24,8 @@ USB_MASS_TRANSPORT mUsbBotTransport = {
   UsbBotExecCommand,
   UsbBotResetDevice,
   UsbBotGetMaxLun,
-  UsbBotCleanUp
+  UsbBotCleanUp,
+  UsbBotGetMaxCarrySize
 };
 
 /**
@@ -594,6 +595,35 @@ UsbBotGetMaxLun (
   return EFI_SUCCESS;
 }
 
+/**
+  Get the maximum number of bytes a BOT command carries.
+
+  SuperSpeed devices, which are only attached to XHCI, carry up to
+  USB_BOOT_MAX_CARRY_SIZE_LARGE bytes. Slower devices keep the conservative
+  USB_BOOT_MAX_CARRY_SIZE, which many USB keys can't go beyond.
+
+  @param  Context         The context of the BOT protocol, that is, USB_BOT_PROTOCOL.
+
+  @return The maximum number of bytes of one command.
+
+**/
+UINT32
+UsbBotGetMaxCarrySize (
+  IN  VOID                    *Context
+  )
+{
+  USB_BOT_PROTOCOL        *UsbBot;
+
+  UsbBot = (USB_BOT_PROTOCOL *) Context;
+
+  if ((UsbBot->BulkInEndpoint->MaxPacketSize >= USB_BOT_SUPER_SPEED_MAX_PACKET) &&
+      (UsbBot->BulkOutEndpoint->MaxPacketSize >= USB_BOT_SUPER_SPEED_MAX_PACKET)) {
+    return USB_BOOT_MAX_CARRY_SIZE_LARGE;
+  }
+
+  return USB_BOOT_MAX_CARRY_SIZE;
+}
+
 /**
   Clean up the resource used by this BOT protocol.
 
@@ -3,7 +3,7 @@
   based on the "Universal Serial Bus Mass Storage Class Bulk-Only
   Transport" Revision 1.0, September 31, 1999.
 
-Copyright (c) 2007 - 2011, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2007 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -53,6 +53,11 @@ extern USB_MASS_TRANSPORT mUsbBotTransport;
 #define USB_BOT_RECV_CSW_TIMEOUT     (3 * USB_MASS_1_SECOND)
 #define USB_BOT_RESET_DEVICE_TIMEOUT (3 * USB_MASS_1_SECOND)
 
+//
+// The bulk endpoints of a SuperSpeed device have a max packet size of 1024 bytes
+//
+#define USB_BOT_SUPER_SPEED_MAX_PACKET  1024
+
 #pragma pack(1)
 ///
 /// The CBW (Command Block Wrapper) structures used by the USB BOT protocol.
@@ -177,6 +182,19 @@ UsbBotGetMaxLun (
   OUT UINT8                   *MaxLun
   );
 
+/**
+  Get the maximum number of bytes a BOT command carries.
+
+  @param  Context         The context of the BOT protocol, that is, USB_BOT_PROTOCOL.
+
+  @return The maximum number of bytes of one command.
+
+**/
+UINT32
+UsbBotGetMaxCarrySize (
+  IN  VOID                    *Context
+  );
+
 /**
   Clean up the resource used by this BOT protocol.
 
@@ -26,7 +26,8 @@ USB_MASS_TRANSPORT mUsbCbi0Transport = {
   UsbCbiExecCommand,
   UsbCbiResetDevice,
   NULL,
-  UsbCbiCleanUp
+  UsbCbiCleanUp,
+  NULL
 };
 
 //
@@ -38,7 +39,8 @@ USB_MASS_TRANSPORT mUsbCbi1Transport = {
   UsbCbiExecCommand,
   UsbCbiResetDevice,
   NULL,
-  UsbCbiCleanUp
+  UsbCbiCleanUp,
+  NULL
 };
 
 /**
@@ -575,6 +575,15 @@ CoreDispatcher (
         }
       }
     }
+
+    //
+    // If nothing else can be scheduled but drivers still have work running on
+    // the work queue, wait for the next work item to complete. Its completion
+    // callback may install protocols that satisfy more dependency expressions.
+    //
+    if (!ReadyToRun && CoreWorkQueueWaitForProgress ()) {
+      ReadyToRun = TRUE;
+    }
   } while (ReadyToRun);
 
   //
@@ -1444,6 +1453,8 @@ CoreInitializeDispatcher (
                   NULL,
                   &mFwVolEventRegistration
                   );
+
+  CoreInitializeWorkQueue ();
 }
 
 //
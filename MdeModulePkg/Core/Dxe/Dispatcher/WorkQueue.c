@@ -0,0 +1,414 @@
+/** @file
+  DXE Core work queue.
+
+  Runs boot-services-free work submitted by drivers on the application
+  processors (APs) reported by the MP Services Protocol. Each enabled AP is a
+  worker that runs one work item at a time through StartupThisAP() in
+  non-blocking mode. Completion is reported back to the boot processor (BSP)
+  through the WaitEvent of StartupThisAP(), whose notification function
+  signals the completion event of the work item and starts the next item.
+
+  Before the MP Services Protocol is installed, or when there is no enabled AP,
+  work runs on the BSP when it is submitted.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "DxeMain.h"
+
+#define CORE_WORK_ITEM_SIGNATURE  SIGNATURE_32 ('w', 'r', 'k', 'i')
+
+typedef struct {
+  UINTN                       Signature;
+  LIST_ENTRY                  Link;
+  EDKII_WORK_PROCEDURE        Procedure;
+  VOID                        *Context;
+  EFI_EVENT                   CompletionEvent;
+} CORE_WORK_ITEM;
+
+typedef struct {
+  UINTN                       ProcessorNumber;
+  EFI_EVENT                   WaitEvent;
+  ///
+  /// The work item running on this AP, or NULL if the AP is idle.
+  ///
+  CORE_WORK_ITEM              *Item;
+} CORE_WORKER;
+
+EFI_STATUS
+EFIAPI
+CoreWorkQueueSubmit (
+  IN EDKII_WORK_QUEUE_PROTOCOL  *This,
+  IN EDKII_WORK_PROCEDURE       Procedure,
+  IN VOID                       *Context          OPTIONAL,
+  IN EFI_EVENT                  CompletionEvent   OPTIONAL
+  );
+
+EFI_STATUS
+EFIAPI
+CoreWorkQueueWait (
+  IN EDKII_WORK_QUEUE_PROTOCOL  *This
+  );
+
+EDKII_WORK_QUEUE_PROTOCOL mWorkQueue = {
+  CoreWorkQueueSubmit,
+  CoreWorkQueueWait
+};
+
+//
+// Work items that have been submitted but not yet started. List of CORE_WORK_ITEM.
+//
+LIST_ENTRY                    mPendingWork = INITIALIZE_LIST_HEAD_VARIABLE (mPendingWork);
+
+//
+// Lock for mPendingWork and mWorkers. The lock is taken at TPL_CALLBACK, the
+// TPL of the worker WaitEvent notification function.
+//
+EFI_LOCK                      mWorkQueueLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_CALLBACK);
+
+EFI_MP_SERVICES_PROTOCOL      *mWorkQueueMpServices = NULL;
+CORE_WORKER                   *mWorkers             = NULL;
+UINTN                         mWorkerCount          = 0;
+
+//
+// Number of work items submitted and not yet completed, and number of work
+// items completed so far. Both are updated at TPL_CALLBACK and polled at
+// lower TPLs.
+//
+volatile UINTN                mOutstandingWork = 0;
+volatile UINTN                mCompletedWork   = 0;
+
+EFI_EVENT                     mMpServicesEvent;
+VOID                          *mMpServicesRegistration;
+
+/**
+  Complete a work item: signal its completion event and free it.
+
+  @param  Item              The work item whose procedure has returned.
+
+**/
+VOID
+CoreCompleteWorkItem (
+  IN CORE_WORK_ITEM           *Item
+  )
+{
+  if (Item->CompletionEvent != NULL) {
+    CoreSignalEvent (Item->CompletionEvent);
+  }
+  CoreFreePool (Item);
+
+  mCompletedWork++;
+  mOutstandingWork--;
+}
+
+/**
+  Start pending work items on idle workers.
+
+  The caller must hold mWorkQueueLock.
+
+**/
+VOID
+CoreWorkQueueKick (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UINTN                       Index;
+  CORE_WORK_ITEM              *Item;
+
+  ASSERT_LOCKED (&mWorkQueueLock);
+
+  for (Index = 0; Index < mWorkerCount && !IsListEmpty (&mPendingWork); Index++) {
+    if (mWorkers[Index].Item != NULL) {
+      continue;
+    }
+
+    Item = CR (mPendingWork.ForwardLink, CORE_WORK_ITEM, Link, CORE_WORK_ITEM_SIGNATURE);
+    Status = mWorkQueueMpServices->StartupThisAP (
+                                     mWorkQueueMpServices,
+                                     (EFI_AP_PROCEDURE) Item->Procedure,
+                                     mWorkers[Index].ProcessorNumber,
+                                     mWorkers[Index].WaitEvent,
+                                     0,
+                                     Item->Context,
+                                     NULL
+                                     );
+    if (!EFI_ERROR (Status)) {
+      RemoveEntryList (&Item->Link);
+      mWorkers[Index].Item = Item;
+    }
+  }
+}
+
+/**
+  Notification function of the WaitEvent of a worker, signaled by the MP
+  Services Protocol when the work item running on the AP has returned.
+
+  @param  Event             The WaitEvent of the worker.
+  @param  Context           The CORE_WORKER.
+
+**/
+VOID
+EFIAPI
+CoreWorkerDone (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  CORE_WORKER                 *Worker;
+  CORE_WORK_ITEM              *Item;
+
+  Worker = (CORE_WORKER *) Context;
+
+  CoreAcquireLock (&mWorkQueueLock);
+  Item         = Worker->Item;
+  Worker->Item = NULL;
+  if (Item != NULL) {
+    CoreCompleteWorkItem (Item);
+  }
+  CoreWorkQueueKick ();
+  CoreReleaseLock (&mWorkQueueLock);
+}
+
+/**
+  Notification function called when the MP Services Protocol is installed.
+  Creates one worker per enabled AP.
+
+  @param  Event             The event that was signaled.
+  @param  Context           Not used.
+
+**/
+VOID
+EFIAPI
+CoreMpServicesNotify (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_MP_SERVICES_PROTOCOL    *MpServices;
+  EFI_PROCESSOR_INFORMATION   ProcessorInfo;
+  CORE_WORKER                 *Workers;
+  UINTN                       NumberOfProcessors;
+  UINTN                       NumberOfEnabledProcessors;
+  UINTN                       WorkerCount;
+  UINTN                       Index;
+
+  if (mWorkQueueMpServices != NULL) {
+    return;
+  }
+
+  Status = CoreLocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **) &MpServices);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Status = MpServices->GetNumberOfProcessors (MpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status) || NumberOfEnabledProcessors < 2) {
+    return;
+  }
+
+  Workers = AllocateZeroPool (NumberOfProcessors * sizeof (CORE_WORKER));
+  if (Workers == NULL) {
+    return;
+  }
+
+  WorkerCount = 0;
+  for (Index = 0; Index < NumberOfProcessors; Index++) {
+    Status = MpServices->GetProcessorInfo (MpServices, Index, &ProcessorInfo);
+    if (EFI_ERROR (Status) ||
+        (ProcessorInfo.StatusFlag & PROCESSOR_AS_BSP_BIT) != 0 ||
+        (ProcessorInfo.StatusFlag & PROCESSOR_ENABLED_BIT) == 0) {
+      continue;
+    }
+
+    Status = CoreCreateEvent (
+               EVT_NOTIFY_SIGNAL,
+               TPL_CALLBACK,
+               CoreWorkerDone,
+               &Workers[WorkerCount],
+               &Workers[WorkerCount].WaitEvent
+               );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Workers[WorkerCount].ProcessorNumber = Index;
+    WorkerCount++;
+  }
+
+  if (WorkerCount == 0) {
+    CoreFreePool (Workers);
+    return;
+  }
+
+  DEBUG ((DEBUG_INFO, "DXE work queue: %d AP workers\n", WorkerCount));
+
+  CoreAcquireLock (&mWorkQueueLock);
+  mWorkers             = Workers;
+  mWorkerCount         = WorkerCount;
+  mWorkQueueMpServices = MpServices;
+  CoreWorkQueueKick ();
+  CoreReleaseLock (&mWorkQueueLock);
+
+  CoreCloseEvent (Event);
+}
+
+/**
+  Submit a unit of work.
+
+  @param  This              The protocol instance pointer.
+  @param  Procedure         The work procedure.
+  @param  Context           The context passed to Procedure.
+  @param  CompletionEvent   The event signaled on the boot processor after
+                            Procedure has returned. It is optional.
+
+  @retval EFI_SUCCESS            The work was submitted.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources to queue the work.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreWorkQueueSubmit (
+  IN EDKII_WORK_QUEUE_PROTOCOL  *This,
+  IN EDKII_WORK_PROCEDURE       Procedure,
+  IN VOID                       *Context          OPTIONAL,
+  IN EFI_EVENT                  CompletionEvent   OPTIONAL
+  )
+{
+  CORE_WORK_ITEM              *Item;
+
+  if (Procedure == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mWorkerCount == 0) {
+    //
+    // No AP to run the work on, so run it on the BSP now.
+    //
+    Procedure (Context);
+    if (CompletionEvent != NULL) {
+      CoreSignalEvent (CompletionEvent);
+    }
+    mCompletedWork++;
+    return EFI_SUCCESS;
+  }
+
+  Item = AllocateZeroPool (sizeof (CORE_WORK_ITEM));
+  if (Item == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Item->Signature       = CORE_WORK_ITEM_SIGNATURE;
+  Item->Procedure       = Procedure;
+  Item->Context         = Context;
+  Item->CompletionEvent = CompletionEvent;
+
+  CoreAcquireLock (&mWorkQueueLock);
+  InsertTailList (&mPendingWork, &Item->Link);
+  mOutstandingWork++;
+  CoreWorkQueueKick ();
+  CoreReleaseLock (&mWorkQueueLock);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Wait until all work submitted so far has completed and its completion
+  events have been signaled.
+
+  @param  This              The protocol instance pointer.
+
+  @retval EFI_SUCCESS            All work has completed.
+  @retval EFI_UNSUPPORTED        The current TPL is TPL_CALLBACK or higher.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreWorkQueueWait (
+  IN EDKII_WORK_QUEUE_PROTOCOL  *This
+  )
+{
+  if (gEfiCurrentTpl >= TPL_CALLBACK) {
+    return EFI_UNSUPPORTED;
+  }
+
+  while (mOutstandingWork != 0) {
+    CpuPause ();
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Wait until at least one outstanding work item completes.
+
+  Used by the DXE Dispatcher, which must re-evaluate the dependency expressions
+  of the discovered drivers each time a work item completes, because the
+  completion event of a work item typically installs protocols.
+
+  @retval TRUE              A work item completed.
+  @retval FALSE             There was no outstanding work.
+
+**/
+BOOLEAN
+CoreWorkQueueWaitForProgress (
+  VOID
+  )
+{
+  UINTN                       Completed;
+
+  if (!FeaturePcdGet (PcdDxeWorkQueueSupport) || mOutstandingWork == 0) {
+    return FALSE;
+  }
+
+  PERF_START (NULL, "WorkQueueWait", "DxeMain", 0);
+  Completed = mCompletedWork;
+  while (mOutstandingWork != 0 && Completed == mCompletedWork) {
+    CpuPause ();
+  }
+  PERF_END (NULL, "WorkQueueWait", "DxeMain", 0);
+
+  return TRUE;
+}
+
+/**
+  Install the EDKII Work Queue Protocol if PcdDxeWorkQueueSupport is TRUE, and
+  register for the installation of the MP Services Protocol.
+
+**/
+VOID
+CoreInitializeWorkQueue (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_HANDLE                  Handle;
+
+  if (!FeaturePcdGet (PcdDxeWorkQueueSupport)) {
+    return;
+  }
+
+  mMpServicesEvent = EfiCreateProtocolNotifyEvent (
+                       &gEfiMpServiceProtocolGuid,
+                       TPL_CALLBACK,
+                       CoreMpServicesNotify,
+                       NULL,
+                       &mMpServicesRegistration
+                       );
+
+  Handle = NULL;
+  Status = CoreInstallProtocolInterface (
+             &Handle,
+             &gEdkiiWorkQueueProtocolGuid,
+             EFI_NATIVE_INTERFACE,
+             &mWorkQueue
+             );
+  ASSERT_EFI_ERROR (Status);
+}
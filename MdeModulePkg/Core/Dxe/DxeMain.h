@@ -53,6 +53,9 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/TcgService.h>
 #include <Protocol/HiiPackageList.h>
 #include <Protocol/SmmBase2.h>
+#include <Protocol/MpService.h>
+#include <Protocol/WorkQueue.h>
+#include <Protocol/BootServicesProfile.h>
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
@@ -70,6 +73,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Guid/VectorHandoffTable.h>
 #include <Ppi/VectorHandoffInfo.h>
 #include <Guid/MemoryProfile.h>
+#include <Guid/HobIndexTable.h>
 
 #include <Library/DxeCoreEntryPoint.h>
 #include <Library/DebugLib.h>
@@ -237,6 +241,12 @@ typedef struct {
   PE_COFF_LOADER_IMAGE_CONTEXT  ImageContext; 
   /// Status returned by LoadImage() service.
   EFI_STATUS                  LoadImageStatus;
+  /// Performance counter when PE/COFF section loading started
+  UINT64                      LoadStartTick;
+  /// Performance counter when PE/COFF relocation started
+  UINT64                      RelocateStartTick;
+  /// Performance counter when PE/COFF relocation and cache maintenance ended
+  UINT64                      RelocateEndTick;
 } LOADED_IMAGE_PRIVATE_DATA;
 
 #define LOADED_IMAGE_PRIVATE_DATA_FROM_THIS(a) \
@@ -490,6 +500,30 @@ CoreInitializeDispatcher (
   );
 
 
+/**
+  Install the EDKII Work Queue Protocol if PcdDxeWorkQueueSupport is TRUE, and
+  register for the installation of the MP Services Protocol.
+
+**/
+VOID
+CoreInitializeWorkQueue (
+  VOID
+  );
+
+
+/**
+  Wait until at least one outstanding work item of the work queue completes.
+
+  @retval TRUE              A work item completed.
+  @retval FALSE             There was no outstanding work.
+
+**/
+BOOLEAN
+CoreWorkQueueWaitForProgress (
+  VOID
+  );
+
+
 /**
   This is the POSTFIX version of the dependency evaluator.  This code does
   not need to handle Before or After, as it is not valid to call this
@@ -2752,6 +2786,16 @@ MemoryProfileInstallProtocol (
   VOID
   );
 
+/**
+  Start measuring the boot services if PcdDxeBootServicesProfile is TRUE, and
+  install the EDKII Boot Services Profile Protocol.
+
+**/
+VOID
+CoreInitializeBootServicesProfile (
+  VOID
+  );
+
 /**
   Register image to memory profile.
 
@@ -2966,4 +3010,16 @@ MergeMemoryMap (
   IN UINTN                      DescriptorSize
   );
 
+/**
+  Build a hash index of all GUID extension HOBs in the HOB list and install it
+  into the EFI System Table with gEdkiiHobIndexTableGuid.
+
+  @param  HobStart      The start address of the HOB list.
+
+**/
+VOID
+CoreInstallHobIndexTable (
+  IN VOID                   *HobStart
+  );
+
 #endif
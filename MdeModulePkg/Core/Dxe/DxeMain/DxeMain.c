@@ -331,6 +331,11 @@ DxeMain (
   Status = CoreInstallConfigurationTable (&gEfiHobListGuid, HobStart);
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Install the GUID HOB index into the EFI System Tables's Configuration Table
+  //
+  CoreInstallHobIndexTable (HobStart);
+
   //
   // Install Memory Type Information Table into the EFI System Tables's Configuration Table
   //
@@ -429,6 +434,8 @@ DxeMain (
 
   MemoryProfileInstallProtocol ();
 
+  CoreInitializeBootServicesProfile ();
+
   CoreInitializePropertiesTable ();
   CoreInitializeMemoryAttributesTable ();
   CoreInitializeMemoryProtection ();
@@ -15,6 +15,83 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "DxeMain.h"
 #include "Handle.h"
 
+//
+// mDriverBindingCache      - The handles of all the Driver Binding Protocols, in
+//                            handle database order
+// mDriverBindingCacheCount - The number of handles in mDriverBindingCache
+// mDriverBindingCacheKey   - The gDriverBindingDatabaseKey value mDriverBindingCache
+//                            was built for
+//
+EFI_HANDLE      *mDriverBindingCache      = NULL;
+UINTN           mDriverBindingCacheCount  = 0;
+UINT64          mDriverBindingCacheKey    = MAX_UINT64;
+
+
+/**
+  Return the handles of all the Driver Binding Protocols, in the order
+  CoreLocateHandleBuffer() returns them.
+
+  The list is cached, and only rebuilt after a Driver Binding Protocol has
+  been installed or uninstalled.
+
+  @param  HandleCount           On return, the number of Driver Binding handles.
+  @param  HandleBuffer          On return, a copy of the handle list that the
+                                caller must free. Optional.
+
+  @retval EFI_SUCCESS           The handles were returned.
+  @retval EFI_NOT_FOUND         There are no Driver Binding Protocols.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources to build the list.
+
+**/
+EFI_STATUS
+CoreGetDriverBindingHandles (
+  OUT UINTN       *HandleCount,
+  OUT EFI_HANDLE  **HandleBuffer  OPTIONAL
+  )
+{
+  EFI_STATUS                   Status;
+  UINT64                       Key;
+  UINTN                        Count;
+  EFI_HANDLE                   *Buffer;
+
+  *HandleCount = 0;
+
+  Key = gDriverBindingDatabaseKey;
+  if (Key != mDriverBindingCacheKey) {
+    Status = CoreLocateHandleBuffer (
+               ByProtocol,
+               &gEfiDriverBindingProtocolGuid,
+               NULL,
+               &Count,
+               &Buffer
+               );
+    if (EFI_ERROR (Status)) {
+      Count  = 0;
+      Buffer = NULL;
+    }
+
+    if (mDriverBindingCache != NULL) {
+      CoreFreePool (mDriverBindingCache);
+    }
+    mDriverBindingCache      = Buffer;
+    mDriverBindingCacheCount = Count;
+    mDriverBindingCacheKey   = Key;
+  }
+
+  if (mDriverBindingCacheCount == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (HandleBuffer != NULL) {
+    *HandleBuffer = AllocateCopyPool (mDriverBindingCacheCount * sizeof (EFI_HANDLE), mDriverBindingCache);
+    if (*HandleBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+  *HandleCount = mDriverBindingCacheCount;
+  return EFI_SUCCESS;
+}
+
 
 //
 // Driver Support Functions
@@ -133,6 +210,7 @@ CoreConnectController (
   // Driver Binding Protocols in the handle database has increased during the call
   // so the connect operation must be restarted
   //
+  PERF_START (ControllerHandle, "ConnectController:", NULL, 0);
   do {
     ReturnStatus = CoreConnectSingleController (
                      ControllerHandle,
@@ -140,6 +218,7 @@ CoreConnectController (
                      AlignedRemainingDevicePath
                      );
   } while (ReturnStatus == EFI_NOT_READY);
+  PERF_END (ControllerHandle, "ConnectController:", NULL, 0);
 
   //
   // Free the aligned copy of RemainingDevicePath
@@ -172,18 +251,13 @@ CoreConnectController (
 
 
     //
-    // Count ControllerHandle's children
+    // Count ControllerHandle's children. Most handles have none, so there is
+    // nothing more to do for them.
     //
-    for (Link = Handle->Protocols.ForwardLink, ChildHandleCount = 0; Link != &Handle->Protocols; Link = Link->ForwardLink) {
-      Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-      for (ProtLink = Prot->OpenList.ForwardLink;
-          ProtLink != &Prot->OpenList;
-          ProtLink = ProtLink->ForwardLink) {
-        OpenData = CR (ProtLink, OPEN_PROTOCOL_DATA, Link, OPEN_PROTOCOL_DATA_SIGNATURE);
-        if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) != 0) {
-          ChildHandleCount++;
-        }
-      }
+    ChildHandleCount = Handle->ChildOpenCount;
+    if (ChildHandleCount == 0) {
+      CoreReleaseProtocolLock ();
+      return ReturnStatus;
     }
 
     //
@@ -397,7 +471,6 @@ CoreConnectSingleController (
   UINTN                                      DriverBindingHandleCount;
   EFI_HANDLE                                 *DriverBindingHandleBuffer;
   UINTN                                      NewDriverBindingHandleCount;
-  EFI_HANDLE                                 *NewDriverBindingHandleBuffer;
   EFI_DRIVER_BINDING_PROTOCOL                *DriverBinding;
   EFI_DRIVER_FAMILY_OVERRIDE_PROTOCOL        *DriverFamilyOverride;
   UINTN                                      NumberOfSortedDriverBindingProtocols;
@@ -417,15 +490,11 @@ CoreConnectSingleController (
   NumberOfSortedDriverBindingProtocols  = 0;
   SortedDriverBindingProtocols          = NULL;
   PlatformDriverOverride                = NULL;
-  NewDriverBindingHandleBuffer          = NULL;
 
   //
   // Get list of all Driver Binding Protocol Instances
   //
-  Status = CoreLocateHandleBuffer (
-             ByProtocol,
-             &gEfiDriverBindingProtocolGuid,
-             NULL,
+  Status = CoreGetDriverBindingHandles (
              &DriverBindingHandleCount,
              &DriverBindingHandleBuffer
              );
@@ -574,14 +643,7 @@ CoreConnectSingleController (
   // If the number of Driver Binding Protocols has increased since this function started, then return
   // EFI_NOT_READY, so it will be restarted
   //
-  Status = CoreLocateHandleBuffer (
-             ByProtocol,
-             &gEfiDriverBindingProtocolGuid,
-             NULL,
-             &NewDriverBindingHandleCount,
-             &NewDriverBindingHandleBuffer
-             );
-  CoreFreePool (NewDriverBindingHandleBuffer);
+  CoreGetDriverBindingHandles (&NewDriverBindingHandleCount, NULL);
   if (NewDriverBindingHandleCount > DriverBindingHandleCount) {
     //
     // Free any buffers that were allocated with AllocatePool()
@@ -732,6 +794,7 @@ CoreDisconnectController (
 {
   EFI_STATUS                          Status;
   IHANDLE                             *Handle;
+  IHANDLE                             *DriverHandle;
   EFI_HANDLE                          *DriverImageHandleBuffer;
   EFI_HANDLE                          *ChildBuffer;
   UINTN                               Index;
@@ -779,20 +842,8 @@ CoreDisconnectController (
     //
     // Look at each protocol interface for a match
     //
-    DriverImageHandleCount = 0;
-
     CoreAcquireProtocolLock ();
-    for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
-      Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-      for (ProtLink = Prot->OpenList.ForwardLink;
-           ProtLink != &Prot->OpenList;
-           ProtLink = ProtLink->ForwardLink) {
-        OpenData = CR (ProtLink, OPEN_PROTOCOL_DATA, Link, OPEN_PROTOCOL_DATA_SIGNATURE);
-        if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_DRIVER) != 0) {
-          DriverImageHandleCount++;
-        }
-      }
-    }
+    DriverImageHandleCount = Handle->DriverOpenCount;
     CoreReleaseProtocolLock ();
 
     //
@@ -857,25 +908,23 @@ CoreDisconnectController (
     }
 
     //
-    // Look at each protocol interface for a match
+    // Look at each protocol interface opened by the driver for a match.
+    // CoreHandleProtocol() above has validated DriverImageHandle, so its
+    // agent index can be walked instead of every open list on the controller.
     //
     DriverImageHandleValid = FALSE;
     ChildBufferCount = 0;
+    DriverHandle = (IHANDLE *)DriverImageHandle;
 
     CoreAcquireProtocolLock ();
-    for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
-      Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-      for (ProtLink = Prot->OpenList.ForwardLink;
-           ProtLink != &Prot->OpenList;
-           ProtLink = ProtLink->ForwardLink) {
-        OpenData = CR (ProtLink, OPEN_PROTOCOL_DATA, Link, OPEN_PROTOCOL_DATA_SIGNATURE);
-        if (OpenData->AgentHandle == DriverImageHandle) {
-          if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) != 0) {
-            ChildBufferCount++;
-          }
-          if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_DRIVER) != 0) {
-            DriverImageHandleValid = TRUE;
-          }
+    for (Link = DriverHandle->AgentOpenList.ForwardLink; Link != &DriverHandle->AgentOpenList; Link = Link->ForwardLink) {
+      OpenData = CR (Link, OPEN_PROTOCOL_DATA, AgentLink, OPEN_PROTOCOL_DATA_SIGNATURE);
+      if (OpenData->Interface->Handle == Handle) {
+        if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) != 0) {
+          ChildBufferCount++;
+        }
+        if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_DRIVER) != 0) {
+          DriverImageHandleValid = TRUE;
         }
       }
     }
@@ -894,28 +943,23 @@ CoreDisconnectController (
         ChildBufferCount = 0;
 
         CoreAcquireProtocolLock ();
-        for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
-          Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-          for (ProtLink = Prot->OpenList.ForwardLink;
-               ProtLink != &Prot->OpenList;
-               ProtLink = ProtLink->ForwardLink) {
-            OpenData = CR (ProtLink, OPEN_PROTOCOL_DATA, Link, OPEN_PROTOCOL_DATA_SIGNATURE);
-            if ((OpenData->AgentHandle == DriverImageHandle) &&
-                ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) != 0)) {
-              Duplicate = FALSE;
-              for (Index = 0; Index < ChildBufferCount; Index++) {
-                if (ChildBuffer[Index] == OpenData->ControllerHandle) {
-                  Duplicate = TRUE;
-                  break;
-                }
+        for (Link = DriverHandle->AgentOpenList.ForwardLink; Link != &DriverHandle->AgentOpenList; Link = Link->ForwardLink) {
+          OpenData = CR (Link, OPEN_PROTOCOL_DATA, AgentLink, OPEN_PROTOCOL_DATA_SIGNATURE);
+          if ((OpenData->Interface->Handle == Handle) &&
+              ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) != 0)) {
+            Duplicate = FALSE;
+            for (Index = 0; Index < ChildBufferCount; Index++) {
+              if (ChildBuffer[Index] == OpenData->ControllerHandle) {
+                Duplicate = TRUE;
+                break;
               }
-              if (!Duplicate) {
-                ChildBuffer[ChildBufferCount] = OpenData->ControllerHandle;
-                if (ChildHandle == ChildBuffer[ChildBufferCount]) {
-                  ChildHandleValid = TRUE;
-                }
-                ChildBufferCount++;
+            }
+            if (!Duplicate) {
+              ChildBuffer[ChildBufferCount] = OpenData->ControllerHandle;
+              if (ChildHandle == ChildBuffer[ChildBufferCount]) {
+                ChildHandleValid = TRUE;
               }
+              ChildBufferCount++;
             }
           }
         }
@@ -21,11 +21,144 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 // gHandleList           - A list of all the handles in the system
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
+// gDriverBindingDatabaseKey - The Key to show that a Driver Binding Protocol has been
+//                         installed or uninstalled
+// mHandleHash           - Hash table of all the handles in the system, used to
+//                         validate handles without walking gHandleList
 //
 LIST_ENTRY      mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
 LIST_ENTRY      gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
 EFI_LOCK        gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64          gHandleDatabaseKey    = 0;
+UINT64          gDriverBindingDatabaseKey = 0;
+
+#define HANDLE_HASH_SIZE  256
+#define HANDLE_HASH(Handle) \
+  ((((UINTN) (Handle) >> 3) ^ ((UINTN) (Handle) >> 11)) & (HANDLE_HASH_SIZE - 1))
+
+IHANDLE         *mHandleHash[HANDLE_HASH_SIZE];
+
+
+
+/**
+  Add a handle to the handle hash table.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to add
+
+**/
+VOID
+CoreInsertHandleHash (
+  IN IHANDLE    *Handle
+  )
+{
+  UINTN         Bucket;
+
+  Bucket = HANDLE_HASH (Handle);
+  Handle->HashNext    = mHandleHash[Bucket];
+  mHandleHash[Bucket] = Handle;
+}
+
+
+
+/**
+  Remove a handle from the handle hash table.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to remove
+
+**/
+VOID
+CoreRemoveHandleHash (
+  IN IHANDLE    *Handle
+  )
+{
+  IHANDLE       **Link;
+
+  for (Link = &mHandleHash[HANDLE_HASH (Handle)]; *Link != NULL; Link = &(*Link)->HashNext) {
+    if (*Link == Handle) {
+      *Link = Handle->HashNext;
+      return;
+    }
+  }
+  ASSERT (FALSE);
+}
+
+
+
+/**
+  Insert an open protocol data entry into the open list of a protocol
+  interface, and account for it on the handle of the protocol interface.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Prot                   The protocol interface
+  @param  OpenData               The open protocol data to insert
+
+**/
+VOID
+CoreInsertOpenProtocolData (
+  IN PROTOCOL_INTERFACE  *Prot,
+  IN OPEN_PROTOCOL_DATA  *OpenData
+  )
+{
+  InsertTailList (&Prot->OpenList, &OpenData->Link);
+  Prot->OpenListCount++;
+  OpenData->Interface = Prot;
+
+  //
+  // Index the open protocol data by its agent as well, so the opens held by
+  // a driver can be found without walking the open lists of every protocol
+  //
+  if (!EFI_ERROR (CoreValidateHandle (OpenData->AgentHandle))) {
+    InsertTailList (&((IHANDLE *)OpenData->AgentHandle)->AgentOpenList, &OpenData->AgentLink);
+  } else {
+    InitializeListHead (&OpenData->AgentLink);
+  }
+
+  if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_DRIVER) != 0) {
+    Prot->Handle->DriverOpenCount++;
+  }
+  if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) != 0) {
+    Prot->Handle->ChildOpenCount++;
+  }
+}
+
+
+
+/**
+  Remove an open protocol data entry from the open list of a protocol
+  interface, and free it.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Prot                   The protocol interface
+  @param  OpenData               The open protocol data to remove
+
+  @return The entry that followed OpenData in the open list
+
+**/
+LIST_ENTRY *
+CoreRemoveOpenProtocolData (
+  IN PROTOCOL_INTERFACE  *Prot,
+  IN OPEN_PROTOCOL_DATA  *OpenData
+  )
+{
+  LIST_ENTRY             *Link;
+
+  if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_DRIVER) != 0) {
+    ASSERT (Prot->Handle->DriverOpenCount > 0);
+    Prot->Handle->DriverOpenCount--;
+  }
+  if ((OpenData->Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) != 0) {
+    ASSERT (Prot->Handle->ChildOpenCount > 0);
+    Prot->Handle->ChildOpenCount--;
+  }
+
+  RemoveEntryList (&OpenData->AgentLink);
+  Link = RemoveEntryList (&OpenData->Link);
+  Prot->OpenListCount--;
+  CoreFreePool (OpenData);
+  return Link;
+}
 
 
 
@@ -72,14 +205,12 @@ CoreValidateHandle (
   )
 {
   IHANDLE             *Handle;
-  LIST_ENTRY          *Link;
 
   if (UserHandle == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  for (Link = gHandleList.BackLink; Link != &gHandleList; Link = Link->BackLink) {
-    Handle = CR (Link, IHANDLE, AllHandles, EFI_HANDLE_SIGNATURE);
+  for (Handle = mHandleHash[HANDLE_HASH (UserHandle)]; Handle != NULL; Handle = Handle->HashNext) {
     if (Handle == (IHANDLE *) UserHandle) {
       return EFI_SUCCESS;
     }
@@ -421,6 +552,7 @@ CoreInstallProtocolInterfaceNotify (
     //
     Handle->Signature = EFI_HANDLE_SIGNATURE;
     InitializeListHead (&Handle->Protocols);
+    InitializeListHead (&Handle->AgentOpenList);
 
     //
     // Initialize the Key to show that the handle has been created/modified
@@ -433,6 +565,7 @@ CoreInstallProtocolInterfaceNotify (
     // in the system
     //
     InsertTailList (&gHandleList, &Handle->AllHandles);
+    CoreInsertHandleHash (Handle);
   } else {
     Status = CoreValidateHandle (Handle);
     if (EFI_ERROR (Status)) {
@@ -471,6 +604,9 @@ CoreInstallProtocolInterfaceNotify (
   // protocol entry
   //
   InsertTailList (&ProtEntry->Protocols, &Prot->ByProtocol);
+  if (CompareGuid (&ProtEntry->ProtocolID, &gEfiDriverBindingProtocolGuid)) {
+    gDriverBindingDatabaseKey++;
+  }
 
   //
   // Notify the notification list for this protocol
@@ -670,9 +806,7 @@ CoreDisconnectControllersUsingProtocolInterface (
       OpenData = CR (Link, OPEN_PROTOCOL_DATA, Link, OPEN_PROTOCOL_DATA_SIGNATURE);
       if ((OpenData->Attributes &
           (EFI_OPEN_PROTOCOL_BY_HANDLE_PROTOCOL | EFI_OPEN_PROTOCOL_GET_PROTOCOL | EFI_OPEN_PROTOCOL_TEST_PROTOCOL)) != 0) {
-        Link = RemoveEntryList (&OpenData->Link);
-        Prot->OpenListCount--;
-        CoreFreePool (OpenData);
+        Link = CoreRemoveOpenProtocolData (Prot, OpenData);
       } else {
         Link = Link->ForwardLink;
       }
@@ -718,6 +852,7 @@ CoreUninstallProtocolInterface (
   EFI_STATUS            Status;
   IHANDLE               *Handle;
   PROTOCOL_INTERFACE    *Prot;
+  LIST_ENTRY            *Link;
 
   //
   // Check that Protocol is valid
@@ -793,8 +928,18 @@ CoreUninstallProtocolInterface (
   // If there are no more handlers for the handle, free the handle
   //
   if (IsListEmpty (&Handle->Protocols)) {
+    //
+    // Detach any open protocol data still held with this handle as the agent
+    //
+    while (!IsListEmpty (&Handle->AgentOpenList)) {
+      Link = GetFirstNode (&Handle->AgentOpenList);
+      RemoveEntryList (Link);
+      InitializeListHead (Link);
+    }
+
     Handle->Signature = 0;
     RemoveEntryList (&Handle->AllHandles);
+    CoreRemoveHandleHash (Handle);
     CoreFreePool (Handle);
   }
 
@@ -1161,8 +1306,7 @@ CoreOpenProtocol (
     OpenData->ControllerHandle  = ControllerHandle;
     OpenData->Attributes        = Attributes;
     OpenData->OpenCount         = 1;
-    InsertTailList (&Prot->OpenList, &OpenData->Link);
-    Prot->OpenListCount++;
+    CoreInsertOpenProtocolData (Prot, OpenData);
     Status = EFI_SUCCESS;
   }
 
@@ -1287,9 +1431,7 @@ CoreCloseProtocol (
     OpenData = CR (Link, OPEN_PROTOCOL_DATA, Link, OPEN_PROTOCOL_DATA_SIGNATURE);
     Link = Link->ForwardLink;
     if ((OpenData->AgentHandle == AgentHandle) && (OpenData->ControllerHandle == ControllerHandle)) {
-        RemoveEntryList (&OpenData->Link);
-        ProtocolInterface->OpenListCount--;
-        CoreFreePool (OpenData);
+        CoreRemoveOpenProtocolData (ProtocolInterface, OpenData);
         Status = EFI_SUCCESS;
     }
   }
@@ -1355,16 +1497,9 @@ CoreOpenProtocolInformation (
   }
 
   //
-  // Count the number of Open Entries
+  // The number of Open Entries is tracked on the protocol interface
   //
-  for ( Link = ProtocolInterface->OpenList.ForwardLink, Count = 0;
-        (Link != &ProtocolInterface->OpenList) ;
-        Link = Link->ForwardLink  ) {
-    Count++;
-  }
-
-  ASSERT (Count == ProtocolInterface->OpenListCount);
-
+  Count = ProtocolInterface->OpenListCount;
   if (Count == 0) {
     Size = sizeof(EFI_OPEN_PROTOCOL_INFORMATION_ENTRY);
   } else {
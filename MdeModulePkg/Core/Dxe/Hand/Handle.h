@@ -21,7 +21,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 ///
 /// IHANDLE - contains a list of protocol handles
 ///
-typedef struct {
+typedef struct _IHANDLE {
   UINTN               Signature;
   /// All handles list of IHANDLE
   LIST_ENTRY          AllHandles;
@@ -30,6 +30,14 @@ typedef struct {
   UINTN               LocateRequest;
   /// The Handle Database Key value when this handle was last created or modified
   UINT64              Key;
+  /// Next handle in the same bucket of the handle hash table
+  struct _IHANDLE     *HashNext;
+  /// Number of BY_DRIVER open protocol data on the protocols of this handle
+  UINTN               DriverOpenCount;
+  /// Number of BY_CHILD_CONTROLLER open protocol data on the protocols of this handle
+  UINTN               ChildOpenCount;
+  /// List of OPEN_PROTOCOL_DATA's whose AgentHandle is this handle
+  LIST_ENTRY          AgentOpenList;
 } IHANDLE;
 
 #define ASSERT_IS_HANDLE(a)  ASSERT((a)->Signature == EFI_HANDLE_SIGNATURE)
@@ -84,6 +92,10 @@ typedef struct {
   UINTN                       Signature;
   ///Link on PROTOCOL_INTERFACE.OpenList
   LIST_ENTRY                  Link;      
+  ///Link on IHANDLE.AgentOpenList of the agent handle
+  LIST_ENTRY                  AgentLink;
+  ///Back pointer to the protocol interface that was opened
+  PROTOCOL_INTERFACE          *Interface;
 
   EFI_HANDLE                  AgentHandle;
   EFI_HANDLE                  ControllerHandle;
@@ -177,6 +189,66 @@ CoreRemoveInterfaceFromProtocol (
   );
 
 
+/**
+  Add a handle to the handle hash table.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to add
+
+**/
+VOID
+CoreInsertHandleHash (
+  IN IHANDLE    *Handle
+  );
+
+
+/**
+  Remove a handle from the handle hash table.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to remove
+
+**/
+VOID
+CoreRemoveHandleHash (
+  IN IHANDLE    *Handle
+  );
+
+
+/**
+  Insert an open protocol data entry into the open list of a protocol
+  interface, and account for it on the handle of the protocol interface.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Prot                   The protocol interface
+  @param  OpenData               The open protocol data to insert
+
+**/
+VOID
+CoreInsertOpenProtocolData (
+  IN PROTOCOL_INTERFACE  *Prot,
+  IN OPEN_PROTOCOL_DATA  *OpenData
+  );
+
+
+/**
+  Remove an open protocol data entry from the open list of a protocol
+  interface, and free it.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Prot                   The protocol interface
+  @param  OpenData               The open protocol data to remove
+
+  @return The entry that followed OpenData in the open list
+
+**/
+LIST_ENTRY *
+CoreRemoveOpenProtocolData (
+  IN PROTOCOL_INTERFACE  *Prot,
+  IN OPEN_PROTOCOL_DATA  *OpenData
+  );
+
+
 /**
   Connects a controller to a driver.
 
@@ -266,5 +338,6 @@ CoreValidateHandle (
 extern EFI_LOCK         gProtocolDatabaseLock;
 extern LIST_ENTRY       gHandleList;
 extern UINT64           gHandleDatabaseKey;
+extern UINT64           gDriverBindingDatabaseKey;
 
 #endif
@@ -85,6 +85,9 @@ CoreRemoveInterfaceFromProtocol (
     // Remove the protocol interface entry
     //
     RemoveEntryList (&Prot->ByProtocol);
+    if (CompareGuid (&ProtEntry->ProtocolID, &gEfiDriverBindingProtocolGuid)) {
+      gDriverBindingDatabaseKey++;
+    }
   }
 
   return Prot;
@@ -609,6 +609,9 @@ CoreLoadPeImage (
   //
   // Load the image from the file into the allocated memory
   //
+  PERF_CODE (
+    Image->LoadStartTick = GetPerformanceCounter ();
+  );
   Status = PeCoffLoaderLoadImage (&Image->ImageContext);
   if (EFI_ERROR (Status)) {
     goto Done;
@@ -632,15 +635,22 @@ CoreLoadPeImage (
   //
   // Relocate the image in memory
   //
+  PERF_CODE (
+    Image->RelocateStartTick = GetPerformanceCounter ();
+  );
   Status = PeCoffLoaderRelocateImage (&Image->ImageContext);
   if (EFI_ERROR (Status)) {
     goto Done;
   }
 
   //
-  // Flush the Instruction Cache
+  // Flush the Instruction Cache once for the whole image, after all sections
+  // have been loaded and relocated.
   //
   InvalidateInstructionCacheRange ((VOID *)(UINTN)Image->ImageContext.ImageAddress, (UINTN)Image->ImageContext.ImageSize);
+  PERF_CODE (
+    Image->RelocateEndTick = GetPerformanceCounter ();
+  );
 
   //
   // Copy the machine type from the context to the image private data. This
@@ -1353,6 +1363,17 @@ CoreLoadImageCommon (
   //
   *ImageHandle = Image->Handle;
 
+  //
+  // Log the PE/COFF load and relocation times of the image now that it has
+  // a handle.
+  //
+  if (Image->LoadStartTick != 0) {
+    PERF_START (Image->Handle, "PeCoffLoad:", NULL, Image->LoadStartTick);
+    PERF_END (Image->Handle, "PeCoffLoad:", NULL, Image->RelocateStartTick);
+    PERF_START (Image->Handle, "PeCoffRelocate:", NULL, Image->RelocateStartTick);
+    PERF_END (Image->Handle, "PeCoffRelocate:", NULL, Image->RelocateEndTick);
+  }
+
 Done:
   //
   // All done accessing the source file
@@ -0,0 +1,917 @@
+/** @file
+  Measure the services of the Boot Services Table and of the DXE Services
+  Table, and produce the EDKII Boot Services Profile Protocol.
+
+  When PcdDxeBootServicesProfile is TRUE, the entries of gBS and gDS for the
+  measured services are replaced with functions that time the original
+  service and account the call to the service and to the return address of
+  the caller. Return addresses are resolved to image handles when the data is
+  retrieved, not when it is collected.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "DxeMain.h"
+
+//
+// Number of caller slots, must be a power of two, and the number of slots
+// probed before a call is only accounted to its service.
+//
+#define BS_PROFILE_CALLER_SLOTS       4096
+#define BS_PROFILE_MAX_PROBE          16
+
+typedef enum {
+  BsProfileIndexRaiseTpl,
+  BsProfileIndexRestoreTpl,
+  BsProfileIndexAllocatePages,
+  BsProfileIndexFreePages,
+  BsProfileIndexAllocatePool,
+  BsProfileIndexFreePool,
+  BsProfileIndexCreateEvent,
+  BsProfileIndexCreateEventEx,
+  BsProfileIndexSignalEvent,
+  BsProfileIndexCloseEvent,
+  BsProfileIndexCheckEvent,
+  BsProfileIndexInstallProtocolInterface,
+  BsProfileIndexReinstallProtocolInterface,
+  BsProfileIndexUninstallProtocolInterface,
+  BsProfileIndexHandleProtocol,
+  BsProfileIndexLocateHandle,
+  BsProfileIndexLocateDevicePath,
+  BsProfileIndexStall,
+  BsProfileIndexConnectController,
+  BsProfileIndexDisconnectController,
+  BsProfileIndexOpenProtocol,
+  BsProfileIndexCloseProtocol,
+  BsProfileIndexLocateHandleBuffer,
+  BsProfileIndexLocateProtocol,
+  BsProfileIndexAllocateMemorySpace,
+  BsProfileIndexGetMemorySpaceDescriptor,
+  BsProfileIndexSetMemorySpaceAttributes,
+  BsProfileIndexGetMemorySpaceMap,
+  BsProfileServiceMax
+} BS_PROFILE_SERVICE;
+
+GLOBAL_REMOVE_IF_UNREFERENCED CONST CHAR8 *mBsProfileServiceNames[BsProfileServiceMax] = {
+  "RaiseTPL",
+  "RestoreTPL",
+  "AllocatePages",
+  "FreePages",
+  "AllocatePool",
+  "FreePool",
+  "CreateEvent",
+  "CreateEventEx",
+  "SignalEvent",
+  "CloseEvent",
+  "CheckEvent",
+  "InstallProtocolInterface",
+  "ReinstallProtocolInterface",
+  "UninstallProtocolInterface",
+  "HandleProtocol",
+  "LocateHandle",
+  "LocateDevicePath",
+  "Stall",
+  "ConnectController",
+  "DisconnectController",
+  "OpenProtocol",
+  "CloseProtocol",
+  "LocateHandleBuffer",
+  "LocateProtocol",
+  "DS:AllocateMemorySpace",
+  "DS:GetMemorySpaceDescriptor",
+  "DS:SetMemorySpaceAttributes",
+  "DS:GetMemorySpaceMap"
+};
+
+typedef struct {
+  UINT64                CallCount;
+  UINT64                Ticks;
+} BS_PROFILE_TOTAL;
+
+typedef struct {
+  ///
+  /// Return address of the caller, 0 if the slot is free.
+  ///
+  UINTN                 Caller;
+  UINTN                 Service;
+  BS_PROFILE_TOTAL      Total;
+} BS_PROFILE_CALLER_SLOT;
+
+EFI_BOOT_SERVICES       mBsProfileBootServices;
+EFI_DXE_SERVICES        mBsProfileDxeServices;
+BS_PROFILE_TOTAL        mBsProfileServices[BsProfileServiceMax];
+BS_PROFILE_CALLER_SLOT  *mBsProfileCallers = NULL;
+BOOLEAN                 mBsProfileCountUp  = TRUE;
+
+/**
+  Account a call of a measured service.
+
+  @param  Service               The measured service.
+  @param  StartTick             The performance counter when the service was called.
+  @param  Caller                The return address of the caller.
+
+**/
+VOID
+BsProfileRecord (
+  IN BS_PROFILE_SERVICE     Service,
+  IN UINT64                 StartTick,
+  IN VOID                   *Caller
+  )
+{
+  UINT64                    EndTick;
+  UINT64                    Ticks;
+  BOOLEAN                   InterruptState;
+  UINTN                     Slot;
+  UINTN                     Probe;
+  BS_PROFILE_CALLER_SLOT    *Entry;
+
+  EndTick = GetPerformanceCounter ();
+  Ticks   = mBsProfileCountUp ? EndTick - StartTick : StartTick - EndTick;
+
+  //
+  // Services are called at every TPL, including from the timer interrupt.
+  //
+  InterruptState = SaveAndDisableInterrupts ();
+
+  mBsProfileServices[Service].CallCount++;
+  mBsProfileServices[Service].Ticks += Ticks;
+
+  Slot = (((UINTN) Caller >> 2) ^ ((UINTN) Caller >> 13) ^ Service) & (BS_PROFILE_CALLER_SLOTS - 1);
+  for (Probe = 0; Probe < BS_PROFILE_MAX_PROBE; Probe++) {
+    Entry = &mBsProfileCallers[(Slot + Probe) & (BS_PROFILE_CALLER_SLOTS - 1)];
+    if (Entry->Caller == 0) {
+      Entry->Caller  = (UINTN) Caller;
+      Entry->Service = Service;
+    }
+    if (Entry->Caller == (UINTN) Caller && Entry->Service == Service) {
+      Entry->Total.CallCount++;
+      Entry->Total.Ticks += Ticks;
+      break;
+    }
+  }
+
+  SetInterruptState (InterruptState);
+}
+
+//
+// Boot Services Table thunks
+//
+
+EFI_TPL
+EFIAPI
+BsProfileRaiseTpl (
+  IN EFI_TPL      NewTpl
+  )
+{
+  UINT64          Start;
+  EFI_TPL         OldTpl;
+
+  Start  = GetPerformanceCounter ();
+  OldTpl = mBsProfileBootServices.RaiseTPL (NewTpl);
+  BsProfileRecord (BsProfileIndexRaiseTpl, Start, RETURN_ADDRESS (0));
+  return OldTpl;
+}
+
+VOID
+EFIAPI
+BsProfileRestoreTpl (
+  IN EFI_TPL      OldTpl
+  )
+{
+  UINT64          Start;
+
+  Start = GetPerformanceCounter ();
+  mBsProfileBootServices.RestoreTPL (OldTpl);
+  BsProfileRecord (BsProfileIndexRestoreTpl, Start, RETURN_ADDRESS (0));
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileAllocatePages (
+  IN EFI_ALLOCATE_TYPE         Type,
+  IN EFI_MEMORY_TYPE           MemoryType,
+  IN UINTN                     NumberOfPages,
+  IN OUT EFI_PHYSICAL_ADDRESS  *Memory
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.AllocatePages (Type, MemoryType, NumberOfPages, Memory);
+  BsProfileRecord (BsProfileIndexAllocatePages, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileFreePages (
+  IN EFI_PHYSICAL_ADDRESS      Memory,
+  IN UINTN                     NumberOfPages
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.FreePages (Memory, NumberOfPages);
+  BsProfileRecord (BsProfileIndexFreePages, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileAllocatePool (
+  IN EFI_MEMORY_TYPE  PoolType,
+  IN UINTN            Size,
+  OUT VOID            **Buffer
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.AllocatePool (PoolType, Size, Buffer);
+  BsProfileRecord (BsProfileIndexAllocatePool, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileFreePool (
+  IN VOID         *Buffer
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.FreePool (Buffer);
+  BsProfileRecord (BsProfileIndexFreePool, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileCreateEvent (
+  IN  UINT32            Type,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction  OPTIONAL,
+  IN  VOID              *NotifyContext  OPTIONAL,
+  OUT EFI_EVENT         *Event
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.CreateEvent (Type, NotifyTpl, NotifyFunction, NotifyContext, Event);
+  BsProfileRecord (BsProfileIndexCreateEvent, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileCreateEventEx (
+  IN       UINT32            Type,
+  IN       EFI_TPL           NotifyTpl,
+  IN       EFI_EVENT_NOTIFY  NotifyFunction  OPTIONAL,
+  IN CONST VOID              *NotifyContext  OPTIONAL,
+  IN CONST EFI_GUID          *EventGroup     OPTIONAL,
+  OUT      EFI_EVENT         *Event
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.CreateEventEx (Type, NotifyTpl, NotifyFunction, NotifyContext, EventGroup, Event);
+  BsProfileRecord (BsProfileIndexCreateEventEx, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileSignalEvent (
+  IN EFI_EVENT    Event
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.SignalEvent (Event);
+  BsProfileRecord (BsProfileIndexSignalEvent, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileCloseEvent (
+  IN EFI_EVENT    Event
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.CloseEvent (Event);
+  BsProfileRecord (BsProfileIndexCloseEvent, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileCheckEvent (
+  IN EFI_EVENT    Event
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.CheckEvent (Event);
+  BsProfileRecord (BsProfileIndexCheckEvent, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileInstallProtocolInterface (
+  IN OUT EFI_HANDLE      *Handle,
+  IN     EFI_GUID        *Protocol,
+  IN     EFI_INTERFACE_TYPE  InterfaceType,
+  IN     VOID            *Interface
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.InstallProtocolInterface (Handle, Protocol, InterfaceType, Interface);
+  BsProfileRecord (BsProfileIndexInstallProtocolInterface, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileReinstallProtocolInterface (
+  IN EFI_HANDLE   Handle,
+  IN EFI_GUID     *Protocol,
+  IN VOID         *OldInterface,
+  IN VOID         *NewInterface
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.ReinstallProtocolInterface (Handle, Protocol, OldInterface, NewInterface);
+  BsProfileRecord (BsProfileIndexReinstallProtocolInterface, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileUninstallProtocolInterface (
+  IN EFI_HANDLE   Handle,
+  IN EFI_GUID     *Protocol,
+  IN VOID         *Interface
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.UninstallProtocolInterface (Handle, Protocol, Interface);
+  BsProfileRecord (BsProfileIndexUninstallProtocolInterface, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileHandleProtocol (
+  IN  EFI_HANDLE  Handle,
+  IN  EFI_GUID    *Protocol,
+  OUT VOID        **Interface
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.HandleProtocol (Handle, Protocol, Interface);
+  BsProfileRecord (BsProfileIndexHandleProtocol, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileLocateHandle (
+  IN     EFI_LOCATE_SEARCH_TYPE  SearchType,
+  IN     EFI_GUID                *Protocol    OPTIONAL,
+  IN     VOID                    *SearchKey   OPTIONAL,
+  IN OUT UINTN                   *BufferSize,
+  OUT    EFI_HANDLE              *Buffer
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.LocateHandle (SearchType, Protocol, SearchKey, BufferSize, Buffer);
+  BsProfileRecord (BsProfileIndexLocateHandle, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileLocateDevicePath (
+  IN     EFI_GUID                  *Protocol,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL  **DevicePath,
+  OUT    EFI_HANDLE                *Device
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.LocateDevicePath (Protocol, DevicePath, Device);
+  BsProfileRecord (BsProfileIndexLocateDevicePath, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileStall (
+  IN UINTN        Microseconds
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.Stall (Microseconds);
+  BsProfileRecord (BsProfileIndexStall, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileConnectController (
+  IN  EFI_HANDLE                ControllerHandle,
+  IN  EFI_HANDLE                *DriverImageHandle    OPTIONAL,
+  IN  EFI_DEVICE_PATH_PROTOCOL  *RemainingDevicePath  OPTIONAL,
+  IN  BOOLEAN                   Recursive
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.ConnectController (ControllerHandle, DriverImageHandle, RemainingDevicePath, Recursive);
+  BsProfileRecord (BsProfileIndexConnectController, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileDisconnectController (
+  IN  EFI_HANDLE  ControllerHandle,
+  IN  EFI_HANDLE  DriverImageHandle  OPTIONAL,
+  IN  EFI_HANDLE  ChildHandle        OPTIONAL
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.DisconnectController (ControllerHandle, DriverImageHandle, ChildHandle);
+  BsProfileRecord (BsProfileIndexDisconnectController, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileOpenProtocol (
+  IN  EFI_HANDLE  UserHandle,
+  IN  EFI_GUID    *Protocol,
+  OUT VOID        **Interface OPTIONAL,
+  IN  EFI_HANDLE  ImageHandle,
+  IN  EFI_HANDLE  ControllerHandle,
+  IN  UINT32      Attributes
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.OpenProtocol (UserHandle, Protocol, Interface, ImageHandle, ControllerHandle, Attributes);
+  BsProfileRecord (BsProfileIndexOpenProtocol, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileCloseProtocol (
+  IN  EFI_HANDLE  UserHandle,
+  IN  EFI_GUID    *Protocol,
+  IN  EFI_HANDLE  AgentHandle,
+  IN  EFI_HANDLE  ControllerHandle
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.CloseProtocol (UserHandle, Protocol, AgentHandle, ControllerHandle);
+  BsProfileRecord (BsProfileIndexCloseProtocol, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileLocateHandleBuffer (
+  IN     EFI_LOCATE_SEARCH_TYPE  SearchType,
+  IN     EFI_GUID                *Protocol OPTIONAL,
+  IN     VOID                    *SearchKey OPTIONAL,
+  IN OUT UINTN                   *NumberOfHandles,
+  OUT    EFI_HANDLE              **Buffer
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.LocateHandleBuffer (SearchType, Protocol, SearchKey, NumberOfHandles, Buffer);
+  BsProfileRecord (BsProfileIndexLocateHandleBuffer, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileLocateProtocol (
+  IN  EFI_GUID    *Protocol,
+  IN  VOID        *Registration OPTIONAL,
+  OUT VOID        **Interface
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileBootServices.LocateProtocol (Protocol, Registration, Interface);
+  BsProfileRecord (BsProfileIndexLocateProtocol, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+//
+// DXE Services Table thunks
+//
+
+EFI_STATUS
+EFIAPI
+BsProfileAllocateMemorySpace (
+  IN     EFI_GCD_ALLOCATE_TYPE  GcdAllocateType,
+  IN     EFI_GCD_MEMORY_TYPE    GcdMemoryType,
+  IN     UINTN                  Alignment,
+  IN     UINT64                 Length,
+  IN OUT EFI_PHYSICAL_ADDRESS   *BaseAddress,
+  IN     EFI_HANDLE             ImageHandle,
+  IN     EFI_HANDLE             DeviceHandle OPTIONAL
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileDxeServices.AllocateMemorySpace (
+                                   GcdAllocateType,
+                                   GcdMemoryType,
+                                   Alignment,
+                                   Length,
+                                   BaseAddress,
+                                   ImageHandle,
+                                   DeviceHandle
+                                   );
+  BsProfileRecord (BsProfileIndexAllocateMemorySpace, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileGetMemorySpaceDescriptor (
+  IN  EFI_PHYSICAL_ADDRESS             BaseAddress,
+  OUT EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *Descriptor
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileDxeServices.GetMemorySpaceDescriptor (BaseAddress, Descriptor);
+  BsProfileRecord (BsProfileIndexGetMemorySpaceDescriptor, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileSetMemorySpaceAttributes (
+  IN EFI_PHYSICAL_ADDRESS         BaseAddress,
+  IN UINT64                       Length,
+  IN UINT64                       Attributes
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileDxeServices.SetMemorySpaceAttributes (BaseAddress, Length, Attributes);
+  BsProfileRecord (BsProfileIndexSetMemorySpaceAttributes, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+BsProfileGetMemorySpaceMap (
+  OUT UINTN                            *NumberOfDescriptors,
+  OUT EFI_GCD_MEMORY_SPACE_DESCRIPTOR  **MemorySpaceMap
+  )
+{
+  UINT64          Start;
+  EFI_STATUS      Status;
+
+  Start  = GetPerformanceCounter ();
+  Status = mBsProfileDxeServices.GetMemorySpaceMap (NumberOfDescriptors, MemorySpaceMap);
+  BsProfileRecord (BsProfileIndexGetMemorySpaceMap, Start, RETURN_ADDRESS (0));
+  return Status;
+}
+
+/**
+  Find the image that contains an address.
+
+  @param  Images                The loaded image handles.
+  @param  ImageCount            The number of handles in Images.
+  @param  Address               The address.
+
+  @return The image handle, or NULL if no loaded image contains Address.
+
+**/
+EFI_HANDLE
+BsProfileFindImage (
+  IN EFI_HANDLE             *Images,
+  IN UINTN                  ImageCount,
+  IN UINTN                  Address
+  )
+{
+  EFI_STATUS                Status;
+  EFI_LOADED_IMAGE_PROTOCOL *LoadedImage;
+  UINTN                     Index;
+
+  for (Index = 0; Index < ImageCount; Index++) {
+    Status = CoreHandleProtocol (Images[Index], &gEfiLoadedImageProtocolGuid, (VOID **) &LoadedImage);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+    if (Address >= (UINTN) LoadedImage->ImageBase &&
+        Address - (UINTN) LoadedImage->ImageBase < LoadedImage->ImageSize) {
+      return Images[Index];
+    }
+  }
+  return NULL;
+}
+
+/**
+  Get the data collected so far.
+
+  @param  This              The protocol instance pointer.
+  @param  ServiceCount      On return, the number of entries in Services.
+  @param  Services          On return, the totals of each measured service.
+  @param  CallerCount       On return, the number of entries in Callers.
+  @param  Callers           On return, the totals of each service per calling image.
+
+  @retval EFI_SUCCESS            The data was returned.
+  @retval EFI_INVALID_PARAMETER  One of the parameters is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources to return the data.
+
+**/
+EFI_STATUS
+EFIAPI
+BsProfileGetData (
+  IN  EDKII_BOOT_SERVICES_PROFILE_PROTOCOL  *This,
+  OUT UINTN                                 *ServiceCount,
+  OUT EDKII_BOOT_SERVICE_PROFILE_SERVICE    **Services,
+  OUT UINTN                                 *CallerCount,
+  OUT EDKII_BOOT_SERVICE_PROFILE_CALLER     **Callers
+  )
+{
+  EFI_STATUS                          Status;
+  BS_PROFILE_TOTAL                    *ServiceTotals;
+  BS_PROFILE_CALLER_SLOT              *CallerSlots;
+  EDKII_BOOT_SERVICE_PROFILE_SERVICE  *ServiceData;
+  EDKII_BOOT_SERVICE_PROFILE_CALLER   *CallerData;
+  EFI_HANDLE                          *Images;
+  UINTN                               ImageCount;
+  EFI_HANDLE                          ImageHandle;
+  BOOLEAN                             InterruptState;
+  UINTN                               Count;
+  UINTN                               Index;
+  UINTN                               Index2;
+
+  if (ServiceCount == NULL || Services == NULL || CallerCount == NULL || Callers == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ServiceTotals = AllocatePool (sizeof (mBsProfileServices));
+  CallerSlots   = AllocatePool (BS_PROFILE_CALLER_SLOTS * sizeof (BS_PROFILE_CALLER_SLOT));
+  ServiceData   = AllocateZeroPool (BsProfileServiceMax * sizeof (EDKII_BOOT_SERVICE_PROFILE_SERVICE));
+  CallerData    = AllocateZeroPool (BS_PROFILE_CALLER_SLOTS * sizeof (EDKII_BOOT_SERVICE_PROFILE_CALLER));
+  if (ServiceTotals == NULL || CallerSlots == NULL || ServiceData == NULL || CallerData == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Error;
+  }
+
+  //
+  // Take a consistent snapshot, so that the data is not updated while the
+  // image handles are resolved.
+  //
+  InterruptState = SaveAndDisableInterrupts ();
+  CopyMem (ServiceTotals, mBsProfileServices, sizeof (mBsProfileServices));
+  CopyMem (CallerSlots, mBsProfileCallers, BS_PROFILE_CALLER_SLOTS * sizeof (BS_PROFILE_CALLER_SLOT));
+  SetInterruptState (InterruptState);
+
+  for (Index = 0; Index < BsProfileServiceMax; Index++) {
+    AsciiStrCpyS (ServiceData[Index].Name, EDKII_BOOT_SERVICE_PROFILE_NAME_SIZE, mBsProfileServiceNames[Index]);
+    ServiceData[Index].CallCount = ServiceTotals[Index].CallCount;
+    ServiceData[Index].Duration  = GetTimeInNanoSecond (ServiceTotals[Index].Ticks);
+  }
+
+  Status = CoreLocateHandleBuffer (ByProtocol, &gEfiLoadedImageProtocolGuid, NULL, &ImageCount, &Images);
+  if (EFI_ERROR (Status)) {
+    ImageCount = 0;
+    Images     = NULL;
+  }
+
+  //
+  // Merge the call sites of each image
+  //
+  Count = 0;
+  for (Index = 0; Index < BS_PROFILE_CALLER_SLOTS; Index++) {
+    if (CallerSlots[Index].Caller == 0) {
+      continue;
+    }
+    ImageHandle = BsProfileFindImage (Images, ImageCount, CallerSlots[Index].Caller);
+    for (Index2 = 0; Index2 < Count; Index2++) {
+      if (CallerData[Index2].ImageHandle == ImageHandle &&
+          CallerData[Index2].ServiceIndex == CallerSlots[Index].Service) {
+        break;
+      }
+    }
+    if (Index2 == Count) {
+      CallerData[Count].ServiceIndex = (UINT32) CallerSlots[Index].Service;
+      CallerData[Count].ImageHandle  = ImageHandle;
+      Count++;
+    }
+    CallerData[Index2].CallCount += CallerSlots[Index].Total.CallCount;
+    CallerData[Index2].Duration  += CallerSlots[Index].Total.Ticks;
+  }
+  for (Index = 0; Index < Count; Index++) {
+    CallerData[Index].Duration = GetTimeInNanoSecond (CallerData[Index].Duration);
+  }
+
+  if (Images != NULL) {
+    FreePool (Images);
+  }
+  FreePool (ServiceTotals);
+  FreePool (CallerSlots);
+
+  *ServiceCount = BsProfileServiceMax;
+  *Services     = ServiceData;
+  *CallerCount  = Count;
+  *Callers      = CallerData;
+  return EFI_SUCCESS;
+
+Error:
+  if (ServiceTotals != NULL) {
+    FreePool (ServiceTotals);
+  }
+  if (CallerSlots != NULL) {
+    FreePool (CallerSlots);
+  }
+  if (ServiceData != NULL) {
+    FreePool (ServiceData);
+  }
+  if (CallerData != NULL) {
+    FreePool (CallerData);
+  }
+  return Status;
+}
+
+/**
+  Discard the data collected so far.
+
+  @param  This              The protocol instance pointer.
+
+  @retval EFI_SUCCESS       The data was discarded.
+
+**/
+EFI_STATUS
+EFIAPI
+BsProfileReset (
+  IN EDKII_BOOT_SERVICES_PROFILE_PROTOCOL   *This
+  )
+{
+  BOOLEAN                   InterruptState;
+
+  InterruptState = SaveAndDisableInterrupts ();
+  ZeroMem (mBsProfileServices, sizeof (mBsProfileServices));
+  ZeroMem (mBsProfileCallers, BS_PROFILE_CALLER_SLOTS * sizeof (BS_PROFILE_CALLER_SLOT));
+  SetInterruptState (InterruptState);
+  return EFI_SUCCESS;
+}
+
+EDKII_BOOT_SERVICES_PROFILE_PROTOCOL  mBsProfileProtocol = {
+  BsProfileGetData,
+  BsProfileReset
+};
+
+/**
+  Start measuring the boot services if PcdDxeBootServicesProfile is TRUE, and
+  install the EDKII Boot Services Profile Protocol.
+
+**/
+VOID
+CoreInitializeBootServicesProfile (
+  VOID
+  )
+{
+  EFI_STATUS                Status;
+  EFI_HANDLE                Handle;
+  UINT64                    StartValue;
+  UINT64                    EndValue;
+
+  if (!FeaturePcdGet (PcdDxeBootServicesProfile)) {
+    return;
+  }
+
+  mBsProfileCallers = AllocateZeroPool (BS_PROFILE_CALLER_SLOTS * sizeof (BS_PROFILE_CALLER_SLOT));
+  if (mBsProfileCallers == NULL) {
+    return;
+  }
+
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  mBsProfileCountUp = (BOOLEAN) (EndValue >= StartValue);
+
+  CopyMem (&mBsProfileBootServices, gBS, sizeof (EFI_BOOT_SERVICES));
+  CopyMem (&mBsProfileDxeServices, gDxeCoreDS, sizeof (EFI_DXE_SERVICES));
+
+  gBS->RaiseTPL                   = BsProfileRaiseTpl;
+  gBS->RestoreTPL                 = BsProfileRestoreTpl;
+  gBS->AllocatePages              = BsProfileAllocatePages;
+  gBS->FreePages                  = BsProfileFreePages;
+  gBS->AllocatePool               = BsProfileAllocatePool;
+  gBS->FreePool                   = BsProfileFreePool;
+  gBS->CreateEvent                = BsProfileCreateEvent;
+  gBS->CreateEventEx              = BsProfileCreateEventEx;
+  gBS->SignalEvent                = BsProfileSignalEvent;
+  gBS->CloseEvent                 = BsProfileCloseEvent;
+  gBS->CheckEvent                 = BsProfileCheckEvent;
+  gBS->InstallProtocolInterface   = BsProfileInstallProtocolInterface;
+  gBS->ReinstallProtocolInterface = BsProfileReinstallProtocolInterface;
+  gBS->UninstallProtocolInterface = BsProfileUninstallProtocolInterface;
+  gBS->HandleProtocol             = BsProfileHandleProtocol;
+  gBS->LocateHandle               = BsProfileLocateHandle;
+  gBS->LocateDevicePath           = BsProfileLocateDevicePath;
+  gBS->Stall                      = BsProfileStall;
+  gBS->ConnectController          = BsProfileConnectController;
+  gBS->DisconnectController       = BsProfileDisconnectController;
+  gBS->OpenProtocol               = BsProfileOpenProtocol;
+  gBS->CloseProtocol              = BsProfileCloseProtocol;
+  gBS->LocateHandleBuffer         = BsProfileLocateHandleBuffer;
+  gBS->LocateProtocol             = BsProfileLocateProtocol;
+
+  gDxeCoreDS->AllocateMemorySpace      = BsProfileAllocateMemorySpace;
+  gDxeCoreDS->GetMemorySpaceDescriptor = BsProfileGetMemorySpaceDescriptor;
+  gDxeCoreDS->SetMemorySpaceAttributes = BsProfileSetMemorySpaceAttributes;
+  gDxeCoreDS->GetMemorySpaceMap        = BsProfileGetMemorySpaceMap;
+
+  CalculateEfiHdrCrc (&gBS->Hdr);
+  CalculateEfiHdrCrc (&gDxeCoreDS->Hdr);
+
+  Handle = NULL;
+  Status = CoreInstallProtocolInterface (
+             &Handle,
+             &gEdkiiBootServicesProfileProtocolGuid,
+             EFI_NATIVE_INTERFACE,
+             &mBsProfileProtocol
+             );
+  ASSERT_EFI_ERROR (Status);
+}
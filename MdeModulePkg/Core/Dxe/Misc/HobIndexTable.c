@@ -0,0 +1,171 @@
+/** @file
+  Build the GUID HOB index table and install it into the EFI System Table.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "DxeMain.h"
+
+#define HOB_INDEX_MIN_BUCKET_COUNT  16
+
+/**
+  Find the group of a GUID in the HOB index table being built, or claim an
+  empty bucket for it.
+
+  @param  Buckets       The bucket array.
+  @param  BucketCount   The number of buckets, a power of two.
+  @param  Groups        The group array.
+  @param  Name          The GUID to look for.
+
+  @return Pointer to the bucket that holds or should hold the group of Name.
+
+**/
+UINT32 *
+HobIndexFindBucket (
+  IN UINT32                 *Buckets,
+  IN UINT32                 BucketCount,
+  IN EDKII_HOB_INDEX_GROUP  *Groups,
+  IN CONST EFI_GUID         *Name
+  )
+{
+  UINT32                    Bucket;
+
+  Bucket = EDKII_HOB_INDEX_GUID_HASH (Name) & (BucketCount - 1);
+  while (Buckets[Bucket] != 0) {
+    if (CompareGuid (&Groups[Buckets[Bucket] - 1].Name, Name)) {
+      break;
+    }
+    Bucket = (Bucket + 1) & (BucketCount - 1);
+  }
+  return &Buckets[Bucket];
+}
+
+/**
+  Build a hash index of all GUID extension HOBs in the HOB list and install it
+  into the EFI System Table with gEdkiiHobIndexTableGuid.
+
+  HOB library instances use this table to look up GUID HOBs in constant time
+  instead of walking the HOB list.  Failure to build the table is not fatal,
+  since the consumers fall back to walking the HOB list.
+
+  @param  HobStart      The start address of the HOB list.
+
+**/
+VOID
+CoreInstallHobIndexTable (
+  IN VOID                   *HobStart
+  )
+{
+  EFI_STATUS                Status;
+  EFI_PEI_HOB_POINTERS      Hob;
+  EDKII_HOB_INDEX_TABLE     *Table;
+  UINT32                    *Buckets;
+  EDKII_HOB_INDEX_GROUP     *Groups;
+  EFI_PHYSICAL_ADDRESS      *Hobs;
+  UINT32                    *Bucket;
+  EDKII_HOB_INDEX_GROUP     *Group;
+  UINT32                    GuidHobCount;
+  UINT32                    BucketCount;
+  UINT32                    Index;
+  UINT32                    FirstHob;
+
+  //
+  // Count the GUID HOBs to size the table.
+  //
+  GuidHobCount = 0;
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) {
+      GuidHobCount++;
+    }
+  }
+
+  //
+  // Keep the load factor at or below one half.
+  //
+  BucketCount = HOB_INDEX_MIN_BUCKET_COUNT;
+  while (BucketCount < GuidHobCount * 2) {
+    BucketCount <<= 1;
+  }
+
+  Table = AllocateZeroPool (
+            sizeof (EDKII_HOB_INDEX_TABLE) +
+            BucketCount * sizeof (UINT32) +
+            GuidHobCount * (sizeof (EDKII_HOB_INDEX_GROUP) + sizeof (EFI_PHYSICAL_ADDRESS))
+            );
+  if (Table == NULL) {
+    DEBUG ((DEBUG_WARN, "HOB index table not installed, out of resources\n"));
+    return;
+  }
+
+  Table->Signature    = EDKII_HOB_INDEX_TABLE_SIGNATURE;
+  Table->BucketCount  = BucketCount;
+  Table->BucketOffset = sizeof (EDKII_HOB_INDEX_TABLE);
+  Table->GroupOffset  = Table->BucketOffset + BucketCount * sizeof (UINT32);
+  Table->HobOffset    = Table->GroupOffset + GuidHobCount * sizeof (EDKII_HOB_INDEX_GROUP);
+  Table->HobListStart = (EFI_PHYSICAL_ADDRESS) (UINTN) HobStart;
+
+  Buckets = (UINT32 *) ((UINT8 *) Table + Table->BucketOffset);
+  Groups  = (EDKII_HOB_INDEX_GROUP *) ((UINT8 *) Table + Table->GroupOffset);
+  Hobs    = (EFI_PHYSICAL_ADDRESS *) ((UINT8 *) Table + Table->HobOffset);
+
+  //
+  // First pass: create one group per distinct GUID and count its HOBs.
+  //
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) != EFI_HOB_TYPE_GUID_EXTENSION) {
+      continue;
+    }
+    Bucket = HobIndexFindBucket (Buckets, BucketCount, Groups, &Hob.Guid->Name);
+    if (*Bucket == 0) {
+      CopyGuid (&Groups[Table->GroupCount].Name, &Hob.Guid->Name);
+      *Bucket = ++Table->GroupCount;
+    }
+    Groups[*Bucket - 1].HobCount++;
+  }
+  Table->HobListEnd = (EFI_PHYSICAL_ADDRESS) (UINTN) Hob.Raw;
+
+  //
+  // Lay out the HOB address runs of the groups back to back.
+  //
+  FirstHob = 0;
+  for (Index = 0; Index < Table->GroupCount; Index++) {
+    Groups[Index].FirstHob = FirstHob;
+    FirstHob += Groups[Index].HobCount;
+    Groups[Index].HobCount = 0;
+  }
+
+  //
+  // Second pass: record the HOB addresses of each group in HOB list order.
+  //
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) != EFI_HOB_TYPE_GUID_EXTENSION) {
+      continue;
+    }
+    Bucket = HobIndexFindBucket (Buckets, BucketCount, Groups, &Hob.Guid->Name);
+    ASSERT (*Bucket != 0);
+    Group = &Groups[*Bucket - 1];
+    Hobs[Group->FirstHob + Group->HobCount++] = (EFI_PHYSICAL_ADDRESS) (UINTN) Hob.Raw;
+  }
+  Table->HobCount = GuidHobCount;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "HOB index table: %d GUID HOBs, %d GUIDs, %d buckets\n",
+    GuidHobCount,
+    Table->GroupCount,
+    BucketCount
+    ));
+
+  Status = CoreInstallConfigurationTable (&gEdkiiHobIndexTableGuid, Table);
+  if (EFI_ERROR (Status)) {
+    FreePool (Table);
+  }
+}
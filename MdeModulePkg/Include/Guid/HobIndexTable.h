@@ -0,0 +1,77 @@
+/** @file
+  This file defines the HOB index table GUID and data structures.
+
+  The DXE Core builds a hash index of all GUID extension HOBs in the HOB list
+  and publishes it in the EFI System Configuration Table, so that HOB library
+  instances can look up GUID HOBs without walking the whole HOB list.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __HOB_INDEX_TABLE_GUID_H__
+#define __HOB_INDEX_TABLE_GUID_H__
+
+#define EDKII_HOB_INDEX_TABLE_GUID \
+  { 0x2d3e6c51, 0x8f0a, 0x4b7e, { 0x9c, 0x13, 0x5e, 0x7a, 0x41, 0xd2, 0x6b, 0x90 } }
+
+#define EDKII_HOB_INDEX_TABLE_SIGNATURE  SIGNATURE_32 ('H', 'I', 'D', 'X')
+
+///
+/// All GUID HOBs sharing one GUID name.  The HOB addresses of the group are
+/// stored consecutively, in HOB list order, starting at Hobs[FirstHob].
+///
+typedef struct {
+  EFI_GUID                Name;
+  UINT32                  FirstHob;
+  UINT32                  HobCount;
+} EDKII_HOB_INDEX_GROUP;
+
+///
+/// The HOB index table header.  It is followed in the same buffer by:
+///   UINT32                 Buckets[BucketCount]  at BucketOffset
+///   EDKII_HOB_INDEX_GROUP  Groups[GroupCount]    at GroupOffset
+///   EFI_PHYSICAL_ADDRESS   Hobs[HobCount]        at HobOffset
+/// Each bucket holds a group index plus one, or zero if the bucket is empty.
+/// BucketCount is a power of two, and collisions are resolved by linear probing.
+///
+typedef struct {
+  UINT32                  Signature;
+  UINT32                  BucketCount;
+  UINT32                  GroupCount;
+  UINT32                  HobCount;
+  UINT32                  BucketOffset;
+  UINT32                  GroupOffset;
+  UINT32                  HobOffset;
+  UINT32                  Reserved;
+  ///
+  /// The first HOB (PHIT) and the end of list HOB of the indexed HOB list.
+  ///
+  EFI_PHYSICAL_ADDRESS    HobListStart;
+  EFI_PHYSICAL_ADDRESS    HobListEnd;
+} EDKII_HOB_INDEX_TABLE;
+
+/**
+  Compute the hash of a GUID used to select the HOB index table bucket.
+
+  @param  Guid          The GUID to hash.
+
+  @return The hash value.
+
+**/
+#define EDKII_HOB_INDEX_GUID_HASH(Guid) \
+  (ReadUnaligned32 ((CONST UINT32 *) (Guid)) ^ \
+   ReadUnaligned32 ((CONST UINT32 *) (Guid) + 1) ^ \
+   ReadUnaligned32 ((CONST UINT32 *) (Guid) + 2) ^ \
+   ReadUnaligned32 ((CONST UINT32 *) (Guid) + 3))
+
+extern EFI_GUID gEdkiiHobIndexTableGuid;
+
+#endif
@@ -0,0 +1,97 @@
+/** @file
+  GUID and on-media layout of a compressed RAM disk image.
+
+  A RAM disk registered with this type GUID is not a byte-for-byte copy of the
+  disk. The memory region holds a header, a chunk table and the chunks. The
+  disk is cut into chunks of ChunkSize bytes, and each chunk is either elided
+  (all zeros), stored as is, or stored as a PI GUID-defined section that the
+  RAM disk driver decodes with the extract handler registered for the section
+  GUID (LZMA, Brotli, Tiano...). Chunks are decoded on first read.
+
+  Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __RAM_DISK_COMPRESSED_IMAGE_GUID_H__
+#define __RAM_DISK_COMPRESSED_IMAGE_GUID_H__
+
+#define EDKII_RAM_DISK_COMPRESSED_IMAGE_GUID \
+  { \
+    0x6c1b0f4e, 0x93a2, 0x4d57, {0xb0, 0x8c, 0x5e, 0x27, 0xd1, 0x4a, 0x96, 0x3f} \
+  }
+
+#define EDKII_RAM_DISK_COMPRESSED_IMAGE_SIGNATURE  SIGNATURE_32 ('R', 'D', 'C', 'I')
+
+//
+// Chunk types.
+//
+#define EDKII_RAM_DISK_COMPRESSED_CHUNK_ZERO     0
+#define EDKII_RAM_DISK_COMPRESSED_CHUNK_STORED   1
+#define EDKII_RAM_DISK_COMPRESSED_CHUNK_GUIDED   2
+
+#pragma pack(1)
+
+///
+/// The header at the start of a compressed RAM disk image.
+///
+typedef struct {
+  ///
+  /// EDKII_RAM_DISK_COMPRESSED_IMAGE_SIGNATURE.
+  ///
+  UINT32    Signature;
+  ///
+  /// Offset of the chunk table from the start of the image.
+  ///
+  UINT32    HeaderSize;
+  ///
+  /// The type of the expanded disk, for example gEfiVirtualDiskGuid or
+  /// gEfiVirtualCdGuid. It is the type in the RAM disk device path node.
+  ///
+  EFI_GUID  DiskType;
+  ///
+  /// Size of the expanded disk in bytes, a multiple of 512.
+  ///
+  UINT64    DiskSize;
+  ///
+  /// Size of a chunk of the expanded disk in bytes, a multiple of 512. The
+  /// last chunk may be shorter.
+  ///
+  UINT32    ChunkSize;
+  ///
+  /// Number of entries in the chunk table.
+  ///
+  UINT32    ChunkCount;
+} EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER;
+
+///
+/// An entry of the chunk table.
+///
+typedef struct {
+  ///
+  /// Offset of the chunk data from the start of the image. Ignored for
+  /// EDKII_RAM_DISK_COMPRESSED_CHUNK_ZERO.
+  ///
+  UINT64    Offset;
+  ///
+  /// Size of the chunk data in bytes. Ignored for
+  /// EDKII_RAM_DISK_COMPRESSED_CHUNK_ZERO.
+  ///
+  UINT32    Length;
+  ///
+  /// One of the EDKII_RAM_DISK_COMPRESSED_CHUNK_* types.
+  ///
+  UINT32    Type;
+} EDKII_RAM_DISK_COMPRESSED_CHUNK;
+
+#pragma pack()
+
+extern EFI_GUID gEdkiiRamDiskCompressedImageGuid;
+
+#endif
@@ -0,0 +1,127 @@
+/** @file
+
+  EDKII Boot Services Profile Protocol.
+
+  When PcdDxeBootServicesProfile is TRUE, the DXE Core measures the calls made
+  through the Boot Services Table and the DXE Services Table. For each measured
+  service it counts the calls and sums the time they take. It also keeps these
+  totals per calling image. This protocol returns the collected data, so that
+  tools like the dp shell command can show which drivers use which services
+  most.
+
+  The time of a service includes the time of any service it calls itself, for
+  example the notification functions that RestoreTPL() dispatches.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EDKII_BOOT_SERVICES_PROFILE_H__
+#define __EDKII_BOOT_SERVICES_PROFILE_H__
+
+#define EDKII_BOOT_SERVICES_PROFILE_PROTOCOL_GUID \
+    { \
+      0x5c0a7e91, 0x2b6d, 0x4e38, { 0xa4, 0x1f, 0x93, 0xd2, 0x6c, 0x08, 0xb5, 0x7e } \
+    }
+
+#define EDKII_BOOT_SERVICE_PROFILE_NAME_SIZE  32
+
+//
+// Forward reference for pure ANSI compatability
+//
+typedef struct _EDKII_BOOT_SERVICES_PROFILE_PROTOCOL  EDKII_BOOT_SERVICES_PROFILE_PROTOCOL;
+
+///
+/// The totals of one measured service.
+///
+typedef struct {
+  ///
+  /// The name of the service, for example "OpenProtocol".
+  ///
+  CHAR8                   Name[EDKII_BOOT_SERVICE_PROFILE_NAME_SIZE];
+  UINT64                  CallCount;
+  ///
+  /// The total time spent in the service, in nanoseconds.
+  ///
+  UINT64                  Duration;
+} EDKII_BOOT_SERVICE_PROFILE_SERVICE;
+
+///
+/// The totals of one measured service for one calling image.
+///
+typedef struct {
+  ///
+  /// Index of the service in the array returned by GetData().
+  ///
+  UINT32                  ServiceIndex;
+  UINT32                  Reserved;
+  ///
+  /// The image handle of the caller, or NULL if the caller is not in a loaded image.
+  ///
+  EFI_HANDLE              ImageHandle;
+  UINT64                  CallCount;
+  ///
+  /// The total time spent in the service for this caller, in nanoseconds.
+  ///
+  UINT64                  Duration;
+} EDKII_BOOT_SERVICE_PROFILE_CALLER;
+
+/**
+  Get the data collected so far.
+
+  @param  This              The protocol instance pointer.
+  @param  ServiceCount      On return, the number of entries in Services.
+  @param  Services          On return, the totals of each measured service. The
+                            caller frees the buffer with FreePool().
+  @param  CallerCount       On return, the number of entries in Callers.
+  @param  Callers           On return, the totals of each service per calling
+                            image. The caller frees the buffer with FreePool().
+
+  @retval EFI_SUCCESS            The data was returned.
+  @retval EFI_INVALID_PARAMETER  One of the parameters is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources to return the data.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_BOOT_SERVICES_PROFILE_GET_DATA)(
+  IN  EDKII_BOOT_SERVICES_PROFILE_PROTOCOL  *This,
+  OUT UINTN                                 *ServiceCount,
+  OUT EDKII_BOOT_SERVICE_PROFILE_SERVICE    **Services,
+  OUT UINTN                                 *CallerCount,
+  OUT EDKII_BOOT_SERVICE_PROFILE_CALLER     **Callers
+  );
+
+/**
+  Discard the data collected so far.
+
+  @param  This              The protocol instance pointer.
+
+  @retval EFI_SUCCESS       The data was discarded.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_BOOT_SERVICES_PROFILE_RESET)(
+  IN EDKII_BOOT_SERVICES_PROFILE_PROTOCOL   *This
+  );
+
+///
+/// The EDKII Boot Services Profile Protocol reports the call counts and the
+/// time spent in the boot services, per service and per calling image.
+///
+struct _EDKII_BOOT_SERVICES_PROFILE_PROTOCOL {
+  EDKII_BOOT_SERVICES_PROFILE_GET_DATA  GetData;
+  EDKII_BOOT_SERVICES_PROFILE_RESET     Reset;
+};
+
+extern EFI_GUID gEdkiiBootServicesProfileProtocolGuid;
+
+#endif
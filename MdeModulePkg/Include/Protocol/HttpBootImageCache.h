@@ -0,0 +1,130 @@
+/** @file
+
+  EDKII HTTP Boot Image Cache Protocol.
+
+  The HTTP boot driver keeps the boot files it downloads in a cache on the EFI
+  system partition, and revalidates them with a conditional request on the
+  next boot. It installs this protocol on its image handle, so that tools like
+  the httpcache shell command can list and clear the cached files.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EDKII_HTTP_BOOT_IMAGE_CACHE_H__
+#define __EDKII_HTTP_BOOT_IMAGE_CACHE_H__
+
+#define EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL_GUID \
+    { \
+      0x4d1f9a72, 0xc63e, 0x4b05, { 0x8a, 0x17, 0xe2, 0x5b, 0x90, 0x3c, 0x6f, 0xd4 } \
+    }
+
+#define EDKII_HTTP_BOOT_IMAGE_CACHE_URI_SIZE        512
+#define EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE  64
+
+//
+// Forward reference for pure ANSI compatability
+//
+typedef struct _EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL  EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL;
+
+///
+/// A boot file in the cache.
+///
+typedef struct {
+  ///
+  /// The URI the file was downloaded from, NULL terminated.
+  ///
+  CHAR8                   Uri[EDKII_HTTP_BOOT_IMAGE_CACHE_URI_SIZE];
+  ///
+  /// The ETag of the file returned by the server, NULL terminated, or empty.
+  ///
+  CHAR8                   ETag[EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE];
+  ///
+  /// The Last-Modified date of the file returned by the server, NULL
+  /// terminated, or empty.
+  ///
+  CHAR8                   LastModified[EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE];
+  ///
+  /// The size of the file in bytes.
+  ///
+  UINT64                  Size;
+  ///
+  /// The CRC32 of the file, checked when the file is loaded from the cache.
+  ///
+  UINT32                  Crc32;
+  ///
+  /// The number of boots the file was loaded from the cache.
+  ///
+  UINT32                  Hits;
+  ///
+  /// When the file was last used, in a sequence shared by all the files.
+  /// The least recently used files are evicted first.
+  ///
+  UINT64                  LastUsed;
+} EDKII_HTTP_BOOT_IMAGE_CACHE_ENTRY;
+
+/**
+  Get the boot files in the cache.
+
+  @param  This              The protocol instance pointer.
+  @param  Count             On return, the number of entries in Entries.
+  @param  Entries           On return, the cached files. The caller frees the
+                            buffer with FreePool().
+  @param  UsedSize          On return, the total size of the cached files in bytes.
+  @param  MaxSize           On return, the size limit of the cache in bytes.
+
+  @retval EFI_SUCCESS            The cached files were returned.
+  @retval EFI_NOT_FOUND          The cache is empty.
+  @retval EFI_INVALID_PARAMETER  Count, Entries, UsedSize or MaxSize is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources to return the
+                                 cached files.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_HTTP_BOOT_IMAGE_CACHE_GET_ENTRIES)(
+  IN  EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL  *This,
+  OUT UINTN                                 *Count,
+  OUT EDKII_HTTP_BOOT_IMAGE_CACHE_ENTRY     **Entries,
+  OUT UINT64                                *UsedSize,
+  OUT UINT64                                *MaxSize
+  );
+
+/**
+  Remove boot files from the cache.
+
+  @param  This              The protocol instance pointer.
+  @param  Uri               The URI of the file to remove, or NULL to remove
+                            all the files.
+
+  @retval EFI_SUCCESS            The files were removed.
+  @retval EFI_NOT_FOUND          Uri is not in the cache.
+  @retval Others                 The cache couldn't be updated.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_HTTP_BOOT_IMAGE_CACHE_REMOVE)(
+  IN  EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL  *This,
+  IN  CHAR8                                 *Uri OPTIONAL
+  );
+
+///
+/// The EDKII HTTP Boot Image Cache Protocol lists and removes the boot files
+/// cached by the HTTP boot driver.
+///
+struct _EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL {
+  EDKII_HTTP_BOOT_IMAGE_CACHE_GET_ENTRIES  GetEntries;
+  EDKII_HTTP_BOOT_IMAGE_CACHE_REMOVE       Remove;
+};
+
+extern EFI_GUID gEdkiiHttpBootImageCacheProtocolGuid;
+
+#endif
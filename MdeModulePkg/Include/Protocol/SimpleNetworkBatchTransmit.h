@@ -0,0 +1,104 @@
+/** @file
+
+  EDKII Simple Network Batch Transmit Protocol.
+
+  A network interface driver installs this protocol on the handle of its
+  Simple Network Protocol when it can hand several packets to the hardware at
+  once, for example by filling several transmit descriptors before it notifies
+  the device. The Managed Network Protocol driver then queues the packets its
+  clients transmit and passes them to the driver in batches.
+
+  The packets are owned by the driver until it returns them through
+  EFI_SIMPLE_NETWORK_PROTOCOL.GetStatus(), exactly like the packets passed to
+  EFI_SIMPLE_NETWORK_PROTOCOL.Transmit().
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_H__
+#define __EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_H__
+
+#include <Protocol/SimpleNetwork.h>
+
+#define EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL_GUID \
+    { \
+      0x3e8a5f1c, 0x94d2, 0x4b7e, { 0xb6, 0x0d, 0x2f, 0x71, 0xc8, 0x5a, 0x13, 0xe9 } \
+    }
+
+#define EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL_REVISION  0x00010000
+
+//
+// Forward reference for pure ANSI compatability
+//
+typedef struct _EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL  EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL;
+
+///
+/// One packet of a batch. The fields have the meaning of the parameters of
+/// EFI_SIMPLE_NETWORK_PROTOCOL.Transmit().
+///
+typedef struct {
+  UINTN                   HeaderSize;
+  UINTN                   BufferSize;
+  VOID                    *Buffer;
+  EFI_MAC_ADDRESS         *SrcAddr;     OPTIONAL
+  EFI_MAC_ADDRESS         *DestAddr;    OPTIONAL
+  UINT16                  *Protocol;    OPTIONAL
+} EDKII_SIMPLE_NETWORK_TRANSMIT_PACKET;
+
+/**
+  Places several packets in the transmit queue of a network interface.
+
+  The packets are placed in the transmit queue in order. The function stops at
+  the first packet it cannot place in the queue.
+
+  On return, whatever the status, the first *PacketCount packets have been
+  handed to the network interface. They are owned by the driver until it
+  returns them through EFI_SIMPLE_NETWORK_PROTOCOL.GetStatus(), which it may
+  never do if the interface failed while sending them. The remaining packets
+  have not been touched and stay owned by the caller.
+
+  @param  This              The protocol instance pointer.
+  @param  PacketCount       On input, the number of packets in Packets. On
+                            output, the number of packets handed to the
+                            network interface.
+  @param  Packets           The packets to transmit.
+
+  @retval EFI_SUCCESS           All the packets were placed on the transmit queue.
+  @retval EFI_NOT_STARTED       The network interface has not been started.
+  @retval EFI_NOT_READY         The network interface is too busy to accept
+                                more packets. The first *PacketCount packets
+                                were placed on the transmit queue.
+  @retval EFI_INVALID_PARAMETER One or more of the parameters has an
+                                unsupported value.
+  @retval EFI_DEVICE_ERROR      The network interface failed. The first
+                                *PacketCount packets were handed to it.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_SIMPLE_NETWORK_TRANSMIT_BATCH)(
+  IN     EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL  *This,
+  IN OUT UINTN                                         *PacketCount,
+  IN     EDKII_SIMPLE_NETWORK_TRANSMIT_PACKET          *Packets
+  );
+
+///
+/// The EDKII Simple Network Batch Transmit Protocol lets the Managed Network
+/// Protocol driver pass several packets to a network interface in one call.
+///
+struct _EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL {
+  UINT64                                Revision;
+  EDKII_SIMPLE_NETWORK_TRANSMIT_BATCH   TransmitBatch;
+};
+
+extern EFI_GUID gEdkiiSimpleNetworkBatchTransmitProtocolGuid;
+
+#endif
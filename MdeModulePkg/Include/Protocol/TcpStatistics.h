@@ -0,0 +1,128 @@
+/** @file
+
+  EDKII TCP Statistics Protocol.
+
+  The TCP driver installs this protocol on its image handle. It returns the
+  state of the congestion control and the retransmission counters of each
+  TCP connection, so that tools like the tcpstat shell command can show why
+  a transfer is slow.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EDKII_TCP_STATISTICS_H__
+#define __EDKII_TCP_STATISTICS_H__
+
+#define EDKII_TCP_STATISTICS_PROTOCOL_GUID \
+    { \
+      0x8b2c4f6e, 0x1d7a, 0x4c93, { 0x9e, 0x25, 0x6a, 0xf0, 0x3b, 0xd8, 0x47, 0xc1 } \
+    }
+
+#define EDKII_TCP_CONGESTION_CONTROL_NAME_SIZE  16
+
+//
+// Forward reference for pure ANSI compatability
+//
+typedef struct _EDKII_TCP_STATISTICS_PROTOCOL  EDKII_TCP_STATISTICS_PROTOCOL;
+
+///
+/// The statistics of one TCP connection.
+///
+typedef struct {
+  ///
+  /// IP_VERSION_4 or IP_VERSION_6.
+  ///
+  UINT8                   IpVersion;
+  ///
+  /// The state of the connection, as an EFI_TCP4_CONNECTION_STATE value.
+  ///
+  UINT8                   State;
+  UINT16                  LocalPort;
+  UINT16                  RemotePort;
+  UINT16                  Mss;
+  EFI_IP_ADDRESS          LocalAddress;
+  EFI_IP_ADDRESS          RemoteAddress;
+  ///
+  /// The name of the congestion control algorithm, for example "cubic".
+  ///
+  CHAR8                   CongestionControl[EDKII_TCP_CONGESTION_CONTROL_NAME_SIZE];
+  ///
+  /// The congestion window, in bytes.
+  ///
+  UINT32                  CongestionWindow;
+  ///
+  /// The slow start threshold, in bytes.
+  ///
+  UINT32                  SlowStartThreshold;
+  ///
+  /// The send window advertised by the peer, in bytes.
+  ///
+  UINT32                  SendWindow;
+  ///
+  /// The receive window advertised to the peer, in bytes.
+  ///
+  UINT32                  ReceiveWindow;
+  ///
+  /// The smoothed round trip time, in milliseconds.
+  ///
+  UINT32                  SmoothedRtt;
+  ///
+  /// The retransmission timeout, in milliseconds.
+  ///
+  UINT32                  Rto;
+  ///
+  /// The number of segments retransmitted.
+  ///
+  UINT32                  Retransmits;
+  ///
+  /// The number of times fast retransmission was entered.
+  ///
+  UINT32                  FastRetransmits;
+  ///
+  /// The number of retransmission timeouts.
+  ///
+  UINT32                  Timeouts;
+} EDKII_TCP_CONNECTION_STATISTICS;
+
+/**
+  Get the statistics of the TCP connections.
+
+  @param  This              The protocol instance pointer.
+  @param  Count             On return, the number of entries in Connections.
+  @param  Connections       On return, the statistics of each connection. The
+                            caller frees the buffer with FreePool().
+
+  @retval EFI_SUCCESS            The statistics were returned.
+  @retval EFI_NOT_FOUND          There is no TCP connection.
+  @retval EFI_INVALID_PARAMETER  Count or Connections is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources to return the
+                                 statistics.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_TCP_STATISTICS_GET_CONNECTIONS)(
+  IN  EDKII_TCP_STATISTICS_PROTOCOL     *This,
+  OUT UINTN                             *Count,
+  OUT EDKII_TCP_CONNECTION_STATISTICS   **Connections
+  );
+
+///
+/// The EDKII TCP Statistics Protocol reports the congestion control state and
+/// the retransmission counters of the TCP connections.
+///
+struct _EDKII_TCP_STATISTICS_PROTOCOL {
+  EDKII_TCP_STATISTICS_GET_CONNECTIONS  GetConnections;
+};
+
+extern EFI_GUID gEdkiiTcpStatisticsProtocolGuid;
+
+#endif
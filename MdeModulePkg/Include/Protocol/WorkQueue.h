@@ -0,0 +1,114 @@
+/** @file
+
+  EDKII Work Queue Protocol.
+
+  The work queue lets DXE drivers move long-running initialization work that
+  does not need any boot service, such as waiting for a PHY to autonegotiate,
+  tuning an eMMC device or training a PCIe link, to secondary processors.
+  The work queue is produced by the DXE Core when PcdDxeWorkQueueSupport is
+  TRUE, and runs work on the processors reported by the MP Services Protocol.
+
+  A typical driver submits its slow hardware initialization from its entry
+  point, returns, and installs its protocols from the notification function
+  of the completion event. The DXE Dispatcher waits for outstanding work before
+  it concludes that no more drivers can be dispatched.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EDKII_WORK_QUEUE_H__
+#define __EDKII_WORK_QUEUE_H__
+
+#define EDKII_WORK_QUEUE_PROTOCOL_GUID \
+    { \
+      0x7b1e4c2d, 0x35a9, 0x4f60, { 0x8d, 0x52, 0xc1, 0x0e, 0x9a, 0x67, 0xf4, 0x3b } \
+    }
+
+//
+// Forward reference for pure ANSI compatability
+//
+typedef struct _EDKII_WORK_QUEUE_PROTOCOL  EDKII_WORK_QUEUE_PROTOCOL;
+
+/**
+  A unit of work submitted to the work queue.
+
+  The procedure may run on an application processor, concurrently with the
+  boot processor and with other work. It must not call any UEFI boot service,
+  DXE service or library function that relies on them (including DebugLib),
+  and it must only access memory and devices the submitter leaves alone until
+  the completion event is signaled.
+
+  @param  Context           The context passed to Submit().
+
+**/
+typedef
+VOID
+(EFIAPI *EDKII_WORK_PROCEDURE)(
+  IN OUT VOID  *Context
+  );
+
+/**
+  Submit a unit of work.
+
+  The work runs as soon as a processor is available. If no application
+  processor is available, the work runs on the boot processor before this
+  function returns.
+
+  @param  This              The protocol instance pointer.
+  @param  Procedure         The work procedure.
+  @param  Context           The context passed to Procedure.
+  @param  CompletionEvent   The event signaled on the boot processor after
+                            Procedure has returned. It is optional.
+
+  @retval EFI_SUCCESS            The work was submitted.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources to queue the work.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_WORK_QUEUE_SUBMIT)(
+  IN EDKII_WORK_QUEUE_PROTOCOL  *This,
+  IN EDKII_WORK_PROCEDURE       Procedure,
+  IN VOID                       *Context          OPTIONAL,
+  IN EFI_EVENT                  CompletionEvent   OPTIONAL
+  );
+
+/**
+  Wait until all work submitted so far has completed and its completion
+  events have been signaled.
+
+  This function must be called at a TPL lower than TPL_CALLBACK.
+
+  @param  This              The protocol instance pointer.
+
+  @retval EFI_SUCCESS            All work has completed.
+  @retval EFI_UNSUPPORTED        The current TPL is TPL_CALLBACK or higher.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_WORK_QUEUE_WAIT)(
+  IN EDKII_WORK_QUEUE_PROTOCOL  *This
+  );
+
+///
+/// The EDKII Work Queue Protocol runs boot-services-free work on secondary
+/// processors.
+///
+struct _EDKII_WORK_QUEUE_PROTOCOL {
+  EDKII_WORK_QUEUE_SUBMIT  Submit;
+  EDKII_WORK_QUEUE_WAIT    Wait;
+};
+
+extern EFI_GUID gEdkiiWorkQueueProtocolGuid;
+
+#endif
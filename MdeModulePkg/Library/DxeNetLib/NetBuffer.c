@@ -20,6 +20,144 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
 
+//
+// The NET_BUF and NET_VECTOR structures released by the driver are kept in
+// per-size free lists and reused, instead of going back to the UEFI pool for
+// each packet. Only the structures of up to NET_BUF_POOL_CLASSES blocks are
+// recycled, at most NET_BUF_POOL_DEPTH of each size.
+//
+#define NET_BUF_POOL_CLASSES      4
+#define NET_BUF_POOL_DEPTH        32
+
+typedef struct {
+  VOID                      *Free[NET_BUF_POOL_CLASSES];
+  UINT32                    Count[NET_BUF_POOL_CLASSES];
+} NET_BUF_POOL;
+
+NET_BUF_POOL                mNetbufPool;
+NET_BUF_POOL                mNetVectorPool;
+
+/**
+  Allocate a NET_BUF or NET_VECTOR structure, from the free list of its size
+  if it isn't empty.
+
+  @param[in, out]  Pool       The pool of the structure.
+  @param[in]       Num        The number of NET_BLOCK_OP or NET_BLOCK in the structure.
+  @param[in]       Size       The size of the structure in bytes.
+
+  @return                     Pointer to the un-initialized structure, or NULL if the
+                              allocation failed due to resource limit.
+
+**/
+VOID *
+NetbufPoolAllocate (
+  IN OUT NET_BUF_POOL       *Pool,
+  IN     UINT32             Num,
+  IN     UINTN              Size
+  )
+{
+  VOID                      *Object;
+  EFI_TPL                   OldTpl;
+
+  Object = NULL;
+
+  if ((Num >= 1) && (Num <= NET_BUF_POOL_CLASSES)) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    Object = Pool->Free[Num - 1];
+    if (Object != NULL) {
+      Pool->Free[Num - 1] = *(VOID **) Object;
+      Pool->Count[Num - 1]--;
+    }
+
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  if (Object == NULL) {
+    Object = AllocatePool (Size);
+  }
+
+  return Object;
+}
+
+/**
+  Release a NET_BUF or NET_VECTOR structure to the free list of its size, or
+  to the UEFI pool if the free list is full.
+
+  The first bytes of the structure are overwritten by the free list link, so
+  its signature is invalid once it is released.
+
+  @param[in, out]  Pool       The pool of the structure.
+  @param[in]       Num        The number of NET_BLOCK_OP or NET_BLOCK in the structure.
+  @param[in]       Object     Pointer to the structure to release.
+
+**/
+VOID
+NetbufPoolFree (
+  IN OUT NET_BUF_POOL       *Pool,
+  IN     UINT32             Num,
+  IN     VOID               *Object
+  )
+{
+  EFI_TPL                   OldTpl;
+
+  if ((Num >= 1) && (Num <= NET_BUF_POOL_CLASSES)) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    if (Pool->Count[Num - 1] < NET_BUF_POOL_DEPTH) {
+      *(VOID **) Object   = Pool->Free[Num - 1];
+      Pool->Free[Num - 1] = Object;
+      Pool->Count[Num - 1]++;
+      Object              = NULL;
+    }
+
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  if (Object != NULL) {
+    FreePool (Object);
+  }
+}
+
+/**
+  Release the NET_BUF and NET_VECTOR structures kept in the free lists when
+  the driver is unloaded.
+
+  @param[in]  ImageHandle       The firmware allocated handle for the EFI image.
+  @param[in]  SystemTable       A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS           The free lists are released.
+
+**/
+EFI_STATUS
+EFIAPI
+NetbufPoolDestructor (
+  IN EFI_HANDLE             ImageHandle,
+  IN EFI_SYSTEM_TABLE       *SystemTable
+  )
+{
+  NET_BUF_POOL              *Pool[2];
+  VOID                      *Object;
+  UINTN                     Index;
+  UINTN                     Class;
+
+  Pool[0] = &mNetbufPool;
+  Pool[1] = &mNetVectorPool;
+
+  for (Index = 0; Index < ARRAY_SIZE (Pool); Index++) {
+    for (Class = 0; Class < NET_BUF_POOL_CLASSES; Class++) {
+      while (Pool[Index]->Free[Class] != NULL) {
+        Object                     = Pool[Index]->Free[Class];
+        Pool[Index]->Free[Class]   = *(VOID **) Object;
+        FreePool (Object);
+      }
+
+      Pool[Index]->Count[Class] = 0;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
 
 /**
   Allocate and build up the sketch for a NET_BUF.
@@ -49,24 +187,28 @@ NetbufAllocStruct (
   //
   // Allocate three memory blocks.
   //
-  Nbuf = AllocateZeroPool (NET_BUF_SIZE (BlockOpNum));
+  Nbuf = NetbufPoolAllocate (&mNetbufPool, BlockOpNum, NET_BUF_SIZE (BlockOpNum));
 
   if (Nbuf == NULL) {
     return NULL;
   }
 
+  ZeroMem (Nbuf, NET_BUF_SIZE (BlockOpNum));
+
   Nbuf->Signature           = NET_BUF_SIGNATURE;
   Nbuf->RefCnt              = 1;
   Nbuf->BlockOpNum          = BlockOpNum;
   InitializeListHead (&Nbuf->List);
 
   if (BlockNum != 0) {
-    Vector = AllocateZeroPool (NET_VECTOR_SIZE (BlockNum));
+    Vector = NetbufPoolAllocate (&mNetVectorPool, BlockNum, NET_VECTOR_SIZE (BlockNum));
 
     if (Vector == NULL) {
       goto FreeNbuf;
     }
 
+    ZeroMem (Vector, NET_VECTOR_SIZE (BlockNum));
+
     Vector->Signature = NET_VECTOR_SIGNATURE;
     Vector->RefCnt    = 1;
     Vector->BlockNum  = BlockNum;
@@ -77,7 +219,7 @@ NetbufAllocStruct (
 
 FreeNbuf:
 
-  FreePool (Nbuf);
+  NetbufPoolFree (&mNetbufPool, BlockOpNum, Nbuf);
   return NULL;
 }
 
@@ -132,7 +274,8 @@ NetbufAlloc (
   return Nbuf;
 
 FreeNBuf:
-  FreePool (Nbuf);
+  NetbufPoolFree (&mNetVectorPool, Nbuf->Vector->BlockNum, Nbuf->Vector);
+  NetbufPoolFree (&mNetbufPool, Nbuf->BlockOpNum, Nbuf);
   return NULL;
 }
 
@@ -184,7 +327,7 @@ NetbufFreeVector (
     }
   }
 
-  FreePool (Vector);
+  NetbufPoolFree (&mNetVectorPool, Vector->BlockNum, Vector);
 }
 
 
@@ -218,7 +361,7 @@ NetbufFree (
     // all the sharing of Nbuf increse Vector's RefCnt by one
     //
     NetbufFreeVector (Nbuf->Vector);
-    FreePool (Nbuf);
+    NetbufPoolFree (&mNetbufPool, Nbuf->BlockOpNum, Nbuf);
   }
 }
 
@@ -245,7 +388,7 @@ NetbufClone (
 
   NET_CHECK_SIGNATURE (Nbuf, NET_BUF_SIGNATURE);
 
-  Clone = AllocatePool (NET_BUF_SIZE (Nbuf->BlockOpNum));
+  Clone = NetbufPoolAllocate (&mNetbufPool, Nbuf->BlockOpNum, NET_BUF_SIZE (Nbuf->BlockOpNum));
 
   if (Clone == NULL) {
     return NULL;
@@ -685,7 +828,8 @@ NetbufGetFragment (
 
 FreeChild:
 
-  FreePool (Child);
+  NetbufPoolFree (&mNetVectorPool, Child->Vector->BlockNum, Child->Vector);
+  NetbufPoolFree (&mNetbufPool, Child->BlockOpNum, Child);
   return NULL;
 }
 
@@ -1661,7 +1805,8 @@ NetblockChecksum (
   IN UINT32                 Len
   )
 {
-  register UINT32           Sum;
+  register UINT64           Sum;
+  UINT32                    *Words;
 
   Sum = 0;
 
@@ -1672,6 +1817,36 @@ NetblockChecksum (
     Sum += *(Bulk + Len - 1);
   }
 
+  //
+  // Add the data 32 bits at a time when it is at least 16-bit aligned. The
+  // 32-bit words folded to 16 bits give the same sum as the 16-bit words, since
+  // 0x10000 is 1 modulo 0xFFFF, and the 64-bit sum can't overflow for a UINT32
+  // length.
+  //
+  if (((UINTN) Bulk & 0x01) == 0) {
+    if ((((UINTN) Bulk & 0x02) != 0) && (Len > 1)) {
+      Sum  += *(UINT16 *) Bulk;
+      Bulk += 2;
+      Len  -= 2;
+    }
+
+    Words = (UINT32 *) Bulk;
+
+    while (Len >= 16) {
+      Sum   += (UINT64) Words[0] + Words[1] + Words[2] + Words[3];
+      Words += 4;
+      Len   -= 16;
+    }
+
+    while (Len >= 4) {
+      Sum += *Words;
+      Words++;
+      Len -= 4;
+    }
+
+    Bulk = (UINT8 *) Words;
+  }
+
   while (Len > 1) {
     Sum += *(UINT16 *) Bulk;
     Bulk += 2;
@@ -1679,7 +1854,7 @@ NetblockChecksum (
   }
 
   //
-  // Fold 32-bit sum to 16 bits
+  // Fold 64-bit sum to 16 bits
   //
   while ((Sum >> 16) != 0) {
     Sum = (Sum & 0xffff) + (Sum >> 16);
@@ -1889,8 +2064,8 @@ NetIpSecNetbufFree (
     if ((Nbuf->Vector->Flag & NET_VECTOR_OWN_FIRST) != 0) {
       FreePool (Nbuf->Vector->Block[0].Bulk);
     }
-    FreePool (Nbuf->Vector);
-    FreePool (Nbuf); 
+    NetbufPoolFree (&mNetVectorPool, Nbuf->Vector->BlockNum, Nbuf->Vector);
+    NetbufPoolFree (&mNetbufPool, Nbuf->BlockOpNum, Nbuf); 
   } 
 }
 
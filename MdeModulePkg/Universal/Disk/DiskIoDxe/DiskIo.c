@@ -8,8 +8,11 @@
                less than a sector in length.
     Aligned  - A read of N contiguous sectors.
     OverRun  - The last byte is not on a sector boundary.
+  When all the sectors of an unaligned request fit in the working buffer, they
+  are transferred at once instead. Requests within one sector can be served by
+  a small LRU sector cache.
 
-Copyright (c) 2006 - 2016, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -54,6 +57,283 @@ DISK_IO_PRIVATE_DATA        gDiskIoPrivateDataTemplate = {
   }
 };
 
+/**
+  Get an aligned bounce buffer from the pool of the instance, or allocate it.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Pages        The number of pages of the buffer.
+
+  @return A pointer to the buffer, or NULL if there are not enough resources.
+**/
+VOID *
+DiskIoAllocateBounceBuffer (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINTN                    Pages
+  )
+{
+  VOID                        *Buffer;
+
+  if (Pages > Instance->BounceBufferPages) {
+    return AllocateAlignedPages (Pages, Instance->BlockIo->Media->IoAlign);
+  }
+
+  Buffer = NULL;
+  EfiAcquireLock (&Instance->BounceBufferLock);
+  if (Instance->BounceBufferCount != 0) {
+    Buffer = Instance->BounceBuffers[--Instance->BounceBufferCount];
+    Instance->BounceBufferReuses++;
+  }
+  EfiReleaseLock (&Instance->BounceBufferLock);
+
+  if (Buffer == NULL) {
+    Buffer = AllocateAlignedPages (Instance->BounceBufferPages, Instance->BlockIo->Media->IoAlign);
+  }
+  return Buffer;
+}
+
+/**
+  Return a bounce buffer got from DiskIoAllocateBounceBuffer() to the pool of
+  the instance, or free it.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Buffer       The buffer.
+  @param Pages        The number of pages the buffer was requested with.
+**/
+VOID
+DiskIoFreeBounceBuffer (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN VOID                     *Buffer,
+  IN UINTN                    Pages
+  )
+{
+  if (Pages > Instance->BounceBufferPages) {
+    FreeAlignedPages (Buffer, Pages);
+    return;
+  }
+
+  EfiAcquireLock (&Instance->BounceBufferLock);
+  if (Instance->BounceBufferCount < DISK_IO_BOUNCE_BUFFER_NUM) {
+    Instance->BounceBuffers[Instance->BounceBufferCount++] = Buffer;
+    Buffer = NULL;
+  }
+  EfiReleaseLock (&Instance->BounceBufferLock);
+
+  if (Buffer != NULL) {
+    FreeAlignedPages (Buffer, Instance->BounceBufferPages);
+  }
+}
+
+/**
+  Free the bounce buffers in the pool of the instance.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoFreeBounceBuffers (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  while (Instance->BounceBufferCount != 0) {
+    FreeAlignedPages (Instance->BounceBuffers[--Instance->BounceBufferCount], Instance->BounceBufferPages);
+  }
+}
+
+/**
+  Free the sector cache of the instance.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoFreeCache (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  if (Instance->CacheBuffer != NULL) {
+    FreeAlignedPages (Instance->CacheBuffer, Instance->CacheBufferPages);
+    Instance->CacheBuffer = NULL;
+  }
+  if (Instance->CacheEntries != NULL) {
+    FreePool (Instance->CacheEntries);
+    Instance->CacheEntries = NULL;
+  }
+  InitializeListHead (&Instance->CacheList);
+  Instance->CacheEntryNum = 0;
+}
+
+/**
+  Allocate the sector cache of the instance, PcdDiskIoCacheBlockNum blocks.
+
+  The cache is only used on non-removable media, where a hit cannot hide a
+  media change from the caller. It's left empty when the PCD is 0 or when
+  there are not enough resources.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoInitCache (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  EFI_BLOCK_IO_MEDIA          *Media;
+  UINTN                       EntryNum;
+  UINTN                       EntrySize;
+  UINTN                       Index;
+
+  Media    = Instance->BlockIo->Media;
+  EntryNum = PcdGet32 (PcdDiskIoCacheBlockNum);
+
+  InitializeListHead (&Instance->CacheList);
+  Instance->CacheEntryNum = 0;
+  if ((EntryNum == 0) || Media->RemovableMedia) {
+    return;
+  }
+
+  //
+  // Keep every block of the cache aligned as the device requires.
+  //
+  EntrySize = ALIGN_VALUE (Media->BlockSize, MAX (Media->IoAlign, 1));
+
+  Instance->CacheEntries     = AllocateZeroPool (EntryNum * sizeof (DISK_IO_CACHE_ENTRY));
+  Instance->CacheBufferPages = EFI_SIZE_TO_PAGES (EntryNum * EntrySize);
+  Instance->CacheBuffer      = AllocateAlignedPages (Instance->CacheBufferPages, Media->IoAlign);
+  if ((Instance->CacheEntries == NULL) || (Instance->CacheBuffer == NULL)) {
+    DEBUG ((EFI_D_WARN, "DiskIo: No enough memory for the sector cache\n"));
+    DiskIoFreeCache (Instance);
+    return;
+  }
+
+  for (Index = 0; Index < EntryNum; Index++) {
+    Instance->CacheEntries[Index].Signature = DISK_IO_CACHE_ENTRY_SIGNATURE;
+    Instance->CacheEntries[Index].Data      = Instance->CacheBuffer + Index * EntrySize;
+    InsertTailList (&Instance->CacheList, &Instance->CacheEntries[Index].Link);
+  }
+  Instance->CacheEntryNum = EntryNum;
+}
+
+/**
+  Read the data of a request within one block through the sector cache.
+
+  The block is looked up in the cache first. When it's not cached and Fill is
+  TRUE, it's read from the device into the least recently used entry.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId      ID of the medium to be read.
+  @param Offset       The starting byte offset on the device to read from.
+  @param BufferSize   The number of bytes to read.
+  @param Buffer       A pointer to the destination buffer for the data.
+  @param Fill         TRUE to read the block from the device when it's not cached.
+
+  @retval EFI_SUCCESS   The data was read.
+  @retval EFI_NOT_FOUND The request cannot be served by the cache.
+  @retval others        The block couldn't be read from the device.
+**/
+EFI_STATUS
+DiskIoCacheRead (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT32                   MediaId,
+  IN UINT64                   Offset,
+  IN UINTN                    BufferSize,
+  OUT UINT8                   *Buffer,
+  IN BOOLEAN                  Fill
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_BLOCK_IO_MEDIA          *Media;
+  UINT64                      Lba;
+  UINT32                      UnderRun;
+  LIST_ENTRY                  *Link;
+  DISK_IO_CACHE_ENTRY         *Entry;
+
+  Media = Instance->BlockIo->Media;
+  if ((BufferSize == 0) || (MediaId != Media->MediaId) || !Media->MediaPresent) {
+    return EFI_NOT_FOUND;
+  }
+
+  Lba = DivU64x32Remainder (Offset, Media->BlockSize, &UnderRun);
+  if (UnderRun + BufferSize > Media->BlockSize) {
+    return EFI_NOT_FOUND;
+  }
+
+  for ( Link = GetFirstNode (&Instance->CacheList)
+      ; !IsNull (&Instance->CacheList, Link)
+      ; Link = GetNextNode (&Instance->CacheList, Link)
+      ) {
+    Entry = CR (Link, DISK_IO_CACHE_ENTRY, Link, DISK_IO_CACHE_ENTRY_SIGNATURE);
+    if (Entry->Valid && (Entry->Lba == Lba) && (Entry->MediaId == MediaId)) {
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&Instance->CacheList, &Entry->Link);
+      CopyMem (Buffer, Entry->Data + UnderRun, BufferSize);
+      Instance->CacheHits++;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (!Fill) {
+    return EFI_NOT_FOUND;
+  }
+
+  Instance->CacheMisses++;
+  Entry = CR (GetPreviousNode (&Instance->CacheList, &Instance->CacheList), DISK_IO_CACHE_ENTRY, Link, DISK_IO_CACHE_ENTRY_SIGNATURE);
+  Entry->Valid = FALSE;
+  Status = Instance->BlockIo->ReadBlocks (Instance->BlockIo, MediaId, Lba, Media->BlockSize, Entry->Data);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Entry->Valid   = TRUE;
+  Entry->MediaId = MediaId;
+  Entry->Lba     = Lba;
+  RemoveEntryList (&Entry->Link);
+  InsertHeadList (&Instance->CacheList, &Entry->Link);
+  CopyMem (Buffer, Entry->Data + UnderRun, BufferSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Drop the blocks written by a request from the sector cache.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Offset       The starting byte offset on the device to write to.
+  @param BufferSize   The number of bytes to write.
+**/
+VOID
+DiskIoCacheInvalidate (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT64                   Offset,
+  IN UINTN                    BufferSize
+  )
+{
+  UINT32                      BlockSize;
+  UINT64                      StartLba;
+  UINT64                      EndLba;
+  LIST_ENTRY                  *Link;
+  LIST_ENTRY                  *NextLink;
+  DISK_IO_CACHE_ENTRY         *Entry;
+
+  if (BufferSize == 0) {
+    return;
+  }
+
+  BlockSize = Instance->BlockIo->Media->BlockSize;
+  StartLba  = DivU64x32 (Offset, BlockSize);
+  EndLba    = DivU64x32 (Offset + BufferSize - 1, BlockSize);
+
+  //
+  // Move the dropped entries to the tail so that they are reused first.
+  //
+  for ( Link = GetFirstNode (&Instance->CacheList), NextLink = GetNextNode (&Instance->CacheList, Link)
+      ; !IsNull (&Instance->CacheList, Link)
+      ; Link = NextLink, NextLink = GetNextNode (&Instance->CacheList, NextLink)
+      ) {
+    Entry = CR (Link, DISK_IO_CACHE_ENTRY, Link, DISK_IO_CACHE_ENTRY_SIGNATURE);
+    if (Entry->Valid && (Entry->Lba >= StartLba) && (Entry->Lba <= EndLba)) {
+      Entry->Valid = FALSE;
+      RemoveEntryList (&Entry->Link);
+      InsertTailList (&Instance->CacheList, &Entry->Link);
+    }
+  }
+}
+
 /**
   Test to see if this driver supports ControllerHandle. 
 
@@ -182,6 +462,9 @@ DiskIoDriverBindingStart (
   
   InitializeListHead (&Instance->TaskQueue);
   EfiInitializeLock (&Instance->TaskQueueLock, TPL_NOTIFY);
+  EfiInitializeLock (&Instance->BounceBufferLock, TPL_NOTIFY);
+  Instance->BounceBufferPages = EFI_SIZE_TO_PAGES (Instance->BlockIo->Media->BlockSize);
+  DiskIoInitCache (Instance);
   Instance->SharedWorkingBuffer = AllocateAlignedPages (
                                     EFI_SIZE_TO_PAGES (PcdGet32 (PcdDiskIoDataBufferBlockNum) * Instance->BlockIo->Media->BlockSize),
                                     Instance->BlockIo->Media->IoAlign
@@ -219,6 +502,7 @@ ErrorExit:
     }
 
     if (Instance != NULL) {
+      DiskIoFreeCache (Instance);
       FreePool (Instance);
     }
 
@@ -322,10 +606,18 @@ DiskIoDriverBindingStop (
       EfiReleaseLock (&Instance->TaskQueueLock);
     } while (!AllTaskDone);
 
+    DEBUG ((
+      EFI_D_INFO,
+      "DiskIo: BlockIo calls saved: %ld by merging, %ld by the cache (%ld misses); %ld bounce buffers reused\n",
+      Instance->MergedBlockIoCalls, Instance->CacheHits, Instance->CacheMisses, Instance->BounceBufferReuses
+      ));
+
     FreeAlignedPages (
       Instance->SharedWorkingBuffer,
       EFI_SIZE_TO_PAGES (PcdGet32 (PcdDiskIoDataBufferBlockNum) * Instance->BlockIo->Media->BlockSize)
       );
+    DiskIoFreeBounceBuffers (Instance);
+    DiskIoFreeCache (Instance);
 
     Status = gBS->CloseProtocol (
                     ControllerHandle,
@@ -351,6 +643,27 @@ DiskIoDriverBindingStop (
 }
 
 
+/**
+  Get the number of bytes a subtask transfers from or to the device, the
+  blocks covering its Offset and Length.
+
+  @param BlockSize    The block size of the device.
+  @param Subtask      Subtask.
+
+  @return The number of bytes to transfer.
+**/
+UINTN
+DiskIoSubtaskTransferLength (
+  IN UINT32                   BlockSize,
+  IN DISK_IO_SUBTASK          *Subtask
+  )
+{
+  if (Subtask->Length == 0) {
+    return 0;
+  }
+  return ((Subtask->Offset + Subtask->Length + BlockSize - 1) / BlockSize) * BlockSize;
+}
+
 /**
   Destroy the sub task.
 
@@ -377,11 +690,10 @@ DiskIoDestroySubtask (
 
   if (!Subtask->Blocking) {
     if (Subtask->WorkingBuffer != NULL) {
-      FreeAlignedPages (
-        Subtask->WorkingBuffer, 
-        Subtask->Length < Instance->BlockIo->Media->BlockSize
-        ? EFI_SIZE_TO_PAGES (Instance->BlockIo->Media->BlockSize)
-        : EFI_SIZE_TO_PAGES (Subtask->Length)
+      DiskIoFreeBounceBuffer (
+        Instance,
+        Subtask->WorkingBuffer,
+        EFI_SIZE_TO_PAGES (DiskIoSubtaskTransferLength (Instance->BlockIo->Media->BlockSize, Subtask))
         );
     }
     if (Subtask->BlockIo2Token.Event != NULL) {
@@ -506,6 +818,150 @@ DiskIoCreateSubtask (
   return Subtask;
 }
 
+/**
+  Create the subtasks transferring all the blocks covered by an unaligned
+  request at once through one working buffer, instead of separate UnderRun,
+  Aligned and OverRun subtasks.
+
+  @param Instance            Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Write               TRUE: Write request; FALSE: Read request.
+  @param Lba                 The first block of the request.
+  @param UnderRun            The starting byte offset of the request in the first block.
+  @param BufferSize          The size in bytes of Buffer.
+  @param Buffer              A pointer to the buffer for the data.
+  @param Blocking            TRUE: Blocking request; FALSE: Non-blocking request.
+  @param SharedWorkingBuffer The aligned buffer to hold the data for reading or writing.
+  @param Subtasks            The subtask list header.
+
+  @retval TRUE  The subtasks are created and appended to the list.
+  @retval FALSE The request is aligned, doesn't fit in the working buffer or
+                the subtasks cannot be created; the list is not changed.
+**/
+BOOLEAN
+DiskIoCreateMergedSubtaskList (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN BOOLEAN               Write,
+  IN UINT64                Lba,
+  IN UINT32                UnderRun,
+  IN UINTN                 BufferSize,
+  IN VOID                  *Buffer,
+  IN BOOLEAN               Blocking,
+  IN VOID                  *SharedWorkingBuffer,
+  IN OUT LIST_ENTRY        *Subtasks
+  )
+{
+  UINT32                BlockSize;
+  UINT32                IoAlign;
+  UINT64                BlockCount;
+  UINT32                OverRun;
+  UINTN                 SplitCalls;
+  UINTN                 MergedCalls;
+  UINT8                 *WorkingBuffer;
+  UINTN                 LastBlockOffset;
+  DISK_IO_SUBTASK       *Subtask;
+  LIST_ENTRY            MergedSubtasks;
+  LIST_ENTRY            *Link;
+
+  BlockSize = Instance->BlockIo->Media->BlockSize;
+  IoAlign   = Instance->BlockIo->Media->IoAlign;
+  if (IoAlign == 0) {
+    IoAlign = 1;
+  }
+
+  BlockCount = DivU64x32Remainder ((UINT64) UnderRun + BufferSize, BlockSize, &OverRun);
+  if (OverRun != 0) {
+    BlockCount++;
+  }
+  if (((UnderRun == 0) && (OverRun == 0)) || (BlockCount < 2) ||
+      (BlockCount > PcdGet32 (PcdDiskIoDataBufferBlockNum))) {
+    return FALSE;
+  }
+
+  //
+  // A write reads the partially written blocks first. The last one is read
+  // in place, so it has to be aligned as well.
+  //
+  LastBlockOffset = (UINTN) (BlockCount - 1) * BlockSize;
+  if (Write && (OverRun != 0) && (LastBlockOffset % IoAlign != 0)) {
+    return FALSE;
+  }
+
+  //
+  // Count the BlockIo calls of the split subtasks and of the merged ones.
+  //
+  SplitCalls  = (UnderRun != 0 ? 1 : 0) + (OverRun != 0 ? 1 : 0);
+  MergedCalls = 1;
+  if (Write) {
+    MergedCalls += ((UnderRun != 0) && (OverRun != 0) && (BlockCount == 2)) ? 1 : SplitCalls;
+    SplitCalls  *= 2;
+  }
+  if (BlockCount > (UINT64) ((UnderRun != 0 ? 1 : 0) + (OverRun != 0 ? 1 : 0))) {
+    SplitCalls++;
+  }
+
+  if (Blocking) {
+    WorkingBuffer = SharedWorkingBuffer;
+  } else {
+    WorkingBuffer = DiskIoAllocateBounceBuffer (Instance, EFI_SIZE_TO_PAGES (LastBlockOffset + BlockSize));
+    if (WorkingBuffer == NULL) {
+      return FALSE;
+    }
+  }
+
+  InitializeListHead (&MergedSubtasks);
+  if (Write) {
+    if ((UnderRun != 0) && (OverRun != 0) && (BlockCount == 2)) {
+      Subtask = DiskIoCreateSubtask (FALSE, Lba, 0, 2 * BlockSize, NULL, WorkingBuffer, TRUE);
+      if (Subtask == NULL) {
+        goto Done;
+      }
+      InsertTailList (&MergedSubtasks, &Subtask->Link);
+    } else {
+      if (UnderRun != 0) {
+        Subtask = DiskIoCreateSubtask (FALSE, Lba, 0, BlockSize, NULL, WorkingBuffer, TRUE);
+        if (Subtask == NULL) {
+          goto Done;
+        }
+        InsertTailList (&MergedSubtasks, &Subtask->Link);
+      }
+      if (OverRun != 0) {
+        Subtask = DiskIoCreateSubtask (FALSE, Lba + BlockCount - 1, 0, BlockSize, NULL, WorkingBuffer + LastBlockOffset, TRUE);
+        if (Subtask == NULL) {
+          goto Done;
+        }
+        InsertTailList (&MergedSubtasks, &Subtask->Link);
+      }
+    }
+  }
+
+  Subtask = DiskIoCreateSubtask (Write, Lba, UnderRun, BufferSize, WorkingBuffer, Buffer, Blocking);
+  if (Subtask == NULL) {
+    goto Done;
+  }
+  InsertTailList (&MergedSubtasks, &Subtask->Link);
+
+  while (!IsListEmpty (&MergedSubtasks)) {
+    Link = GetFirstNode (&MergedSubtasks);
+    RemoveEntryList (Link);
+    InsertTailList (Subtasks, Link);
+  }
+  Instance->MergedBlockIoCalls += SplitCalls - MergedCalls;
+  return TRUE;
+
+Done:
+  //
+  // Only the blocking block-reads may have been created, they don't own the working buffer.
+  //
+  for (Link = GetFirstNode (&MergedSubtasks); !IsNull (&MergedSubtasks, Link); ) {
+    Subtask = CR (Link, DISK_IO_SUBTASK, Link, DISK_IO_SUBTASK_SIGNATURE);
+    Link = DiskIoDestroySubtask (Instance, Subtask);
+  }
+  if (!Blocking) {
+    DiskIoFreeBounceBuffer (Instance, WorkingBuffer, EFI_SIZE_TO_PAGES (LastBlockOffset + BlockSize));
+  }
+  return FALSE;
+}
+
 /**
   Create the subtask list.
 
@@ -569,12 +1025,16 @@ DiskIoCreateSubtaskList (
     return TRUE;
   }
 
+  if (DiskIoCreateMergedSubtaskList (Instance, Write, Lba, UnderRun, BufferSize, BufferPtr, Blocking, SharedWorkingBuffer, Subtasks)) {
+    return TRUE;
+  }
+
   if (UnderRun != 0) {
     Length = MIN (BlockSize - UnderRun, BufferSize);
     if (Blocking) {
       WorkingBuffer = SharedWorkingBuffer;
     } else {
-      WorkingBuffer = AllocateAlignedPages (EFI_SIZE_TO_PAGES (BlockSize), IoAlign);
+      WorkingBuffer = DiskIoAllocateBounceBuffer (Instance, EFI_SIZE_TO_PAGES (BlockSize));
       if (WorkingBuffer == NULL) {
         goto Done;
       }
@@ -610,7 +1070,7 @@ DiskIoCreateSubtaskList (
     if (Blocking) {
       WorkingBuffer = SharedWorkingBuffer;
     } else {
-      WorkingBuffer = AllocateAlignedPages (EFI_SIZE_TO_PAGES (BlockSize), IoAlign);
+      WorkingBuffer = DiskIoAllocateBounceBuffer (Instance, EFI_SIZE_TO_PAGES (BlockSize));
       if (WorkingBuffer == NULL) {
         goto Done;
       }
@@ -669,7 +1129,7 @@ DiskIoCreateSubtaskList (
           BufferSize -= DataBufferSize;
         }
       } else {
-        WorkingBuffer = AllocateAlignedPages (EFI_SIZE_TO_PAGES (BufferSize), IoAlign);
+        WorkingBuffer = DiskIoAllocateBounceBuffer (Instance, EFI_SIZE_TO_PAGES (BufferSize));
         if (WorkingBuffer == NULL) {
           //
           // If there is not enough memory, downgrade to blocking access
@@ -838,7 +1298,33 @@ DiskIo2ReadWriteDisk (
     // Wait till pending async task is completed.
     //
     while (!DiskIo2RemoveCompletedTask (Instance));
+  }
+
+  if (Instance->CacheEntryNum != 0) {
+    OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+    if (Write) {
+      DiskIoCacheInvalidate (Instance, Offset, BufferSize);
+      Status = EFI_NOT_FOUND;
+    } else {
+      //
+      // Only blocking requests fill the cache, the non-blocking ones are served on hits.
+      //
+      Status = DiskIoCacheRead (Instance, MediaId, Offset, BufferSize, Buffer, Blocking);
+    }
+    gBS->RestoreTPL (OldTpl);
 
+    if (Status != EFI_NOT_FOUND) {
+      if (!Blocking) {
+        Token->TransactionStatus = Status;
+        gBS->SignalEvent (Token->Event);
+        Status = EFI_SUCCESS;
+      }
+      return Status;
+    }
+    Status = EFI_SUCCESS;
+  }
+
+  if (Blocking) {
     SubtasksPtr = &Subtasks;
   } else {
     DiskIo2RemoveCompletedTask (Instance);
@@ -877,7 +1363,7 @@ DiskIo2ReadWriteDisk (
     Subtask->Task   = Task;
     SubtaskBlocking = Subtask->Blocking;
 
-    ASSERT ((Subtask->Length % Media->BlockSize == 0) || (Subtask->Length < Media->BlockSize));
+    ASSERT ((Subtask->Length % Media->BlockSize == 0) || (Subtask->WorkingBuffer != NULL));
 
     if (Subtask->Write) {
       //
@@ -895,7 +1381,7 @@ DiskIo2ReadWriteDisk (
                             BlockIo,
                             MediaId,
                             Subtask->Lba,
-                            (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
+                            DiskIoSubtaskTransferLength (Media->BlockSize, Subtask),
                             (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
                             );
       } else {
@@ -904,7 +1390,7 @@ DiskIo2ReadWriteDisk (
                              MediaId,
                              Subtask->Lba,
                              &Subtask->BlockIo2Token,
-                             (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
+                             DiskIoSubtaskTransferLength (Media->BlockSize, Subtask),
                              (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
                              );
       }
@@ -918,7 +1404,7 @@ DiskIo2ReadWriteDisk (
                             BlockIo,
                             MediaId,
                             Subtask->Lba,
-                            (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
+                            DiskIoSubtaskTransferLength (Media->BlockSize, Subtask),
                             (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
                             );
         if (!EFI_ERROR (Status) && (Subtask->WorkingBuffer != NULL)) {
@@ -930,7 +1416,7 @@ DiskIo2ReadWriteDisk (
                              MediaId,
                              Subtask->Lba,
                              &Subtask->BlockIo2Token,
-                             (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
+                             DiskIoSubtaskTransferLength (Media->BlockSize, Subtask),
                              (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
                              );
       }
@@ -1,7 +1,7 @@
 /** @file
   Master header file for DiskIo driver. It includes the module private defininitions.
 
-Copyright (c) 2006 - 2013, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -30,6 +30,21 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
+//
+// The number of aligned bounce buffers kept for reuse by each instance.
+//
+#define DISK_IO_BOUNCE_BUFFER_NUM       8
+
+#define DISK_IO_CACHE_ENTRY_SIGNATURE   SIGNATURE_32 ('d', 'i', 'c', 'e')
+typedef struct {
+  UINT32                          Signature;
+  LIST_ENTRY                      Link;     /// < link in the LRU list, most recently used first
+  BOOLEAN                         Valid;
+  UINT32                          MediaId;
+  UINT64                          Lba;
+  UINT8                           *Data;    /// < one block of data
+} DISK_IO_CACHE_ENTRY;
+
 #define DISK_IO_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'I')
 typedef struct {
   UINT32                          Signature;
@@ -43,6 +58,32 @@ typedef struct {
 
   EFI_LOCK                        TaskQueueLock;
   LIST_ENTRY                      TaskQueue;
+
+  //
+  // Aligned bounce buffers of BounceBufferPages pages released by the
+  // non-blocking subtasks, handed out again to the next ones.
+  //
+  EFI_LOCK                        BounceBufferLock;
+  UINTN                           BounceBufferPages;
+  UINTN                           BounceBufferCount;
+  VOID                            *BounceBuffers[DISK_IO_BOUNCE_BUFFER_NUM];
+
+  //
+  // LRU cache of the blocks read by the requests within one block.
+  //
+  LIST_ENTRY                      CacheList;
+  DISK_IO_CACHE_ENTRY             *CacheEntries;
+  UINTN                           CacheEntryNum;
+  UINT8                           *CacheBuffer;
+  UINTN                           CacheBufferPages;
+
+  //
+  // Statistics
+  //
+  UINT64                          MergedBlockIoCalls;
+  UINT64                          CacheHits;
+  UINT64                          CacheMisses;
+  UINT64                          BounceBufferReuses;
 } DISK_IO_PRIVATE_DATA;
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO(a)  CR (a, DISK_IO_PRIVATE_DATA, DiskIo,  DISK_IO_PRIVATE_DATA_SIGNATURE)
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO2(a) CR (a, DISK_IO_PRIVATE_DATA, DiskIo2, DISK_IO_PRIVATE_DATA_SIGNATURE)
@@ -70,6 +111,8 @@ typedef struct {
   // UnderRun:  Offset != 0, Length < BlockSize
   // OverRun:   Offset == 0, Length < BlockSize
   // Middle:    Offset is block aligned, Length is multiple of block size
+  // Merged:    Offset < BlockSize, the blocks covering Offset and Length are
+  //            transferred through WorkingBuffer at once
   //
   UINT32                          Signature;
   LIST_ENTRY                      Link;
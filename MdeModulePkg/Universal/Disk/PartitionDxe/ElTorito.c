@@ -2,7 +2,7 @@
   Decode an El Torito formatted CD-ROM
 
 Copyright (c) 2018 Qualcomm Datacenter Technologies, Inc.
-Copyright (c) 2006 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -27,6 +27,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
   @param[in]  BlockIo     Parent BlockIo interface.
   @param[in]  BlockIo2    Parent BlockIo2 interface.
   @param[in]  DevicePath  Parent Device Path
+  @param[in]  Probe       Sectors read from the start of the media
 
 
   @retval EFI_SUCCESS         Child handle(s) was added.
@@ -42,7 +43,8 @@ PartitionInstallElToritoChildHandles (
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   )
 {
   EFI_STATUS                   Status;
@@ -94,13 +96,13 @@ PartitionInstallElToritoChildHandles (
   for (VolDescriptorOffset = SIZE_32KB;
        VolDescriptorOffset <= MultU64x32 (Media->LastBlock, Media->BlockSize);
        VolDescriptorOffset += SIZE_2KB) {
-    Status = DiskIo->ReadDisk (
-                       DiskIo,
-                       Media->MediaId,
-                       VolDescriptorOffset,
-                       SIZE_2KB,
-                       VolDescriptor
-                       );
+    Status = PartitionProbeReadDisk (
+                             Probe,
+                             Media->MediaId,
+                             VolDescriptorOffset,
+                             SIZE_2KB,
+                             VolDescriptor
+                             );
     if (EFI_ERROR (Status)) {
       Found = Status;
       break;
@@ -139,13 +141,13 @@ PartitionInstallElToritoChildHandles (
       continue;
     }
 
-    Status = DiskIo->ReadDisk (
-                       DiskIo,
-                       Media->MediaId,
-                       MultU64x32 (Lba2KB, SIZE_2KB),
-                       SIZE_2KB,
-                       Catalog
-                       );
+    Status = PartitionProbeReadDisk (
+                             Probe,
+                             Media->MediaId,
+                             MultU64x32 (Lba2KB, SIZE_2KB),
+                             SIZE_2KB,
+                             Catalog
+                             );
     if (EFI_ERROR (Status)) {
       DEBUG ((EFI_D_ERROR, "EltCheckDevice: error reading catalog %r\n", Status));
       continue;
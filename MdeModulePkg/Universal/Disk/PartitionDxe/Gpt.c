@@ -14,7 +14,7 @@
   partition content and validate the GPT table and GPT entry.
 
 Copyright (c) 2018 Qualcomm Datacenter Technologies, Inc.
-Copyright (c) 2006 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -36,7 +36,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
   will do basic validation for GPT partition table header before return.
 
   @param[in]  BlockIo     Parent BlockIo interface.
-  @param[in]  DiskIo      Disk Io protocol.
+  @param[in]  Probe       Sectors read from the start of the media.
   @param[in]  Lba         The starting Lba of the Partition Table
   @param[out] PartHeader  Stores the partition table that is read
 
@@ -47,7 +47,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 BOOLEAN
 PartitionValidGptTable (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
-  IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
+  IN  PARTITION_PROBE_CONTEXT     *Probe,
   IN  EFI_LBA                     Lba,
   OUT EFI_PARTITION_TABLE_HEADER  *PartHeader
   );
@@ -57,7 +57,7 @@ PartitionValidGptTable (
   for Partition entry array.
 
   @param[in]  BlockIo     Parent BlockIo interface
-  @param[in]  DiskIo      Disk Io Protocol.
+  @param[in]  Probe       Sectors read from the start of the media.
   @param[in]  PartHeader  Partition table header structure
 
   @retval TRUE      the CRC is valid
@@ -67,7 +67,7 @@ PartitionValidGptTable (
 BOOLEAN
 PartitionCheckGptEntryArrayCRC (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
-  IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
+  IN  PARTITION_PROBE_CONTEXT     *Probe,
   IN  EFI_PARTITION_TABLE_HEADER  *PartHeader
   );
 
@@ -77,7 +77,7 @@ PartitionCheckGptEntryArrayCRC (
   (Primary -> Backup or Backup -> Primary).
 
   @param[in]  BlockIo     Parent BlockIo interface.
-  @param[in]  DiskIo      Disk Io Protocol.
+  @param[in]  Probe       Sectors read from the start of the media.
   @param[in]  PartHeader  Partition table header structure.
 
   @retval TRUE      Restoring succeeds
@@ -87,7 +87,7 @@ PartitionCheckGptEntryArrayCRC (
 BOOLEAN
 PartitionRestoreGptTable (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
-  IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
+  IN  PARTITION_PROBE_CONTEXT     *Probe,
   IN  EFI_PARTITION_TABLE_HEADER  *PartHeader
   );
 
@@ -189,6 +189,7 @@ PartitionSetCrc (
   @param[in]  BlockIo    Parent BlockIo interface.
   @param[in]  BlockIo2   Parent BlockIo2 interface.
   @param[in]  DevicePath Parent Device Path.
+  @param[in]  Probe      Sectors read from the start of the media.
 
   @retval EFI_SUCCESS           Valid GPT disk.
   @retval EFI_MEDIA_CHANGED     Media changed Detected.
@@ -203,7 +204,8 @@ PartitionInstallGptChildHandles (
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   )
 {
   EFI_STATUS                   Status;
@@ -247,13 +249,13 @@ PartitionInstallGptChildHandles (
   //
   // Read the Protective MBR from LBA #0
   //
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     0,
-                     BlockSize,
-                     ProtectiveMbr
-                     );
+  Status = PartitionProbeReadDisk (
+                           Probe,
+                           MediaId,
+                           0,
+                           BlockSize,
+                           ProtectiveMbr
+                           );
   if (EFI_ERROR (Status)) {
     GptValidStatus = Status;
     goto Done;
@@ -290,31 +292,31 @@ PartitionInstallGptChildHandles (
   //
   // Check primary and backup partition tables
   //
-  if (!PartitionValidGptTable (BlockIo, DiskIo, PRIMARY_PART_HEADER_LBA, PrimaryHeader)) {
+  if (!PartitionValidGptTable (BlockIo, Probe, PRIMARY_PART_HEADER_LBA, PrimaryHeader)) {
     DEBUG ((EFI_D_INFO, " Not Valid primary partition table\n"));
 
-    if (!PartitionValidGptTable (BlockIo, DiskIo, LastBlock, BackupHeader)) {
+    if (!PartitionValidGptTable (BlockIo, Probe, LastBlock, BackupHeader)) {
       DEBUG ((EFI_D_INFO, " Not Valid backup partition table\n"));
       goto Done;
     } else {
       DEBUG ((EFI_D_INFO, " Valid backup partition table\n"));
       DEBUG ((EFI_D_INFO, " Restore primary partition table by the backup\n"));
-      if (!PartitionRestoreGptTable (BlockIo, DiskIo, BackupHeader)) {
+      if (!PartitionRestoreGptTable (BlockIo, Probe, BackupHeader)) {
         DEBUG ((EFI_D_INFO, " Restore primary partition table error\n"));
       }
 
-      if (PartitionValidGptTable (BlockIo, DiskIo, BackupHeader->AlternateLBA, PrimaryHeader)) {
+      if (PartitionValidGptTable (BlockIo, Probe, BackupHeader->AlternateLBA, PrimaryHeader)) {
         DEBUG ((EFI_D_INFO, " Restore backup partition table success\n"));
       }
     }
-  } else if (!PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader)) {
+  } else if (!PartitionValidGptTable (BlockIo, Probe, PrimaryHeader->AlternateLBA, BackupHeader)) {
     DEBUG ((EFI_D_INFO, " Valid primary and !Valid backup partition table\n"));
     DEBUG ((EFI_D_INFO, " Restore backup partition table by the primary\n"));
-    if (!PartitionRestoreGptTable (BlockIo, DiskIo, PrimaryHeader)) {
+    if (!PartitionRestoreGptTable (BlockIo, Probe, PrimaryHeader)) {
       DEBUG ((EFI_D_INFO, " Restore backup partition table error\n"));
     }
 
-    if (PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader)) {
+    if (PartitionValidGptTable (BlockIo, Probe, PrimaryHeader->AlternateLBA, BackupHeader)) {
       DEBUG ((EFI_D_INFO, " Restore backup partition table success\n"));
     }
 
@@ -331,13 +333,13 @@ PartitionInstallGptChildHandles (
     goto Done;
   }
 
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     MultU64x32(PrimaryHeader->PartitionEntryLBA, BlockSize),
-                     PrimaryHeader->NumberOfPartitionEntries * (PrimaryHeader->SizeOfPartitionEntry),
-                     PartEntry
-                     );
+  Status = PartitionProbeReadDisk (
+                           Probe,
+                           MediaId,
+                           MultU64x32(PrimaryHeader->PartitionEntryLBA, BlockSize),
+                           PrimaryHeader->NumberOfPartitionEntries * (PrimaryHeader->SizeOfPartitionEntry),
+                           PartEntry
+                           );
   if (EFI_ERROR (Status)) {
     GptValidStatus = Status;
     DEBUG ((EFI_D_ERROR, " Partition Entry ReadDisk error\n"));
@@ -455,7 +457,7 @@ Done:
   will do basic validation for GPT partition table header before return.
 
   @param[in]  BlockIo     Parent BlockIo interface.
-  @param[in]  DiskIo      Disk Io protocol.
+  @param[in]  Probe       Sectors read from the start of the media.
   @param[in]  Lba         The starting Lba of the Partition Table
   @param[out] PartHeader  Stores the partition table that is read
 
@@ -466,7 +468,7 @@ Done:
 BOOLEAN
 PartitionValidGptTable (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
-  IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
+  IN  PARTITION_PROBE_CONTEXT     *Probe,
   IN  EFI_LBA                     Lba,
   OUT EFI_PARTITION_TABLE_HEADER  *PartHeader
   )
@@ -487,13 +489,13 @@ PartitionValidGptTable (
   //
   // Read the EFI Partition Table Header
   //
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     MultU64x32 (Lba, BlockSize),
-                     BlockSize,
-                     PartHdr
-                     );
+  Status = PartitionProbeReadDisk (
+                           Probe,
+                           MediaId,
+                           MultU64x32 (Lba, BlockSize),
+                           BlockSize,
+                           PartHdr
+                           );
   if (EFI_ERROR (Status)) {
     FreePool (PartHdr);
     return FALSE;
@@ -518,7 +520,7 @@ PartitionValidGptTable (
   }
 
   CopyMem (PartHeader, PartHdr, sizeof (EFI_PARTITION_TABLE_HEADER));
-  if (!PartitionCheckGptEntryArrayCRC (BlockIo, DiskIo, PartHeader)) {
+  if (!PartitionCheckGptEntryArrayCRC (BlockIo, Probe, PartHeader)) {
     FreePool (PartHdr);
     return FALSE;
   }
@@ -533,7 +535,7 @@ PartitionValidGptTable (
   for Partition entry array.
 
   @param[in]  BlockIo     Parent BlockIo interface
-  @param[in]  DiskIo      Disk Io Protocol.
+  @param[in]  Probe       Sectors read from the start of the media.
   @param[in]  PartHeader  Partition table header structure
 
   @retval TRUE      the CRC is valid
@@ -543,7 +545,7 @@ PartitionValidGptTable (
 BOOLEAN
 PartitionCheckGptEntryArrayCRC (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
-  IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
+  IN  PARTITION_PROBE_CONTEXT     *Probe,
   IN  EFI_PARTITION_TABLE_HEADER  *PartHeader
   )
 {
@@ -561,13 +563,13 @@ PartitionCheckGptEntryArrayCRC (
     return FALSE;
   }
 
-  Status = DiskIo->ReadDisk (
-                    DiskIo,
-                    BlockIo->Media->MediaId,
-                    MultU64x32(PartHeader->PartitionEntryLBA, BlockIo->Media->BlockSize),
-                    PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry,
-                    Ptr
-                    );
+  Status = PartitionProbeReadDisk (
+                          Probe,
+                          BlockIo->Media->MediaId,
+                          MultU64x32(PartHeader->PartitionEntryLBA, BlockIo->Media->BlockSize),
+                          PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry,
+                          Ptr
+                          );
   if (EFI_ERROR (Status)) {
     FreePool (Ptr);
     return FALSE;
@@ -593,7 +595,7 @@ PartitionCheckGptEntryArrayCRC (
   (Primary -> Backup or Backup -> Primary).
 
   @param[in]  BlockIo     Parent BlockIo interface.
-  @param[in]  DiskIo      Disk Io Protocol.
+  @param[in]  Probe       Sectors read from the start of the media.
   @param[in]  PartHeader  Partition table header structure.
 
   @retval TRUE      Restoring succeeds
@@ -603,7 +605,7 @@ PartitionCheckGptEntryArrayCRC (
 BOOLEAN
 PartitionRestoreGptTable (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
-  IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
+  IN  PARTITION_PROBE_CONTEXT     *Probe,
   IN  EFI_PARTITION_TABLE_HEADER  *PartHeader
   )
 {
@@ -638,13 +640,13 @@ PartitionRestoreGptTable (
   PartHdr->PartitionEntryLBA  = PEntryLBA;
   PartitionSetCrc ((EFI_TABLE_HEADER *) PartHdr);
 
-  Status = DiskIo->WriteDisk (
-                     DiskIo,
-                     MediaId,
-                     MultU64x32 (PartHdr->MyLBA, (UINT32) BlockSize),
-                     BlockSize,
-                     PartHdr
-                     );
+  Status = PartitionProbeWriteDisk (
+                           Probe,
+                           MediaId,
+                           MultU64x32 (PartHdr->MyLBA, (UINT32) BlockSize),
+                           BlockSize,
+                           PartHdr
+                           );
   if (EFI_ERROR (Status)) {
     goto Done;
   }
@@ -656,24 +658,24 @@ PartitionRestoreGptTable (
     goto Done;
   }
 
-  Status = DiskIo->ReadDisk (
-                    DiskIo,
-                    MediaId,
-                    MultU64x32(PartHeader->PartitionEntryLBA, (UINT32) BlockSize),
-                    PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry,
-                    Ptr
-                    );
+  Status = PartitionProbeReadDisk (
+                          Probe,
+                          MediaId,
+                          MultU64x32(PartHeader->PartitionEntryLBA, (UINT32) BlockSize),
+                          PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry,
+                          Ptr
+                          );
   if (EFI_ERROR (Status)) {
     goto Done;
   }
 
-  Status = DiskIo->WriteDisk (
-                    DiskIo,
-                    MediaId,
-                    MultU64x32(PEntryLBA, (UINT32) BlockSize),
-                    PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry,
-                    Ptr
-                    );
+  Status = PartitionProbeWriteDisk (
+                          Probe,
+                          MediaId,
+                          MultU64x32(PEntryLBA, (UINT32) BlockSize),
+                          PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry,
+                          Ptr
+                          );
 
 Done:
   FreePool (PartHdr);
@@ -13,7 +13,7 @@
 
 Copyright (c) 2018 Qualcomm Datacenter Technologies, Inc.
 Copyright (c) 2014, Hewlett-Packard Development Company, L.P.<BR>
-Copyright (c) 2006 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -113,6 +113,7 @@ PartitionValidMbr (
   @param[in]  BlockIo           Parent BlockIo interface.
   @param[in]  BlockIo2          Parent BlockIo2 interface.
   @param[in]  DevicePath        Parent Device Path.
+  @param[in]  Probe             Sectors read from the start of the media.
    
   @retval EFI_SUCCESS       A child handle was added.
   @retval EFI_MEDIA_CHANGED Media change was detected.
@@ -127,7 +128,8 @@ PartitionInstallMbrChildHandles (
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   )
 {
   EFI_STATUS                   Status;
@@ -155,13 +157,13 @@ PartitionInstallMbrChildHandles (
     return Found;
   }
 
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     0,
-                     BlockSize,
-                     Mbr
-                     );
+  Status = PartitionProbeReadDisk (
+                           Probe,
+                           MediaId,
+                           0,
+                           BlockSize,
+                           Mbr
+                           );
   if (EFI_ERROR (Status)) {
     Found = Status;
     goto Done;
@@ -265,13 +267,13 @@ PartitionInstallMbrChildHandles (
 
     do {
 
-      Status = DiskIo->ReadDisk (
-                         DiskIo,
-                         MediaId,
-                         MultU64x32 (ExtMbrStartingLba, BlockSize),
-                         BlockSize,
-                         Mbr
-                         );
+      Status = PartitionProbeReadDisk (
+                               Probe,
+                               MediaId,
+                               MultU64x32 (ExtMbrStartingLba, BlockSize),
+                               BlockSize,
+                               Mbr
+                               );
       if (EFI_ERROR (Status)) {
         Found = Status;
         goto Done;
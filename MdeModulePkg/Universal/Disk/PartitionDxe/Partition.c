@@ -203,6 +203,7 @@ PartitionDriverBindingStart (
   PARTITION_DETECT_ROUTINE  *Routine;
   BOOLEAN                   MediaPresent;
   EFI_TPL                   OldTpl;
+  PARTITION_PROBE_CONTEXT   Probe;
 
   BlockIo2 = NULL;
   OldTpl = gBS->RaiseTPL (TPL_CALLBACK); 
@@ -310,6 +311,8 @@ PartitionDriverBindingStart (
     // If the media supports a given partition type install child handles to
     // represent the partitions described by the media.
     //
+    PartitionProbeInit (&Probe, DiskIo, BlockIo);
+
     Routine = &mPartitionDetectRoutineTable[0];
     while (*Routine != NULL) {
       Status = (*Routine) (
@@ -319,13 +322,16 @@ PartitionDriverBindingStart (
                    DiskIo2,
                    BlockIo,
                    BlockIo2,
-                   ParentDevicePath
+                   ParentDevicePath,
+                   &Probe
                    );
       if (!EFI_ERROR (Status) || Status == EFI_MEDIA_CHANGED || Status == EFI_NO_MEDIA) {
         break;
       }
       Routine++;
     }
+
+    PartitionProbeFree (&Probe);
   }
   //
   // In the case that the driver is already started (OpenStatus == EFI_ALREADY_STARTED),
@@ -1362,3 +1368,155 @@ HasChildren (
   return (BOOLEAN) (Index < EntryCount);
 }
 
+
+/**
+  Read the start of the media with a single request, for the partition detect
+  routines to share.
+
+  If the read fails, the probe context is still usable and all the reads go to
+  the media.
+
+  @param[out] Probe       The probe context to initialize.
+  @param[in]  DiskIo      Parent DiskIo interface.
+  @param[in]  BlockIo     Parent BlockIo interface.
+
+**/
+VOID
+PartitionProbeInit (
+  OUT PARTITION_PROBE_CONTEXT      *Probe,
+  IN  EFI_DISK_IO_PROTOCOL         *DiskIo,
+  IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo
+  )
+{
+  EFI_STATUS                       Status;
+  UINT64                           MediaSize;
+  UINTN                            Size;
+
+  ZeroMem (Probe, sizeof (PARTITION_PROBE_CONTEXT));
+  Probe->DiskIo  = DiskIo;
+  Probe->MediaId = BlockIo->Media->MediaId;
+
+  if (!BlockIo->Media->MediaPresent) {
+    return;
+  }
+
+  MediaSize = MultU64x32 (BlockIo->Media->LastBlock + 1, BlockIo->Media->BlockSize);
+  Size      = MAX (PARTITION_PROBE_SIZE, BlockIo->Media->BlockSize);
+  if (Size > MediaSize) {
+    Size = (UINTN) MediaSize;
+  }
+
+  Probe->Buffer = AllocatePool (Size);
+  if (Probe->Buffer == NULL) {
+    return;
+  }
+
+  Status = DiskIo->ReadDisk (DiskIo, Probe->MediaId, 0, Size, Probe->Buffer);
+  if (EFI_ERROR (Status)) {
+    FreePool (Probe->Buffer);
+    Probe->Buffer = NULL;
+    return;
+  }
+
+  Probe->BufferSize = Size;
+}
+
+
+/**
+  Free the buffer of a probe context.
+
+  @param[in, out] Probe   The probe context.
+
+**/
+VOID
+PartitionProbeFree (
+  IN OUT PARTITION_PROBE_CONTEXT   *Probe
+  )
+{
+  DEBUG ((
+    EFI_D_INFO,
+    "PartitionDxe: %d reads served from the %d probe bytes, %d reads from the media.\n",
+    (UINT32) Probe->Hits,
+    (UINT32) Probe->BufferSize,
+    (UINT32) Probe->Misses
+    ));
+
+  if (Probe->Buffer != NULL) {
+    FreePool (Probe->Buffer);
+    Probe->Buffer = NULL;
+  }
+  Probe->BufferSize = 0;
+}
+
+
+/**
+  Read from the media, serving the read from the probe buffer when it holds
+  the whole range.
+
+  @param[in, out] Probe       The probe context.
+  @param[in]      MediaId     Id of the media, changes every time the media is replaced.
+  @param[in]      Offset      The starting byte offset on the media to read from.
+  @param[in]      BufferSize  Size of Buffer.
+  @param[out]     Buffer      The buffer receiving the data.
+
+  @retval EFI_SUCCESS         The data was read.
+  @retval Others              The status returned by the DiskIo read.
+
+**/
+EFI_STATUS
+PartitionProbeReadDisk (
+  IN OUT PARTITION_PROBE_CONTEXT   *Probe,
+  IN     UINT32                    MediaId,
+  IN     UINT64                    Offset,
+  IN     UINTN                     BufferSize,
+     OUT VOID                      *Buffer
+  )
+{
+  if ((MediaId == Probe->MediaId) &&
+      (Offset < Probe->BufferSize) &&
+      (BufferSize <= Probe->BufferSize - (UINTN) Offset)) {
+    CopyMem (Buffer, Probe->Buffer + (UINTN) Offset, BufferSize);
+    Probe->Hits++;
+    return EFI_SUCCESS;
+  }
+
+  Probe->Misses++;
+  return Probe->DiskIo->ReadDisk (Probe->DiskIo, MediaId, Offset, BufferSize, Buffer);
+}
+
+
+/**
+  Write to the media, and update the part of the probe buffer it overlaps.
+
+  @param[in, out] Probe       The probe context.
+  @param[in]      MediaId     Id of the media, changes every time the media is replaced.
+  @param[in]      Offset      The starting byte offset on the media to write to.
+  @param[in]      BufferSize  Size of Buffer.
+  @param[in]      Buffer      The data to write.
+
+  @retval EFI_SUCCESS         The data was written.
+  @retval Others              The status returned by the DiskIo write.
+
+**/
+EFI_STATUS
+PartitionProbeWriteDisk (
+  IN OUT PARTITION_PROBE_CONTEXT   *Probe,
+  IN     UINT32                    MediaId,
+  IN     UINT64                    Offset,
+  IN     UINTN                     BufferSize,
+  IN     VOID                      *Buffer
+  )
+{
+  EFI_STATUS                       Status;
+
+  Status = Probe->DiskIo->WriteDisk (Probe->DiskIo, MediaId, Offset, BufferSize, Buffer);
+  if (!EFI_ERROR (Status) && (Offset < Probe->BufferSize)) {
+    CopyMem (
+      Probe->Buffer + (UINTN) Offset,
+      Buffer,
+      MIN (BufferSize, Probe->BufferSize - (UINTN) Offset)
+      );
+  }
+
+  return Status;
+}
@@ -5,7 +5,7 @@
   MBR, and GPT partition schemes are supported.
 
 Copyright (c) 2018 Qualcomm Datacenter Technologies, Inc.
-Copyright (c) 2006 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -102,6 +102,23 @@ extern EFI_COMPONENT_NAME2_PROTOCOL  gPartitionComponentName2;
                                    (((UINT8 *) a)[3] << 24) )
 
 
+//
+// The start of the media holds the sectors that the partition detect routines
+// look at: the MBR, the GPT header and entry array, and the CD volume
+// descriptors at 32KB. They are read once with a single request and shared by
+// all the routines.
+//
+#define PARTITION_PROBE_SIZE  SIZE_64KB
+
+typedef struct {
+  EFI_DISK_IO_PROTOCOL         *DiskIo;
+  UINT32                       MediaId;
+  UINT8                        *Buffer;
+  UINTN                        BufferSize;
+  UINTN                        Hits;
+  UINTN                        Misses;
+} PARTITION_PROBE_CONTEXT;
+
 //
 // GPT Partition Entry Status
 //
@@ -365,6 +382,81 @@ HasChildren (
   IN EFI_HANDLE           ControllerHandle
   );
 
+/**
+  Read the start of the media with a single request, for the partition detect
+  routines to share.
+
+  If the read fails, the probe context is still usable and all the reads go to
+  the media.
+
+  @param[out] Probe       The probe context to initialize.
+  @param[in]  DiskIo      Parent DiskIo interface.
+  @param[in]  BlockIo     Parent BlockIo interface.
+
+**/
+VOID
+PartitionProbeInit (
+  OUT PARTITION_PROBE_CONTEXT      *Probe,
+  IN  EFI_DISK_IO_PROTOCOL         *DiskIo,
+  IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo
+  );
+
+/**
+  Free the buffer of a probe context.
+
+  @param[in, out] Probe   The probe context.
+
+**/
+VOID
+PartitionProbeFree (
+  IN OUT PARTITION_PROBE_CONTEXT   *Probe
+  );
+
+/**
+  Read from the media, serving the read from the probe buffer when it holds
+  the whole range.
+
+  @param[in, out] Probe       The probe context.
+  @param[in]      MediaId     Id of the media, changes every time the media is replaced.
+  @param[in]      Offset      The starting byte offset on the media to read from.
+  @param[in]      BufferSize  Size of Buffer.
+  @param[out]     Buffer      The buffer receiving the data.
+
+  @retval EFI_SUCCESS         The data was read.
+  @retval Others              The status returned by the DiskIo read.
+
+**/
+EFI_STATUS
+PartitionProbeReadDisk (
+  IN OUT PARTITION_PROBE_CONTEXT   *Probe,
+  IN     UINT32                    MediaId,
+  IN     UINT64                    Offset,
+  IN     UINTN                     BufferSize,
+     OUT VOID                      *Buffer
+  );
+
+/**
+  Write to the media, and update the part of the probe buffer it overlaps.
+
+  @param[in, out] Probe       The probe context.
+  @param[in]      MediaId     Id of the media, changes every time the media is replaced.
+  @param[in]      Offset      The starting byte offset on the media to write to.
+  @param[in]      BufferSize  Size of Buffer.
+  @param[in]      Buffer      The data to write.
+
+  @retval EFI_SUCCESS         The data was written.
+  @retval Others              The status returned by the DiskIo write.
+
+**/
+EFI_STATUS
+PartitionProbeWriteDisk (
+  IN OUT PARTITION_PROBE_CONTEXT   *Probe,
+  IN     UINT32                    MediaId,
+  IN     UINT64                    Offset,
+  IN     UINTN                     BufferSize,
+  IN     VOID                      *Buffer
+  );
+
 /**
   Install child handles if the Handle supports GPT partition structure.
 
@@ -375,6 +467,7 @@ HasChildren (
   @param[in]  BlockIo    Parent BlockIo interface.
   @param[in]  BlockIo2   Parent BlockIo2 interface.
   @param[in]  DevicePath Parent Device Path.
+  @param[in]  Probe      Sectors read from the start of the media.
 
   @retval EFI_SUCCESS           Valid GPT disk.
   @retval EFI_MEDIA_CHANGED     Media changed Detected.
@@ -390,7 +483,8 @@ PartitionInstallGptChildHandles (
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   );
 
 /**
@@ -403,6 +497,7 @@ PartitionInstallGptChildHandles (
   @param[in]  BlockIo     Parent BlockIo interface.
   @param[in]  BlockIo2    Parent BlockIo2 interface.
   @param[in]  DevicePath  Parent Device Path
+  @param[in]  Probe       Sectors read from the start of the media
 
 
   @retval EFI_SUCCESS         Child handle(s) was added.
@@ -418,7 +513,8 @@ PartitionInstallElToritoChildHandles (
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   );
 
 /**
@@ -431,6 +527,7 @@ PartitionInstallElToritoChildHandles (
   @param[in]  BlockIo           Parent BlockIo interface.
   @param[in]  BlockIo2          Parent BlockIo2 interface.
   @param[in]  DevicePath        Parent Device Path.
+  @param[in]  Probe             Sectors read from the start of the media.
    
   @retval EFI_SUCCESS       A child handle was added.
   @retval EFI_MEDIA_CHANGED Media change was detected.
@@ -445,7 +542,8 @@ PartitionInstallMbrChildHandles (
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   );
 
 /**
@@ -458,6 +556,7 @@ PartitionInstallMbrChildHandles (
   @param[in]  BlockIo     Parent BlockIo interface.
   @param[in]  BlockIo2    Parent BlockIo2 interface.
   @param[in]  DevicePath  Parent Device Path
+  @param[in]  Probe       Sectors read from the start of the media
 
 
   @retval EFI_SUCCESS         Child handle(s) was added.
@@ -473,7 +572,8 @@ PartitionInstallUdfChildHandles (
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   );
 
 typedef
@@ -485,7 +585,8 @@ EFI_STATUS
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   );
 
 #endif
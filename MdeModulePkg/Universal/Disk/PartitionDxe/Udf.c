@@ -250,7 +250,7 @@ Out_Free:
   Find UDF volume identifiers in a Volume Recognition Sequence.
 
   @param[in]  BlockIo             BlockIo interface.
-  @param[in]  DiskIo              DiskIo interface.
+  @param[in]  Probe               Sectors read from the start of the media.
 
   @retval EFI_SUCCESS             UDF volume identifiers were found.
   @retval EFI_NOT_FOUND           UDF volume identifiers were not found.
@@ -260,7 +260,7 @@ Out_Free:
 EFI_STATUS
 FindUdfVolumeIdentifiers (
   IN EFI_BLOCK_IO_PROTOCOL  *BlockIo,
-  IN EFI_DISK_IO_PROTOCOL   *DiskIo
+  IN PARTITION_PROBE_CONTEXT *Probe
   )
 {
   EFI_STATUS                            Status;
@@ -283,8 +283,8 @@ FindUdfVolumeIdentifiers (
     // Check if block device has a Volume Structure Descriptor and an Extended
     // Area.
     //
-    Status = DiskIo->ReadDisk (
-      DiskIo,
+    Status = PartitionProbeReadDisk (
+      Probe,
       BlockIo->Media->MediaId,
       Offset,
       sizeof (CDROM_VOLUME_DESCRIPTOR),
@@ -318,8 +318,8 @@ FindUdfVolumeIdentifiers (
     return EFI_NOT_FOUND;
   }
 
-  Status = DiskIo->ReadDisk (
-    DiskIo,
+  Status = PartitionProbeReadDisk (
+    Probe,
     BlockIo->Media->MediaId,
     Offset,
     sizeof (CDROM_VOLUME_DESCRIPTOR),
@@ -346,8 +346,8 @@ FindUdfVolumeIdentifiers (
     return EFI_NOT_FOUND;
   }
 
-  Status = DiskIo->ReadDisk (
-    DiskIo,
+  Status = PartitionProbeReadDisk (
+    Probe,
     BlockIo->Media->MediaId,
     Offset,
     sizeof (CDROM_VOLUME_DESCRIPTOR),
@@ -600,6 +600,7 @@ Out_Free:
 
   @param[in]  BlockIo             BlockIo interface.
   @param[in]  DiskIo              DiskIo interface.
+  @param[in]  Probe               Sectors read from the start of the media.
   @param[out] StartingLBA         UDF file system starting LBA.
   @param[out] EndingLBA           UDF file system starting LBA.
 
@@ -611,6 +612,7 @@ EFI_STATUS
 FindUdfFileSystem (
   IN EFI_BLOCK_IO_PROTOCOL  *BlockIo,
   IN EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN PARTITION_PROBE_CONTEXT *Probe,
   OUT EFI_LBA               *StartingLBA,
   OUT EFI_LBA               *EndingLBA
   )
@@ -622,7 +624,7 @@ FindUdfFileSystem (
   //
   // Find UDF volume identifiers
   //
-  Status = FindUdfVolumeIdentifiers (BlockIo, DiskIo);
+  Status = FindUdfVolumeIdentifiers (BlockIo, Probe);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -665,6 +667,7 @@ FindUdfFileSystem (
   @param[in]  BlockIo     Parent BlockIo interface.
   @param[in]  BlockIo2    Parent BlockIo2 interface.
   @param[in]  DevicePath  Parent Device Path
+  @param[in]  Probe       Sectors read from the start of the media
 
 
   @retval EFI_SUCCESS         Child handle(s) was added.
@@ -680,7 +683,8 @@ PartitionInstallUdfChildHandles (
   IN  EFI_DISK_IO2_PROTOCOL        *DiskIo2,
   IN  EFI_BLOCK_IO_PROTOCOL        *BlockIo,
   IN  EFI_BLOCK_IO2_PROTOCOL       *BlockIo2,
-  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
+  IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN  PARTITION_PROBE_CONTEXT      *Probe
   )
 {
   UINT32                       RemainderByMediaBlockSize;
@@ -717,7 +721,8 @@ PartitionInstallUdfChildHandles (
              DiskIo2,
              BlockIo,
              BlockIo2,
-             DevicePath
+             DevicePath,
+             Probe
              );
   if (!EFI_ERROR (Status)) {
     DEBUG ((DEBUG_INFO, "PartitionDxe: El Torito standard found on handle 0x%p.\n", Handle));
@@ -727,7 +732,7 @@ PartitionInstallUdfChildHandles (
   //
   // Search for an UDF file system on block device
   //
-  Status = FindUdfFileSystem (BlockIo, DiskIo, &StartingLBA, &EndingLBA);
+  Status = FindUdfFileSystem (BlockIo, DiskIo, Probe, &StartingLBA, &EndingLBA);
   if (EFI_ERROR (Status)) {
     return (ChildCreated ? EFI_SUCCESS : EFI_NOT_FOUND);
   }
@@ -54,6 +54,7 @@ RamDiskInitBlockIo (
   EFI_BLOCK_IO_PROTOCOL           *BlockIo;
   EFI_BLOCK_IO2_PROTOCOL          *BlockIo2;
   EFI_BLOCK_IO_MEDIA              *Media;
+  UINT64                          DiskSize;
 
   BlockIo  = &PrivateData->BlockIo;
   BlockIo2 = &PrivateData->BlockIo2;
@@ -62,16 +63,24 @@ RamDiskInitBlockIo (
   CopyMem (BlockIo, &mRamDiskBlockIoTemplate, sizeof (EFI_BLOCK_IO_PROTOCOL));
   CopyMem (BlockIo2, &mRamDiskBlockIo2Template, sizeof (EFI_BLOCK_IO2_PROTOCOL));
 
+  //
+  // A compressed RAM disk is expanded on read and can't be written.
+  //
+  DiskSize = PrivateData->Size;
+  if (PrivateData->Compressed != NULL) {
+    DiskSize = PrivateData->Compressed->DiskSize;
+  }
+
   BlockIo->Media          = Media;
   BlockIo2->Media         = Media;
   Media->RemovableMedia   = FALSE;
   Media->MediaPresent     = TRUE;
   Media->LogicalPartition = FALSE;
-  Media->ReadOnly         = FALSE;
+  Media->ReadOnly         = (BOOLEAN) (PrivateData->Compressed != NULL);
   Media->WriteCaching     = FALSE;
   Media->BlockSize        = RAM_DISK_BLOCK_SIZE;
   Media->LastBlock        = DivU64x32 (
-                              PrivateData->Size + RAM_DISK_BLOCK_SIZE - 1,
+                              DiskSize + RAM_DISK_BLOCK_SIZE - 1,
                               RAM_DISK_BLOCK_SIZE
                               ) - 1;
 }
@@ -164,6 +173,15 @@ RamDiskBlkIoReadBlocks (
     return EFI_INVALID_PARAMETER;
   }
 
+  if (PrivateData->Compressed != NULL) {
+    return RamDiskCompressedRead (
+             PrivateData,
+             MultU64x32 (Lba, PrivateData->Media.BlockSize),
+             BufferSize,
+             Buffer
+             );
+  }
+
   CopyMem (
     Buffer,
     (VOID *)(UINTN)(PrivateData->StartingAddr + MultU64x32 (Lba, PrivateData->Media.BlockSize)),
@@ -0,0 +1,489 @@
+/** @file
+  Lazily expand the RAM disks registered with gEdkiiRamDiskCompressedImageGuid.
+
+  The memory of such a RAM disk holds a chunked image of the disk, described
+  in Guid/RamDiskCompressedImage.h. Elided chunks read as zeros, stored chunks
+  are read in place, and GUID-defined chunks are decoded on first read into a
+  bounded LRU cache, so the expanded disk never has to be held in memory.
+
+  Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "RamDiskImpl.h"
+
+
+/**
+  Return the number of bytes of the expanded disk in a chunk.
+
+  @param[in] Compressed      Points to the compressed RAM disk state.
+  @param[in] ChunkIndex      The index of the chunk.
+
+  @return The size of the chunk, only the last chunk may be shorter than
+          ChunkSize.
+
+**/
+UINT32
+RamDiskChunkLength (
+  IN RAM_DISK_COMPRESSED_DATA     *Compressed,
+  IN UINT32                       ChunkIndex
+  )
+{
+  if (ChunkIndex == Compressed->ChunkCount - 1) {
+    return (UINT32) (Compressed->DiskSize - MultU64x32 (ChunkIndex, Compressed->ChunkSize));
+  }
+
+  return Compressed->ChunkSize;
+}
+
+
+/**
+  Check that a chunk table entry lies within the image.
+
+  @param[in] PrivateData     Points to RAM disk private data.
+  @param[in] ChunkIndex      The index of the chunk.
+
+  @retval TRUE               The chunk is valid.
+  @retval FALSE              The chunk is malformed.
+
+**/
+BOOLEAN
+RamDiskIsChunkValid (
+  IN RAM_DISK_PRIVATE_DATA        *PrivateData,
+  IN UINT32                       ChunkIndex
+  )
+{
+  RAM_DISK_COMPRESSED_DATA        *Compressed;
+  EDKII_RAM_DISK_COMPRESSED_CHUNK *Chunk;
+  EFI_COMMON_SECTION_HEADER       *Section;
+  UINT32                          SectionSize;
+  UINT32                          OutputBufferSize;
+  UINT32                          ScratchBufferSize;
+  UINT16                          SectionAttribute;
+
+  Compressed = PrivateData->Compressed;
+  Chunk      = &Compressed->Chunks[ChunkIndex];
+
+  if (Chunk->Type == EDKII_RAM_DISK_COMPRESSED_CHUNK_ZERO) {
+    return TRUE;
+  }
+
+  if ((Chunk->Offset > PrivateData->Size) ||
+      (Chunk->Length > PrivateData->Size - Chunk->Offset)) {
+    return FALSE;
+  }
+
+  switch (Chunk->Type) {
+  case EDKII_RAM_DISK_COMPRESSED_CHUNK_STORED:
+    return (BOOLEAN) (Chunk->Length == RamDiskChunkLength (Compressed, ChunkIndex));
+
+  case EDKII_RAM_DISK_COMPRESSED_CHUNK_GUIDED:
+    //
+    // Make sure the extract handlers only see a whole GUID-defined section.
+    //
+    if (Chunk->Length < sizeof (EFI_GUID_DEFINED_SECTION)) {
+      return FALSE;
+    }
+
+    Section = (EFI_COMMON_SECTION_HEADER *) (UINTN) (PrivateData->StartingAddr + Chunk->Offset);
+    if (Section->Type != EFI_SECTION_GUID_DEFINED) {
+      return FALSE;
+    }
+
+    if (IS_SECTION2 (Section)) {
+      if (Chunk->Length < sizeof (EFI_GUID_DEFINED_SECTION2)) {
+        return FALSE;
+      }
+      SectionSize = SECTION2_SIZE (Section);
+    } else {
+      SectionSize = SECTION_SIZE (Section);
+    }
+
+    if (SectionSize > Chunk->Length) {
+      return FALSE;
+    }
+
+    //
+    // Fail the registration rather than the reads if no extract handler is
+    // linked in for the section GUID, or if it decodes to the wrong size.
+    //
+    if (RETURN_ERROR (ExtractGuidedSectionGetInfo (Section, &OutputBufferSize, &ScratchBufferSize, &SectionAttribute))) {
+      return FALSE;
+    }
+
+    return (BOOLEAN) (OutputBufferSize == RamDiskChunkLength (Compressed, ChunkIndex));
+
+  default:
+    return FALSE;
+  }
+}
+
+
+/**
+  Set up the chunk table and the chunk cache of a RAM disk registered with
+  gEdkiiRamDiskCompressedImageGuid.
+
+  @param[in, out] PrivateData     Points to RAM disk private data.
+
+  @retval EFI_SUCCESS             The compressed image is valid.
+  @retval EFI_INVALID_PARAMETER   The compressed image is malformed.
+  @retval EFI_OUT_OF_RESOURCES    The chunk cache couldn't be allocated.
+
+**/
+EFI_STATUS
+RamDiskCompressedInit (
+  IN OUT RAM_DISK_PRIVATE_DATA    *PrivateData
+  )
+{
+  RAM_DISK_COMPRESSED_DATA                *Compressed;
+  EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER  *Header;
+  UINT64                                  ChunkCount;
+  UINT32                                  Remainder;
+  UINT32                                  Index;
+  UINTN                                   CacheSize;
+
+  if (PrivateData->Size < sizeof (EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Header = (EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER *) (UINTN) PrivateData->StartingAddr;
+  if ((Header->Signature != EDKII_RAM_DISK_COMPRESSED_IMAGE_SIGNATURE) ||
+      (Header->HeaderSize < sizeof (EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER)) ||
+      (Header->HeaderSize > PrivateData->Size)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (IsZeroGuid (&Header->DiskType) ||
+      CompareGuid (&Header->DiskType, &gEdkiiRamDiskCompressedImageGuid)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((Header->DiskSize == 0) || ((Header->DiskSize % RAM_DISK_BLOCK_SIZE) != 0) ||
+      (Header->ChunkSize == 0) || ((Header->ChunkSize % RAM_DISK_BLOCK_SIZE) != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ChunkCount = DivU64x32Remainder (Header->DiskSize, Header->ChunkSize, &Remainder);
+  if (Remainder != 0) {
+    ChunkCount++;
+  }
+
+  if ((ChunkCount != Header->ChunkCount) ||
+      (MultU64x32 (ChunkCount, sizeof (EDKII_RAM_DISK_COMPRESSED_CHUNK)) >
+       PrivateData->Size - Header->HeaderSize)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Compressed = AllocateZeroPool (sizeof (RAM_DISK_COMPRESSED_DATA));
+  if (Compressed == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  EfiInitializeLock (&Compressed->Lock, TPL_NOTIFY);
+  InitializeListHead (&Compressed->CacheList);
+  Compressed->Header     = Header;
+  Compressed->Chunks     = (EDKII_RAM_DISK_COMPRESSED_CHUNK *) ((UINT8 *) Header + Header->HeaderSize);
+  Compressed->DiskSize   = Header->DiskSize;
+  Compressed->ChunkSize  = Header->ChunkSize;
+  Compressed->ChunkCount = Header->ChunkCount;
+
+  PrivateData->Compressed = Compressed;
+
+  //
+  // The device path node describes the expanded disk, not its image.
+  //
+  CopyGuid (&PrivateData->TypeGuid, &Header->DiskType);
+
+  for (Index = 0; Index < Compressed->ChunkCount; Index++) {
+    if (!RamDiskIsChunkValid (PrivateData, Index)) {
+      DEBUG ((EFI_D_ERROR, "RamDiskCompressedInit: Chunk %d is malformed.\n", Index));
+      RamDiskCompressedFree (PrivateData);
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  //
+  // The cache holds at least one chunk, and no more chunks than the disk has.
+  //
+  CacheSize                 = PcdGet32 (PcdRamDiskCompressedCacheSize);
+  Compressed->CacheEntryNum = MAX (CacheSize / Compressed->ChunkSize, 1);
+  Compressed->CacheEntryNum = MIN (Compressed->CacheEntryNum, Compressed->ChunkCount);
+  Compressed->CacheEntries  = AllocateZeroPool (Compressed->CacheEntryNum * sizeof (RAM_DISK_CHUNK_CACHE_ENTRY));
+  Compressed->CacheBuffer   = AllocatePool (Compressed->CacheEntryNum * Compressed->ChunkSize);
+  if ((Compressed->CacheEntries == NULL) || (Compressed->CacheBuffer == NULL)) {
+    RamDiskCompressedFree (PrivateData);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < Compressed->CacheEntryNum; Index++) {
+    Compressed->CacheEntries[Index].ChunkIndex = RAM_DISK_INVALID_CHUNK_INDEX;
+    Compressed->CacheEntries[Index].Data       = Compressed->CacheBuffer + Index * Compressed->ChunkSize;
+    InsertTailList (&Compressed->CacheList, &Compressed->CacheEntries[Index].Link);
+  }
+
+  DEBUG ((
+    EFI_D_INFO,
+    "RamDiskCompressedInit: %ld bytes in %d chunks, caching %d chunks.\n",
+    Compressed->DiskSize,
+    Compressed->ChunkCount,
+    (UINT32) Compressed->CacheEntryNum
+    ));
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Free the chunk table and the chunk cache of a compressed RAM disk.
+
+  @param[in, out] PrivateData     Points to RAM disk private data.
+
+**/
+VOID
+RamDiskCompressedFree (
+  IN OUT RAM_DISK_PRIVATE_DATA    *PrivateData
+  )
+{
+  RAM_DISK_COMPRESSED_DATA        *Compressed;
+
+  Compressed = PrivateData->Compressed;
+  if (Compressed == NULL) {
+    return;
+  }
+
+  DEBUG ((
+    EFI_D_INFO,
+    "RamDiskCompressedFree: %ld chunk cache hits, %ld chunks decoded.\n",
+    Compressed->ChunkHits,
+    Compressed->ChunkMisses
+    ));
+
+  if (Compressed->CacheEntries != NULL) {
+    FreePool (Compressed->CacheEntries);
+  }
+
+  if (Compressed->CacheBuffer != NULL) {
+    FreePool (Compressed->CacheBuffer);
+  }
+
+  if (Compressed->ScratchBuffer != NULL) {
+    FreePool (Compressed->ScratchBuffer);
+  }
+
+  FreePool (Compressed);
+  PrivateData->Compressed = NULL;
+}
+
+
+/**
+  Decode a GUID-defined chunk with the extract handler registered for its
+  section GUID.
+
+  @param[in]  Compressed          Points to the compressed RAM disk state.
+  @param[in]  ChunkIndex          The index of the chunk.
+  @param[out] Data                The buffer of ChunkSize bytes receiving the
+                                  decoded chunk.
+
+  @retval EFI_SUCCESS             The chunk was decoded.
+  @retval EFI_DEVICE_ERROR        The chunk couldn't be decoded.
+  @retval EFI_OUT_OF_RESOURCES    The scratch buffer couldn't be allocated.
+
+**/
+EFI_STATUS
+RamDiskDecodeChunk (
+  IN  RAM_DISK_COMPRESSED_DATA    *Compressed,
+  IN  UINT32                      ChunkIndex,
+  OUT UINT8                       *Data
+  )
+{
+  RETURN_STATUS                   Status;
+  VOID                            *Section;
+  VOID                            *OutputBuffer;
+  UINT32                          OutputBufferSize;
+  UINT32                          ScratchBufferSize;
+  UINT16                          SectionAttribute;
+  UINT32                          AuthenticationStatus;
+
+  Section = (UINT8 *) Compressed->Header + Compressed->Chunks[ChunkIndex].Offset;
+
+  Status = ExtractGuidedSectionGetInfo (
+             Section,
+             &OutputBufferSize,
+             &ScratchBufferSize,
+             &SectionAttribute
+             );
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "RamDiskDecodeChunk: Chunk %d can't be decoded - %r\n", ChunkIndex, Status));
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (OutputBufferSize != RamDiskChunkLength (Compressed, ChunkIndex)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (ScratchBufferSize > Compressed->ScratchBufferSize) {
+    if (Compressed->ScratchBuffer != NULL) {
+      FreePool (Compressed->ScratchBuffer);
+    }
+
+    Compressed->ScratchBuffer = AllocatePool (ScratchBufferSize);
+    if (Compressed->ScratchBuffer == NULL) {
+      Compressed->ScratchBufferSize = 0;
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Compressed->ScratchBufferSize = ScratchBufferSize;
+  }
+
+  //
+  // A section that needs no processing is returned in place.
+  //
+  OutputBuffer = Data;
+  Status = ExtractGuidedSectionDecode (
+             Section,
+             &OutputBuffer,
+             Compressed->ScratchBuffer,
+             &AuthenticationStatus
+             );
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "RamDiskDecodeChunk: Chunk %d can't be decoded - %r\n", ChunkIndex, Status));
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (OutputBuffer != Data) {
+    CopyMem (Data, OutputBuffer, OutputBufferSize);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Get a decoded GUID-defined chunk from the chunk cache, decoding it into the
+  least recently used entry on a miss.
+
+  @param[in]  Compressed          Points to the compressed RAM disk state.
+  @param[in]  ChunkIndex          The index of the chunk.
+  @param[out] Data                On return, points to the decoded chunk.
+
+  @retval EFI_SUCCESS             The chunk is in the cache.
+  @retval Others                  The chunk couldn't be decoded.
+
+**/
+EFI_STATUS
+RamDiskGetChunk (
+  IN  RAM_DISK_COMPRESSED_DATA    *Compressed,
+  IN  UINT32                      ChunkIndex,
+  OUT UINT8                       **Data
+  )
+{
+  EFI_STATUS                      Status;
+  LIST_ENTRY                      *Link;
+  RAM_DISK_CHUNK_CACHE_ENTRY      *Entry;
+
+  for (Link = GetFirstNode (&Compressed->CacheList)
+       ; !IsNull (&Compressed->CacheList, Link)
+       ; Link = GetNextNode (&Compressed->CacheList, Link)
+       ) {
+    Entry = RAM_DISK_CHUNK_CACHE_ENTRY_FROM_LINK (Link);
+    if (Entry->ChunkIndex == ChunkIndex) {
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&Compressed->CacheList, &Entry->Link);
+      Compressed->ChunkHits++;
+      *Data = Entry->Data;
+      return EFI_SUCCESS;
+    }
+  }
+
+  Entry = RAM_DISK_CHUNK_CACHE_ENTRY_FROM_LINK (Compressed->CacheList.BackLink);
+  Entry->ChunkIndex = RAM_DISK_INVALID_CHUNK_INDEX;
+
+  Status = RamDiskDecodeChunk (Compressed, ChunkIndex, Entry->Data);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Entry->ChunkIndex = ChunkIndex;
+  RemoveEntryList (&Entry->Link);
+  InsertHeadList (&Compressed->CacheList, &Entry->Link);
+  Compressed->ChunkMisses++;
+  *Data = Entry->Data;
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Read from the expanded disk of a compressed RAM disk.
+
+  @param[in]  PrivateData         Points to RAM disk private data.
+  @param[in]  Offset              The offset in the expanded disk.
+  @param[in]  BufferSize          The number of bytes to read.
+  @param[out] Buffer              The destination buffer.
+
+  @retval EFI_SUCCESS             The data was read.
+  @retval EFI_DEVICE_ERROR        A chunk couldn't be decoded.
+  @retval EFI_OUT_OF_RESOURCES    The scratch buffer couldn't be allocated.
+
+**/
+EFI_STATUS
+RamDiskCompressedRead (
+  IN  RAM_DISK_PRIVATE_DATA       *PrivateData,
+  IN  UINT64                      Offset,
+  IN  UINTN                       BufferSize,
+  OUT VOID                        *Buffer
+  )
+{
+  EFI_STATUS                      Status;
+  RAM_DISK_COMPRESSED_DATA        *Compressed;
+  EDKII_RAM_DISK_COMPRESSED_CHUNK *Chunk;
+  UINT8                           *Destination;
+  UINT8                           *Data;
+  UINT32                          ChunkIndex;
+  UINT32                          ChunkOffset;
+  UINTN                           Length;
+
+  Compressed  = PrivateData->Compressed;
+  Destination = (UINT8 *) Buffer;
+  Status      = EFI_SUCCESS;
+
+  EfiAcquireLock (&Compressed->Lock);
+
+  while (BufferSize != 0) {
+    ChunkIndex = (UINT32) DivU64x32Remainder (Offset, Compressed->ChunkSize, &ChunkOffset);
+    Length     = MIN (BufferSize, RamDiskChunkLength (Compressed, ChunkIndex) - ChunkOffset);
+    Chunk      = &Compressed->Chunks[ChunkIndex];
+
+    switch (Chunk->Type) {
+    case EDKII_RAM_DISK_COMPRESSED_CHUNK_ZERO:
+      ZeroMem (Destination, Length);
+      break;
+
+    case EDKII_RAM_DISK_COMPRESSED_CHUNK_STORED:
+      CopyMem (Destination, (UINT8 *) Compressed->Header + Chunk->Offset + ChunkOffset, Length);
+      break;
+
+    default:
+      Status = RamDiskGetChunk (Compressed, ChunkIndex, &Data);
+      if (EFI_ERROR (Status)) {
+        goto Done;
+      }
+      CopyMem (Destination, Data + ChunkOffset, Length);
+      break;
+    }
+
+    Destination += Length;
+    Offset      += Length;
+    BufferSize  -= Length;
+  }
+
+Done:
+  EfiReleaseLock (&Compressed->Lock);
+  return Status;
+}
@@ -1,7 +1,7 @@
 /** @file
   HII Config Access protocol implementation of RamDiskDxe driver.
 
-  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2016 - 2018, Intel Corporation. All rights reserved.<BR>
   (C) Copyright 2016 Hewlett Packard Enterprise Development LP<BR>
   This program and the accompanying materials
   are licensed and made available under the terms and conditions of the BSD License
@@ -196,6 +196,7 @@ UnregisterAllRamDisks (
         FreePool ((VOID *)(UINTN) PrivateData->StartingAddr);
       }
 
+      RamDiskCompressedFree (PrivateData);
       FreePool (PrivateData->DevicePath);
       FreePool (PrivateData);
     }
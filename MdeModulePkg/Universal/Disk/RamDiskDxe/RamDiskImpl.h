@@ -1,7 +1,7 @@
 /** @file
   The header file of RamDiskDxe driver.
 
-  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2016 - 2018, Intel Corporation. All rights reserved.<BR>
   This program and the accompanying materials
   are licensed and made available under the terms and conditions of the BSD License
   which accompanies this distribution.  The full text of the license may be found at
@@ -16,6 +16,7 @@
 #define _RAM_DISK_IMPL_H_
 
 #include <Uefi.h>
+#include <Pi/PiFirmwareFile.h>
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
@@ -30,6 +31,7 @@
 #include <Library/PrintLib.h>
 #include <Library/PcdLib.h>
 #include <Library/DxeServicesLib.h>
+#include <Library/ExtractGuidedSectionLib.h>
 #include <Protocol/RamDisk.h>
 #include <Protocol/BlockIo.h>
 #include <Protocol/BlockIo2.h>
@@ -39,6 +41,7 @@
 #include <Protocol/AcpiSystemDescriptionTable.h>
 #include <Guid/MdeModuleHii.h>
 #include <Guid/RamDiskHii.h>
+#include <Guid/RamDiskCompressedImage.h>
 #include <Guid/FileInfo.h>
 #include <IndustryStandard/Acpi61.h>
 
@@ -86,6 +89,52 @@ typedef enum _RAM_DISK_CREATE_METHOD {
   RamDiskCreateHii
 } RAM_DISK_CREATE_METHOD;
 
+//
+// A decoded chunk of a compressed RAM disk, kept in an LRU list.
+//
+typedef struct {
+  LIST_ENTRY                      Link;
+  UINT32                          ChunkIndex;
+  UINT8                           *Data;
+} RAM_DISK_CHUNK_CACHE_ENTRY;
+
+#define RAM_DISK_CHUNK_CACHE_ENTRY_FROM_LINK(a)  BASE_CR (a, RAM_DISK_CHUNK_CACHE_ENTRY, Link)
+
+//
+// Invalid chunk index of an unused chunk cache entry
+//
+#define RAM_DISK_INVALID_CHUNK_INDEX    MAX_UINT32
+
+//
+// The state of a RAM disk registered with gEdkiiRamDiskCompressedImageGuid.
+// The chunks are decoded on first read into a bounded cache, so the
+// expanded disk never has to be held in memory.
+//
+typedef struct {
+  EFI_LOCK                        Lock;
+
+  EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER
+                                  *Header;
+  EDKII_RAM_DISK_COMPRESSED_CHUNK *Chunks;
+  UINT64                          DiskSize;
+  UINT32                          ChunkSize;
+  UINT32                          ChunkCount;
+
+  //
+  // Chunk cache, the most recently used entry first
+  //
+  LIST_ENTRY                      CacheList;
+  RAM_DISK_CHUNK_CACHE_ENTRY      *CacheEntries;
+  UINTN                           CacheEntryNum;
+  UINT8                           *CacheBuffer;
+
+  VOID                            *ScratchBuffer;
+  UINT32                          ScratchBufferSize;
+
+  UINT64                          ChunkHits;
+  UINT64                          ChunkMisses;
+} RAM_DISK_COMPRESSED_DATA;
+
 //
 // RamDiskDxe driver maintains a list of registered RAM disks.
 // The struct contains the list entry and the information of each RAM
@@ -110,6 +159,11 @@ typedef struct {
   EFI_QUESTION_ID                 CheckBoxId;
   BOOLEAN                         CheckBoxChecked;
 
+  //
+  // NULL unless the RAM disk holds a compressed image
+  //
+  RAM_DISK_COMPRESSED_DATA        *Compressed;
+
   LIST_ENTRY                      ThisInstance;
 } RAM_DISK_PRIVATE_DATA;
 
@@ -220,6 +274,54 @@ RamDiskInitBlockIo (
   IN     RAM_DISK_PRIVATE_DATA    *PrivateData
   );
 
+/**
+  Set up the chunk table and the chunk cache of a RAM disk registered with
+  gEdkiiRamDiskCompressedImageGuid.
+
+  @param[in, out] PrivateData     Points to RAM disk private data.
+
+  @retval EFI_SUCCESS             The compressed image is valid.
+  @retval EFI_INVALID_PARAMETER   The compressed image is malformed.
+  @retval EFI_OUT_OF_RESOURCES    The chunk cache couldn't be allocated.
+
+**/
+EFI_STATUS
+RamDiskCompressedInit (
+  IN OUT RAM_DISK_PRIVATE_DATA    *PrivateData
+  );
+
+/**
+  Free the chunk table and the chunk cache of a compressed RAM disk.
+
+  @param[in, out] PrivateData     Points to RAM disk private data.
+
+**/
+VOID
+RamDiskCompressedFree (
+  IN OUT RAM_DISK_PRIVATE_DATA    *PrivateData
+  );
+
+/**
+  Read from the expanded disk of a compressed RAM disk.
+
+  @param[in]  PrivateData         Points to RAM disk private data.
+  @param[in]  Offset              The offset in the expanded disk.
+  @param[in]  BufferSize          The number of bytes to read.
+  @param[out] Buffer              The destination buffer.
+
+  @retval EFI_SUCCESS             The data was read.
+  @retval EFI_DEVICE_ERROR        A chunk couldn't be decoded.
+  @retval EFI_OUT_OF_RESOURCES    The scratch buffer couldn't be allocated.
+
+**/
+EFI_STATUS
+RamDiskCompressedRead (
+  IN  RAM_DISK_PRIVATE_DATA       *PrivateData,
+  IN  UINT64                      Offset,
+  IN  UINTN                       BufferSize,
+  OUT VOID                        *Buffer
+  );
+
 /**
   Reset the Block Device.
 
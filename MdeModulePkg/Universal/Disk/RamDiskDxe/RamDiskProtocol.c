@@ -1,7 +1,7 @@
 /** @file
   The realization of EFI_RAM_DISK_PROTOCOL.
 
-  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2016 - 2018, Intel Corporation. All rights reserved.<BR>
   (C) Copyright 2016 Hewlett Packard Enterprise Development LP<BR>
   This program and the accompanying materials
   are licensed and made available under the terms and conditions of the BSD License
@@ -158,6 +158,14 @@ RamDiskPublishNfit (
   UINT8                                         Checksum;
   BOOLEAN                                       MemoryFound;
 
+  //
+  // The memory of a compressed RAM disk doesn't hold the disk the OS would
+  // expect to find in the SPA range, so it is never published.
+  //
+  if (PrivateData->Compressed != NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
   //
   // Get the EFI memory map.
   //
@@ -635,6 +643,13 @@ RamDiskRegister (
   CopyGuid (&PrivateData->TypeGuid, RamDiskType);
   InitializeListHead (&PrivateData->ThisInstance);
 
+  if (CompareGuid (RamDiskType, &gEdkiiRamDiskCompressedImageGuid)) {
+    Status = RamDiskCompressedInit (PrivateData);
+    if (EFI_ERROR (Status)) {
+      goto ErrorExit;
+    }
+  }
+
   //
   // Generate device path information for the registered RAM disk
   //
@@ -733,6 +748,8 @@ ErrorExit:
       FreePool (PrivateData->DevicePath);
     }
 
+    RamDiskCompressedFree (PrivateData);
+
     FreePool (PrivateData);
   }
 
@@ -844,6 +861,7 @@ RamDiskUnregister (
           FreePool ((VOID *)(UINTN) PrivateData->StartingAddr);
         }
 
+        RamDiskCompressedFree (PrivateData);
         FreePool (PrivateData->DevicePath);
         FreePool (PrivateData);
         Found = TRUE;
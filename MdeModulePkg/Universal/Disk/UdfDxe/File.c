@@ -79,6 +79,8 @@ UdfOpenVolume (
     // There is no more open files. Read volume information again since it was
     // cleaned up on the last UdfClose() call.
     //
+    PurgeIcbCache (&PrivFsData->Volume);
+
     Status = ReadUdfVolumeInformation (
       PrivFsData->BlockIo,
       PrivFsData->DiskIo,
@@ -265,6 +267,7 @@ UdfOpen (
   NewPrivFileData->FilePosition = 0;
   ZeroMem ((VOID *)&NewPrivFileData->ReadDirInfo,
            sizeof (UDF_READ_DIRECTORY_INFO));
+  ZeroMem ((VOID *)&NewPrivFileData->Extents, sizeof (UDF_FILE_EXTENTS));
 
   *NewHandle = &NewPrivFileData->FileIo;
 
@@ -374,6 +377,7 @@ UdfRead (
       Volume,
       Parent,
       PrivFileData->FileSize,
+      &PrivFileData->Extents,
       &PrivFileData->FilePosition,
       Buffer,
       &BufferSizeUint64
@@ -546,6 +550,8 @@ UdfClose (
     if (PrivFileData->ReadDirInfo.DirectoryData != NULL) {
       FreePool (PrivFileData->ReadDirInfo.DirectoryData);
     }
+
+    FreeFileExtents (&PrivFileData->Extents);
   }
 
   FreePool ((VOID *)PrivFileData);
@@ -967,6 +967,181 @@ GrowUpBufferToNextAd (
   return EFI_SUCCESS;
 }
 
+/**
+  Free an entry of the ICB cache.
+
+  @param[in]  CacheEntry          ICB cache entry pointer.
+
+**/
+VOID
+FreeIcbCacheEntry (
+  IN  UDF_ICB_CACHE_ENTRY  *CacheEntry
+  )
+{
+  if (CacheEntry->FileEntry != NULL) {
+    FreePool (CacheEntry->FileEntry);
+  }
+  if (CacheEntry->DirectoryData != NULL) {
+    FreePool (CacheEntry->DirectoryData);
+  }
+  FreePool (CacheEntry);
+}
+
+/**
+  Drop all the FEs/EFEs and directory data cached for an UDF volume.
+
+  @param[in, out] Volume        UDF volume information structure.
+
+**/
+VOID
+PurgeIcbCache (
+  IN OUT  UDF_VOLUME_INFO        *Volume
+  )
+{
+  UDF_ICB_CACHE_ENTRY  *CacheEntry;
+
+  while (!IsListEmpty (&Volume->IcbCache)) {
+    CacheEntry = CR (
+      GetFirstNode (&Volume->IcbCache),
+      UDF_ICB_CACHE_ENTRY,
+      Link,
+      UDF_ICB_CACHE_ENTRY_SIGNATURE
+      );
+    RemoveEntryList (&CacheEntry->Link);
+    FreeIcbCacheEntry (CacheEntry);
+  }
+
+  Volume->IcbCacheCount = 0;
+}
+
+/**
+  Look up the ICB cache entry of a given logical sector.
+
+  The cache is dropped when the medium has changed. A found or created entry
+  is moved to the head of the cache; when the cache is full, the least
+  recently used entry is replaced.
+
+  @param[in]  BlockIo             BlockIo interface.
+  @param[in]  Volume              Volume information pointer.
+  @param[in]  Lsn                 Logical sector number of the ICB.
+  @param[in]  Create              TRUE to create the entry if it's not found.
+
+  @return The cache entry, or NULL if it was not found or created.
+
+**/
+UDF_ICB_CACHE_ENTRY *
+GetIcbCacheEntry (
+  IN  EFI_BLOCK_IO_PROTOCOL  *BlockIo,
+  IN  UDF_VOLUME_INFO        *Volume,
+  IN  UINT64                 Lsn,
+  IN  BOOLEAN                Create
+  )
+{
+  LIST_ENTRY           *Link;
+  UDF_ICB_CACHE_ENTRY  *CacheEntry;
+
+  if (Volume->IcbCacheMediaId != BlockIo->Media->MediaId) {
+    PurgeIcbCache (Volume);
+    Volume->IcbCacheMediaId = BlockIo->Media->MediaId;
+  }
+
+  for (Link = GetFirstNode (&Volume->IcbCache);
+       !IsNull (&Volume->IcbCache, Link);
+       Link = GetNextNode (&Volume->IcbCache, Link)) {
+    CacheEntry = CR (Link, UDF_ICB_CACHE_ENTRY, Link,
+                     UDF_ICB_CACHE_ENTRY_SIGNATURE);
+    if (CacheEntry->Lsn == Lsn) {
+      RemoveEntryList (&CacheEntry->Link);
+      InsertHeadList (&Volume->IcbCache, &CacheEntry->Link);
+      return CacheEntry;
+    }
+  }
+
+  if (!Create) {
+    return NULL;
+  }
+
+  if (Volume->IcbCacheCount >= UDF_ICB_CACHE_MAX_ENTRIES) {
+    CacheEntry = CR (
+      GetPreviousNode (&Volume->IcbCache, &Volume->IcbCache),
+      UDF_ICB_CACHE_ENTRY,
+      Link,
+      UDF_ICB_CACHE_ENTRY_SIGNATURE
+      );
+    RemoveEntryList (&CacheEntry->Link);
+    FreeIcbCacheEntry (CacheEntry);
+    Volume->IcbCacheCount--;
+  }
+
+  CacheEntry = AllocateZeroPool (sizeof (UDF_ICB_CACHE_ENTRY));
+  if (CacheEntry == NULL) {
+    return NULL;
+  }
+
+  CacheEntry->Signature = UDF_ICB_CACHE_ENTRY_SIGNATURE;
+  CacheEntry->Lsn       = Lsn;
+  InsertHeadList (&Volume->IcbCache, &CacheEntry->Link);
+  Volume->IcbCacheCount++;
+
+  return CacheEntry;
+}
+
+/**
+  Append the extent of an Allocation Descriptor to a file's extent array,
+  merging it with the last extent when they are contiguous on the disk.
+
+  @param[in, out] ReadFileInfo    Read file information pointer.
+  @param[in]      Offset          Byte offset of the extent on the disk.
+  @param[in]      ExtentLength    Length of the extent.
+
+  @retval EFI_SUCCESS             The extent was appended.
+  @retval EFI_OUT_OF_RESOURCES    The extent was not appended due to lack of
+                                  resources.
+
+**/
+EFI_STATUS
+AppendFileExtent (
+  IN OUT  UDF_READ_FILE_INFO  *ReadFileInfo,
+  IN      UINT64              Offset,
+  IN      UINT32              ExtentLength
+  )
+{
+  UDF_FILE_EXTENT  *Extents;
+  UDF_FILE_EXTENT  *LastExtent;
+
+  Extents = (UDF_FILE_EXTENT *)ReadFileInfo->FileData;
+
+  if (ReadFileInfo->ExtentCount != 0) {
+    LastExtent = &Extents[ReadFileInfo->ExtentCount - 1];
+    if (LastExtent->Offset + LastExtent->Length == Offset) {
+      LastExtent->Length += ExtentLength;
+      ReadFileInfo->ReadLength += ExtentLength;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if ((ReadFileInfo->ExtentCount % UDF_FILE_EXTENT_GROWTH) == 0) {
+    Extents = ReallocatePool (
+      ReadFileInfo->ExtentCount * sizeof (UDF_FILE_EXTENT),
+      (ReadFileInfo->ExtentCount + UDF_FILE_EXTENT_GROWTH) *
+      sizeof (UDF_FILE_EXTENT),
+      Extents
+      );
+    if (Extents == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    ReadFileInfo->FileData = Extents;
+  }
+
+  Extents[ReadFileInfo->ExtentCount].FilePosition = ReadFileInfo->ReadLength;
+  Extents[ReadFileInfo->ExtentCount].Offset       = Offset;
+  Extents[ReadFileInfo->ExtentCount].Length       = ExtentLength;
+  ReadFileInfo->ExtentCount++;
+  ReadFileInfo->ReadLength += ExtentLength;
+
+  return EFI_SUCCESS;
+}
+
 /**
   Read data or size of either a File Entry or an Extended File Entry.
 
@@ -1029,12 +1204,14 @@ ReadFile (
   switch (ReadFileInfo->Flags) {
   case ReadFileGetFileSize:
   case ReadFileAllocateAndRead:
+  case ReadFileGetExtents:
     //
-    // Initialise ReadFileInfo structure for either getting file size, or
-    // reading file's recorded data.
+    // Initialise ReadFileInfo structure for either getting file size, reading
+    // file's recorded data, or resolving its extents.
     //
     ReadFileInfo->ReadLength = 0;
     ReadFileInfo->FileData = NULL;
+    ReadFileInfo->ExtentCount = 0;
     break;
   case ReadFileSeekAndRead:
     //
@@ -1067,7 +1244,8 @@ ReadFile (
     //
     GetFileEntryData (FileEntryData, &Data, &Length);
 
-    if (ReadFileInfo->Flags == ReadFileGetFileSize) {
+    if (ReadFileInfo->Flags == ReadFileGetFileSize ||
+        ReadFileInfo->Flags == ReadFileGetExtents) {
       ReadFileInfo->ReadLength = Length;
     } else if (ReadFileInfo->Flags == ReadFileAllocateAndRead) {
       //
@@ -1169,6 +1347,20 @@ ReadFile (
       case ReadFileGetFileSize:
         ReadFileInfo->ReadLength += ExtentLength;
         break;
+      case ReadFileGetExtents:
+        //
+        // Keep where the extent is, merged with the previous one when they
+        // are contiguous on the disk.
+        //
+        Status = AppendFileExtent (
+          ReadFileInfo,
+          MultU64x32 (Lsn, LogicalBlockSize),
+          ExtentLength
+          );
+        if (EFI_ERROR (Status)) {
+          goto Error_Alloc_Buffer_To_Next_Ad;
+        }
+        break;
       case ReadFileAllocateAndRead:
         //
         // Increase FileData (if necessary) to read next extent.
@@ -1300,7 +1492,8 @@ Done:
 
 Error_Read_Disk_Blk:
 Error_Alloc_Buffer_To_Next_Ad:
-  if (ReadFileInfo->Flags != ReadFileSeekAndRead) {
+  if (ReadFileInfo->Flags != ReadFileSeekAndRead &&
+      ReadFileInfo->FileData != NULL) {
     FreePool (ReadFileInfo->FileData);
   }
 
@@ -1611,15 +1804,29 @@ FindFileEntry (
   OUT  VOID                            **FileEntry
   )
 {
-  EFI_STATUS          Status;
-  UINT64              Lsn;
-  UINT32              LogicalBlockSize;
-  UDF_DESCRIPTOR_TAG  *DescriptorTag;
-  VOID                *ReadBuffer;
+  EFI_STATUS           Status;
+  UINT64               Lsn;
+  UINT32               LogicalBlockSize;
+  UDF_DESCRIPTOR_TAG   *DescriptorTag;
+  VOID                 *ReadBuffer;
+  UDF_ICB_CACHE_ENTRY  *CacheEntry;
 
   Lsn               = GetLongAdLsn (Volume, Icb);
   LogicalBlockSize  = Volume->LogicalVolDesc.LogicalBlockSize;
 
+  //
+  // Return a copy of the FE/EFE if it was already read.
+  //
+  CacheEntry = GetIcbCacheEntry (BlockIo, Volume, Lsn, TRUE);
+  if (CacheEntry != NULL && CacheEntry->FileEntry != NULL) {
+    *FileEntry = AllocateCopyPool (Volume->FileEntrySize, CacheEntry->FileEntry);
+    if (*FileEntry == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    return EFI_SUCCESS;
+  }
+
   ReadBuffer = AllocateZeroPool (Volume->FileEntrySize);
   if (ReadBuffer == NULL) {
     return EFI_OUT_OF_RESOURCES;
@@ -1651,6 +1858,10 @@ FindFileEntry (
     goto Error_Invalid_Fe;
   }
 
+  if (CacheEntry != NULL) {
+    CacheEntry->FileEntry = AllocateCopyPool (Volume->FileEntrySize, ReadBuffer);
+  }
+
   *FileEntry = ReadBuffer;
   return EFI_SUCCESS;
 
@@ -1825,6 +2036,39 @@ ReadDirectoryEntry (
   EFI_STATUS                      Status;
   UDF_READ_FILE_INFO              ReadFileInfo;
   UDF_FILE_IDENTIFIER_DESCRIPTOR  *FileIdentifierDesc;
+  UDF_ICB_CACHE_ENTRY             *CacheEntry;
+
+  CacheEntry = NULL;
+
+  if (ReadDirInfo->DirectoryData == NULL) {
+    //
+    // Directory data is only cached along with the directory's FE/EFE, so
+    // make sure that it's the one given here.
+    //
+    CacheEntry = GetIcbCacheEntry (
+      BlockIo,
+      Volume,
+      GetLongAdLsn (Volume, ParentIcb),
+      FALSE
+      );
+    if (CacheEntry != NULL &&
+        (CacheEntry->FileEntry == NULL ||
+         CompareMem (CacheEntry->FileEntry, FileEntryData,
+                     Volume->FileEntrySize) != 0)) {
+      CacheEntry = NULL;
+    }
+
+    if (CacheEntry != NULL && CacheEntry->DirectoryData != NULL) {
+      ReadDirInfo->DirectoryData = AllocateCopyPool (
+        (UINTN) CacheEntry->DirectoryLength,
+        CacheEntry->DirectoryData
+        );
+      if (ReadDirInfo->DirectoryData == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+      ReadDirInfo->DirectoryLength = CacheEntry->DirectoryLength;
+    }
+  }
 
   if (ReadDirInfo->DirectoryData == NULL) {
     //
@@ -1850,6 +2094,16 @@ ReadDirectoryEntry (
     //
     ReadDirInfo->DirectoryData = ReadFileInfo.FileData;
     ReadDirInfo->DirectoryLength = ReadFileInfo.ReadLength;
+
+    if (CacheEntry != NULL && ReadDirInfo->DirectoryLength != 0) {
+      CacheEntry->DirectoryData = AllocateCopyPool (
+        (UINTN) ReadDirInfo->DirectoryLength,
+        ReadDirInfo->DirectoryData
+        );
+      if (CacheEntry->DirectoryData != NULL) {
+        CacheEntry->DirectoryLength = ReadDirInfo->DirectoryLength;
+      }
+    }
   }
 
   do {
@@ -2472,6 +2726,124 @@ Out_Free:
   return Status;
 }
 
+/**
+  Free the resolved extents of a file.
+
+  @param[in, out] Extents       Extents of the file.
+
+**/
+VOID
+FreeFileExtents (
+  IN OUT  UDF_FILE_EXTENTS       *Extents
+  )
+{
+  if (Extents->Extents != NULL) {
+    FreePool (Extents->Extents);
+  }
+
+  ZeroMem ((VOID *)Extents, sizeof (UDF_FILE_EXTENTS));
+}
+
+/**
+  Seek a file and read its data using its resolved extents.
+
+  The data is read with a DiskIo call per extent, extents contiguous on the
+  disk having been merged when they were resolved.
+
+  @param[in]      BlockIo       BlockIo interface.
+  @param[in]      DiskIo        DiskIo interface.
+  @param[in]      Extents       Extents of the file.
+  @param[in]      FileSize      Size of the file.
+  @param[in, out] FilePosition  File position.
+  @param[in, out] Buffer        File data.
+  @param[in, out] BufferSize    Read size.
+
+  @retval EFI_SUCCESS          File seeked and read.
+  @retval EFI_VOLUME_CORRUPTED The extents don't cover the file size.
+  @retval other                The file's data was not read.
+
+**/
+EFI_STATUS
+ReadFileExtents (
+  IN      EFI_BLOCK_IO_PROTOCOL  *BlockIo,
+  IN      EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN      UDF_FILE_EXTENTS       *Extents,
+  IN      UINT64                 FileSize,
+  IN OUT  UINT64                 *FilePosition,
+  IN OUT  VOID                   *Buffer,
+  IN OUT  UINT64                 *BufferSize
+  )
+{
+  EFI_STATUS       Status;
+  UDF_FILE_EXTENT  *Extent;
+  UINTN            Low;
+  UINTN            High;
+  UINTN            Middle;
+  UINT64           Offset;
+  UINT64           DataLength;
+  UINT64           BytesLeft;
+  UINT8            *Data;
+
+  if (*BufferSize > FileSize - *FilePosition) {
+    //
+    // About to read beyond the EOF -- truncate it.
+    //
+    *BufferSize = FileSize - *FilePosition;
+  }
+
+  //
+  // Find the last extent starting at or before the file position.
+  //
+  Low  = 0;
+  High = Extents->ExtentCount;
+  while (High - Low > 1) {
+    Middle = (Low + High) / 2;
+    if (Extents->Extents[Middle].FilePosition <= *FilePosition) {
+      Low = Middle;
+    } else {
+      High = Middle;
+    }
+  }
+
+  BytesLeft = *BufferSize;
+  Data      = (UINT8 *)Buffer;
+
+  for (Extent = &Extents->Extents[Low];
+       BytesLeft != 0;
+       Extent++) {
+    if (Extent == &Extents->Extents[Extents->ExtentCount]) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Offset = *FilePosition - Extent->FilePosition;
+    if (Offset >= Extent->Length) {
+      continue;
+    }
+
+    DataLength = Extent->Length - Offset;
+    if (DataLength > BytesLeft) {
+      DataLength = BytesLeft;
+    }
+
+    Status = DiskIo->ReadDisk (
+      DiskIo,
+      BlockIo->Media->MediaId,
+      Extent->Offset + Offset,
+      (UINTN) DataLength,
+      Data
+      );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Data          += DataLength;
+    *FilePosition += DataLength;
+    BytesLeft     -= DataLength;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Seek a file and read its data into memory on an UDF volume.
 
@@ -2480,6 +2852,7 @@ Out_Free:
   @param[in]      Volume        UDF volume information structure.
   @param[in]      File          File information structure.
   @param[in]      FileSize      Size of the file.
+  @param[in, out] Extents       Extents of the file, resolved on the first read.
   @param[in, out] FilePosition  File position.
   @param[in, out] Buffer        File data.
   @param[in, out] BufferSize    Read size.
@@ -2500,13 +2873,53 @@ ReadFileData (
   IN      UDF_VOLUME_INFO        *Volume,
   IN      UDF_FILE_INFO          *File,
   IN      UINT64                 FileSize,
+  IN OUT  UDF_FILE_EXTENTS       *Extents,
   IN OUT  UINT64                 *FilePosition,
   IN OUT  VOID                   *Buffer,
   IN OUT  UINT64                 *BufferSize
   )
 {
-  EFI_STATUS          Status;
-  UDF_READ_FILE_INFO  ReadFileInfo;
+  EFI_STATUS              Status;
+  UDF_READ_FILE_INFO      ReadFileInfo;
+  UDF_FE_RECORDING_FLAGS  RecordingFlags;
+
+  //
+  // Resolve the extents of a file recorded in Allocation Descriptors on its
+  // first read, rather than walking its ADs (and AEDs) on every read.
+  //
+  RecordingFlags = GET_FE_RECORDING_FLAGS (File->FileEntry);
+  if (Extents->Extents == NULL &&
+      (RecordingFlags == LongAdsSequence ||
+       RecordingFlags == ShortAdsSequence)) {
+    ReadFileInfo.Flags = ReadFileGetExtents;
+
+    Status = ReadFile (
+      BlockIo,
+      DiskIo,
+      Volume,
+      &File->FileIdentifierDesc->Icb,
+      File->FileEntry,
+      &ReadFileInfo
+      );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Extents->Extents     = (UDF_FILE_EXTENT *)ReadFileInfo.FileData;
+    Extents->ExtentCount = ReadFileInfo.ExtentCount;
+  }
+
+  if (Extents->ExtentCount != 0) {
+    return ReadFileExtents (
+      BlockIo,
+      DiskIo,
+      Extents,
+      FileSize,
+      FilePosition,
+      Buffer,
+      BufferSize
+      );
+  }
 
   ReadFileInfo.Flags         = ReadFileSeekAndRead;
   ReadFileInfo.FilePosition  = *FilePosition;
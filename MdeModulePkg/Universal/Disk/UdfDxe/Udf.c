@@ -181,6 +181,7 @@ UdfDriverBindingStart (
   PrivFsData->BlockIo   = BlockIo;
   PrivFsData->DiskIo    = DiskIo;
   PrivFsData->Handle    = ControllerHandle;
+  InitializeListHead (&PrivFsData->Volume.IcbCache);
 
   //
   // Set up SimpleFs protocol
@@ -276,6 +277,7 @@ UdfDriverBindingStop (
       NULL
       );
 
+    PurgeIcbCache (&PrivFsData->Volume);
     FreePool ((VOID *)PrivFsData);
   }
 
@@ -139,15 +139,31 @@ typedef enum {
   ReadFileGetFileSize,
   ReadFileAllocateAndRead,
   ReadFileSeekAndRead,
+  ReadFileGetExtents,
 } UDF_READ_FILE_FLAGS;
 
+//
+// A run of a file's recorded data, contiguous on the disk.
+//
+typedef struct {
+  UINT64               FilePosition;  // Position of the run in the file
+  UINT64               Offset;        // Byte offset of the run on the disk
+  UINT64               Length;
+} UDF_FILE_EXTENT;
+
+//
+// The number of UDF_FILE_EXTENT entries the extent array is grown by.
+//
+#define UDF_FILE_EXTENT_GROWTH  32
+
 typedef struct {
-  VOID                 *FileData;
+  VOID                 *FileData;     // UDF_FILE_EXTENT array for ReadFileGetExtents
   UDF_READ_FILE_FLAGS  Flags;
   UINT64               FileDataSize;
   UINT64               FilePosition;
   UINT64               FileSize;
   UINT64               ReadLength;
+  UINTN                ExtentCount;
 } UDF_READ_FILE_INFO;
 
 #pragma pack(1)
@@ -323,13 +339,38 @@ typedef struct {
   UDF_PARTITION_DESCRIPTOR       PartitionDesc;
   UDF_FILE_SET_DESCRIPTOR        FileSetDesc;
   UINTN                          FileEntrySize;
+  //
+  // FEs/EFEs and directory data already read, keyed by ICB location, most
+  // recently used first.
+  //
+  LIST_ENTRY                     IcbCache;
+  UINTN                          IcbCacheCount;
+  UINT32                         IcbCacheMediaId;
 } UDF_VOLUME_INFO;
 
+#define UDF_ICB_CACHE_ENTRY_SIGNATURE SIGNATURE_32 ('U', 'd', 'f', 'c')
+
+#define UDF_ICB_CACHE_MAX_ENTRIES     64
+
+typedef struct {
+  UINTN                           Signature;
+  LIST_ENTRY                      Link;
+  UINT64                          Lsn;
+  VOID                            *FileEntry;
+  VOID                            *DirectoryData;
+  UINT64                          DirectoryLength;
+} UDF_ICB_CACHE_ENTRY;
+
 typedef struct {
   VOID                            *FileEntry;
   UDF_FILE_IDENTIFIER_DESCRIPTOR  *FileIdentifierDesc;
 } UDF_FILE_INFO;
 
+typedef struct {
+  UDF_FILE_EXTENT                 *Extents;
+  UINTN                           ExtentCount;
+} UDF_FILE_EXTENTS;
+
 typedef struct {
   VOID                      *DirectoryData;
   UINT64                    DirectoryLength;
@@ -358,6 +399,7 @@ typedef struct {
   CHAR16                           FileName[UDF_FILENAME_LENGTH];
   UINT64                           FileSize;
   UINT64                           FilePosition;
+  UDF_FILE_EXTENTS                 Extents;
 } PRIVATE_UDF_FILE_DATA;
 
 #define PRIVATE_UDF_SIMPLE_FS_DATA_SIGNATURE SIGNATURE_32 ('U', 'd', 'f', 's')
@@ -908,6 +950,7 @@ GetVolumeSize (
   @param[in]      Volume        UDF volume information structure.
   @param[in]      File          File information structure.
   @param[in]      FileSize      Size of the file.
+  @param[in, out] Extents       Extents of the file, resolved on the first read.
   @param[in, out] FilePosition  File position.
   @param[in, out] Buffer        File data.
   @param[in, out] BufferSize    Read size.
@@ -928,11 +971,34 @@ ReadFileData (
   IN      UDF_VOLUME_INFO        *Volume,
   IN      UDF_FILE_INFO          *File,
   IN      UINT64                 FileSize,
+  IN OUT  UDF_FILE_EXTENTS       *Extents,
   IN OUT  UINT64                 *FilePosition,
   IN OUT  VOID                   *Buffer,
   IN OUT  UINT64                 *BufferSize
   );
 
+/**
+  Free the resolved extents of a file.
+
+  @param[in, out] Extents       Extents of the file.
+
+**/
+VOID
+FreeFileExtents (
+  IN OUT  UDF_FILE_EXTENTS       *Extents
+  );
+
+/**
+  Drop all the FEs/EFEs and directory data cached for an UDF volume.
+
+  @param[in, out] Volume        UDF volume information structure.
+
+**/
+VOID
+PurgeIcbCache (
+  IN OUT  UDF_VOLUME_INFO        *Volume
+  );
+
 /**
   Check if ControllerHandle supports an UDF file system.
 
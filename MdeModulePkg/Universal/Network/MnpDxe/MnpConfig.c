@@ -568,6 +568,33 @@ MnpInitializeDeviceData (
     goto ERROR;
   }
 
+  //
+  // Use batched transmit if the Snp driver supports it.
+  //
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEdkiiSimpleNetworkBatchTransmitProtocolGuid,
+                  (VOID **) &MnpDeviceData->BatchTx,
+                  ImageHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (!EFI_ERROR (Status)) {
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    MnpFlushTxPacketsNotify,
+                    MnpDeviceData,
+                    &MnpDeviceData->TxFlushEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      MnpDeviceData->BatchTx = NULL;
+    }
+  } else {
+    MnpDeviceData->BatchTx = NULL;
+  }
+  Status = EFI_SUCCESS;
+
 ERROR:
   if (EFI_ERROR (Status)) {
     //
@@ -649,6 +676,10 @@ MnpDestroyDeviceData (
   gBS->CloseEvent (MnpDeviceData->TimeoutCheckTimer);
   gBS->CloseEvent (MnpDeviceData->MediaDetectTimer);
   gBS->CloseEvent (MnpDeviceData->PollTimer);
+  if (MnpDeviceData->TxFlushEvent != NULL) {
+    ASSERT (MnpDeviceData->TxPendingCount == 0);
+    gBS->CloseEvent (MnpDeviceData->TxFlushEvent);
+  }
 
   //
   // Free the Tx buffer pool.
@@ -1279,7 +1310,9 @@ MnpStart (
     //
     TimerOpType = EnableSystemPoll ? TimerPeriodic : TimerCancel;
 
-    Status      = gBS->SetTimer (MnpDeviceData->PollTimer, TimerOpType, MNP_SYS_POLL_INTERVAL);
+    MnpDeviceData->PollInterval  = MNP_SYS_POLL_INTERVAL;
+    MnpDeviceData->IdlePollCount = 0;
+    Status      = gBS->SetTimer (MnpDeviceData->PollTimer, TimerOpType, MnpDeviceData->PollInterval);
     if (EFI_ERROR (Status)) {
       DEBUG ((EFI_D_ERROR, "MnpStart: gBS->SetTimer for PollTimer failed, %r.\n", Status));
 
@@ -1320,6 +1353,11 @@ MnpStop (
   MnpDeviceData = MnpServiceData->MnpDeviceData;
   ASSERT (MnpDeviceData->ConfiguredChildrenNumber > 0);
 
+  //
+  // Send the queued packets, their tokens may belong to the stopped instance.
+  //
+  MnpFlushTxPackets (MnpDeviceData);
+
   //
   // Configure the receive filters.
   //
@@ -1349,6 +1387,16 @@ MnpStop (
     MnpDeviceData->EnableSystemPoll = FALSE;
   }
 
+  DEBUG ((
+    EFI_D_NET,
+    "MnpStop: %ld polls, %ld empty, max %d packets per poll, %ld packets received, %ld dropped.\n",
+    MnpDeviceData->RxStatistics.PollCount,
+    MnpDeviceData->RxStatistics.EmptyPollCount,
+    MnpDeviceData->RxStatistics.MaxPacketsPerPoll,
+    MnpDeviceData->RxStatistics.RxPacketCount,
+    MnpDeviceData->RxStatistics.RxDropCount
+    ));
+
   //
   // Cancel the timeout timer.
   //
@@ -22,6 +22,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/SimpleNetwork.h>
 #include <Protocol/ServiceBinding.h>
 #include <Protocol/VlanConfig.h>
+#include <Protocol/SimpleNetworkBatchTransmit.h>
 
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -44,6 +45,35 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 //
 extern  EFI_DRIVER_BINDING_PROTOCOL gMnpDriverBinding;
 
+//
+// Max number of packets queued for a batched transmit.
+//
+#define MNP_TX_BATCH_SIZE             32
+
+//
+// A packet queued for a batched transmit.
+//
+typedef struct {
+  EFI_MANAGED_NETWORK_PROTOCOL          *ManagedNetwork;
+  EFI_MANAGED_NETWORK_COMPLETION_TOKEN  *Token;
+  UINT8                                 *Packet;
+  UINT32                                Length;
+  UINT32                                HeaderSize;
+  UINT16                                ProtocolType;
+} MNP_TX_PENDING;
+
+//
+// Receive counters of a device. They are only meant for debugging, and are
+// reported with DEBUG_NET when the device is stopped.
+//
+typedef struct {
+  UINT64                        PollCount;          // System polls
+  UINT64                        EmptyPollCount;     // System polls that received nothing
+  UINT32                        MaxPacketsPerPoll;  // Most packets received by one system poll
+  UINT64                        RxPacketCount;      // Packets received from Snp
+  UINT64                        RxDropCount;        // Received packets that no instance wanted or that were malformed
+} MNP_RX_STATISTICS;
+
 typedef struct {
   UINT32                        Signature;
 
@@ -55,6 +85,17 @@ typedef struct {
   CHAR16                        *MacString;
   EFI_SIMPLE_NETWORK_PROTOCOL   *Snp;
 
+  //
+  // Batched transmit, only used if the Snp driver produces the Simple Network
+  // Batch Transmit Protocol. The packets queued by MnpQueueTxPacket () are
+  // sent by TxFlushEvent once the TPL drops below TPL_CALLBACK, or as soon as
+  // MNP_TX_BATCH_SIZE packets are queued.
+  //
+  EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL  *BatchTx;
+  EFI_EVENT                     TxFlushEvent;
+  MNP_TX_PENDING                TxPending[MNP_TX_BATCH_SIZE];
+  UINTN                         TxPendingCount;
+
   //
   // List of MNP_SERVICE_DATA
   //
@@ -76,6 +117,13 @@ typedef struct {
 
   EFI_EVENT                     PollTimer;
   BOOLEAN                       EnableSystemPoll;
+  //
+  // Current period of PollTimer, adapted to the receive load, and the
+  // number of consecutive system polls that received nothing.
+  //
+  UINT64                        PollInterval;
+  UINT32                        IdlePollCount;
+  MNP_RX_STATISTICS             RxStatistics;
 
   EFI_EVENT                     TimeoutCheckTimer;
   EFI_EVENT                     MediaDetectTimer;
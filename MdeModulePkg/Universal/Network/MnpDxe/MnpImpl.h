@@ -21,6 +21,10 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define NET_ETHER_FCS_SIZE            4
 
 #define MNP_SYS_POLL_INTERVAL         (10 * TICKS_PER_MS)   // 10 milliseconds
+#define MNP_SYS_POLL_INTERVAL_MIN     (1 * TICKS_PER_MS)    // 1 millisecond
+#define MNP_SYS_POLL_INTERVAL_MAX     (50 * TICKS_PER_MS)   // 50 milliseconds
+#define MNP_SYS_POLL_BUDGET           64    // Max packets received by one system poll.
+#define MNP_SYS_POLL_IDLE_COUNT       8     // Empty system polls before the interval is lengthened.
 #define MNP_TIMEOUT_CHECK_INTERVAL    (50 * TICKS_PER_MS)   // 50 milliseconds
 #define MNP_MEDIA_DETECT_INTERVAL     (500 * TICKS_PER_MS)  // 500 milliseconds
 #define MNP_TX_TIMEOUT_TIME           (500 * TICKS_PER_MS)  // 500 milliseconds
@@ -390,6 +394,76 @@ MnpSyncSendPacket (
   IN OUT EFI_MANAGED_NETWORK_COMPLETION_TOKEN    *Token
   );
 
+/**
+  Queue the packet for a batched transmit.
+
+  The queued packets are passed to the Simple Network Batch Transmit Protocol
+  when the TPL drops below TPL_CALLBACK, when MNP_TX_BATCH_SIZE packets are
+  queued, or when the device is polled. The token is signaled once its packet
+  is placed in SNP driver's transmit queue, while the packet buffer recycle is
+  deferred like in MnpSyncSendPacket ().
+
+  @param[in]       Instance            Pointer to the instance transmitting the packet.
+  @param[in]       Packet              Pointer to the pakcet buffer.
+  @param[in]       Length              The length of the packet.
+  @param[in, out]  Token               Pointer to the token the packet generated from.
+
+  @retval EFI_SUCCESS                  The packet is queued.
+
+**/
+EFI_STATUS
+MnpQueueTxPacket (
+  IN     MNP_INSTANCE_DATA                       *Instance,
+  IN     UINT8                                   *Packet,
+  IN     UINT32                                  Length,
+  IN OUT EFI_MANAGED_NETWORK_COMPLETION_TOKEN    *Token
+  );
+
+/**
+  Send the packets queued by MnpQueueTxPacket () through the Simple Network
+  Batch Transmit Protocol, and signal their tokens.
+
+  @param[in, out]  MnpDeviceData       Pointer to the mnp device context data.
+
+**/
+VOID
+MnpFlushTxPackets (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  );
+
+/**
+  Cancel the packets queued by MnpQueueTxPacket () for the instance, and signal
+  their tokens with EFI_ABORTED.
+
+  @param[in]  Instance          Pointer to the instance context data.
+  @param[in]  Token             The token to cancel, or NULL to cancel all the
+                                queued tokens of the instance.
+
+  @retval EFI_SUCCESS           Token is NULL, or Token isn't queued.
+  @retval EFI_ABORTED           Token isn't NULL, and it is cancelled.
+
+**/
+EFI_STATUS
+MnpCancelTxPackets (
+  IN MNP_INSTANCE_DATA                     *Instance,
+  IN EFI_MANAGED_NETWORK_COMPLETION_TOKEN  *Token OPTIONAL
+  );
+
+/**
+  Send the packets queued by MnpQueueTxPacket () once the TPL drops below
+  TPL_CALLBACK.
+
+  @param[in]  Event        The event this notify function registered to.
+  @param[in]  Context      Pointer to the context data registered to the event.
+
+**/
+VOID
+EFIAPI
+MnpFlushTxPacketsNotify (
+  IN EFI_EVENT     Event,
+  IN VOID          *Context
+  );
+
 /**
   Try to deliver the received packet to the instance.
 
@@ -426,7 +500,7 @@ MnpRecycleRxData (
 
   @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
 
-  @retval EFI_SUCCESS           add return value to function comment
+  @retval EFI_SUCCESS           A packet was received, and delivered or dropped.
   @retval EFI_NOT_STARTED       The simple network protocol is not started.
   @retval EFI_NOT_READY         No packet received.
   @retval EFI_DEVICE_ERROR      An unexpected error occurs.
@@ -482,6 +556,19 @@ MnpAllocTxBuf (
   IN OUT MNP_DEVICE_DATA   *MnpDeviceData
   );
 
+/**
+  Try to reclaim the TX buffer into the buffer pool.
+
+  @param[in, out]  MnpDeviceData         Pointer to the mnp device context data.
+  @param[in, out]  TxBuf                 Pointer to the TX buffer to free.
+
+**/
+VOID
+MnpFreeTxBuf (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN OUT UINT8             *TxBuf
+  );
+
 /**
   Try to recycle all the transmitted buffer address from SNP.
 
@@ -301,6 +301,264 @@ SIGNAL_TOKEN:
   return EFI_SUCCESS;
 }
 
+/**
+  Queue the packet for a batched transmit.
+
+  The queued packets are passed to the Simple Network Batch Transmit Protocol
+  when the TPL drops below TPL_CALLBACK, when MNP_TX_BATCH_SIZE packets are
+  queued, or when the device is polled. The token is signaled once its packet
+  is placed in SNP driver's transmit queue, while the packet buffer recycle is
+  deferred like in MnpSyncSendPacket ().
+
+  @param[in]       Instance            Pointer to the instance transmitting the packet.
+  @param[in]       Packet              Pointer to the pakcet buffer.
+  @param[in]       Length              The length of the packet.
+  @param[in, out]  Token               Pointer to the token the packet generated from.
+
+  @retval EFI_SUCCESS                  The packet is queued.
+
+**/
+EFI_STATUS
+MnpQueueTxPacket (
+  IN     MNP_INSTANCE_DATA                       *Instance,
+  IN     UINT8                                   *Packet,
+  IN     UINT32                                  Length,
+  IN OUT EFI_MANAGED_NETWORK_COMPLETION_TOKEN    *Token
+  )
+{
+  EFI_SIMPLE_NETWORK_PROTOCOL       *Snp;
+  EFI_MANAGED_NETWORK_TRANSMIT_DATA *TxData;
+  MNP_SERVICE_DATA                  *MnpServiceData;
+  MNP_DEVICE_DATA                   *MnpDeviceData;
+  MNP_TX_PENDING                    *TxPending;
+  UINT16                            ProtocolType;
+
+  MnpServiceData = Instance->MnpServiceData;
+  MnpDeviceData = MnpServiceData->MnpDeviceData;
+  Snp           = MnpDeviceData->Snp;
+  TxData        = Token->Packet.TxData;
+  Token->Status = EFI_SUCCESS;
+
+  if (Snp->Mode->MediaPresentSupported && !Snp->Mode->MediaPresent) {
+    //
+    // Media not present, skip packet transmit and report EFI_NO_MEDIA
+    //
+    DEBUG ((EFI_D_WARN, "MnpQueueTxPacket: No network cable detected.\n"));
+    MnpFreeTxBuf (MnpDeviceData, (MnpServiceData->VlanId != 0) ? Packet - NET_VLAN_TAG_LEN : Packet);
+    Token->Status = EFI_NO_MEDIA;
+    gBS->SignalEvent (Token->Event);
+    DispatchDpc ();
+    return EFI_SUCCESS;
+  }
+
+  if (MnpServiceData->VlanId != 0) {
+    //
+    // Insert VLAN tag
+    //
+    MnpInsertVlanTag (MnpServiceData, TxData, &ProtocolType, &Packet, &Length);
+  } else {
+    ProtocolType = TxData->ProtocolType;
+  }
+
+  ASSERT (MnpDeviceData->TxPendingCount < MNP_TX_BATCH_SIZE);
+  TxPending                 = &MnpDeviceData->TxPending[MnpDeviceData->TxPendingCount++];
+  TxPending->ManagedNetwork = &Instance->ManagedNetwork;
+  TxPending->Token          = Token;
+  TxPending->Packet         = Packet;
+  TxPending->Length         = Length;
+  TxPending->HeaderSize     = Snp->Mode->MediaHeaderSize - TxData->HeaderLength;
+  TxPending->ProtocolType   = ProtocolType;
+
+  if (MnpDeviceData->TxPendingCount == MNP_TX_BATCH_SIZE) {
+    MnpFlushTxPackets (MnpDeviceData);
+  } else if (MnpDeviceData->TxPendingCount == 1) {
+    gBS->SignalEvent (MnpDeviceData->TxFlushEvent);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Send the packets queued by MnpQueueTxPacket () through the Simple Network
+  Batch Transmit Protocol, and signal their tokens.
+
+  @param[in, out]  MnpDeviceData       Pointer to the mnp device context data.
+
+**/
+VOID
+MnpFlushTxPackets (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  )
+{
+  EFI_STATUS                            Status;
+  EDKII_SIMPLE_NETWORK_TRANSMIT_PACKET  Packets[MNP_TX_BATCH_SIZE];
+  EFI_MANAGED_NETWORK_COMPLETION_TOKEN  *Tokens[MNP_TX_BATCH_SIZE];
+  EFI_MANAGED_NETWORK_TRANSMIT_DATA     *TxData;
+  MNP_TX_PENDING                        *TxPending;
+  UINTN                                 Count;
+  UINTN                                 Sent;
+  UINTN                                 Accepted;
+  UINTN                                 Index;
+  BOOLEAN                               Retried;
+
+  Count = MnpDeviceData->TxPendingCount;
+  if (Count == 0) {
+    return;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    TxPending = &MnpDeviceData->TxPending[Index];
+    TxData    = TxPending->Token->Packet.TxData;
+
+    Packets[Index].HeaderSize = TxPending->HeaderSize;
+    Packets[Index].BufferSize = TxPending->Length;
+    Packets[Index].Buffer     = TxPending->Packet;
+    Packets[Index].SrcAddr    = TxData->SourceAddress;
+    Packets[Index].DestAddr   = TxData->DestinationAddress;
+    Packets[Index].Protocol   = &TxPending->ProtocolType;
+  }
+
+  Sent    = 0;
+  Retried = FALSE;
+  while (Sent < Count) {
+    Accepted = Count - Sent;
+    Status   = MnpDeviceData->BatchTx->TransmitBatch (MnpDeviceData->BatchTx, &Accepted, &Packets[Sent]);
+    Sent    += Accepted;
+    if (!EFI_ERROR (Status) && (Accepted != 0)) {
+      continue;
+    }
+
+    if (Status == EFI_NOT_READY) {
+      //
+      // The transmit queue is full. Reclaim the buffers the interface has
+      // sent, and give up only if that does not make any room.
+      //
+      if (Accepted == 0 && Retried) {
+        break;
+      }
+      Retried = (BOOLEAN) (Accepted == 0);
+      if (EFI_ERROR (MnpRecycleTxBuf (MnpDeviceData))) {
+        break;
+      }
+      continue;
+    }
+
+    //
+    // The interface failed. The packets it accepted belong to the Snp driver
+    // and are only reclaimed through GetStatus.
+    //
+    break;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Tokens[Index] = MnpDeviceData->TxPending[Index].Token;
+    if (Index >= Sent) {
+      //
+      // The packet was never handed to the Snp driver, reclaim it here.
+      //
+      Tokens[Index]->Status = EFI_DEVICE_ERROR;
+      MnpFreeTxBuf (MnpDeviceData, MnpDeviceData->TxPending[Index].Packet);
+    }
+  }
+
+  //
+  // The notify functions of the tokens may queue new packets.
+  //
+  MnpDeviceData->TxPendingCount = 0;
+  for (Index = 0; Index < Count; Index++) {
+    gBS->SignalEvent (Tokens[Index]->Event);
+  }
+
+  //
+  // Dispatch the DPC queued by the NotifyFunction of the tokens' events.
+  //
+  DispatchDpc ();
+}
+
+/**
+  Cancel the packets queued by MnpQueueTxPacket () for the instance, and signal
+  their tokens with EFI_ABORTED.
+
+  @param[in]  Instance          Pointer to the instance context data.
+  @param[in]  Token             The token to cancel, or NULL to cancel all the
+                                queued tokens of the instance.
+
+  @retval EFI_SUCCESS           Token is NULL, or Token isn't queued.
+  @retval EFI_ABORTED           Token isn't NULL, and it is cancelled.
+
+**/
+EFI_STATUS
+MnpCancelTxPackets (
+  IN MNP_INSTANCE_DATA                     *Instance,
+  IN EFI_MANAGED_NETWORK_COMPLETION_TOKEN  *Token OPTIONAL
+  )
+{
+  MNP_DEVICE_DATA                       *MnpDeviceData;
+  MNP_TX_PENDING                        *TxPending;
+  EFI_MANAGED_NETWORK_COMPLETION_TOKEN  *TokenToCancel;
+  EFI_STATUS                            Status;
+  UINTN                                 Index;
+  UINTN                                 Kept;
+
+  MnpDeviceData = Instance->MnpServiceData->MnpDeviceData;
+  Status        = EFI_SUCCESS;
+  Kept          = 0;
+
+  for (Index = 0; Index < MnpDeviceData->TxPendingCount; Index++) {
+    TxPending = &MnpDeviceData->TxPending[Index];
+    if ((TxPending->ManagedNetwork != &Instance->ManagedNetwork) ||
+        ((Token != NULL) && (TxPending->Token != Token))) {
+      //
+      // Keep the packet queued, in order.
+      //
+      if (Kept != Index) {
+        CopyMem (&MnpDeviceData->TxPending[Kept], TxPending, sizeof (MNP_TX_PENDING));
+      }
+      Kept++;
+      continue;
+    }
+
+    //
+    // The packet has not been handed to the Snp driver yet, so its buffer can
+    // be reclaimed right away.
+    //
+    TokenToCancel = TxPending->Token;
+    MnpFreeTxBuf (MnpDeviceData, TxPending->Packet);
+    TokenToCancel->Status = EFI_ABORTED;
+    gBS->SignalEvent (TokenToCancel->Event);
+
+    if (Token != NULL) {
+      Status = EFI_ABORTED;
+    }
+  }
+
+  MnpDeviceData->TxPendingCount = Kept;
+  return Status;
+}
+
+/**
+  Send the packets queued by MnpQueueTxPacket () once the TPL drops below
+  TPL_CALLBACK.
+
+  @param[in]  Event        The event this notify function registered to.
+  @param[in]  Context      Pointer to the context data registered to the event.
+
+**/
+VOID
+EFIAPI
+MnpFlushTxPacketsNotify (
+  IN EFI_EVENT     Event,
+  IN VOID          *Context
+  )
+{
+  MNP_DEVICE_DATA  *MnpDeviceData;
+
+  MnpDeviceData = (MNP_DEVICE_DATA *) Context;
+  NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
+
+  MnpFlushTxPackets (MnpDeviceData);
+}
+
 
 /**
   Try to deliver the received packet to the instance.
@@ -843,7 +1101,7 @@ MnpEnqueuePacket (
 
   @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
 
-  @retval EFI_SUCCESS           add return value to function comment
+  @retval EFI_SUCCESS           A packet was received, and delivered or dropped.
   @retval EFI_NOT_STARTED       The simple network protocol is not started.
   @retval EFI_NOT_READY         No packet received.
   @retval EFI_DEVICE_ERROR      An unexpected error occurs.
@@ -914,17 +1172,23 @@ MnpReceivePacket (
     return Status;
   }
 
+  MnpDeviceData->RxStatistics.RxPacketCount++;
+
   //
   // Sanity check.
   //
   if ((HeaderSize != Snp->Mode->MediaHeaderSize) || (BufLen < HeaderSize)) {
+    //
+    // Drop the malformed frame, the cache buffer has not been trimmed yet.
+    //
+    MnpDeviceData->RxStatistics.RxDropCount++;
     DEBUG (
       (EFI_D_WARN,
       "MnpReceivePacket: Size error, HL:TL = %d:%d.\n",
       HeaderSize,
       BufLen)
       );
-    return EFI_DEVICE_ERROR;
+    goto EXIT;
   }
 
   Trimmed = 0;
@@ -951,6 +1215,7 @@ MnpReceivePacket (
     //
     // VLAN is not set for this tagged frame, ignore this packet
     //
+    MnpDeviceData->RxStatistics.RxDropCount++;
     if (Trimmed > 0) {
       NetbufAllocSpace (Nbuf, Trimmed, NET_BUF_TAIL);
     }
@@ -986,6 +1251,7 @@ MnpReceivePacket (
     //
     // No receiver for this packet.
     //
+    MnpDeviceData->RxStatistics.RxDropCount++;
     if (Trimmed > 0) {
       NetbufAllocSpace (Nbuf, Trimmed, NET_BUF_TAIL);
     }
@@ -1108,10 +1374,57 @@ MnpCheckMediaStatus (
   }
 }
 
+/**
+  Adapt the period of the system poll timer to the number of packets the last
+  system poll received.
+
+  The period is halved while the polls use up their budget, set back to the
+  default once the load drops, and doubled after MNP_SYS_POLL_IDLE_COUNT polls
+  in a row received nothing.
+
+  @param[in, out]  MnpDeviceData   Pointer to the mnp device context data.
+  @param[in]       PacketCount     The number of packets the last poll received.
+
+**/
+VOID
+MnpAdaptPollInterval (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     UINT32            PacketCount
+  )
+{
+  UINT64  Interval;
+
+  Interval = MnpDeviceData->PollInterval;
+
+  if (PacketCount >= MNP_SYS_POLL_BUDGET) {
+    MnpDeviceData->IdlePollCount = 0;
+    Interval = MAX (Interval / 2, MNP_SYS_POLL_INTERVAL_MIN);
+  } else if (PacketCount > 0) {
+    MnpDeviceData->IdlePollCount = 0;
+    if (Interval > MNP_SYS_POLL_INTERVAL) {
+      Interval = MNP_SYS_POLL_INTERVAL;
+    }
+  } else {
+    MnpDeviceData->IdlePollCount++;
+    if (MnpDeviceData->IdlePollCount >= MNP_SYS_POLL_IDLE_COUNT) {
+      MnpDeviceData->IdlePollCount = 0;
+      Interval = MIN (Interval * 2, MNP_SYS_POLL_INTERVAL_MAX);
+    }
+  }
+
+  if (Interval != MnpDeviceData->PollInterval && MnpDeviceData->EnableSystemPoll) {
+    MnpDeviceData->PollInterval = Interval;
+    gBS->SetTimer (MnpDeviceData->PollTimer, TimerPeriodic, Interval);
+  }
+}
+
 /**
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
 
+  Each poll receives up to MNP_SYS_POLL_BUDGET packets, so that a burst is not
+  limited to one packet per timer tick when no upper layer polls on its own.
+
   @param[in]  Event        The event this notify function registered to.
   @param[in]  Context      Pointer to the context data registered to the event.
 
@@ -1124,14 +1437,39 @@ MnpSystemPoll (
   )
 {
   MNP_DEVICE_DATA  *MnpDeviceData;
+  UINT32           PacketCount;
 
   MnpDeviceData = (MNP_DEVICE_DATA *) Context;
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
-  //
-  // Try to receive packets from Snp.
-  //
-  MnpReceivePacket (MnpDeviceData);
+  MnpFlushTxPackets (MnpDeviceData);
+
+  for (PacketCount = 0; PacketCount < MNP_SYS_POLL_BUDGET; PacketCount++) {
+    //
+    // Try to receive packets from Snp. A malformed or unwanted frame is
+    // dropped with EFI_SUCCESS, so only an empty Snp queue or a real error
+    // ends the drain.
+    //
+    if (EFI_ERROR (MnpReceivePacket (MnpDeviceData))) {
+      break;
+    }
+
+    //
+    // Dispatch the DPC queued by the NotifyFunction of rx token's events, so
+    // that the receivers can queue new rx tokens for the next packets.
+    //
+    DispatchDpc ();
+  }
+
+  MnpDeviceData->RxStatistics.PollCount++;
+  if (PacketCount == 0) {
+    MnpDeviceData->RxStatistics.EmptyPollCount++;
+  }
+  if (PacketCount > MnpDeviceData->RxStatistics.MaxPacketsPerPoll) {
+    MnpDeviceData->RxStatistics.MaxPacketsPerPoll = PacketCount;
+  }
+
+  MnpAdaptPollInterval (MnpDeviceData, PacketCount);
 
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
@@ -557,10 +557,18 @@ MnpTransmit (
     goto ON_EXIT;
   }
 
-  //
-  //  OK, send the packet synchronously.
-  //
-  Status = MnpSyncSendPacket (MnpServiceData, PktBuf, PktLen, Token);
+  if (MnpServiceData->MnpDeviceData->BatchTx != NULL) {
+    //
+    // Queue the packet, it is sent together with the other packets
+    // transmitted before the TPL drops.
+    //
+    Status = MnpQueueTxPacket (Instance, PktBuf, PktLen, Token);
+  } else {
+    //
+    //  OK, send the packet synchronously.
+    //
+    Status = MnpSyncSendPacket (MnpServiceData, PktBuf, PktLen, Token);
+  }
 
 ON_EXIT:
   gBS->RestoreTPL (OldTpl);
@@ -715,6 +723,13 @@ MnpCancel (
   // Iterate the RxTokenMap to cancel the specified Token.
   //
   Status = NetMapIterate (&Instance->RxTokenMap, MnpCancelTokens, (VOID *) Token);
+  if ((Token == NULL) || (Status != EFI_ABORTED)) {
+    //
+    // Then cancel the Tx tokens still queued for a batched transmit.
+    //
+    Status = MnpCancelTxPackets (Instance, Token);
+  }
+
   if (Token != NULL) {
     Status = (Status == EFI_ABORTED) ? EFI_SUCCESS : EFI_NOT_FOUND;
   }
@@ -779,6 +794,11 @@ MnpPoll (
     goto ON_EXIT;
   }
 
+  //
+  // Send the queued packets before waiting for the replies.
+  //
+  MnpFlushTxPackets (Instance->MnpServiceData->MnpDeviceData);
+
   //
   // Try to receive packets.
   //
@@ -81,6 +81,10 @@ Mtftp4CleanOperation (
 
   Instance->BlkSize       = MTFTP4_DEFAULT_BLKSIZE;
   Instance->LastBlock     = 0;
+  Instance->WindowSize    = MTFTP4_DEFAULT_WINDOWSIZE;
+  Instance->TotalBlock    = 0;
+  Instance->AckedBlock    = 0;
+  Instance->GapBlock      = -1;
   Instance->ServerIp      = 0;
   Instance->ListeningPort = 0;
   Instance->ConnectedPort = 0;
@@ -435,6 +439,16 @@ Mtftp4Start (
       TokenStatus = EFI_DEVICE_ERROR;
       goto ON_ERROR;
     }
+
+    //
+    // The windowsize option only applies to downloads.
+    //
+    if ((Operation == EFI_MTFTP4_OPCODE_WRQ) &&
+        ((Instance->RequestOption.Exist & MTFTP4_WINDOWSIZE_EXIST) != 0)) {
+      Status      = EFI_UNSUPPORTED;
+      TokenStatus = EFI_DEVICE_ERROR;
+      goto ON_ERROR;
+    }
   }
 
   //
@@ -443,6 +457,8 @@ Mtftp4Start (
   Config                  = &Instance->Config;
   Instance->Token         = Token;
   Instance->BlkSize       = MTFTP4_DEFAULT_BLKSIZE;
+  Instance->WindowSize    = MTFTP4_DEFAULT_WINDOWSIZE;
+  Instance->GapBlock      = -1;
 
   CopyMem (&Instance->ServerIp, &Config->ServerIp, sizeof (IP4_ADDR));
   Instance->ServerIp      = NTOHL (Instance->ServerIp);
@@ -56,6 +56,7 @@ typedef struct _MTFTP4_PROTOCOL MTFTP4_PROTOCOL;
 #define MTFTP4_DEFAULT_TIMEOUT      3
 #define MTFTP4_DEFAULT_RETRY        5
 #define MTFTP4_DEFAULT_BLKSIZE      512
+#define MTFTP4_DEFAULT_WINDOWSIZE   1
 #define MTFTP4_TIME_TO_GETMAP       5
 
 #define MTFTP4_STATE_UNCONFIGED     0
@@ -121,6 +122,18 @@ struct _MTFTP4_PROTOCOL {
   UINT16                        LastBlock;
   LIST_ENTRY                    Blocks;
 
+  //
+  // The number of data blocks the server sends before waiting for an
+  // ACK (RFC 7440), the number of blocks received and saved, and the
+  // number of blocks received when the last ACK was sent. GapBlock is
+  // the block that was expected when an ACK was last sent for a lost
+  // block, or -1 if a block was received in order since.
+  //
+  UINT16                        WindowSize;
+  UINT64                        TotalBlock;
+  UINT64                        AckedBlock;
+  INTN                          GapBlock;
+
   //
   // The server's communication end point: IP and two ports. one for
   // initial request, one for its selected port.
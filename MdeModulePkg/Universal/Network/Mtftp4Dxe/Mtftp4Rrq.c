@@ -115,6 +115,8 @@ Mtftp4RrqSendAck (
   Ack->Ack.OpCode   = HTONS (EFI_MTFTP4_OPCODE_ACK);
   Ack->Ack.Block[0] = HTONS (BlkNo);
 
+  Instance->AckedBlock = Instance->TotalBlock;
+
   return Mtftp4SendPacket (Instance, Packet);
 }
 
@@ -230,7 +232,10 @@ Mtftp4RrqSaveBlock (
 /**
   Function to process the received data packets. 
   
-  It will save the block then send back an ACK if it is active.
+  It will save the block then send back an ACK if it is active. If a window
+  size was negotiated, the ACK is only sent when the whole window has been
+  received, or when a block is lost, to tell the server to send the window
+  again from the last block received in order.
 
   @param  Instance              The downloading MTFTP session
   @param  Packet                The packet received
@@ -268,7 +273,24 @@ Mtftp4RrqHandleData (
   // the block.
   //
   if (Instance->Master && (Expected != BlockNum)) {
-    Mtftp4Retransmit (Instance);
+    if (Instance->WindowSize == 1) {
+      Mtftp4Retransmit (Instance);
+      return EFI_SUCCESS;
+    }
+
+    //
+    // In a window, the server keeps sending the blocks after the lost
+    // one. ACK the last block received in order once per lost block, so
+    // the server sends the window again from there, and drop the rest.
+    // This also covers the loss of the first block of a window, when no
+    // block was received since the last ACK. If Expected is 0,
+    // (UINT16) (Expected - 1) is the block number 65535.
+    //
+    if (Instance->GapBlock != Expected) {
+      Instance->GapBlock = Expected;
+      return Mtftp4RrqSendAck (Instance, (UINT16) (Expected - 1));
+    }
+
     return EFI_SUCCESS;
   }
 
@@ -278,11 +300,15 @@ Mtftp4RrqHandleData (
     return Status;
   }
 
+  Instance->TotalBlock++;
+  Instance->GapBlock = -1;
+
   //
   // Reset the passive client's timer whenever it received a
-  // valid data packet.
+  // valid data packet. So does the active client in a window,
+  // because it doesn't ACK every block.
   //
-  if (!Instance->Master) {
+  if (!Instance->Master || (Instance->WindowSize > 1)) {
     Mtftp4SetTimeout (Instance);
   }
 
@@ -309,7 +335,10 @@ Mtftp4RrqHandleData (
       BlockNum = (UINT16) (Expected - 1);
     }
 
-    Mtftp4RrqSendAck (Instance, BlockNum);
+    if ((Expected < 0) ||
+        (Instance->TotalBlock - Instance->AckedBlock >= Instance->WindowSize)) {
+      Mtftp4RrqSendAck (Instance, BlockNum);
+    }
   }
 
   return EFI_SUCCESS;
@@ -324,6 +353,7 @@ Mtftp4RrqHandleData (
   2. The server can only use smaller blksize than that is requested
   3. The server can only use the same timeout as requested
   4. The server doesn't change its multicast channel.
+  5. The server can only use smaller windowsize than that is requested
 
   @param  This                  The downloading Mtftp session
   @param  Reply                 The options in the OACK packet
@@ -357,6 +387,15 @@ Mtftp4RrqOackValid (
     return FALSE;
   }
 
+  //
+  // Server can only specify a smaller window size to be used. The window
+  // isn't supported in multicast download, where each client ACKs in turn.
+  //
+  if (((Reply->Exist & MTFTP4_WINDOWSIZE_EXIST) != 0) &&
+      ((Reply->WindowSize > Request->WindowSize) || ((Reply->Exist & MTFTP4_MCAST_EXIST) != 0))) {
+    return FALSE;
+  }
+
   //
   // The server can send ",,master" to client to change its master
   // setting. But if it use the specific multicast channel, it can't
@@ -614,6 +653,10 @@ Mtftp4RrqHandleOack (
     if (Reply.Timeout != 0) {
       Instance->Timeout = Reply.Timeout;
     }
+
+    if (Reply.WindowSize != 0) {
+      Instance->WindowSize = Reply.WindowSize;
+    }
   }
   
   //
@@ -353,9 +353,10 @@ EfiPxeBcStart (
 
 
   //
-  // Configure block size for TFTP as a default value to handle all link layers.
+  // Configure block size for TFTP from the MTU of the link, so that a data
+  // packet fills a whole frame, jumbo frames included.
   // 
-  Private->BlockSize   = MIN (Private->Ip4MaxPacketSize, PXEBC_DEFAULT_PACKET_SIZE) -
+  Private->BlockSize   = Private->Ip4MaxPacketSize -
                            PXEBC_DEFAULT_UDP_OVERHEAD_SIZE - PXEBC_DEFAULT_TFTP_OVERHEAD_SIZE;
   //
   // If PcdTftpBlockSize is set to non-zero, override the default value.
@@ -363,6 +364,8 @@ EfiPxeBcStart (
   if (PcdGet64 (PcdTftpBlockSize) != 0) {
     Private->BlockSize   = (UINTN) PcdGet64 (PcdTftpBlockSize);
   }
+
+  Private->WindowSize  = PcdGet16 (PcdTftpWindowSize);
   
   Private->AddressIsOk = FALSE;
 
@@ -55,7 +55,6 @@ typedef struct _PXEBC_PRIVATE_DATA  PXEBC_PRIVATE_DATA;
 #define PXEBC_MTFTP_RETRIES                6
 #define PXEBC_DEFAULT_UDP_OVERHEAD_SIZE    8
 #define PXEBC_DEFAULT_TFTP_OVERHEAD_SIZE   4
-#define PXEBC_DEFAULT_PACKET_SIZE          1480
 #define PXEBC_DEFAULT_LIFETIME             50000  // 50ms, unit is microsecond
 #define PXEBC_CHECK_MEDIA_WAITING_TIME     EFI_TIMER_PERIOD_SECONDS(20)
 
@@ -100,6 +99,7 @@ struct _PXEBC_PRIVATE_DATA {
   BOOLEAN                                   AddressIsOk;
   UINT32                                    Ip4MaxPacketSize;
   UINTN                                     BlockSize;
+  UINTN                                     WindowSize;
   UINTN                                     FileSize;
 
   UINT8                                     OptionBuffer[PXEBC_DHCP4_MAX_OPTION_SIZE];
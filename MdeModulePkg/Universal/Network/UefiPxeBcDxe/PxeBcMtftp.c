@@ -18,7 +18,8 @@ CHAR8 *mMtftpOptions[PXE_MTFTP_OPTION_MAXIMUM_INDEX] = {
   "blksize",
   "timeout",
   "tsize",
-  "multicast"
+  "multicast",
+  "windowsize"
 };
 
 
@@ -242,14 +243,16 @@ PxeBcTftpReadFile (
 {
   EFI_MTFTP4_PROTOCOL *Mtftp4;
   EFI_MTFTP4_TOKEN    Token;
-  EFI_MTFTP4_OPTION   ReqOpt[1];
+  EFI_MTFTP4_OPTION   ReqOpt[2];
   UINT32              OptCnt;
   UINT8               OptBuf[128];
+  UINTN               OptLen;
   EFI_STATUS          Status;
 
   Status                    = EFI_DEVICE_ERROR;
   Mtftp4                    = Private->Mtftp4;
   OptCnt                    = 0;
+  OptLen                    = 0;
   Config->InitialServerPort = PXEBC_BS_DOWNLOAD_PORT;
 
   Status = Mtftp4->Configure (Mtftp4, Config);
@@ -263,6 +266,18 @@ PxeBcTftpReadFile (
     ReqOpt[0].OptionStr = (UINT8*) mMtftpOptions[PXE_MTFTP_OPTION_BLKSIZE_INDEX];
     ReqOpt[0].ValueStr  = OptBuf;
     UtoA10 (*BlockSize, (CHAR8 *) ReqOpt[0].ValueStr, PXE_MTFTP_OPTBUF_MAXNUM_INDEX);
+    OptLen = AsciiStrLen ((CHAR8 *) ReqOpt[0].ValueStr) + 1;
+    OptCnt++;
+  }
+
+  //
+  // Ask the server to send several blocks per ACK. A server which doesn't
+  // support the windowsize option ignores it and sends one block per ACK.
+  //
+  if (Private->WindowSize > 1) {
+    ReqOpt[OptCnt].OptionStr = (UINT8*) mMtftpOptions[PXE_MTFTP_OPTION_WINDOWSIZE_INDEX];
+    ReqOpt[OptCnt].ValueStr  = OptBuf + OptLen;
+    UtoA10 (Private->WindowSize, (CHAR8 *) ReqOpt[OptCnt].ValueStr, PXE_MTFTP_OPTBUF_MAXNUM_INDEX - OptLen);
     OptCnt++;
   }
 
@@ -211,6 +211,14 @@
 ///
 #define HTTP_HEADER_IF_NONE_MATCH     "If-None-Match"
 
+///
+/// The If-Modified-Since request-header field is used with a method to make it
+/// conditional: if the requested variant has not been modified since the time
+/// specified in this field, the server returns a 304 (not modified) response
+/// without any message-body.
+///
+#define HTTP_HEADER_IF_MODIFIED_SINCE "If-Modified-Since"
+
 
 
 /// 
@@ -228,6 +236,20 @@
 ///
 #define HTTP_HEADER_ETAG              "ETag"
 
+///
+/// Last-Modified Response Header
+/// The Last-Modified entity-header field indicates the date and time at
+/// which the origin server believes the variant was last modified.
+///
+#define HTTP_HEADER_LAST_MODIFIED     "Last-Modified"
+
+///
+/// Range Request Header
+/// The Range request-header field requests only one or more sub-ranges
+/// of the entity, for example "bytes=0-499" for the first 500 bytes.
+///
+#define HTTP_HEADER_RANGE             "Range"
+
 ///
 /// Custom header field checked by the iLO web server to
 /// specify a client session key.
@@ -954,6 +954,7 @@ PeCoffLoaderRelocateImage (
   UINT32                                NumberOfRvaAndSizes;
   UINT16                                Magic;
   UINT32                                TeStrippedOffset;
+  UINT16                                RelocType;
 
   ASSERT (ImageContext != NULL);
 
@@ -1086,6 +1087,28 @@ PeCoffLoaderRelocateImage (
         return RETURN_LOAD_ERROR;
       }  
 
+      //
+      // Fast path for blocks of 64-bit fixups, as emitted for X64 and AARCH64
+      // images. When no fixup log is kept and the whole 4 KB page covered by
+      // this block lies within the image, every entry of the block is known to
+      // be in range, so the per-entry address check can be skipped. Stop at
+      // the first entry of another type and let the generic loop below handle
+      // the rest of the block.
+      //
+      if ((FixupData == NULL) &&
+          ((UINT64) RelocBase->VirtualAddress + SIZE_4KB <= (UINT64) ImageContext->ImageSize + TeStrippedOffset)) {
+        while (Reloc < RelocEnd) {
+          RelocType = (UINT16) ((*Reloc) >> 12);
+          if (RelocType == EFI_IMAGE_REL_BASED_DIR64) {
+            Fixup64  = (UINT64 *) (FixupBase + (*Reloc & 0xFFF));
+            *Fixup64 = *Fixup64 + (UINT64) Adjust;
+          } else if (RelocType != EFI_IMAGE_REL_BASED_ABSOLUTE) {
+            break;
+          }
+          Reloc += 1;
+        }
+      }
+
       //
       // Run this relocation record
       //
@@ -352,6 +352,7 @@ DnsUnload (
   DNS4_SERVER_IP                  *ItemServerIp4;
   DNS6_CACHE                      *ItemCache6;
   DNS6_SERVER_IP                  *ItemServerIp6;
+  DNS_NEGATIVE_CACHE              *ItemNegative;
 
   ItemCache4    = NULL;
   ItemServerIp4 = NULL;
@@ -409,6 +410,20 @@ DnsUnload (
       ItemServerIp6 = NET_LIST_USER_STRUCT (Entry, DNS6_SERVER_IP, AllServerLink);
       FreePool (ItemServerIp6);
     }
+
+    while (!IsListEmpty (&mDriverData->Dns4NegativeCacheList)) {
+      Entry = NetListRemoveHead (&mDriverData->Dns4NegativeCacheList);
+      ItemNegative = NET_LIST_USER_STRUCT (Entry, DNS_NEGATIVE_CACHE, AllCacheLink);
+      FreePool (ItemNegative->HostName);
+      FreePool (ItemNegative);
+    }
+
+    while (!IsListEmpty (&mDriverData->Dns6NegativeCacheList)) {
+      Entry = NetListRemoveHead (&mDriverData->Dns6NegativeCacheList);
+      ItemNegative = NET_LIST_USER_STRUCT (Entry, DNS_NEGATIVE_CACHE, AllCacheLink);
+      FreePool (ItemNegative->HostName);
+      FreePool (ItemNegative);
+    }
     
     FreePool (mDriverData);
   }
@@ -435,6 +450,7 @@ DnsDriverEntryPoint (
   )
 {
   EFI_STATUS  Status;
+  UINTN       Index;
 
   Status = EFI_SUCCESS;
 
@@ -500,6 +516,12 @@ DnsDriverEntryPoint (
   InitializeListHead (&mDriverData->Dns4ServerList);
   InitializeListHead (&mDriverData->Dns6CacheList);
   InitializeListHead (&mDriverData->Dns6ServerList);
+  InitializeListHead (&mDriverData->Dns4NegativeCacheList);
+  InitializeListHead (&mDriverData->Dns6NegativeCacheList);
+  for (Index = 0; Index < DNS_CACHE_HASH_SIZE; Index++) {
+    InitializeListHead (&mDriverData->Dns4CacheHash[Index]);
+    InitializeListHead (&mDriverData->Dns6CacheHash[Index]);
+  }
   
   return Status;
 
@@ -37,13 +37,22 @@ typedef struct _DNS_INSTANCE DNS_INSTANCE;
 
 #define DNS_INSTANCE_SIGNATURE   SIGNATURE_32 ('D', 'N', 'S', 'I') 
 
+///
+/// Number of buckets of the hash tables indexing the DNS caches by host name.
+///
+#define DNS_CACHE_HASH_SIZE      64
+
 struct _DNS_DRIVER_DATA {
   EFI_EVENT                     Timer; /// Ticking timer for DNS cache update.
   
   LIST_ENTRY                    Dns4CacheList;
+  LIST_ENTRY                    Dns4CacheHash[DNS_CACHE_HASH_SIZE];
+  LIST_ENTRY                    Dns4NegativeCacheList;
   LIST_ENTRY                    Dns4ServerList;
 
   LIST_ENTRY                    Dns6CacheList;
+  LIST_ENTRY                    Dns6CacheHash[DNS_CACHE_HASH_SIZE];
+  LIST_ENTRY                    Dns6NegativeCacheList;
   LIST_ENTRY                    Dns6ServerList;
 };
 
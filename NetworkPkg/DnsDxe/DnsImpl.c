@@ -773,15 +773,17 @@ UpdateDns4Cache (
   DNS4_CACHE    *Item;
   LIST_ENTRY    *Entry;
   LIST_ENTRY    *Next;
+  LIST_ENTRY    *Bucket;
 
   NewDnsCache = NULL;
   Item        = NULL;
+  Bucket      = &mDriverData->Dns4CacheHash[DnsCacheHash (DnsCacheEntry.HostName)];
   
   //
   // Search the database for the matching EFI_DNS_CACHE_ENTRY
   //
-  NET_LIST_FOR_EACH_SAFE (Entry, Next, Dns4CacheList) {
-    Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, Bucket) {
+    Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, HashLink);
     if (StrCmp (DnsCacheEntry.HostName, Item->DnsCache.HostName) == 0 && \
         CompareMem (DnsCacheEntry.IpAddress, Item->DnsCache.IpAddress, sizeof (EFI_IPv4_ADDRESS)) == 0) {
       //
@@ -792,6 +794,7 @@ UpdateDns4Cache (
         // Delete matching DNS Cache entry
         //
         RemoveEntryList (&Item->AllCacheLink);
+        RemoveEntryList (&Item->HashLink);
 
         FreePool (Item->DnsCache.HostName);
         FreePool (Item->DnsCache.IpAddress);
@@ -841,6 +844,7 @@ UpdateDns4Cache (
   NewDnsCache->DnsCache.Timeout = DnsCacheEntry.Timeout;
   
   InsertTailList (Dns4CacheList, &NewDnsCache->AllCacheLink);
+  InsertTailList (Bucket, &NewDnsCache->HashLink);
   
   return EFI_SUCCESS;
 }
@@ -871,15 +875,17 @@ UpdateDns6Cache (
   DNS6_CACHE    *Item;
   LIST_ENTRY    *Entry;
   LIST_ENTRY    *Next;
+  LIST_ENTRY    *Bucket;
 
   NewDnsCache = NULL;
   Item        = NULL;
+  Bucket      = &mDriverData->Dns6CacheHash[DnsCacheHash (DnsCacheEntry.HostName)];
   
   //
   // Search the database for the matching EFI_DNS_CACHE_ENTRY
   //
-  NET_LIST_FOR_EACH_SAFE (Entry, Next, Dns6CacheList) {
-    Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, Bucket) {
+    Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, HashLink);
     if (StrCmp (DnsCacheEntry.HostName, Item->DnsCache.HostName) == 0 && \
         CompareMem (DnsCacheEntry.IpAddress, Item->DnsCache.IpAddress, sizeof (EFI_IPv6_ADDRESS)) == 0) {
       //
@@ -890,6 +896,7 @@ UpdateDns6Cache (
         // Delete matching DNS Cache entry
         //
         RemoveEntryList (&Item->AllCacheLink);
+        RemoveEntryList (&Item->HashLink);
         
         FreePool (Item->DnsCache.HostName);
         FreePool (Item->DnsCache.IpAddress);
@@ -939,10 +946,591 @@ UpdateDns6Cache (
   NewDnsCache->DnsCache.Timeout = DnsCacheEntry.Timeout;
   
   InsertTailList (Dns6CacheList, &NewDnsCache->AllCacheLink);
+  InsertTailList (Bucket, &NewDnsCache->HashLink);
   
   return EFI_SUCCESS;
 }
 
+/**
+  Get the bucket of a host name in the hash tables of the DNS caches.
+
+  @param  HostName           The host name.
+
+  @return The index of the bucket.
+
+**/
+UINTN
+DnsCacheHash (
+  IN CHAR16                 *HostName
+  )
+{
+  UINT32    Hash;
+
+  //
+  // The cache compares host names case sensitively, so does the hash.
+  //
+  Hash = 0;
+  while (*HostName != L'\0') {
+    Hash = Hash * 31 + *HostName;
+    HostName++;
+  }
+
+  return Hash % DNS_CACHE_HASH_SIZE;
+}
+
+/**
+  Get the addresses of a host name from the Dns4 cache.
+
+  @param  HostName           The host name.
+  @param  H2AData            Return the addresses. The caller frees H2AData->IpList
+                             and H2AData.
+
+  @retval EFI_SUCCESS        The addresses are returned.
+  @retval EFI_NOT_FOUND      The host name is not in the cache.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the addresses.
+
+**/
+EFI_STATUS
+Dns4LookupCache (
+  IN     CHAR16                 *HostName,
+     OUT DNS_HOST_TO_ADDR_DATA  **H2AData
+  )
+{
+  LIST_ENTRY                *Bucket;
+  LIST_ENTRY                *Entry;
+  DNS4_CACHE                *Item;
+  UINT32                    Count;
+
+  Bucket = &mDriverData->Dns4CacheHash[DnsCacheHash (HostName)];
+
+  Count = 0;
+  NET_LIST_FOR_EACH (Entry, Bucket) {
+    Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, HashLink);
+    if (Item->DnsCache.Timeout != 0 && StrCmp (HostName, Item->DnsCache.HostName) == 0) {
+      Count++;
+    }
+  }
+
+  if (Count == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  *H2AData = AllocatePool (sizeof (DNS_HOST_TO_ADDR_DATA));
+  if (*H2AData == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  (*H2AData)->IpList = AllocatePool (sizeof (EFI_IPv4_ADDRESS) * Count);
+  if ((*H2AData)->IpList == NULL) {
+    FreePool (*H2AData);
+    *H2AData = NULL;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  (*H2AData)->IpCount = 0;
+  NET_LIST_FOR_EACH (Entry, Bucket) {
+    Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, HashLink);
+    if (Item->DnsCache.Timeout != 0 && StrCmp (HostName, Item->DnsCache.HostName) == 0) {
+      CopyMem ((*H2AData)->IpList + (*H2AData)->IpCount, Item->DnsCache.IpAddress, sizeof (EFI_IPv4_ADDRESS));
+      (*H2AData)->IpCount++;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the addresses of a host name from the Dns6 cache.
+
+  @param  HostName           The host name.
+  @param  H2AData            Return the addresses. The caller frees H2AData->IpList
+                             and H2AData.
+
+  @retval EFI_SUCCESS        The addresses are returned.
+  @retval EFI_NOT_FOUND      The host name is not in the cache.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the addresses.
+
+**/
+EFI_STATUS
+Dns6LookupCache (
+  IN     CHAR16                 *HostName,
+     OUT DNS6_HOST_TO_ADDR_DATA **H2AData
+  )
+{
+  LIST_ENTRY                *Bucket;
+  LIST_ENTRY                *Entry;
+  DNS6_CACHE                *Item;
+  UINT32                    Count;
+
+  Bucket = &mDriverData->Dns6CacheHash[DnsCacheHash (HostName)];
+
+  Count = 0;
+  NET_LIST_FOR_EACH (Entry, Bucket) {
+    Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, HashLink);
+    if (Item->DnsCache.Timeout != 0 && StrCmp (HostName, Item->DnsCache.HostName) == 0) {
+      Count++;
+    }
+  }
+
+  if (Count == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  *H2AData = AllocatePool (sizeof (DNS6_HOST_TO_ADDR_DATA));
+  if (*H2AData == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  (*H2AData)->IpList = AllocatePool (sizeof (EFI_IPv6_ADDRESS) * Count);
+  if ((*H2AData)->IpList == NULL) {
+    FreePool (*H2AData);
+    *H2AData = NULL;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  (*H2AData)->IpCount = 0;
+  NET_LIST_FOR_EACH (Entry, Bucket) {
+    Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, HashLink);
+    if (Item->DnsCache.Timeout != 0 && StrCmp (HostName, Item->DnsCache.HostName) == 0) {
+      CopyMem ((*H2AData)->IpList + (*H2AData)->IpCount, Item->DnsCache.IpAddress, sizeof (EFI_IPv6_ADDRESS));
+      (*H2AData)->IpCount++;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Remember that a host name doesn't exist, or update the time it is remembered.
+
+  @param  NegativeCacheList  The Dns4 or Dns6 negative cache list.
+  @param  HostName           The host name the server answered doesn't exist.
+  @param  Timeout            The time to remember it, in seconds.
+
+  @retval EFI_SUCCESS        The negative cache is updated.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the entry.
+
+**/
+EFI_STATUS
+UpdateDnsNegativeCache (
+  IN LIST_ENTRY             *NegativeCacheList,
+  IN CHAR16                 *HostName,
+  IN UINT32                 Timeout
+  )
+{
+  LIST_ENTRY                *Entry;
+  DNS_NEGATIVE_CACHE        *Item;
+
+  NET_LIST_FOR_EACH (Entry, NegativeCacheList) {
+    Item = NET_LIST_USER_STRUCT (Entry, DNS_NEGATIVE_CACHE, AllCacheLink);
+    if (StrCmp (HostName, Item->HostName) == 0) {
+      Item->Timeout = Timeout;
+      return EFI_SUCCESS;
+    }
+  }
+
+  Item = AllocatePool (sizeof (DNS_NEGATIVE_CACHE));
+  if (Item == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Item->HostName = AllocateCopyPool (StrSize (HostName), HostName);
+  if (Item->HostName == NULL) {
+    FreePool (Item);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Item->Timeout = Timeout;
+  InsertTailList (NegativeCacheList, &Item->AllCacheLink);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Find out whether the server answered recently that a host name doesn't exist.
+
+  @param  NegativeCacheList  The Dns4 or Dns6 negative cache list.
+  @param  HostName           The host name.
+
+  @retval TRUE               The host name is in the negative cache.
+  @retval FALSE              The host name is not in the negative cache.
+
+**/
+BOOLEAN
+IsDnsNegativeCached (
+  IN LIST_ENTRY             *NegativeCacheList,
+  IN CHAR16                 *HostName
+  )
+{
+  LIST_ENTRY                *Entry;
+  DNS_NEGATIVE_CACHE        *Item;
+
+  NET_LIST_FOR_EACH (Entry, NegativeCacheList) {
+    Item = NET_LIST_USER_STRUCT (Entry, DNS_NEGATIVE_CACHE, AllCacheLink);
+    if (Item->Timeout != 0 && StrCmp (HostName, Item->HostName) == 0) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Skip a domain name in a DNS message.
+
+  @param  Name               The start of the domain name.
+  @param  End                The end of the message.
+
+  @return The first byte after the domain name, or NULL if the name runs past End.
+
+**/
+UINT8 *
+DnsSkipName (
+  IN UINT8                  *Name,
+  IN UINT8                  *End
+  )
+{
+  while (Name < End) {
+    if ((*Name & 0xC0) == 0xC0) {
+      //
+      // A pointer to a name elsewhere in the message ends the name.
+      //
+      return (Name + sizeof (UINT16) <= End) ? Name + sizeof (UINT16) : NULL;
+    }
+
+    if (*Name == 0) {
+      return Name + 1;
+    }
+
+    Name += *Name + 1;
+  }
+
+  return NULL;
+}
+
+/**
+  Get the time a name error can be cached from the SOA record in the
+  authority section of a DNS response, as specified by RFC 2308.
+
+  @param  DnsHeader          The header of the response, in host byte order.
+  @param  Section            The start of the answer section.
+  @param  End                The end of the response.
+  @param  Ttl                Return the time to cache the name error, in seconds.
+
+  @retval TRUE               Ttl is returned.
+  @retval FALSE              The response has no SOA record or is malformed, the
+                             name error can't be cached.
+
+**/
+BOOLEAN
+DnsGetNegativeTtl (
+  IN     DNS_HEADER         *DnsHeader,
+  IN     UINT8              *Section,
+  IN     UINT8              *End,
+     OUT UINT32             *Ttl
+  )
+{
+  UINT32                    Index;
+  DNS_ANSWER_SECTION        Record;
+  UINT16                    DataLength;
+  UINT32                    Minimum;
+
+  //
+  // Skip the CNAME records of the answer section, if any, then look for the
+  // SOA record of the zone in the authority section.
+  //
+  for (Index = 0; Index < (UINT32) DnsHeader->AnswersNum + DnsHeader->AuthorityNum; Index++) {
+    Section = DnsSkipName (Section, End);
+    if ((Section == NULL) || (Section + sizeof (DNS_ANSWER_SECTION) > End)) {
+      return FALSE;
+    }
+
+    CopyMem (&Record, Section, sizeof (DNS_ANSWER_SECTION));
+    Section   += sizeof (DNS_ANSWER_SECTION);
+    DataLength = NTOHS (Record.DataLength);
+    if (Section + DataLength > End) {
+      return FALSE;
+    }
+
+    if ((Index >= DnsHeader->AnswersNum) && (NTOHS (Record.Type) == DNS_TYPE_SOA) &&
+        (DataLength > sizeof (UINT32))) {
+      //
+      // The negative TTL is the smaller of the TTL of the SOA record and its
+      // MINIMUM field, which ends the record.
+      //
+      CopyMem (&Minimum, Section + DataLength - sizeof (UINT32), sizeof (UINT32));
+      *Ttl = MIN (NTOHL (Record.Ttl), NTOHL (Minimum));
+      *Ttl = MIN (*Ttl, DNS_NEGATIVE_CACHE_MAX_TTL);
+
+      return (BOOLEAN) (*Ttl != 0);
+    }
+
+    Section += DataLength;
+  }
+
+  return FALSE;
+}
+
+/**
+  Find out whether a child of the Dns4 service already queries the same
+  host name from the same server.
+
+  @param  Instance           The DNS instance about to send the query.
+  @param  HostName           The host name to query.
+
+  @retval TRUE               A query for the host name is pending.
+  @retval FALSE              No query for the host name is pending.
+
+**/
+BOOLEAN
+Dns4IsQueryPending (
+  IN DNS_INSTANCE           *Instance,
+  IN CHAR16                 *HostName
+  )
+{
+  LIST_ENTRY                *Entry;
+  LIST_ENTRY                *EntryNetMap;
+  DNS_INSTANCE              *Child;
+  NET_MAP_ITEM              *ItemNetMap;
+  DNS4_TOKEN_ENTRY          *TokenEntry;
+
+  NET_LIST_FOR_EACH (Entry, &Instance->Service->Dns4ChildrenList) {
+    Child = NET_LIST_USER_STRUCT (Entry, DNS_INSTANCE, Link);
+    if (!EFI_IP4_EQUAL (&Child->SessionDnsServer.v4, &Instance->SessionDnsServer.v4)) {
+      continue;
+    }
+
+    NET_LIST_FOR_EACH (EntryNetMap, &Child->Dns4TxTokens.Used) {
+      ItemNetMap = NET_LIST_USER_STRUCT (EntryNetMap, NET_MAP_ITEM, Link);
+      TokenEntry = (DNS4_TOKEN_ENTRY *) ItemNetMap->Key;
+      if (!TokenEntry->GeneralLookUp && !TokenEntry->Coalesced &&
+          (TokenEntry->QueryHostName != NULL) && (StrCmp (TokenEntry->QueryHostName, HostName) == 0)) {
+        return TRUE;
+      }
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Find out whether a child of the Dns6 service already queries the same
+  host name from the same server.
+
+  @param  Instance           The DNS instance about to send the query.
+  @param  HostName           The host name to query.
+
+  @retval TRUE               A query for the host name is pending.
+  @retval FALSE              No query for the host name is pending.
+
+**/
+BOOLEAN
+Dns6IsQueryPending (
+  IN DNS_INSTANCE           *Instance,
+  IN CHAR16                 *HostName
+  )
+{
+  LIST_ENTRY                *Entry;
+  LIST_ENTRY                *EntryNetMap;
+  DNS_INSTANCE              *Child;
+  NET_MAP_ITEM              *ItemNetMap;
+  DNS6_TOKEN_ENTRY          *TokenEntry;
+
+  NET_LIST_FOR_EACH (Entry, &Instance->Service->Dns6ChildrenList) {
+    Child = NET_LIST_USER_STRUCT (Entry, DNS_INSTANCE, Link);
+    if (!EFI_IP6_EQUAL (&Child->SessionDnsServer.v6, &Instance->SessionDnsServer.v6)) {
+      continue;
+    }
+
+    NET_LIST_FOR_EACH (EntryNetMap, &Child->Dns6TxTokens.Used) {
+      ItemNetMap = NET_LIST_USER_STRUCT (EntryNetMap, NET_MAP_ITEM, Link);
+      TokenEntry = (DNS6_TOKEN_ENTRY *) ItemNetMap->Key;
+      if (!TokenEntry->GeneralLookUp && !TokenEntry->Coalesced &&
+          (TokenEntry->QueryHostName != NULL) && (StrCmp (TokenEntry->QueryHostName, HostName) == 0)) {
+        return TRUE;
+      }
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Complete the Dns4 tokens waiting for the answer to the same query as
+  TokenEntry, with the answer of TokenEntry.
+
+  @param  Instance           The DNS instance which received the answer.
+  @param  TokenEntry         The token entry of the query which was answered.
+  @param  Status             The status of the answer. Only EFI_SUCCESS and
+                             EFI_NOT_FOUND are shared, the waiting tokens send
+                             their own queries on other errors.
+
+**/
+VOID
+Dns4CompleteCoalescedTokens (
+  IN DNS_INSTANCE           *Instance,
+  IN DNS4_TOKEN_ENTRY       *TokenEntry,
+  IN EFI_STATUS             Status
+  )
+{
+  LIST_ENTRY                *Entry;
+  LIST_ENTRY                *Next;
+  LIST_ENTRY                *EntryNetMap;
+  DNS_INSTANCE              *Child;
+  NET_MAP_ITEM              *ItemNetMap;
+  DNS4_TOKEN_ENTRY          *Waiting;
+  DNS_HOST_TO_ADDR_DATA     *H2AData;
+  NET_BUF                   *Packet;
+
+  if ((Status != EFI_SUCCESS) && (Status != EFI_NOT_FOUND)) {
+    return;
+  }
+
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, &Instance->Service->Dns4ChildrenList) {
+    Child = NET_LIST_USER_STRUCT (Entry, DNS_INSTANCE, Link);
+    if (!EFI_IP4_EQUAL (&Child->SessionDnsServer.v4, &Instance->SessionDnsServer.v4)) {
+      continue;
+    }
+
+    EntryNetMap = Child->Dns4TxTokens.Used.ForwardLink;
+    while (EntryNetMap != &Child->Dns4TxTokens.Used) {
+      ItemNetMap = NET_LIST_USER_STRUCT (EntryNetMap, NET_MAP_ITEM, Link);
+      Waiting    = (DNS4_TOKEN_ENTRY *) ItemNetMap->Key;
+      EntryNetMap = EntryNetMap->ForwardLink;
+
+      if (!Waiting->Coalesced || (StrCmp (Waiting->QueryHostName, TokenEntry->QueryHostName) != 0)) {
+        continue;
+      }
+
+      if (Status == EFI_SUCCESS) {
+        H2AData = AllocatePool (sizeof (DNS_HOST_TO_ADDR_DATA));
+        if (H2AData == NULL) {
+          continue;
+        }
+
+        H2AData->IpCount = TokenEntry->Token->RspData.H2AData->IpCount;
+        H2AData->IpList  = AllocateCopyPool (
+                             H2AData->IpCount * sizeof (EFI_IPv4_ADDRESS),
+                             TokenEntry->Token->RspData.H2AData->IpList
+                             );
+        if (H2AData->IpList == NULL) {
+          FreePool (H2AData);
+          continue;
+        }
+
+        Waiting->Token->RspData.H2AData = H2AData;
+      }
+
+      //
+      // The query of the waiting token was never sent, just free it.
+      //
+      Packet = (NET_BUF *) ItemNetMap->Value;
+      Dns4RemoveTokenEntry (&Child->Dns4TxTokens, Waiting);
+      NetbufFree (Packet);
+
+      Waiting->Token->Status = Status;
+      gBS->SignalEvent (Waiting->Token->Event);
+      DispatchDpc ();
+
+      FreePool (Waiting->QueryHostName);
+      FreePool (Waiting);
+
+      //
+      // The token map may have changed while the event was signaled.
+      //
+      EntryNetMap = Child->Dns4TxTokens.Used.ForwardLink;
+    }
+  }
+}
+
+/**
+  Complete the Dns6 tokens waiting for the answer to the same query as
+  TokenEntry, with the answer of TokenEntry.
+
+  @param  Instance           The DNS instance which received the answer.
+  @param  TokenEntry         The token entry of the query which was answered.
+  @param  Status             The status of the answer. Only EFI_SUCCESS and
+                             EFI_NOT_FOUND are shared, the waiting tokens send
+                             their own queries on other errors.
+
+**/
+VOID
+Dns6CompleteCoalescedTokens (
+  IN DNS_INSTANCE           *Instance,
+  IN DNS6_TOKEN_ENTRY       *TokenEntry,
+  IN EFI_STATUS             Status
+  )
+{
+  LIST_ENTRY                *Entry;
+  LIST_ENTRY                *Next;
+  LIST_ENTRY                *EntryNetMap;
+  DNS_INSTANCE              *Child;
+  NET_MAP_ITEM              *ItemNetMap;
+  DNS6_TOKEN_ENTRY          *Waiting;
+  DNS6_HOST_TO_ADDR_DATA    *H2AData;
+  NET_BUF                   *Packet;
+
+  if ((Status != EFI_SUCCESS) && (Status != EFI_NOT_FOUND)) {
+    return;
+  }
+
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, &Instance->Service->Dns6ChildrenList) {
+    Child = NET_LIST_USER_STRUCT (Entry, DNS_INSTANCE, Link);
+    if (!EFI_IP6_EQUAL (&Child->SessionDnsServer.v6, &Instance->SessionDnsServer.v6)) {
+      continue;
+    }
+
+    EntryNetMap = Child->Dns6TxTokens.Used.ForwardLink;
+    while (EntryNetMap != &Child->Dns6TxTokens.Used) {
+      ItemNetMap = NET_LIST_USER_STRUCT (EntryNetMap, NET_MAP_ITEM, Link);
+      Waiting    = (DNS6_TOKEN_ENTRY *) ItemNetMap->Key;
+      EntryNetMap = EntryNetMap->ForwardLink;
+
+      if (!Waiting->Coalesced || (StrCmp (Waiting->QueryHostName, TokenEntry->QueryHostName) != 0)) {
+        continue;
+      }
+
+      if (Status == EFI_SUCCESS) {
+        H2AData = AllocatePool (sizeof (DNS6_HOST_TO_ADDR_DATA));
+        if (H2AData == NULL) {
+          continue;
+        }
+
+        H2AData->IpCount = TokenEntry->Token->RspData.H2AData->IpCount;
+        H2AData->IpList  = AllocateCopyPool (
+                             H2AData->IpCount * sizeof (EFI_IPv6_ADDRESS),
+                             TokenEntry->Token->RspData.H2AData->IpList
+                             );
+        if (H2AData->IpList == NULL) {
+          FreePool (H2AData);
+          continue;
+        }
+
+        Waiting->Token->RspData.H2AData = H2AData;
+      }
+
+      //
+      // The query of the waiting token was never sent, just free it.
+      //
+      Packet = (NET_BUF *) ItemNetMap->Value;
+      Dns6RemoveTokenEntry (&Child->Dns6TxTokens, Waiting);
+      NetbufFree (Packet);
+
+      Waiting->Token->Status = Status;
+      gBS->SignalEvent (Waiting->Token->Event);
+      DispatchDpc ();
+
+      FreePool (Waiting->QueryHostName);
+      FreePool (Waiting);
+
+      //
+      // The token map may have changed while the event was signaled.
+      //
+      EntryNetMap = Child->Dns6TxTokens.Used.ForwardLink;
+    }
+  }
+}
+
 /**
   Add Dns4 ServerIp to common list of addresses of all configured DNSv4 server. 
 
@@ -1114,6 +1702,7 @@ IsValidDnsResponse (
 
   @param  Instance              The DNS instance
   @param  RxString              Received buffer.
+  @param  Length                The length of the received buffer.
   @param  Completed             Flag to indicate that Dns response is valid. 
   
   @retval EFI_SUCCESS           Parse Dns Response successfully.
@@ -1124,6 +1713,7 @@ EFI_STATUS
 ParseDnsResponse (
   IN OUT DNS_INSTANCE              *Instance,
   IN     UINT8                     *RxString,
+  IN     UINT32                    Length,
      OUT BOOLEAN                   *Completed
   )
 {
@@ -1154,6 +1744,8 @@ ParseDnsResponse (
   DNS_RESOURCE_RECORD   *Dns4RR;
   DNS6_RESOURCE_RECORD  *Dns6RR;
 
+  UINT32                NegativeTtl;
+
   EFI_STATUS            Status;
 
   EFI_TPL               OldTpl;
@@ -1253,6 +1845,20 @@ ParseDnsResponse (
     //
     if (DnsHeader->Flags.Bits.RCode == DNS_FLAGS_RCODE_NAME_ERROR) {
       Status = EFI_NOT_FOUND; 
+
+      //
+      // Remember the name error for the time allowed by the SOA record of the
+      // zone (RFC 2308), so that the next lookups fail without a query.
+      //
+      if (DnsGetNegativeTtl (DnsHeader, (UINT8 *) AnswerName, RxString + Length, &NegativeTtl)) {
+        if ((Dns4TokenEntry != NULL) && !Dns4TokenEntry->GeneralLookUp &&
+            (Dns4TokenEntry->QueryHostName != NULL) && Instance->Dns4CfgData.EnableDnsCache) {
+          UpdateDnsNegativeCache (&mDriverData->Dns4NegativeCacheList, Dns4TokenEntry->QueryHostName, NegativeTtl);
+        } else if ((Dns6TokenEntry != NULL) && !Dns6TokenEntry->GeneralLookUp &&
+                   (Dns6TokenEntry->QueryHostName != NULL) && Instance->Dns6CfgData.EnableDnsCache) {
+          UpdateDnsNegativeCache (&mDriverData->Dns6NegativeCacheList, Dns6TokenEntry->QueryHostName, NegativeTtl);
+        }
+      }
     } else {
       Status = EFI_DEVICE_ERROR;
     }
@@ -1465,7 +2071,12 @@ ParseDnsResponse (
           Dns4CacheEntry->Timeout = MAX (CNameTtl, AnswerSection->Ttl);
         }
         
-        UpdateDns4Cache (&mDriverData->Dns4CacheList, FALSE, TRUE, *Dns4CacheEntry);
+        //
+        // A record with a zero TTL must not be cached.
+        //
+        if (Dns4CacheEntry->Timeout != 0) {
+          UpdateDns4Cache (&mDriverData->Dns4CacheList, FALSE, TRUE, *Dns4CacheEntry);
+        }
 
         // 
         // Free allocated CacheEntry pool.
@@ -1524,7 +2135,12 @@ ParseDnsResponse (
           Dns6CacheEntry->Timeout = MAX (CNameTtl, AnswerSection->Ttl);
         }
         
-        UpdateDns6Cache (&mDriverData->Dns6CacheList, FALSE, TRUE, *Dns6CacheEntry);
+        //
+        // A record with a zero TTL must not be cached.
+        //
+        if (Dns6CacheEntry->Timeout != 0) {
+          UpdateDns6Cache (&mDriverData->Dns6CacheList, FALSE, TRUE, *Dns6CacheEntry);
+        }
 
         // 
         // Free allocated CacheEntry pool.
@@ -1602,6 +2218,9 @@ ON_COMPLETE:
     ASSERT (Dns4TokenEntry != NULL);
     Dns4RemoveTokenEntry (&Instance->Dns4TxTokens, Dns4TokenEntry);
     Dns4TokenEntry->Token->Status = Status;
+    if (!Dns4TokenEntry->GeneralLookUp && (Dns4TokenEntry->QueryHostName != NULL)) {
+      Dns4CompleteCoalescedTokens (Instance, Dns4TokenEntry, Status);
+    }
     if (Dns4TokenEntry->Token->Event != NULL) {
       gBS->SignalEvent (Dns4TokenEntry->Token->Event);
       DispatchDpc ();
@@ -1610,6 +2229,9 @@ ON_COMPLETE:
     ASSERT (Dns6TokenEntry != NULL);
     Dns6RemoveTokenEntry (&Instance->Dns6TxTokens, Dns6TokenEntry);
     Dns6TokenEntry->Token->Status = Status;
+    if (!Dns6TokenEntry->GeneralLookUp && (Dns6TokenEntry->QueryHostName != NULL)) {
+      Dns6CompleteCoalescedTokens (Instance, Dns6TokenEntry, Status);
+    }
     if (Dns6TokenEntry->Token->Event != NULL) {
       gBS->SignalEvent (Dns6TokenEntry->Token->Event);
       DispatchDpc ();
@@ -1758,7 +2380,7 @@ DnsOnPacketReceived (
   //
   // Parse Dns Response
   //
-  ParseDnsResponse (Instance, RcvString, &Completed);
+  ParseDnsResponse (Instance, RcvString, Packet->TotalSize, &Completed);
 
 ON_EXIT:
 
@@ -2049,6 +2671,18 @@ DnsOnTimerRetransmit (
           continue;
         }
 
+        //
+        // The query waiting for the answer to the same query of another token
+        // didn't get it in time, send it now.
+        //
+        if (Dns4TokenEntry->Coalesced) {
+          Dns4TokenEntry->Coalesced    = FALSE;
+          Dns4TokenEntry->PacketToLive = Dns4TokenEntry->Token->RetryInterval;
+          DoDnsQuery (Instance, (NET_BUF *) ItemNetMap->Value);
+          EntryNetMap = EntryNetMap->ForwardLink;
+          continue;
+        }
+
         //
         // Retransmit the packet if haven't reach the maxmium retry count,
         // otherwise exit the transfer.
@@ -2093,6 +2727,18 @@ DnsOnTimerRetransmit (
           continue;
         }
 
+        //
+        // The query waiting for the answer to the same query of another token
+        // didn't get it in time, send it now.
+        //
+        if (Dns6TokenEntry->Coalesced) {
+          Dns6TokenEntry->Coalesced    = FALSE;
+          Dns6TokenEntry->PacketToLive = Dns6TokenEntry->Token->RetryInterval;
+          DoDnsQuery (Instance, (NET_BUF *) ItemNetMap->Value);
+          EntryNetMap = EntryNetMap->ForwardLink;
+          continue;
+        }
+
         //
         // Retransmit the packet if haven't reach the maxmium retry count,
         // otherwise exit the transfer.
@@ -2141,6 +2787,9 @@ DnsOnTimerUpdate (
   LIST_ENTRY                 *Next;
   DNS4_CACHE                 *Item4;
   DNS6_CACHE                 *Item6;
+  DNS_NEGATIVE_CACHE         *NegativeItem;
+  LIST_ENTRY                 *NegativeCacheList[2];
+  UINTN                      Index;
 
   Item4 = NULL;
   Item6 = NULL;
@@ -2150,7 +2799,9 @@ DnsOnTimerUpdate (
   //
   NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns4CacheList) {
     Item4 = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
-    Item4->DnsCache.Timeout--;
+    if (Item4->DnsCache.Timeout != 0) {
+      Item4->DnsCache.Timeout--;
+    }
   }
   
   Entry = mDriverData->Dns4CacheList.ForwardLink;
@@ -2158,6 +2809,7 @@ DnsOnTimerUpdate (
     Item4 = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
     if (Item4->DnsCache.Timeout == 0) {
       RemoveEntryList (&Item4->AllCacheLink);
+      RemoveEntryList (&Item4->HashLink);
       FreePool (Item4->DnsCache.HostName);
       FreePool (Item4->DnsCache.IpAddress);
       FreePool (Item4);
@@ -2172,7 +2824,9 @@ DnsOnTimerUpdate (
   //
   NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns6CacheList) {
     Item6 = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
-    Item6->DnsCache.Timeout--;
+    if (Item6->DnsCache.Timeout != 0) {
+      Item6->DnsCache.Timeout--;
+    }
   }
   
   Entry = mDriverData->Dns6CacheList.ForwardLink;
@@ -2180,6 +2834,7 @@ DnsOnTimerUpdate (
     Item6 = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
     if (Item6->DnsCache.Timeout == 0) {
       RemoveEntryList (&Item6->AllCacheLink);
+      RemoveEntryList (&Item6->HashLink);
       FreePool (Item6->DnsCache.HostName);
       FreePool (Item6->DnsCache.IpAddress);
       FreePool (Item6);
@@ -2188,5 +2843,25 @@ DnsOnTimerUpdate (
       Entry = Entry->ForwardLink;
     }
   }
+
+  //
+  // Iterate through the DNS4 and DNS6 negative cache lists.
+  //
+  NegativeCacheList[0] = &mDriverData->Dns4NegativeCacheList;
+  NegativeCacheList[1] = &mDriverData->Dns6NegativeCacheList;
+  for (Index = 0; Index < ARRAY_SIZE (NegativeCacheList); Index++) {
+    NET_LIST_FOR_EACH_SAFE (Entry, Next, NegativeCacheList[Index]) {
+      NegativeItem = NET_LIST_USER_STRUCT (Entry, DNS_NEGATIVE_CACHE, AllCacheLink);
+      if (NegativeItem->Timeout != 0) {
+        NegativeItem->Timeout--;
+      }
+
+      if (NegativeItem->Timeout == 0) {
+        RemoveEntryList (&NegativeItem->AllCacheLink);
+        FreePool (NegativeItem->HostName);
+        FreePool (NegativeItem);
+      }
+    }
+  }
 }
 
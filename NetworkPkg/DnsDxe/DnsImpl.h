@@ -89,20 +89,36 @@ extern EFI_DNS6_PROTOCOL             mDns6Protocol;
 
 #define DNS_TIME_TO_GETMAP       5
 
+//
+// Upper bound of the time a name error is cached, in seconds.
+//
+#define DNS_NEGATIVE_CACHE_MAX_TTL  300
+
 #pragma pack(1)
 
 typedef union _DNS_FLAGS  DNS_FLAGS;
 
 typedef struct {
   LIST_ENTRY             AllCacheLink;
+  LIST_ENTRY             HashLink;
   EFI_DNS4_CACHE_ENTRY   DnsCache;     
 } DNS4_CACHE;
 
 typedef struct {
   LIST_ENTRY             AllCacheLink;
+  LIST_ENTRY             HashLink;
   EFI_DNS6_CACHE_ENTRY   DnsCache;     
 } DNS6_CACHE;
 
+//
+// A host name the server answered doesn't exist (RFC 2308).
+//
+typedef struct {
+  LIST_ENTRY             AllCacheLink;
+  CHAR16                 *HostName;
+  UINT32                 Timeout;
+} DNS_NEGATIVE_CACHE;
+
 typedef struct {
   LIST_ENTRY             AllServerLink;
   EFI_IPv4_ADDRESS       Dns4ServerIp;     
@@ -119,6 +135,7 @@ typedef struct {
   CHAR16                     *QueryHostName;
   EFI_IPv4_ADDRESS           QueryIpAddress;
   BOOLEAN                    GeneralLookUp;
+  BOOLEAN                    Coalesced;
   EFI_DNS4_COMPLETION_TOKEN  *Token;
 } DNS4_TOKEN_ENTRY;
 
@@ -128,6 +145,7 @@ typedef struct {
   CHAR16                     *QueryHostName;
   EFI_IPv6_ADDRESS           QueryIpAddress;
   BOOLEAN                    GeneralLookUp;
+  BOOLEAN                    Coalesced;
   EFI_DNS6_COMPLETION_TOKEN  *Token;
 } DNS6_TOKEN_ENTRY;
 
@@ -522,6 +540,196 @@ UpdateDns6Cache (
   IN EFI_DNS6_CACHE_ENTRY   DnsCacheEntry
   );
 
+/**
+  Get the bucket of a host name in the hash tables of the DNS caches.
+
+  @param  HostName           The host name.
+
+  @return The index of the bucket.
+
+**/
+UINTN
+DnsCacheHash (
+  IN CHAR16                 *HostName
+  );
+
+/**
+  Get the addresses of a host name from the Dns4 cache.
+
+  @param  HostName           The host name.
+  @param  H2AData            Return the addresses. The caller frees H2AData->IpList
+                             and H2AData.
+
+  @retval EFI_SUCCESS        The addresses are returned.
+  @retval EFI_NOT_FOUND      The host name is not in the cache.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the addresses.
+
+**/
+EFI_STATUS
+Dns4LookupCache (
+  IN     CHAR16                 *HostName,
+     OUT DNS_HOST_TO_ADDR_DATA  **H2AData
+  );
+
+/**
+  Get the addresses of a host name from the Dns6 cache.
+
+  @param  HostName           The host name.
+  @param  H2AData            Return the addresses. The caller frees H2AData->IpList
+                             and H2AData.
+
+  @retval EFI_SUCCESS        The addresses are returned.
+  @retval EFI_NOT_FOUND      The host name is not in the cache.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the addresses.
+
+**/
+EFI_STATUS
+Dns6LookupCache (
+  IN     CHAR16                 *HostName,
+     OUT DNS6_HOST_TO_ADDR_DATA **H2AData
+  );
+
+/**
+  Remember that a host name doesn't exist, or update the time it is remembered.
+
+  @param  NegativeCacheList  The Dns4 or Dns6 negative cache list.
+  @param  HostName           The host name the server answered doesn't exist.
+  @param  Timeout            The time to remember it, in seconds.
+
+  @retval EFI_SUCCESS        The negative cache is updated.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the entry.
+
+**/
+EFI_STATUS
+UpdateDnsNegativeCache (
+  IN LIST_ENTRY             *NegativeCacheList,
+  IN CHAR16                 *HostName,
+  IN UINT32                 Timeout
+  );
+
+/**
+  Find out whether the server answered recently that a host name doesn't exist.
+
+  @param  NegativeCacheList  The Dns4 or Dns6 negative cache list.
+  @param  HostName           The host name.
+
+  @retval TRUE               The host name is in the negative cache.
+  @retval FALSE              The host name is not in the negative cache.
+
+**/
+BOOLEAN
+IsDnsNegativeCached (
+  IN LIST_ENTRY             *NegativeCacheList,
+  IN CHAR16                 *HostName
+  );
+
+/**
+  Skip a domain name in a DNS message.
+
+  @param  Name               The start of the domain name.
+  @param  End                The end of the message.
+
+  @return The first byte after the domain name, or NULL if the name runs past End.
+
+**/
+UINT8 *
+DnsSkipName (
+  IN UINT8                  *Name,
+  IN UINT8                  *End
+  );
+
+/**
+  Get the time a name error can be cached from the SOA record in the
+  authority section of a DNS response, as specified by RFC 2308.
+
+  @param  DnsHeader          The header of the response, in host byte order.
+  @param  Section            The start of the answer section.
+  @param  End                The end of the response.
+  @param  Ttl                Return the time to cache the name error, in seconds.
+
+  @retval TRUE               Ttl is returned.
+  @retval FALSE              The response has no SOA record or is malformed, the
+                             name error can't be cached.
+
+**/
+BOOLEAN
+DnsGetNegativeTtl (
+  IN     DNS_HEADER         *DnsHeader,
+  IN     UINT8              *Section,
+  IN     UINT8              *End,
+     OUT UINT32             *Ttl
+  );
+
+/**
+  Find out whether a child of the Dns4 service already queries the same
+  host name from the same server.
+
+  @param  Instance           The DNS instance about to send the query.
+  @param  HostName           The host name to query.
+
+  @retval TRUE               A query for the host name is pending.
+  @retval FALSE              No query for the host name is pending.
+
+**/
+BOOLEAN
+Dns4IsQueryPending (
+  IN DNS_INSTANCE           *Instance,
+  IN CHAR16                 *HostName
+  );
+
+/**
+  Find out whether a child of the Dns6 service already queries the same
+  host name from the same server.
+
+  @param  Instance           The DNS instance about to send the query.
+  @param  HostName           The host name to query.
+
+  @retval TRUE               A query for the host name is pending.
+  @retval FALSE              No query for the host name is pending.
+
+**/
+BOOLEAN
+Dns6IsQueryPending (
+  IN DNS_INSTANCE           *Instance,
+  IN CHAR16                 *HostName
+  );
+
+/**
+  Complete the Dns4 tokens waiting for the answer to the same query as
+  TokenEntry, with the answer of TokenEntry.
+
+  @param  Instance           The DNS instance which received the answer.
+  @param  TokenEntry         The token entry of the query which was answered.
+  @param  Status             The status of the answer. Only EFI_SUCCESS and
+                             EFI_NOT_FOUND are shared, the waiting tokens send
+                             their own queries on other errors.
+
+**/
+VOID
+Dns4CompleteCoalescedTokens (
+  IN DNS_INSTANCE           *Instance,
+  IN DNS4_TOKEN_ENTRY       *TokenEntry,
+  IN EFI_STATUS             Status
+  );
+
+/**
+  Complete the Dns6 tokens waiting for the answer to the same query as
+  TokenEntry, with the answer of TokenEntry.
+
+  @param  Instance           The DNS instance which received the answer.
+  @param  TokenEntry         The token entry of the query which was answered.
+  @param  Status             The status of the answer. Only EFI_SUCCESS and
+                             EFI_NOT_FOUND are shared, the waiting tokens send
+                             their own queries on other errors.
+
+**/
+VOID
+Dns6CompleteCoalescedTokens (
+  IN DNS_INSTANCE           *Instance,
+  IN DNS6_TOKEN_ENTRY       *TokenEntry,
+  IN EFI_STATUS             Status
+  );
+
 /**
   Add Dns4 ServerIp to common list of addresses of all configured DNSv4 server. 
 
@@ -583,6 +791,7 @@ IsValidDnsResponse (
 
   @param  Instance              The DNS instance
   @param  RxString              Received buffer.
+  @param  Length                The length of the received buffer.
   @param  Completed             Flag to indicate that Dns response is valid. 
   
   @retval EFI_SUCCESS           Parse Dns Response successfully.
@@ -593,6 +802,7 @@ EFI_STATUS
 ParseDnsResponse (
   IN OUT DNS_INSTANCE              *Instance,
   IN     UINT8                     *RxString,
+  IN     UINT32                    Length,
      OUT BOOLEAN                   *Completed
   );
 
@@ -344,11 +344,6 @@ Dns4HostNameToIp (
   
   EFI_DNS4_CONFIG_DATA  *ConfigData;
   
-  UINTN                 Index;
-  DNS4_CACHE            *Item;
-  LIST_ENTRY            *Entry;
-  LIST_ENTRY            *Next;
-  
   CHAR8                 *QueryName;
   
   DNS4_TOKEN_ENTRY      *TokenEntry;
@@ -357,7 +352,6 @@ Dns4HostNameToIp (
   EFI_TPL               OldTpl;
   
   Status     = EFI_SUCCESS;
-  Item       = NULL;
   QueryName  = NULL;
   TokenEntry = NULL;
   Packet     = NULL;
@@ -407,51 +401,37 @@ Dns4HostNameToIp (
   // Check cache
   //
   if (ConfigData->EnableDnsCache) {
-    Index = 0;
-    NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns4CacheList) {
-      Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
-      if (StrCmp (HostName, Item->DnsCache.HostName) == 0) {
-        Index++;
+    Status = Dns4LookupCache (HostName, &Token->RspData.H2AData);
+    if (Status == EFI_SUCCESS) {
+      Token->Status = EFI_SUCCESS;
+          
+      if (Token->Event != NULL) {
+        gBS->SignalEvent (Token->Event);
+        DispatchDpc ();
       }
-    }
 
-    if (Index != 0) {
-      Token->RspData.H2AData = AllocatePool (sizeof (DNS_HOST_TO_ADDR_DATA));
-      if (Token->RspData.H2AData == NULL) {
-        Status = EFI_OUT_OF_RESOURCES;
-        goto ON_EXIT;
-      }
+      Status = Token->Status;
+      goto ON_EXIT;
+    } else if (Status != EFI_NOT_FOUND) {
+      goto ON_EXIT;
+    }
 
-      Token->RspData.H2AData->IpCount = (UINT32)Index;
-      Token->RspData.H2AData->IpList = AllocatePool (sizeof (EFI_IPv4_ADDRESS) * Index);
-      if (Token->RspData.H2AData->IpList == NULL) {
-        if (Token->RspData.H2AData != NULL) {
-          FreePool (Token->RspData.H2AData);
-        }
-        
-        Status = EFI_OUT_OF_RESOURCES;
-        goto ON_EXIT;
-      }
+    //
+    // The server answered recently that the host name doesn't exist.
+    //
+    if (IsDnsNegativeCached (&mDriverData->Dns4NegativeCacheList, HostName)) {
+      Token->Status = EFI_NOT_FOUND;
 
-      Index = 0;
-      NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns4CacheList) {
-        Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
-        if ((UINT32)Index < Token->RspData.H2AData->IpCount && StrCmp (HostName, Item->DnsCache.HostName) == 0) {
-          CopyMem ((Token->RspData.H2AData->IpList) + Index, Item->DnsCache.IpAddress, sizeof (EFI_IPv4_ADDRESS));
-          Index++; 
-        }
-      }
-         
-      Token->Status = EFI_SUCCESS;
-          
       if (Token->Event != NULL) {
         gBS->SignalEvent (Token->Event);
         DispatchDpc ();
       }
 
-      Status = Token->Status;
+      Status = EFI_SUCCESS;
       goto ON_EXIT;
-    } 
+    }
+
+    Status = EFI_SUCCESS;
   }
 
   //
@@ -492,6 +472,16 @@ Dns4HostNameToIp (
 
   ASSERT (Packet != NULL);
 
+  //
+  // Another child already queries the host name from the same server, wait
+  // for its answer instead of sending the same query. The query is sent if
+  // the answer doesn't come within the retry interval. Check this before the
+  // token is saved, so that the token doesn't find its own query.
+  //
+  if (ConfigData->EnableDnsCache && Dns4IsQueryPending (Instance, HostName)) {
+    TokenEntry->Coalesced = TRUE;
+  }
+
   //
   // Save the token into the Dns4TxTokens map.
   //
@@ -499,6 +489,10 @@ Dns4HostNameToIp (
   if (EFI_ERROR (Status)) {
     goto ON_EXIT;
   }
+
+  if (TokenEntry->Coalesced) {
+    goto ON_EXIT;
+  }
   
   //
   // Dns Query Ip
@@ -1186,11 +1180,6 @@ Dns6HostNameToIp (
 
   EFI_DNS6_CONFIG_DATA  *ConfigData;
   
-  UINTN                 Index; 
-  DNS6_CACHE            *Item;
-  LIST_ENTRY            *Entry;
-  LIST_ENTRY            *Next;
-  
   CHAR8                 *QueryName;
   
   DNS6_TOKEN_ENTRY      *TokenEntry;
@@ -1199,7 +1188,6 @@ Dns6HostNameToIp (
   EFI_TPL               OldTpl;
   
   Status     = EFI_SUCCESS;
-  Item       = NULL;
   QueryName  = NULL;
   TokenEntry = NULL;
   Packet     = NULL;
@@ -1249,51 +1237,37 @@ Dns6HostNameToIp (
   // Check cache
   //
   if (ConfigData->EnableDnsCache) {
-    Index = 0;
-    NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns6CacheList) {
-      Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
-      if (StrCmp (HostName, Item->DnsCache.HostName) == 0) {
-        Index++;
+    Status = Dns6LookupCache (HostName, &Token->RspData.H2AData);
+    if (Status == EFI_SUCCESS) {
+      Token->Status = EFI_SUCCESS;
+          
+      if (Token->Event != NULL) {
+        gBS->SignalEvent (Token->Event);
+        DispatchDpc ();
       }
-    }
 
-    if (Index != 0) {
-      Token->RspData.H2AData = AllocatePool (sizeof (DNS6_HOST_TO_ADDR_DATA));
-      if (Token->RspData.H2AData == NULL) {
-        Status = EFI_OUT_OF_RESOURCES;
-        goto ON_EXIT;
-      }
+      Status = Token->Status;
+      goto ON_EXIT;
+    } else if (Status != EFI_NOT_FOUND) {
+      goto ON_EXIT;
+    }
 
-      Token->RspData.H2AData->IpCount = (UINT32)Index;
-      Token->RspData.H2AData->IpList = AllocatePool (sizeof (EFI_IPv6_ADDRESS) * Index);
-      if (Token->RspData.H2AData->IpList == NULL) {
-        if (Token->RspData.H2AData != NULL) {
-          FreePool (Token->RspData.H2AData);
-        }
-        
-        Status = EFI_OUT_OF_RESOURCES;
-        goto ON_EXIT;
-      }
+    //
+    // The server answered recently that the host name doesn't exist.
+    //
+    if (IsDnsNegativeCached (&mDriverData->Dns6NegativeCacheList, HostName)) {
+      Token->Status = EFI_NOT_FOUND;
 
-      Index = 0;
-      NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns6CacheList) {
-        Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
-        if ((UINT32)Index < Token->RspData.H2AData->IpCount && StrCmp (HostName, Item->DnsCache.HostName) == 0) {
-          CopyMem ((Token->RspData.H2AData->IpList) + Index, Item->DnsCache.IpAddress, sizeof (EFI_IPv6_ADDRESS));
-          Index++;
-        }
-      }
-         
-      Token->Status = EFI_SUCCESS;
-          
       if (Token->Event != NULL) {
         gBS->SignalEvent (Token->Event);
         DispatchDpc ();
       }
-      
-      Status = Token->Status;
+
+      Status = EFI_SUCCESS;
       goto ON_EXIT;
-    } 
+    }
+
+    Status = EFI_SUCCESS;
   }
 
   //
@@ -1334,6 +1308,16 @@ Dns6HostNameToIp (
 
   ASSERT (Packet != NULL);
 
+  //
+  // Another child already queries the host name from the same server, wait
+  // for its answer instead of sending the same query. The query is sent if
+  // the answer doesn't come within the retry interval. Check this before the
+  // token is saved, so that the token doesn't find its own query.
+  //
+  if (ConfigData->EnableDnsCache && Dns6IsQueryPending (Instance, HostName)) {
+    TokenEntry->Coalesced = TRUE;
+  }
+
   //
   // Save the token into the Dns6TxTokens map.
   //
@@ -1341,6 +1325,10 @@ Dns6HostNameToIp (
   if (EFI_ERROR (Status)) {
     goto ON_EXIT;
   }
+
+  if (TokenEntry->Coalesced) {
+    goto ON_EXIT;
+  }
   
   //
   // Dns Query Ip
@@ -586,25 +586,26 @@ HttpBootHttpIoCallback (
 }
 
 /**
-  Create a HttpIo instance for the file download.
+  Create and configure a HTTP child of the NIC as a HttpIo.
 
   @param[in]    Private        The pointer to the driver's private data.
+  @param[in]    Callback       Callback function invoked for the HTTP messages, or NULL.
+  @param[out]   HttpIo         The HttpIo to create.
 
   @retval EFI_SUCCESS          Successfully created.
   @retval Others               Failed to create HttpIo.
 
 **/
 EFI_STATUS
-HttpBootCreateHttpIo (
-  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+HttpBootOpenHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_IO_CALLBACK             Callback,
+     OUT HTTP_IO                      *HttpIo
   )
 {
   HTTP_IO_CONFIG_DATA          ConfigData;
-  EFI_STATUS                   Status;
   EFI_HANDLE                   ImageHandle;
 
-  ASSERT (Private != NULL);
-
   ZeroMem (&ConfigData, sizeof (HTTP_IO_CONFIG_DATA));
   if (!Private->UsingIpv6) {
     ConfigData.Config4.HttpVersion    = HttpVersion11;
@@ -619,15 +620,36 @@ HttpBootCreateHttpIo (
     ImageHandle = Private->Ip6Nic->ImageHandle;
   }
 
-  Status = HttpIoCreateIo (
-             ImageHandle,
-             Private->Controller,
-             Private->UsingIpv6 ? IP_VERSION_6 : IP_VERSION_4,
-             &ConfigData,
-             HttpBootHttpIoCallback,
-             (VOID *) Private,
-             &Private->HttpIo
-             );
+  return HttpIoCreateIo (
+           ImageHandle,
+           Private->Controller,
+           Private->UsingIpv6 ? IP_VERSION_6 : IP_VERSION_4,
+           &ConfigData,
+           Callback,
+           (VOID *) Private,
+           HttpIo
+           );
+}
+
+/**
+  Create a HttpIo instance for the file download.
+
+  @param[in]    Private        The pointer to the driver's private data.
+
+  @retval EFI_SUCCESS          Successfully created.
+  @retval Others               Failed to create HttpIo.
+
+**/
+EFI_STATUS
+HttpBootCreateHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+  )
+{
+  EFI_STATUS                   Status;
+
+  ASSERT (Private != NULL);
+
+  Status = HttpBootOpenHttpIo (Private, HttpBootHttpIoCallback, &Private->HttpIo);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -865,9 +887,14 @@ HttpBootGetBootFileCallback (
     if (NewEntityData == NULL) {
       return EFI_OUT_OF_RESOURCES;
     }
+    NewEntityData->Block = NULL;
     if (CallbackData->NewBlock) {
+      //
+      // The cache owns the block from now on, but the rest of it is still
+      // filled by the next receives.
+      //
       NewEntityData->Block = CallbackData->Block;
-      CallbackData->Block = NULL;
+      CallbackData->NewBlock = FALSE;
     }
     NewEntityData->DataLength = Length;
     NewEntityData->DataStart  = (UINT8*) Data;
@@ -921,11 +948,16 @@ HttpBootGetBootFile (
   HTTP_BOOT_CALLBACK_DATA    Context;
   UINTN                      ContentLength;
   HTTP_BOOT_CACHE_CONTENT    *Cache;
-  UINT8                      *Block;
   UINTN                      UrlSize;
   CHAR16                     *Url;
   BOOLEAN                    IdentityMode;
   UINTN                      ReceivedSize;
+  UINT8                      *ReceiveBuffer;
+  UINTN                      ReceiveBufferSize;
+  UINTN                      BlockSize;
+  UINTN                      BlockUsed;
+  HTTP_BOOT_ENTITY_DATA      *EntityData;
+  EFI_HTTP_HEADER            *Header;
   
   ASSERT (Private != NULL);
   ASSERT (Private->HttpCreated);
@@ -982,8 +1014,11 @@ HttpBootGetBootFile (
   //       Host
   //       Accept
   //       User-Agent
+  //     and 2 more to revalidate a cached copy of the file:
+  //       If-None-Match
+  //       If-Modified-Since
   //
-  HttpIoHeader = HttpBootCreateHeader (3);
+  HttpIoHeader = HttpBootCreateHeader (5);
   if (HttpIoHeader == NULL) {
     Status = EFI_OUT_OF_RESOURCES;
     goto ERROR_2;
@@ -1035,6 +1070,34 @@ HttpBootGetBootFile (
     goto ERROR_3;
   }
 
+  //
+  // Add HTTP header field 4 and 5: If-None-Match and If-Modified-Since, so that
+  // the server answers 304 Not Modified if the cached copy is still current.
+  //
+  if (HeaderOnly && Private->ImageCacheFound) {
+    if (Private->ImageCacheRecord.Entry.ETag[0] != '\0') {
+      Status = HttpBootSetHeader (
+                 HttpIoHeader,
+                 HTTP_HEADER_IF_NONE_MATCH,
+                 Private->ImageCacheRecord.Entry.ETag
+                 );
+      if (EFI_ERROR (Status)) {
+        goto ERROR_3;
+      }
+    }
+
+    if (Private->ImageCacheRecord.Entry.LastModified[0] != '\0') {
+      Status = HttpBootSetHeader (
+                 HttpIoHeader,
+                 HTTP_HEADER_IF_MODIFIED_SINCE,
+                 Private->ImageCacheRecord.Entry.LastModified
+                 );
+      if (EFI_ERROR (Status)) {
+        goto ERROR_3;
+      }
+    }
+  }
+
   //
   // 2.2 Build the rest of HTTP request info.
   //
@@ -1089,6 +1152,22 @@ HttpBootGetBootFile (
   if (EFI_ERROR (Status) || EFI_ERROR (ResponseData->Status)) {
     if (EFI_ERROR (ResponseData->Status)) {
       StatusCode = HttpIo->RspToken.Message->Data.Response->StatusCode;
+      if (HeaderOnly && Private->ImageCacheFound && (StatusCode == HTTP_STATUS_304_NOT_MODIFIED)) {
+        //
+        // The cached copy of the boot file is still current, report its size
+        // and image type as if the server returned them.
+        //
+        Private->ImageCacheHit = TRUE;
+        *ImageType = (HTTP_BOOT_IMAGE_TYPE) Private->ImageCacheRecord.ImageType;
+        if (*BufferSize < Private->ImageCacheRecord.Entry.Size) {
+          Status = EFI_BUFFER_TOO_SMALL;
+        } else {
+          Status = EFI_SUCCESS;
+        }
+        *BufferSize = (UINTN) Private->ImageCacheRecord.Entry.Size;
+        HttpFreeHeaderFields (ResponseData->Headers, ResponseData->HeaderCount);
+        goto ERROR_5;
+      }
       HttpBootPrintErrorMessage (StatusCode);
       Status = ResponseData->Status;
     }
@@ -1109,6 +1188,31 @@ HttpBootGetBootFile (
     goto ERROR_5;
   }
 
+  //
+  // Record whether the server serves byte ranges of the file, which allows
+  // to download it over several connections.
+  //
+  if (HeaderOnly) {
+    Header = HttpFindHeader (
+               ResponseData->HeaderCount,
+               ResponseData->Headers,
+               HTTP_HEADER_ACCEPT_RANGES
+               );
+    Private->AcceptRanges = (BOOLEAN) ((Header != NULL) &&
+                                       (AsciiStriCmp (Header->FieldValue, "bytes") == 0));
+
+    //
+    // Keep the validators of the file, to store them with the file in
+    // the image cache once it's downloaded.
+    //
+    HttpBootImageCacheGetValidators (
+      ResponseData->HeaderCount,
+      ResponseData->Headers,
+      Private->ETag,
+      Private->LastModified
+      );
+  }
+
   //
   // 3.2 Cache the response header.
   //
@@ -1144,7 +1248,7 @@ HttpBootGetBootFile (
   //
   // 3.4 Continue to receive and parse message-body if needed.
   //
-  Block = NULL;
+  BlockSize = MAX (PcdGet32 (PcdHttpBootReceiveBlockSize), HTTP_BOOT_BLOCK_SIZE);
   if (!HeaderOnly) {
     //
     // 3.4.1, check whether we are in identity transfer-coding.
@@ -1167,10 +1271,36 @@ HttpBootGetBootFile (
       // In identity transfer-coding there is no need to parse the message body,
       // just download the message body to the user provided buffer directly.
       //
+      ReceiveBuffer     = Buffer;
+      ReceiveBufferSize = *BufferSize;
+      if ((Cache != NULL) && (ContentLength != 0)) {
+        //
+        // The caller doesn't provide a buffer, download the message body to a
+        // single cache block of the entity length.
+        //
+        EntityData = AllocatePool (sizeof (HTTP_BOOT_ENTITY_DATA));
+        if (EntityData == NULL) {
+          Status = EFI_OUT_OF_RESOURCES;
+          goto ERROR_6;
+        }
+        EntityData->Block = AllocatePool (ContentLength);
+        if (EntityData->Block == NULL) {
+          FreePool (EntityData);
+          Status = EFI_OUT_OF_RESOURCES;
+          goto ERROR_6;
+        }
+        EntityData->DataStart  = EntityData->Block;
+        EntityData->DataLength = ContentLength;
+        InsertTailList (&Cache->EntityDataList, &EntityData->Link);
+
+        ReceiveBuffer     = EntityData->Block;
+        ReceiveBufferSize = ContentLength;
+      }
+
       ReceivedSize = 0;
       while (ReceivedSize < ContentLength) {
-        ResponseBody.Body       = (CHAR8*) Buffer + ReceivedSize;
-        ResponseBody.BodyLength = *BufferSize - ReceivedSize;
+        ResponseBody.Body       = (CHAR8*) ReceiveBuffer + ReceivedSize;
+        ResponseBody.BodyLength = ReceiveBufferSize - ReceivedSize;
         Status = HttpIoRecvResponse (
                    &Private->HttpIo,
                    FALSE,
@@ -1201,28 +1331,54 @@ HttpBootGetBootFile (
       // In "chunked" transfer-coding mode, so we need to parse the received
       // data to get the real entity content.
       //
-      Block = NULL;
+      BlockUsed = 0;
       while (!HttpIsMessageComplete (Parser)) {
-        //
-        // Allocate a buffer in Block to hold the message-body.
-        // If caller provides a buffer, this Block will be reused in every HttpIoRecvResponse().
-        // Otherwise a buffer, the buffer in Block will be cached and we should allocate a new before
-        // every HttpIoRecvResponse().
-        //
-        if (Block == NULL || Context.BufferSize == 0) {
-          Block = AllocatePool (HTTP_BOOT_BLOCK_SIZE);
-          if (Block == NULL) {
-            Status = EFI_OUT_OF_RESOURCES;
-            goto ERROR_6;
+        if ((Cache == NULL) && (Context.BufferSize - Context.CopyedSize >= BlockSize)) {
+          //
+          // Receive the message-body straight into the caller's buffer. The entity
+          // data is never ahead of the received data, so the parser callback moves
+          // it down over the chunk headers in place.
+          //
+          ResponseBody.Body       = (CHAR8*) Buffer + Context.CopyedSize;
+          ResponseBody.BodyLength = BlockSize;
+        } else if (Cache == NULL) {
+          //
+          // Near the end of the caller's buffer, receive the message-body in Block,
+          // from which the parser callback copies it.
+          //
+          if (Context.Block == NULL) {
+            Context.Block = AllocatePool (BlockSize);
+            if (Context.Block == NULL) {
+              Status = EFI_OUT_OF_RESOURCES;
+              goto ERROR_6;
+            }
+            Context.NewBlock = TRUE;
           }
-          Context.NewBlock = TRUE;
-          Context.Block = Block;
+          ResponseBody.Body       = (CHAR8*) Context.Block;
+          ResponseBody.BodyLength = BlockSize;
         } else {
-          Context.NewBlock = FALSE;
+          //
+          // If the file is cached, fill Block receive after receive, since each of
+          // them may return much less than BlockSize. The parser callback hands
+          // Block over to the cache list with its first entity data, and a new one
+          // is only allocated once Block is nearly full.
+          //
+          if ((Context.Block == NULL) || (BlockSize - BlockUsed < HTTP_BOOT_BLOCK_SIZE)) {
+            if ((Context.Block != NULL) && Context.NewBlock) {
+              FreePool (Context.Block);
+            }
+            Context.Block = AllocatePool (BlockSize);
+            if (Context.Block == NULL) {
+              Status = EFI_OUT_OF_RESOURCES;
+              goto ERROR_6;
+            }
+            Context.NewBlock = TRUE;
+            BlockUsed        = 0;
+          }
+          ResponseBody.Body       = (CHAR8*) Context.Block + BlockUsed;
+          ResponseBody.BodyLength = BlockSize - BlockUsed;
         }
 
-        ResponseBody.Body       = (CHAR8*) Block;
-        ResponseBody.BodyLength = HTTP_BOOT_BLOCK_SIZE;
         Status = HttpIoRecvResponse (
                    &Private->HttpIo,
                    FALSE,
@@ -1234,6 +1390,9 @@ HttpBootGetBootFile (
           }
           goto ERROR_6;
         }
+        if (Cache != NULL) {
+          BlockUsed += ResponseBody.BodyLength;
+        }
 
         //
         // Parse the new received block of the message-body, the block will be saved in cache.
@@ -1265,6 +1424,10 @@ HttpBootGetBootFile (
   }
   *BufferSize = ContentLength;
 
+  if ((Context.Block != NULL) && Context.NewBlock) {
+    FreePool (Context.Block);
+  }
+
   //
   // 4. Save the cache item to driver's cache list and return.
   //
@@ -1283,7 +1446,7 @@ ERROR_6:
   if (Parser != NULL) {
     HttpFreeMsgParser (Parser);
   }
-  if (Context.Block != NULL) {
+  if ((Context.Block != NULL) && Context.NewBlock) {
     FreePool (Context.Block);
   }
   HttpBootFreeCache (Cache);
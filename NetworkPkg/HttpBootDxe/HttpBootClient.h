@@ -18,7 +18,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #define HTTP_BOOT_REQUEST_TIMEOUT            5000      // 5 seconds in uints of millisecond.
 #define HTTP_BOOT_RESPONSE_TIMEOUT           5000      // 5 seconds in uints of millisecond.
-#define HTTP_BOOT_BLOCK_SIZE                 1500
+#define HTTP_BOOT_BLOCK_SIZE                 1500      // The minimum size to receive the message-body in.
 
 
 
@@ -55,7 +55,7 @@ typedef struct {
   // Cache info.
   //
   HTTP_BOOT_CACHE_CONTENT    *Cache;
-  BOOLEAN                    NewBlock;
+  BOOLEAN                    NewBlock;    // TRUE until Block is owned by an entity data of Cache.
   UINT8                      *Block;
 
   //
@@ -82,6 +82,24 @@ HttpBootDiscoverBootInfo (
   IN OUT HTTP_BOOT_PRIVATE_DATA   *Private
   );
 
+/**
+  Create and configure a HTTP child of the NIC as a HttpIo.
+
+  @param[in]    Private        The pointer to the driver's private data.
+  @param[in]    Callback       Callback function invoked for the HTTP messages, or NULL.
+  @param[out]   HttpIo         The HttpIo to create.
+
+  @retval EFI_SUCCESS          Successfully created.
+  @retval Others               Failed to create HttpIo.
+
+**/
+EFI_STATUS
+HttpBootOpenHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_IO_CALLBACK             Callback,
+     OUT HTTP_IO                      *HttpIo
+  );
+
 /**
   Create a HttpIo instance for the file download.
 
@@ -1337,7 +1337,62 @@ HttpBootDxeDriverEntryPoint (
            &gHttpBootDxeComponentName,
            NULL
            );
+    return Status;
   }
-  return Status;
+
+  //
+  // Let the tools list and clear the cached boot files.
+  //
+  if (PcdGet64 (PcdHttpBootImageCacheSize) != 0) {
+    gBS->InstallMultipleProtocolInterfaces (
+           &ImageHandle,
+           &gEdkiiHttpBootImageCacheProtocolGuid,
+           &mHttpBootImageCache,
+           NULL
+           );
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Unload the HttpBoot driver: stop the driver on all the controllers,
+  uninstall the driver bindings and the image cache protocol.
+
+  @param[in]  ImageHandle   The driver's image handle.
+
+  @retval EFI_SUCCESS   The driver was unloaded.
+  @retval other         The driver could not be unloaded.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootDxeUnload (
+  IN EFI_HANDLE  ImageHandle
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *ImageCache;
+
+  Status = NetLibDefaultUnload (ImageHandle);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->HandleProtocol (
+                  ImageHandle,
+                  &gEdkiiHttpBootImageCacheProtocolGuid,
+                  &ImageCache
+                  );
+  if (!EFI_ERROR (Status)) {
+    gBS->UninstallMultipleProtocolInterfaces (
+           ImageHandle,
+           &gEdkiiHttpBootImageCacheProtocolGuid,
+           &mHttpBootImageCache,
+           NULL
+           );
+  }
+
+  return EFI_SUCCESS;
 }
 
@@ -1,7 +1,7 @@
 /** @file
   UEFI HTTP boot driver's private data structure and interfaces declaration.
 
-Copyright (c) 2015 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2015 - 2018, Intel Corporation. All rights reserved.<BR>
 (C) Copyright 2016 Hewlett Packard Enterprise Development LP<BR>
 This program and the accompanying materials are licensed and made available under 
 the terms and conditions of the BSD License that accompanies this distribution.  
@@ -37,6 +37,8 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/HiiLib.h>
 #include <Library/PrintLib.h>
 #include <Library/DpcLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
 
 //
 // UEFI Driver Model Protocols
@@ -59,17 +61,21 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/Ip6Config.h>
 #include <Protocol/RamDisk.h>
 #include <Protocol/AdapterInformation.h>
+#include <Protocol/SimpleFileSystem.h>
 
 //
 // Produced Protocols
 //
 #include <Protocol/LoadFile.h>
 #include <Protocol/HttpBootCallback.h>
+#include <Protocol/HttpBootImageCache.h>
 
 //
 // Consumed Guids
 //
 #include <Guid/HttpBootConfigHii.h>
+#include <Guid/Gpt.h>
+#include <Guid/RamDiskCompressedImage.h>
 
 //
 // Driver Version
@@ -113,6 +119,8 @@ typedef enum  {
 #include "HttpBootImpl.h"
 #include "HttpBootSupport.h"
 #include "HttpBootClient.h"
+#include "HttpBootRange.h"
+#include "HttpBootImageCache.h"
 #include "HttpBootConfig.h"
 
 typedef union {
@@ -214,6 +222,18 @@ struct _HTTP_BOOT_PRIVATE_DATA {
   CHAR8                                     *BootFileUri;
   VOID                                      *BootFileUriParser;
   UINTN                                     BootFileSize;
+  BOOLEAN                                   AcceptRanges;
+
+  //
+  // The persistent cache of boot files: the cached copy of the boot file
+  // found before the HEAD request, whether the server confirmed it's still
+  // current, and the validators of the file downloaded otherwise.
+  //
+  BOOLEAN                                   ImageCacheFound;
+  BOOLEAN                                   ImageCacheHit;
+  HTTP_BOOT_IMAGE_CACHE_RECORD              ImageCacheRecord;
+  CHAR8                                     ETag[EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE];
+  CHAR8                                     LastModified[EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE];
   BOOLEAN                                   NoGateway;
   HTTP_BOOT_IMAGE_TYPE                      ImageType;
 
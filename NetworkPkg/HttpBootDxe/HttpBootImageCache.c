@@ -0,0 +1,779 @@
+/** @file
+  Persistent cache of boot files on the EFI system partition.
+
+  A downloaded boot file is kept with the ETag and Last-Modified validators
+  the server returned for it. On the next boot, the HEAD request for the file
+  carries them in If-None-Match and If-Modified-Since, and when the server
+  answers 304 Not Modified the file is loaded from the local disk instead of
+  being downloaded again.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HttpBootDxe.h"
+
+/**
+  Open the cache directory on the first EFI system partition where it can
+  be opened or created.
+
+  @param[out]  Dir             The cache directory.
+
+  @retval EFI_SUCCESS          The directory was opened.
+  @retval EFI_NOT_FOUND        There is no usable EFI system partition.
+
+**/
+EFI_STATUS
+HttpBootImageCacheOpenDir (
+  OUT EFI_FILE_PROTOCOL                 **Dir
+  )
+{
+  EFI_STATUS                            Status;
+  EFI_HANDLE                            *Handles;
+  UINTN                                 HandleCount;
+  UINTN                                 Index;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL       *FileSystem;
+  EFI_FILE_PROTOCOL                     *Root;
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiPartTypeSystemPartGuid,
+                  NULL,
+                  &HandleCount,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < HandleCount; Index++) {
+    if (EFI_ERROR (gBS->HandleProtocol (Handles[Index], &gEfiSimpleFileSystemProtocolGuid, (VOID **) &FileSystem))) {
+      continue;
+    }
+
+    if (EFI_ERROR (FileSystem->OpenVolume (FileSystem, &Root))) {
+      continue;
+    }
+
+    Status = Root->Open (
+                     Root,
+                     Dir,
+                     HTTP_BOOT_IMAGE_CACHE_DIRECTORY,
+                     EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+                     EFI_FILE_DIRECTORY
+                     );
+    Root->Close (Root);
+    if (!EFI_ERROR (Status)) {
+      break;
+    }
+    Status = EFI_NOT_FOUND;
+  }
+
+  FreePool (Handles);
+  return Status;
+}
+
+/**
+  Read the index of the cache. A missing or invalid index reads as an
+  empty cache.
+
+  @param[in]   Dir             The cache directory.
+  @param[out]  Index           The index, with room for one more record. The caller
+                               frees it with FreePool().
+
+  @retval EFI_SUCCESS          The index was read.
+  @retval EFI_OUT_OF_RESOURCES There are not enough resources to read the index.
+
+**/
+EFI_STATUS
+HttpBootImageCacheReadIndex (
+  IN     EFI_FILE_PROTOCOL              *Dir,
+     OUT HTTP_BOOT_IMAGE_CACHE_INDEX    **Index
+  )
+{
+  EFI_STATUS                            Status;
+  EFI_FILE_PROTOCOL                     *File;
+  HTTP_BOOT_IMAGE_CACHE_INDEX           Header;
+  HTTP_BOOT_IMAGE_CACHE_INDEX           *NewIndex;
+  HTTP_BOOT_IMAGE_CACHE_RECORD          *Record;
+  UINTN                                 Size;
+  UINTN                                 Position;
+  UINT64                                FileSize;
+
+  ZeroMem (&Header, sizeof (Header));
+
+  Status = Dir->Open (Dir, &File, HTTP_BOOT_IMAGE_CACHE_INDEX_NAME, EFI_FILE_MODE_READ, 0);
+  if (EFI_ERROR (Status)) {
+    File = NULL;
+  } else {
+    Size   = HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (0);
+    Status = File->Read (File, &Size, &Header);
+    if (EFI_ERROR (Status) ||
+        (Size != HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (0)) ||
+        (Header.Signature != HTTP_BOOT_IMAGE_CACHE_SIGNATURE) ||
+        (Header.Version != HTTP_BOOT_IMAGE_CACHE_VERSION)) {
+      ZeroMem (&Header, sizeof (Header));
+    }
+
+    //
+    // The index is read from a writable partition, so don't trust its Count
+    // beyond the records the file really holds.
+    //
+    FileSize = 0;
+    if (EFI_ERROR (File->SetPosition (File, MAX_UINT64)) ||
+        EFI_ERROR (File->GetPosition (File, &FileSize)) ||
+        EFI_ERROR (File->SetPosition (File, HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (0))) ||
+        (FileSize < HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (0))) {
+      FileSize = HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (0);
+    }
+    if ((Header.Count > HTTP_BOOT_IMAGE_CACHE_MAX_RECORDS) ||
+        (Header.Count > DivU64x32 (FileSize - HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (0), sizeof (HTTP_BOOT_IMAGE_CACHE_RECORD)))) {
+      DEBUG ((DEBUG_WARN, "HttpBootImageCacheReadIndex: invalid record count %d\n", Header.Count));
+      Header.Count = 0;
+    }
+  }
+
+  NewIndex = AllocateZeroPool (HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (Header.Count + 1));
+  if (NewIndex == NULL) {
+    if (File != NULL) {
+      File->Close (File);
+    }
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CopyMem (NewIndex, &Header, HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (0));
+  NewIndex->Signature = HTTP_BOOT_IMAGE_CACHE_SIGNATURE;
+  NewIndex->Version   = HTTP_BOOT_IMAGE_CACHE_VERSION;
+
+  if (File != NULL) {
+    Size   = NewIndex->Count * sizeof (HTTP_BOOT_IMAGE_CACHE_RECORD);
+    Status = File->Read (File, &Size, NewIndex->Records);
+    if (EFI_ERROR (Status) || (Size != NewIndex->Count * sizeof (HTTP_BOOT_IMAGE_CACHE_RECORD))) {
+      NewIndex->Count = 0;
+    }
+    File->Close (File);
+  }
+
+  for (Position = 0; Position < NewIndex->Count; Position++) {
+    Record = &NewIndex->Records[Position];
+    Record->Entry.Uri[EDKII_HTTP_BOOT_IMAGE_CACHE_URI_SIZE - 1]                = '\0';
+    Record->Entry.ETag[EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE - 1]         = '\0';
+    Record->Entry.LastModified[EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE - 1] = '\0';
+  }
+
+  *Index = NewIndex;
+  return EFI_SUCCESS;
+}
+
+/**
+  Write the index of the cache.
+
+  @param[in]  Dir              The cache directory.
+  @param[in]  Index            The index.
+
+  @retval EFI_SUCCESS          The index was written.
+  @retval Others               The index couldn't be written.
+
+**/
+EFI_STATUS
+HttpBootImageCacheWriteIndex (
+  IN     EFI_FILE_PROTOCOL              *Dir,
+  IN     HTTP_BOOT_IMAGE_CACHE_INDEX    *Index
+  )
+{
+  EFI_STATUS                            Status;
+  EFI_FILE_PROTOCOL                     *File;
+  UINTN                                 Size;
+
+  //
+  // Delete the old index first, so that a shorter index isn't followed
+  // by the end of the old one.
+  //
+  Status = Dir->Open (Dir, &File, HTTP_BOOT_IMAGE_CACHE_INDEX_NAME, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0);
+  if (!EFI_ERROR (Status)) {
+    File->Delete (File);
+  }
+
+  Status = Dir->Open (
+                  Dir,
+                  &File,
+                  HTTP_BOOT_IMAGE_CACHE_INDEX_NAME,
+                  EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+                  0
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Size   = HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE (Index->Count);
+  Status = File->Write (File, &Size, Index);
+  File->Close (File);
+
+  return Status;
+}
+
+/**
+  Open the content file of a cache record.
+
+  @param[in]   Dir             The cache directory.
+  @param[in]   Id              The Id of the record.
+  @param[in]   OpenMode        The mode to open the file with.
+  @param[out]  File            The content file.
+
+  @return The status of the EFI_FILE_PROTOCOL.Open().
+
+**/
+EFI_STATUS
+HttpBootImageCacheOpenFile (
+  IN     EFI_FILE_PROTOCOL              *Dir,
+  IN     UINT32                         Id,
+  IN     UINT64                         OpenMode,
+     OUT EFI_FILE_PROTOCOL              **File
+  )
+{
+  CHAR16                                FileName[HTTP_BOOT_IMAGE_CACHE_FILE_NAME_SIZE];
+
+  UnicodeSPrint (FileName, sizeof (FileName), L"%08X.img", Id);
+  return Dir->Open (Dir, File, FileName, OpenMode, 0);
+}
+
+/**
+  Find a boot file in the index of the cache.
+
+  @param[in]  Index            The index.
+  @param[in]  Uri              The URI of the boot file.
+
+  @return The position of the file's record in the index, or Index->Count if
+          the file is not in the cache.
+
+**/
+UINTN
+HttpBootImageCacheFind (
+  IN     HTTP_BOOT_IMAGE_CACHE_INDEX    *Index,
+  IN     CHAR8                          *Uri
+  )
+{
+  UINTN                                 Position;
+
+  for (Position = 0; Position < Index->Count; Position++) {
+    if (AsciiStrCmp (Index->Records[Position].Entry.Uri, Uri) == 0) {
+      break;
+    }
+  }
+
+  return Position;
+}
+
+/**
+  Remove a record and its content file from the cache. The caller writes
+  the index.
+
+  @param[in]       Dir         The cache directory.
+  @param[in, out]  Index       The index.
+  @param[in]       Position    The position of the record in the index.
+
+**/
+VOID
+HttpBootImageCacheDelete (
+  IN     EFI_FILE_PROTOCOL              *Dir,
+  IN OUT HTTP_BOOT_IMAGE_CACHE_INDEX    *Index,
+  IN     UINTN                          Position
+  )
+{
+  EFI_FILE_PROTOCOL                     *File;
+
+  if (!EFI_ERROR (HttpBootImageCacheOpenFile (Dir, Index->Records[Position].Id, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, &File))) {
+    File->Delete (File);
+  }
+
+  Index->Count--;
+  CopyMem (
+    &Index->Records[Position],
+    &Index->Records[Position + 1],
+    (Index->Count - Position) * sizeof (HTTP_BOOT_IMAGE_CACHE_RECORD)
+    );
+}
+
+/**
+  Check whether a boot file may be kept in the cache.
+
+  The cached copy is only checked against a CRC32 kept next to it on the EFI
+  system partition, which anybody who can write the partition can forge. That
+  is no weaker than a plain HTTP download, but it would bypass the server
+  authentication of HTTPS, so files downloaded over HTTPS are never cached.
+
+  @param[in]  Uri              The URI of the boot file, with a lower case scheme.
+
+  @retval TRUE                 The file may be cached.
+  @retval FALSE                The file must always be downloaded.
+
+**/
+BOOLEAN
+HttpBootImageCacheIsCacheable (
+  IN     CHAR8                          *Uri
+  )
+{
+  return (BOOLEAN) (AsciiStrnCmp (Uri, "http://", 7) == 0);
+}
+
+/**
+  Look up a boot file in the cache.
+
+  @param[in]   Uri             The URI of the boot file.
+  @param[out]  Record          The record of the cached file.
+
+  @retval EFI_SUCCESS          The file is in the cache.
+  @retval EFI_NOT_FOUND        The file is not in the cache, or the cache is not available.
+
+**/
+EFI_STATUS
+HttpBootImageCacheLookup (
+  IN     CHAR8                          *Uri,
+     OUT HTTP_BOOT_IMAGE_CACHE_RECORD   *Record
+  )
+{
+  EFI_STATUS                            Status;
+  EFI_FILE_PROTOCOL                     *Dir;
+  HTTP_BOOT_IMAGE_CACHE_INDEX           *Index;
+  UINTN                                 Position;
+
+  if (!HttpBootImageCacheIsCacheable (Uri)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = HttpBootImageCacheOpenDir (&Dir);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = HttpBootImageCacheReadIndex (Dir, &Index);
+  Dir->Close (Dir);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Position = HttpBootImageCacheFind (Index, Uri);
+  if (Position < Index->Count) {
+    CopyMem (Record, &Index->Records[Position], sizeof (HTTP_BOOT_IMAGE_CACHE_RECORD));
+    Status = EFI_SUCCESS;
+  } else {
+    Status = EFI_NOT_FOUND;
+  }
+
+  FreePool (Index);
+  return Status;
+}
+
+/**
+  Load a boot file from the cache, and check it against its CRC32.
+  A file which fails the check is removed from the cache.
+
+  @param[in]       Uri             The URI of the boot file.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_NOT_FOUND            The file is not in the cache.
+  @retval EFI_BUFFER_TOO_SMALL     The BufferSize is too small for the file.
+  @retval EFI_CRC_ERROR            The cached file is corrupted.
+  @retval Others                   The cached file couldn't be read.
+
+**/
+EFI_STATUS
+HttpBootImageCacheRead (
+  IN     CHAR8                          *Uri,
+  IN OUT UINTN                          *BufferSize,
+     OUT UINT8                          *Buffer
+  )
+{
+  EFI_STATUS                            Status;
+  EFI_FILE_PROTOCOL                     *Dir;
+  EFI_FILE_PROTOCOL                     *File;
+  HTTP_BOOT_IMAGE_CACHE_INDEX           *Index;
+  HTTP_BOOT_IMAGE_CACHE_RECORD          *Record;
+  UINTN                                 Position;
+  UINTN                                 Size;
+  UINT32                                Crc32;
+
+  Status = HttpBootImageCacheOpenDir (&Dir);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = HttpBootImageCacheReadIndex (Dir, &Index);
+  if (EFI_ERROR (Status)) {
+    Dir->Close (Dir);
+    return Status;
+  }
+
+  Position = HttpBootImageCacheFind (Index, Uri);
+  if (Position == Index->Count) {
+    Status = EFI_NOT_FOUND;
+    goto ON_EXIT;
+  }
+  Record = &Index->Records[Position];
+
+  if (*BufferSize < Record->Entry.Size) {
+    *BufferSize = (UINTN) Record->Entry.Size;
+    Status = EFI_BUFFER_TOO_SMALL;
+    goto ON_EXIT;
+  }
+
+  Status = HttpBootImageCacheOpenFile (Dir, Record->Id, EFI_FILE_MODE_READ, &File);
+  if (!EFI_ERROR (Status)) {
+    Size   = (UINTN) Record->Entry.Size;
+    Status = File->Read (File, &Size, Buffer);
+    File->Close (File);
+    if (!EFI_ERROR (Status) && (Size != Record->Entry.Size)) {
+      Status = EFI_CRC_ERROR;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Crc32 = 0;
+    gBS->CalculateCrc32 (Buffer, Size, &Crc32);
+    if (Crc32 != Record->Entry.Crc32) {
+      Status = EFI_CRC_ERROR;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    //
+    // Drop a cached file which can't be read back as it was stored,
+    // the caller downloads it again.
+    //
+    DEBUG ((DEBUG_WARN, "HttpBootImageCacheRead: %a: %r\n", Uri, Status));
+    HttpBootImageCacheDelete (Dir, Index, Position);
+    HttpBootImageCacheWriteIndex (Dir, Index);
+    goto ON_EXIT;
+  }
+
+  *BufferSize = Size;
+
+  Record->Entry.Hits++;
+  Record->Entry.LastUsed = ++Index->UseCounter;
+  HttpBootImageCacheWriteIndex (Dir, Index);
+
+ON_EXIT:
+  FreePool (Index);
+  Dir->Close (Dir);
+  return Status;
+}
+
+/**
+  Store a downloaded boot file in the cache, evicting the least recently used
+  files to stay within PcdHttpBootImageCacheSize.
+
+  @param[in]  Uri              The URI of the boot file.
+  @param[in]  ETag             The ETag returned by the server, or an empty string.
+  @param[in]  LastModified     The Last-Modified date returned by the server, or an empty string.
+  @param[in]  ImageType        The image type of the boot file.
+  @param[in]  Buffer           The content of the boot file.
+  @param[in]  BufferSize       The size of the boot file in bytes.
+
+  @retval EFI_SUCCESS          The file was stored.
+  @retval EFI_UNSUPPORTED      The file can't be revalidated, was downloaded over HTTPS,
+                               or its URI or validators are too long.
+  @retval EFI_OUT_OF_RESOURCES The file is larger than the cache.
+  @retval Others               The file couldn't be written.
+
+**/
+EFI_STATUS
+HttpBootImageCacheStore (
+  IN     CHAR8                          *Uri,
+  IN     CHAR8                          *ETag,
+  IN     CHAR8                          *LastModified,
+  IN     HTTP_BOOT_IMAGE_TYPE           ImageType,
+  IN     UINT8                          *Buffer,
+  IN     UINTN                          BufferSize
+  )
+{
+  EFI_STATUS                            Status;
+  EFI_FILE_PROTOCOL                     *Dir;
+  EFI_FILE_PROTOCOL                     *File;
+  HTTP_BOOT_IMAGE_CACHE_INDEX           *Index;
+  HTTP_BOOT_IMAGE_CACHE_RECORD          *Record;
+  UINTN                                 Position;
+  UINTN                                 Oldest;
+  UINT64                                MaxSize;
+  UINT64                                UsedSize;
+  UINTN                                 Size;
+
+  //
+  // A file without validators would have to be downloaded again anyway.
+  //
+  if ((ETag[0] == '\0') && (LastModified[0] == '\0')) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (!HttpBootImageCacheIsCacheable (Uri)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (AsciiStrSize (Uri) > EDKII_HTTP_BOOT_IMAGE_CACHE_URI_SIZE) {
+    return EFI_UNSUPPORTED;
+  }
+
+  MaxSize = PcdGet64 (PcdHttpBootImageCacheSize);
+  if (BufferSize > MaxSize) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = HttpBootImageCacheOpenDir (&Dir);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpBootImageCacheReadIndex (Dir, &Index);
+  if (EFI_ERROR (Status)) {
+    Dir->Close (Dir);
+    return Status;
+  }
+
+  //
+  // Replace the older copy of the file, then evict the least recently
+  // used files until the new one fits.
+  //
+  Position = HttpBootImageCacheFind (Index, Uri);
+  if (Position < Index->Count) {
+    HttpBootImageCacheDelete (Dir, Index, Position);
+  }
+
+  while (TRUE) {
+    UsedSize = 0;
+    Oldest   = 0;
+    for (Position = 0; Position < Index->Count; Position++) {
+      UsedSize += Index->Records[Position].Entry.Size;
+      if (Index->Records[Position].Entry.LastUsed < Index->Records[Oldest].Entry.LastUsed) {
+        Oldest = Position;
+      }
+    }
+
+    if ((UsedSize + BufferSize <= MaxSize) && (Index->Count < HTTP_BOOT_IMAGE_CACHE_MAX_RECORDS)) {
+      break;
+    }
+
+    HttpBootImageCacheDelete (Dir, Index, Oldest);
+  }
+
+  Record = &Index->Records[Index->Count];
+  ZeroMem (Record, sizeof (HTTP_BOOT_IMAGE_CACHE_RECORD));
+  Record->Id        = Index->NextId++;
+  Record->ImageType = (UINT32) ImageType;
+  AsciiStrCpyS (Record->Entry.Uri, sizeof (Record->Entry.Uri), Uri);
+  AsciiStrCpyS (Record->Entry.ETag, sizeof (Record->Entry.ETag), ETag);
+  AsciiStrCpyS (Record->Entry.LastModified, sizeof (Record->Entry.LastModified), LastModified);
+  Record->Entry.Size     = BufferSize;
+  Record->Entry.LastUsed = ++Index->UseCounter;
+  gBS->CalculateCrc32 (Buffer, BufferSize, &Record->Entry.Crc32);
+
+  Status = HttpBootImageCacheOpenFile (
+             Dir,
+             Record->Id,
+             EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+             &File
+             );
+  if (!EFI_ERROR (Status)) {
+    Size   = BufferSize;
+    Status = File->Write (File, &Size, Buffer);
+    if (EFI_ERROR (Status)) {
+      //
+      // Most likely the partition is full, don't leave a partial file behind.
+      //
+      File->Delete (File);
+    } else {
+      File->Close (File);
+      Index->Count++;
+    }
+  }
+
+  //
+  // Write the index even if the new file couldn't be stored, the
+  // evicted files are gone.
+  //
+  if (EFI_ERROR (HttpBootImageCacheWriteIndex (Dir, Index)) && !EFI_ERROR (Status)) {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  FreePool (Index);
+  Dir->Close (Dir);
+  return Status;
+}
+
+/**
+  Get the validators of a boot file from the headers of a response, so that
+  the cached copy of the file can be revalidated with a conditional request.
+
+  @param[in]   HeaderCount     Number of HTTP header structures in Headers.
+  @param[in]   Headers         Array containing list of HTTP headers.
+  @param[out]  ETag            The ETag, or an empty string if the server didn't
+                               return one or it is too long.
+  @param[out]  LastModified    The Last-Modified date, or an empty string if the server
+                               didn't return one or it is too long.
+
+**/
+VOID
+HttpBootImageCacheGetValidators (
+  IN     UINTN                          HeaderCount,
+  IN     EFI_HTTP_HEADER                *Headers,
+     OUT CHAR8                          *ETag,
+     OUT CHAR8                          *LastModified
+  )
+{
+  EFI_HTTP_HEADER                       *Header;
+
+  ETag[0]         = '\0';
+  LastModified[0] = '\0';
+
+  Header = HttpFindHeader (HeaderCount, Headers, HTTP_HEADER_ETAG);
+  if ((Header != NULL) && (AsciiStrSize (Header->FieldValue) <= EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE)) {
+    AsciiStrCpyS (ETag, EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE, Header->FieldValue);
+  }
+
+  Header = HttpFindHeader (HeaderCount, Headers, HTTP_HEADER_LAST_MODIFIED);
+  if ((Header != NULL) && (AsciiStrSize (Header->FieldValue) <= EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE)) {
+    AsciiStrCpyS (LastModified, EDKII_HTTP_BOOT_IMAGE_CACHE_VALIDATOR_SIZE, Header->FieldValue);
+  }
+}
+
+/**
+  Get the boot files in the cache.
+
+  @param  This              The protocol instance pointer.
+  @param  Count             On return, the number of entries in Entries.
+  @param  Entries           On return, the cached files. The caller frees the
+                            buffer with FreePool().
+  @param  UsedSize          On return, the total size of the cached files in bytes.
+  @param  MaxSize           On return, the size limit of the cache in bytes.
+
+  @retval EFI_SUCCESS            The cached files were returned.
+  @retval EFI_NOT_FOUND          The cache is empty.
+  @retval EFI_INVALID_PARAMETER  Count, Entries, UsedSize or MaxSize is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources to return the
+                                 cached files.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootImageCacheGetEntries (
+  IN  EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL  *This,
+  OUT UINTN                                 *Count,
+  OUT EDKII_HTTP_BOOT_IMAGE_CACHE_ENTRY     **Entries,
+  OUT UINT64                                *UsedSize,
+  OUT UINT64                                *MaxSize
+  )
+{
+  EFI_STATUS                            Status;
+  EFI_FILE_PROTOCOL                     *Dir;
+  HTTP_BOOT_IMAGE_CACHE_INDEX           *Index;
+  UINTN                                 Position;
+
+  if (Count == NULL || Entries == NULL || UsedSize == NULL || MaxSize == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *MaxSize  = PcdGet64 (PcdHttpBootImageCacheSize);
+  *UsedSize = 0;
+
+  Status = HttpBootImageCacheOpenDir (&Dir);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = HttpBootImageCacheReadIndex (Dir, &Index);
+  Dir->Close (Dir);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Index->Count == 0) {
+    FreePool (Index);
+    return EFI_NOT_FOUND;
+  }
+
+  *Entries = AllocatePool (Index->Count * sizeof (EDKII_HTTP_BOOT_IMAGE_CACHE_ENTRY));
+  if (*Entries == NULL) {
+    FreePool (Index);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Position = 0; Position < Index->Count; Position++) {
+    CopyMem (&(*Entries)[Position], &Index->Records[Position].Entry, sizeof (EDKII_HTTP_BOOT_IMAGE_CACHE_ENTRY));
+    *UsedSize += Index->Records[Position].Entry.Size;
+  }
+  *Count = Index->Count;
+
+  FreePool (Index);
+  return EFI_SUCCESS;
+}
+
+/**
+  Remove boot files from the cache.
+
+  @param  This              The protocol instance pointer.
+  @param  Uri               The URI of the file to remove, or NULL to remove
+                            all the files.
+
+  @retval EFI_SUCCESS            The files were removed.
+  @retval EFI_NOT_FOUND          Uri is not in the cache.
+  @retval Others                 The cache couldn't be updated.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootImageCacheRemove (
+  IN  EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL  *This,
+  IN  CHAR8                                 *Uri OPTIONAL
+  )
+{
+  EFI_STATUS                            Status;
+  EFI_FILE_PROTOCOL                     *Dir;
+  HTTP_BOOT_IMAGE_CACHE_INDEX           *Index;
+  UINTN                                 Position;
+
+  Status = HttpBootImageCacheOpenDir (&Dir);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpBootImageCacheReadIndex (Dir, &Index);
+  if (EFI_ERROR (Status)) {
+    Dir->Close (Dir);
+    return Status;
+  }
+
+  if (Uri == NULL) {
+    while (Index->Count != 0) {
+      HttpBootImageCacheDelete (Dir, Index, Index->Count - 1);
+    }
+  } else {
+    Position = HttpBootImageCacheFind (Index, Uri);
+    if (Position == Index->Count) {
+      Status = EFI_NOT_FOUND;
+      goto ON_EXIT;
+    }
+    HttpBootImageCacheDelete (Dir, Index, Position);
+  }
+
+  Status = HttpBootImageCacheWriteIndex (Dir, Index);
+
+ON_EXIT:
+  FreePool (Index);
+  Dir->Close (Dir);
+  return Status;
+}
+
+EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL  mHttpBootImageCache = {
+  HttpBootImageCacheGetEntries,
+  HttpBootImageCacheRemove
+};
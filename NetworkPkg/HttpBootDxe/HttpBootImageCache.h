@@ -0,0 +1,140 @@
+/** @file
+  Declaration of the persistent cache of boot files on the EFI system partition.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFI_HTTP_BOOT_IMAGE_CACHE_H__
+#define __EFI_HTTP_BOOT_IMAGE_CACHE_H__
+
+#define HTTP_BOOT_IMAGE_CACHE_DIRECTORY      L"\\EFI\\HttpBootCache"
+#define HTTP_BOOT_IMAGE_CACHE_INDEX_NAME     L"Index.dat"
+#define HTTP_BOOT_IMAGE_CACHE_FILE_NAME_SIZE 16        // "%08X.img" and the NULL terminator.
+
+#define HTTP_BOOT_IMAGE_CACHE_SIGNATURE      SIGNATURE_32 ('H', 'B', 'I', 'C')
+#define HTTP_BOOT_IMAGE_CACHE_VERSION        1
+#define HTTP_BOOT_IMAGE_CACHE_MAX_RECORDS    1024
+
+//
+// A cached boot file. Its content is in the file named after Id.
+//
+typedef struct {
+  UINT32                               Id;
+  UINT32                               ImageType;
+  EDKII_HTTP_BOOT_IMAGE_CACHE_ENTRY    Entry;
+} HTTP_BOOT_IMAGE_CACHE_RECORD;
+
+//
+// The index of the cache, stored as is in HTTP_BOOT_IMAGE_CACHE_INDEX_NAME.
+//
+typedef struct {
+  UINT32                               Signature;
+  UINT32                               Version;
+  UINT32                               Count;
+  UINT32                               NextId;
+  UINT64                               UseCounter;
+  HTTP_BOOT_IMAGE_CACHE_RECORD         Records[1];
+} HTTP_BOOT_IMAGE_CACHE_INDEX;
+
+#define HTTP_BOOT_IMAGE_CACHE_INDEX_SIZE(Count) \
+  (OFFSET_OF (HTTP_BOOT_IMAGE_CACHE_INDEX, Records) + (Count) * sizeof (HTTP_BOOT_IMAGE_CACHE_RECORD))
+
+extern EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL  mHttpBootImageCache;
+
+/**
+  Look up a boot file in the cache.
+
+  @param[in]   Uri             The URI of the boot file.
+  @param[out]  Record          The record of the cached file.
+
+  @retval EFI_SUCCESS          The file is in the cache.
+  @retval EFI_NOT_FOUND        The file is not in the cache, or the cache is not available.
+
+**/
+EFI_STATUS
+HttpBootImageCacheLookup (
+  IN     CHAR8                          *Uri,
+     OUT HTTP_BOOT_IMAGE_CACHE_RECORD   *Record
+  );
+
+/**
+  Load a boot file from the cache, and check it against its CRC32.
+  A file which fails the check is removed from the cache.
+
+  @param[in]       Uri             The URI of the boot file.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_NOT_FOUND            The file is not in the cache.
+  @retval EFI_BUFFER_TOO_SMALL     The BufferSize is too small for the file.
+  @retval EFI_CRC_ERROR            The cached file is corrupted.
+  @retval Others                   The cached file couldn't be read.
+
+**/
+EFI_STATUS
+HttpBootImageCacheRead (
+  IN     CHAR8                          *Uri,
+  IN OUT UINTN                          *BufferSize,
+     OUT UINT8                          *Buffer
+  );
+
+/**
+  Store a downloaded boot file in the cache, evicting the least recently used
+  files to stay within PcdHttpBootImageCacheSize.
+
+  @param[in]  Uri              The URI of the boot file.
+  @param[in]  ETag             The ETag returned by the server, or an empty string.
+  @param[in]  LastModified     The Last-Modified date returned by the server, or an empty string.
+  @param[in]  ImageType        The image type of the boot file.
+  @param[in]  Buffer           The content of the boot file.
+  @param[in]  BufferSize       The size of the boot file in bytes.
+
+  @retval EFI_SUCCESS          The file was stored.
+  @retval EFI_UNSUPPORTED      The file can't be revalidated, or its URI or validators are
+                               too long.
+  @retval EFI_OUT_OF_RESOURCES The file is larger than the cache.
+  @retval Others               The file couldn't be written.
+
+**/
+EFI_STATUS
+HttpBootImageCacheStore (
+  IN     CHAR8                          *Uri,
+  IN     CHAR8                          *ETag,
+  IN     CHAR8                          *LastModified,
+  IN     HTTP_BOOT_IMAGE_TYPE           ImageType,
+  IN     UINT8                          *Buffer,
+  IN     UINTN                          BufferSize
+  );
+
+/**
+  Get the validators of a boot file from the headers of a response, so that
+  the cached copy of the file can be revalidated with a conditional request.
+
+  @param[in]   HeaderCount     Number of HTTP header structures in Headers.
+  @param[in]   Headers         Array containing list of HTTP headers.
+  @param[out]  ETag            The ETag, or an empty string if the server didn't
+                               return one or it is too long.
+  @param[out]  LastModified    The Last-Modified date, or an empty string if the server
+                               didn't return one or it is too long.
+
+**/
+VOID
+HttpBootImageCacheGetValidators (
+  IN     UINTN                          HeaderCount,
+  IN     EFI_HTTP_HEADER                *Headers,
+     OUT CHAR8                          *ETag,
+     OUT CHAR8                          *LastModified
+  );
+
+#endif
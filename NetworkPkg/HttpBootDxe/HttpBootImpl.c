@@ -351,6 +351,15 @@ HttpBootLoadFile (
     // Discover the information about the bootfile if we haven't.
     //
 
+    //
+    // Look for a cached copy of the bootfile, which the HEAD request revalidates.
+    //
+    if (PcdGet64 (PcdHttpBootImageCacheSize) != 0) {
+      Private->ImageCacheFound = (BOOLEAN) !EFI_ERROR (
+                                              HttpBootImageCacheLookup (Private->BootFileUri, &Private->ImageCacheRecord)
+                                              );
+    }
+
     //
     // Try to use HTTP HEAD method.
     //
@@ -388,15 +397,53 @@ HttpBootLoadFile (
   }
 
   //
-  // Load the boot file into Buffer
+  // Load the boot file from the image cache if the server confirmed it's current.
   //
-  Status = HttpBootGetBootFile (
-             Private,
-             FALSE,
-             BufferSize,
-             Buffer,
-             ImageType
-             );
+  if ((Buffer != NULL) && Private->ImageCacheHit) {
+    Status = HttpBootImageCacheRead (Private->BootFileUri, BufferSize, Buffer);
+    if (!EFI_ERROR (Status)) {
+      AsciiPrint ("\n  Loaded NBP file from the local image cache.\n");
+      *ImageType = (HTTP_BOOT_IMAGE_TYPE) Private->ImageCacheRecord.ImageType;
+      goto ON_EXIT;
+    }
+    Private->ImageCacheHit = FALSE;
+  }
+
+  //
+  // Load the boot file into Buffer, over several connections if the server
+  // supports byte ranges, otherwise or if that fails, over a single one.
+  //
+  Status = EFI_UNSUPPORTED;
+  if ((Buffer != NULL) && Private->AcceptRanges && (PcdGet8 (PcdHttpBootConnections) > 1)) {
+    Status = HttpBootGetBootFileByRanges (Private, BufferSize, Buffer);
+    if (!EFI_ERROR (Status)) {
+      *ImageType = Private->ImageType;
+    }
+  }
+
+  if (EFI_ERROR (Status) && (Status != EFI_ABORTED) && (Status != EFI_BUFFER_TOO_SMALL)) {
+    Status = HttpBootGetBootFile (
+               Private,
+               FALSE,
+               BufferSize,
+               Buffer,
+               ImageType
+               );
+  }
+
+  //
+  // Keep the downloaded boot file for the next boot.
+  //
+  if (!EFI_ERROR (Status) && (Buffer != NULL) && (PcdGet64 (PcdHttpBootImageCacheSize) != 0)) {
+    HttpBootImageCacheStore (
+      Private->BootFileUri,
+      Private->ETag,
+      Private->LastModified,
+      *ImageType,
+      Buffer,
+      *BufferSize
+      );
+  }
   
 ON_EXIT:
   HttpBootUninstallCallback (Private);
@@ -461,6 +508,11 @@ HttpBootStop (
   Private->BootFileUri = NULL;
   Private->BootFileUriParser = NULL;
   Private->BootFileSize = 0;
+  Private->AcceptRanges = FALSE;
+  Private->ImageCacheFound = FALSE;
+  Private->ImageCacheHit = FALSE;
+  Private->ETag[0] = '\0';
+  Private->LastModified[0] = '\0';
   Private->SelectIndex = 0;
   Private->SelectProxyType = HttpOfferTypeMax; 
 
@@ -0,0 +1,487 @@
+/** @file
+  Download the boot file over several HTTP connections, each one fetching a
+  byte range of the file, so that a single TCP connection's window and loss
+  recovery don't limit the download on high bandwidth-delay links.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HttpBootDxe.h"
+
+/**
+  Open the HTTP child of a range and send the GET request for it.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  Range           The range to request.
+  @param[in]       Url             The URL of the boot file.
+  @param[in]       HostName        The host name of the boot file URL.
+
+  @retval EFI_SUCCESS              The request was sent.
+  @retval Others                   Failed to open the HTTP child or to send the request.
+
+**/
+EFI_STATUS
+HttpBootRangeSendRequest (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT HTTP_BOOT_RANGE          *Range,
+  IN     CHAR16                   *Url,
+  IN     CHAR8                    *HostName
+  )
+{
+  EFI_STATUS                 Status;
+  CHAR8                      RangeValue[HTTP_BOOT_RANGE_HEADER_SIZE];
+
+  //
+  // A HTTP child of its own for each range, without the HttpIo callback
+  // so that the HttpBootCallback sees the file size of the HEAD request
+  // rather than the size of each range.
+  //
+  Status = HttpBootOpenHttpIo (Private, NULL, &Range->HttpIo);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Range->HttpCreated = TRUE;
+
+  //
+  // Build HTTP header for the request, 4 header is needed to download a range:
+  //   Host
+  //   Accept
+  //   User-Agent
+  //   Range
+  //
+  Range->HttpIoHeader = HttpBootCreateHeader (4);
+  if (Range->HttpIoHeader == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = HttpBootSetHeader (Range->HttpIoHeader, HTTP_HEADER_HOST, HostName);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpBootSetHeader (Range->HttpIoHeader, HTTP_HEADER_ACCEPT, "*/*");
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpBootSetHeader (Range->HttpIoHeader, HTTP_HEADER_USER_AGENT, HTTP_USER_AGENT_EFI_HTTP_BOOT);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  AsciiSPrint (
+    RangeValue,
+    sizeof (RangeValue),
+    "bytes=%lu-%lu",
+    (UINT64) Range->Start,
+    (UINT64) (Range->Start + Range->Length - 1)
+    );
+  Status = HttpBootSetHeader (Range->HttpIoHeader, HTTP_HEADER_RANGE, RangeValue);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Range->RequestData.Method = HttpMethodGet;
+  Range->RequestData.Url    = Url;
+
+  return HttpIoSendRequest (
+           &Range->HttpIo,
+           &Range->RequestData,
+           Range->HttpIoHeader->HeaderCount,
+           Range->HttpIoHeader->Headers,
+           0,
+           NULL
+           );
+}
+
+/**
+  Queue a response token on the HTTP child of a range, for the response
+  header first, then for the rest of the range straight into the buffer.
+
+  Unlike HttpIoRecvResponse(), this doesn't wait for the token to complete,
+  so that all the ranges are received at the same time.
+
+  @param[in, out]  Range           The range to receive.
+  @param[in]       Buffer          The buffer of the whole boot file.
+
+  @retval EFI_SUCCESS              The token was queued.
+  @retval Others                   Failed to queue the token.
+
+**/
+EFI_STATUS
+HttpBootRangeQueueResponse (
+  IN OUT HTTP_BOOT_RANGE          *Range,
+  IN     UINT8                    *Buffer
+  )
+{
+  EFI_HTTP_MESSAGE           *Message;
+  EFI_STATUS                 Status;
+
+  Message = Range->HttpIo.RspToken.Message;
+
+  Range->HttpIo.RspToken.Status = EFI_NOT_READY;
+  Message->HeaderCount          = 0;
+  Message->Headers              = NULL;
+  if (!Range->HeaderReceived) {
+    Message->Data.Response = &Range->ResponseData;
+    Message->BodyLength    = 0;
+    Message->Body          = NULL;
+  } else {
+    Message->Data.Response = NULL;
+    Message->BodyLength    = Range->Length - Range->ReceivedSize;
+    Message->Body          = Buffer + Range->Start + Range->ReceivedSize;
+  }
+
+  Range->HttpIo.IsRxDone = FALSE;
+  Status = Range->HttpIo.Http->Response (Range->HttpIo.Http, &Range->HttpIo.RspToken);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Range->RxPending = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Process the completed response token of a range.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  Range           The range the token belongs to.
+  @param[in]       Buffer          The buffer of the whole boot file.
+
+  @retval EFI_SUCCESS              The response was processed.
+  @retval EFI_UNSUPPORTED          The server didn't return the range as a partial content.
+  @retval EFI_ABORTED              The download was cancelled by the HttpBootCallback.
+  @retval Others                   The response token failed.
+
+**/
+EFI_STATUS
+HttpBootRangeProcessResponse (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT HTTP_BOOT_RANGE          *Range,
+  IN     UINT8                    *Buffer
+  )
+{
+  EFI_HTTP_MESSAGE           *Message;
+  EFI_STATUS                 Status;
+
+  Range->RxPending       = FALSE;
+  Range->HttpIo.IsRxDone = FALSE;
+  Message                = Range->HttpIo.RspToken.Message;
+
+  if (Message->Headers != NULL) {
+    HttpFreeHeaderFields (Message->Headers, Message->HeaderCount);
+    Message->Headers     = NULL;
+    Message->HeaderCount = 0;
+  }
+
+  if (EFI_ERROR (Range->HttpIo.RspToken.Status)) {
+    return Range->HttpIo.RspToken.Status;
+  }
+
+  if (!Range->HeaderReceived) {
+    //
+    // A server which ignores the Range header returns the whole file with
+    // 200 OK, give up and let the caller download the file the usual way.
+    //
+    if (Range->ResponseData.StatusCode != HTTP_STATUS_206_PARTIAL_CONTENT) {
+      return EFI_UNSUPPORTED;
+    }
+    Range->HeaderReceived = TRUE;
+    return EFI_SUCCESS;
+  }
+
+  if (Message->BodyLength == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (Private->HttpBootCallback != NULL) {
+    Status = Private->HttpBootCallback->Callback (
+               Private->HttpBootCallback,
+               HttpBootHttpEntityBody,
+               TRUE,
+               (UINT32) Message->BodyLength,
+               Buffer + Range->Start + Range->ReceivedSize
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  Range->ReceivedSize += Message->BodyLength;
+  if (Range->ReceivedSize >= Range->Length) {
+    Range->Completed = TRUE;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Print the throughput of the download.
+
+  @param[in]  FileSize       The size of the boot file in bytes.
+  @param[in]  Count          The number of connections.
+  @param[in]  StartTicks     The performance counter at the start of the download.
+  @param[in]  EndTicks       The performance counter at the end of the download.
+
+**/
+VOID
+HttpBootRangePrintThroughput (
+  IN UINTN                        FileSize,
+  IN UINTN                        Count,
+  IN UINT64                       StartTicks,
+  IN UINT64                       EndTicks
+  )
+{
+  UINT64                     CounterStart;
+  UINT64                     CounterEnd;
+  UINT64                     Ticks;
+  UINT64                     ElapsedMs;
+
+  if (GetPerformanceCounterProperties (&CounterStart, &CounterEnd) == 0) {
+    return;
+  }
+
+  //
+  // The counter may count down, and may have wrapped once.
+  //
+  if (CounterEnd < CounterStart) {
+    Ticks = (StartTicks >= EndTicks) ? (StartTicks - EndTicks) : (StartTicks - CounterEnd) + (CounterStart - EndTicks);
+  } else {
+    Ticks = (EndTicks >= StartTicks) ? (EndTicks - StartTicks) : (CounterEnd - StartTicks) + (EndTicks - CounterStart);
+  }
+
+  ElapsedMs = DivU64x32 (GetTimeInNanoSecond (Ticks), 1000000);
+  if (ElapsedMs == 0) {
+    return;
+  }
+
+  AsciiPrint (
+    "\n  Downloaded %lu Bytes in %lu ms over %d connections, %lu KB/s\n",
+    (UINT64) FileSize,
+    ElapsedMs,
+    Count,
+    DivU64x64Remainder (MultU64x32 (FileSize, 1000), MultU64x32 (ElapsedMs, 1024), NULL)
+    );
+}
+
+/**
+  Download the boot file over several HTTP connections, each one getting a byte
+  range of the file with a HTTP Range request, straight into the caller's buffer.
+
+  The size of the file and the Accept-Ranges support must have been learned from
+  a HEAD request before.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The file is too small to be split, ranged download is
+                                   disabled, or the server didn't return a partial content.
+  @retval EFI_BUFFER_TOO_SMALL     The BufferSize is too small for the file.
+  @retval EFI_TIMEOUT              No data was received for HTTP_BOOT_RESPONSE_TIMEOUT.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileByRanges (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer
+  )
+{
+  EFI_STATUS                 Status;
+  UINTN                      FileSize;
+  UINTN                      Count;
+  UINTN                      RangeSize;
+  UINTN                      Index;
+  HTTP_BOOT_RANGE            *Ranges;
+  HTTP_BOOT_RANGE            *Range;
+  UINTN                      UrlSize;
+  CHAR16                     *Url;
+  CHAR8                      *HostName;
+  EFI_EVENT                  TimeoutEvent;
+  BOOLEAN                    Done;
+  UINTN                      Received;
+  UINTN                      LastReceived;
+  UINT64                     StartTicks;
+
+  ASSERT (Private != NULL);
+
+  if (BufferSize == NULL || Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  FileSize = Private->BootFileSize;
+  if (!Private->AcceptRanges || FileSize == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (*BufferSize < FileSize) {
+    *BufferSize = FileSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  //
+  // Every connection gets at least HTTP_BOOT_RANGE_MIN_SIZE, below that
+  // the connection setup costs more than the parallelism brings.
+  //
+  Count = MIN (PcdGet8 (PcdHttpBootConnections), HTTP_BOOT_MAX_CONNECTIONS);
+  Count = MIN (Count, FileSize / HTTP_BOOT_RANGE_MIN_SIZE);
+  if (Count < 2) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Ranges       = NULL;
+  Url          = NULL;
+  HostName     = NULL;
+  TimeoutEvent = NULL;
+
+  Ranges = AllocateZeroPool (Count * sizeof (HTTP_BOOT_RANGE));
+  if (Ranges == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  UrlSize = AsciiStrSize (Private->BootFileUri);
+  Url = AllocatePool (UrlSize * sizeof (CHAR16));
+  if (Url == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+  AsciiStrToUnicodeStrS (Private->BootFileUri, Url, UrlSize);
+
+  Status = HttpUrlGetHostName (
+             Private->BootFileUri,
+             Private->BootFileUriParser,
+             &HostName
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER,
+                  TPL_CALLBACK,
+                  NULL,
+                  NULL,
+                  &TimeoutEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  StartTicks = GetPerformanceCounter ();
+
+  //
+  // Split the file into Count ranges, the last one takes the remainder.
+  //
+  RangeSize = FileSize / Count;
+  for (Index = 0; Index < Count; Index++) {
+    Range         = &Ranges[Index];
+    Range->Start  = Index * RangeSize;
+    Range->Length = (Index == Count - 1) ? (FileSize - Range->Start) : RangeSize;
+
+    Status = HttpBootRangeSendRequest (Private, Range, Url, HostName);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+  }
+
+  //
+  // Receive all the ranges at the same time, and give up if none of them
+  // makes progress for HTTP_BOOT_RESPONSE_TIMEOUT.
+  //
+  Status = gBS->SetTimer (TimeoutEvent, TimerRelative, HTTP_BOOT_RESPONSE_TIMEOUT * TICKS_PER_MS);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  LastReceived = 0;
+  while (TRUE) {
+    Done     = TRUE;
+    Received = 0;
+
+    for (Index = 0; Index < Count; Index++) {
+      Range = &Ranges[Index];
+      if (Range->Completed) {
+        Received += Range->ReceivedSize;
+        continue;
+      }
+
+      Done = FALSE;
+      if (!Range->RxPending) {
+        Status = HttpBootRangeQueueResponse (Range, Buffer);
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+      }
+
+      Range->HttpIo.Http->Poll (Range->HttpIo.Http);
+
+      if (Range->HttpIo.IsRxDone) {
+        Status = HttpBootRangeProcessResponse (Private, Range, Buffer);
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+      }
+
+      Received += Range->ReceivedSize;
+    }
+
+    if (Done) {
+      break;
+    }
+
+    if (Received != LastReceived) {
+      LastReceived = Received;
+      gBS->SetTimer (TimeoutEvent, TimerRelative, HTTP_BOOT_RESPONSE_TIMEOUT * TICKS_PER_MS);
+    } else if (!EFI_ERROR (gBS->CheckEvent (TimeoutEvent))) {
+      Status = EFI_TIMEOUT;
+      goto ON_EXIT;
+    }
+  }
+
+  HttpBootRangePrintThroughput (FileSize, Count, StartTicks, GetPerformanceCounter ());
+
+  *BufferSize = FileSize;
+  Status      = EFI_SUCCESS;
+
+ON_EXIT:
+  if (TimeoutEvent != NULL) {
+    gBS->CloseEvent (TimeoutEvent);
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Range = &Ranges[Index];
+    if (Range->HttpCreated) {
+      if (Range->RxPending) {
+        Range->HttpIo.Http->Cancel (Range->HttpIo.Http, &Range->HttpIo.RspToken);
+      }
+      HttpIoDestroyIo (&Range->HttpIo);
+    }
+    if (Range->HttpIoHeader != NULL) {
+      HttpBootFreeHeader (Range->HttpIoHeader);
+    }
+  }
+
+  if (HostName != NULL) {
+    FreePool (HostName);
+  }
+  if (Url != NULL) {
+    FreePool (Url);
+  }
+  FreePool (Ranges);
+
+  return Status;
+}
@@ -0,0 +1,69 @@
+/** @file
+  Declaration of the boot file download over several HTTP connections.
+
+Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under
+the terms and conditions of the BSD License that accompanies this distribution.
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFI_HTTP_BOOT_RANGE_H__
+#define __EFI_HTTP_BOOT_RANGE_H__
+
+#define HTTP_BOOT_MAX_CONNECTIONS            16
+#define HTTP_BOOT_RANGE_MIN_SIZE             SIZE_1MB  // Smallest range worth its own connection.
+#define HTTP_BOOT_RANGE_HEADER_SIZE          48        // "bytes=" and two 20 digit offsets.
+
+//
+// One byte range of the boot file, downloaded over its own HTTP child.
+//
+typedef struct {
+  HTTP_IO                    HttpIo;
+  BOOLEAN                    HttpCreated;
+  HTTP_IO_HEADER             *HttpIoHeader;
+  EFI_HTTP_REQUEST_DATA      RequestData;
+  EFI_HTTP_RESPONSE_DATA     ResponseData;
+
+  UINTN                      Start;           // Offset of the range in the file.
+  UINTN                      Length;          // Length of the range in bytes.
+  UINTN                      ReceivedSize;    // Bytes of the range already received.
+
+  BOOLEAN                    HeaderReceived;  // The response header has been received.
+  BOOLEAN                    RxPending;       // A response token is queued.
+  BOOLEAN                    Completed;
+} HTTP_BOOT_RANGE;
+
+/**
+  Download the boot file over several HTTP connections, each one getting a byte
+  range of the file with a HTTP Range request, straight into the caller's buffer.
+
+  The size of the file and the Accept-Ranges support must have been learned from
+  a HEAD request before.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The file is too small to be split, ranged download is
+                                   disabled, or the server didn't return a partial content.
+  @retval EFI_BUFFER_TOO_SMALL     The BufferSize is too small for the file.
+  @retval EFI_TIMEOUT              No data was received for HTTP_BOOT_RESPONSE_TIMEOUT.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileByRanges (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer
+  );
+
+#endif
@@ -1,7 +1,7 @@
 /** @file
   Support functions implementation for UEFI HTTP boot driver.
 
-Copyright (c) 2015 - 2017, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2015 - 2018, Intel Corporation. All rights reserved.<BR>
 (C) Copyright 2016 Hewlett Packard Enterprise Development LP<BR>
 This program and the accompanying materials are licensed and made available under
 the terms and conditions of the BSD License that accompanies this distribution.
@@ -1287,6 +1287,7 @@ HttpBootRegisterRamDisk (
   EFI_STATUS                 Status;
   EFI_DEVICE_PATH_PROTOCOL   *DevicePath;
   EFI_GUID                   *RamDiskType;
+  EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER  *Header;
   
   ASSERT (Private != NULL);
   ASSERT (Buffer != NULL);
@@ -1305,6 +1306,16 @@ HttpBootRegisterRamDisk (
   } else {
     return EFI_UNSUPPORTED;
   }
+
+  //
+  // A compressed image is registered as is, and expanded by the RAM disk
+  // driver on read.
+  //
+  Header = (EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER *) Buffer;
+  if ((BufferSize >= sizeof (EDKII_RAM_DISK_COMPRESSED_IMAGE_HEADER)) &&
+      (Header->Signature == EDKII_RAM_DISK_COMPRESSED_IMAGE_SIGNATURE)) {
+    RamDiskType = &gEdkiiRamDiskCompressedImageGuid;
+  }
   
   Status = RamDisk->Register (
              (UINTN)Buffer,
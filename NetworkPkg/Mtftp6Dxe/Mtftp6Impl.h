@@ -46,6 +46,7 @@ typedef struct _MTFTP6_INSTANCE MTFTP6_INSTANCE;
 #define MTFTP6_GET_MAPPING_TIMEOUT     3
 #define MTFTP6_DEFAULT_MAX_RETRY       5
 #define MTFTP6_DEFAULT_BLK_SIZE        512
+#define MTFTP6_DEFAULT_WINDOW_SIZE     1
 #define MTFTP6_TICK_PER_SECOND         10000000U
 
 #define MTFTP6_SERVICE_FROM_THIS(a)    CR (a, MTFTP6_SERVICE, ServiceBinding, MTFTP6_SERVICE_SIGNATURE)
@@ -77,6 +78,18 @@ struct _MTFTP6_INSTANCE {
   UINT16                        LastBlk;
   LIST_ENTRY                    BlkList;
 
+  //
+  // The number of data blocks the server sends before waiting for an
+  // ACK (RFC 7440), the number of blocks received and saved, and the
+  // number of blocks received when the last ACK was sent. GapBlock is
+  // the block that was expected when an ACK was last sent for a lost
+  // block, or -1 if a block was received in order since.
+  //
+  UINT16                        WindowSize;
+  UINT64                        TotalBlock;
+  UINT64                        AckedBlock;
+  INTN                          GapBlock;
+
   EFI_IPv6_ADDRESS              ServerIp;
   UINT16                        ServerCmdPort;
   UINT16                        ServerDataPort;
@@ -61,6 +61,8 @@ Mtftp6RrqSendAck (
   Instance->CurRetry = 0;
   Instance->LastPacket = Packet;
 
+  Instance->AckedBlock = Instance->TotalBlock;
+
   return Mtftp6TransmitPacket (Instance, Packet);
 }
 
@@ -196,7 +198,10 @@ Mtftp6RrqSaveBlock (
 
 /**
   Process the received data packets. It will save the block
-  then send back an ACK if it is active.
+  then send back an ACK if it is active. If a window size was negotiated,
+  the ACK is only sent when the whole window has been received, or when a
+  block is lost, to tell the server to send the window again from the last
+  block received in order.
 
   @param[in]  Instance              The pointer to the Mtftp6 instance.
   @param[in]  Packet                The pointer to the received packet.
@@ -242,7 +247,24 @@ Mtftp6RrqHandleData (
     NetbufFree (*UdpPacket);
     *UdpPacket = NULL;
 
-    Mtftp6TransmitPacket (Instance, Instance->LastPacket);
+    if (Instance->WindowSize == 1) {
+      Mtftp6TransmitPacket (Instance, Instance->LastPacket);
+      return EFI_SUCCESS;
+    }
+
+    //
+    // In a window, the server keeps sending the blocks after the lost
+    // one. ACK the last block received in order once per lost block, so
+    // the server sends the window again from there, and drop the rest.
+    // This also covers the loss of the first block of a window, when no
+    // block was received since the last ACK. If Expected is 0,
+    // (UINT16) (Expected - 1) is the block number 65535.
+    //
+    if (Instance->GapBlock != Expected) {
+      Instance->GapBlock = Expected;
+      return Mtftp6RrqSendAck (Instance, (UINT16) (Expected - 1));
+    }
+
     return EFI_SUCCESS;
   }
 
@@ -252,11 +274,17 @@ Mtftp6RrqHandleData (
     return Status;
   }
 
+  Instance->TotalBlock++;
+  Instance->GapBlock = -1;
+
   //
   // Reset the passive client's timer whenever it received a valid data packet.
+  // So does the active client in a window, because it doesn't ACK every block.
   //
   if (!Instance->IsMaster) {
     Instance->PacketToLive = Instance->Timeout * 2;
+  } else if (Instance->WindowSize > 1) {
+    Instance->PacketToLive = Instance->Timeout;
   }
 
   //
@@ -288,7 +316,10 @@ Mtftp6RrqHandleData (
     NetbufFree (*UdpPacket);
     *UdpPacket = NULL;
 
-    Mtftp6RrqSendAck (Instance, BlockNum);
+    if ((Expected < 0) ||
+        (Instance->TotalBlock - Instance->AckedBlock >= Instance->WindowSize)) {
+      Mtftp6RrqSendAck (Instance, BlockNum);
+    }
   }
 
   return EFI_SUCCESS;
@@ -302,6 +333,7 @@ Mtftp6RrqHandleData (
   2. The server can only use smaller blksize than that is requested.
   3. The server can only use the same timeout as requested.
   4. The server doesn't change its multicast channel.
+  5. The server can only use smaller windowsize than that is requested.
 
   @param[in]  Instance              The pointer to the Mtftp6 instance.
   @param[in]  ReplyInfo             The pointer to options information in reply packet.
@@ -335,6 +367,15 @@ Mtftp6RrqOackValid (
     return FALSE;
   }
 
+  //
+  // Server can only specify a smaller window size to be used. The window
+  // isn't supported in multicast download, where each client ACKs in turn.
+  //
+  if (((ReplyInfo->BitMap & MTFTP6_OPT_WINDOWSIZE_BIT) != 0) &&
+      ((ReplyInfo->WindowSize > RequestInfo->WindowSize) || ((ReplyInfo->BitMap & MTFTP6_OPT_MCAST_BIT) != 0))) {
+    return FALSE;
+  }
+
   //
   // The server can send ",,master" to client to change its master
   // setting. But if it use the specific multicast channel, it can't
@@ -628,6 +669,10 @@ Mtftp6RrqHandleOack (
     if (ExtInfo.Timeout != 0) {
       Instance->Timeout = ExtInfo.Timeout;
     }
+
+    if (ExtInfo.WindowSize != 0) {
+      Instance->WindowSize = ExtInfo.WindowSize;
+    }
   }
 
   //
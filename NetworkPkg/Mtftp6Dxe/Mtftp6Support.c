@@ -980,6 +980,10 @@ Mtftp6OperationClean (
   Instance->McastPort      = 0;
   Instance->BlkSize        = 0;
   Instance->LastBlk        = 0;
+  Instance->WindowSize     = 0;
+  Instance->TotalBlock     = 0;
+  Instance->AckedBlock     = 0;
+  Instance->GapBlock       = -1;
   Instance->PacketToLive   = 0;
   Instance->MaxRetry       = 0;
   Instance->CurRetry       = 0;
@@ -1066,6 +1070,15 @@ Mtftp6OperationStart (
     if (EFI_ERROR (Status)) {
       goto ON_ERROR;
     }
+
+    //
+    // The windowsize option only applies to downloads.
+    //
+    if ((OpCode == EFI_MTFTP6_OPCODE_WRQ) &&
+        ((Instance->ExtInfo.BitMap & MTFTP6_OPT_WINDOWSIZE_BIT) != 0)) {
+      Status = EFI_UNSUPPORTED;
+      goto ON_ERROR;
+    }
   }
 
   //
@@ -1105,6 +1118,10 @@ Mtftp6OperationStart (
   if (Instance->BlkSize == 0) {
     Instance->BlkSize = MTFTP6_DEFAULT_BLK_SIZE;
   }
+  if (Instance->WindowSize == 0) {
+    Instance->WindowSize = MTFTP6_DEFAULT_WINDOW_SIZE;
+  }
+  Instance->GapBlock = -1;
   if (Instance->MaxRetry == 0) {
     Instance->MaxRetry = MTFTP6_DEFAULT_MAX_RETRY;
   }
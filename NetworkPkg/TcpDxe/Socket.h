@@ -34,8 +34,6 @@
 #define SOCK_RCV_BUF        1
 
 #define SOCK_BUFF_LOW_WATER (2 * 1024)
-#define SOCK_RCV_BUFF_SIZE  (8 * 1024)
-#define SOCK_SND_BUFF_SIZE  (8 * 1024)
 #define SOCK_BACKLOG        5
 
 #define PROTO_RESERVED_LEN  20
@@ -0,0 +1,119 @@
+/** @file
+  TCP congestion control selection and the NewReno congestion control.
+
+  Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php.
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "TcpMain.h"
+
+/**
+  Initialize the NewReno state of a TCP connection. NewReno
+  has no state beyond CWnd and Ssthresh.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpNewRenoInit (
+  IN OUT TCP_CB *Tcb
+  )
+{
+}
+
+/**
+  Open the congestion window as specified in RFC5681.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Acked    The number of bytes newly acknowledged.
+
+**/
+VOID
+TcpNewRenoOnAck (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Acked
+  )
+{
+  if (Tcb->CWnd < Tcb->Ssthresh) {
+
+    TcpSlowStart (Tcb, Acked);
+  } else {
+
+    Tcb->CWnd += MAX (Tcb->SndMss * Tcb->SndMss / Tcb->CWnd, 1);
+  }
+}
+
+/**
+  Compute the slow start threshold as specified in RFC5681:
+  half of the data in flight, but at least two segments.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold, in bytes.
+
+**/
+UINT32
+TcpNewRenoSsthresh (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  UINT32  FlightSize;
+
+  FlightSize = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
+
+  return MAX (FlightSize >> 1, (UINT32) (2 * Tcb->SndMss));
+}
+
+CONST TCP_CONGESTION_OPS  mTcpNewRenoOps = {
+  "newreno",
+  TcpNewRenoInit,
+  TcpNewRenoOnAck,
+  TcpNewRenoSsthresh
+};
+
+/**
+  Get the congestion control algorithm selected by PcdTcpCongestionControl.
+
+  @return The operations of the congestion control algorithm.
+
+**/
+CONST TCP_CONGESTION_OPS *
+TcpGetCongestionOps (
+  VOID
+  )
+{
+  switch (PcdGet8 (PcdTcpCongestionControl)) {
+  case TCP_CONGESTION_CUBIC:
+    return &mTcpCubicOps;
+
+  case TCP_CONGESTION_NEWRENO:
+  default:
+    return &mTcpNewRenoOps;
+  }
+}
+
+/**
+  Open the congestion window in slow start, by the number of bytes
+  acknowledged as specified in RFC3465, with a limit L of 2 * SMSS
+  so that delayed ACKs don't slow down the growth.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Acked    The number of bytes newly acknowledged.
+
+**/
+VOID
+TcpSlowStart (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Acked
+  )
+{
+  Tcb->CWnd += MIN (Acked, (UINT32) (2 * Tcb->SndMss));
+}
@@ -0,0 +1,114 @@
+/** @file
+  Tcp congestion control header file.
+
+  Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php.
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _TCP_CONGESTION_H_
+#define _TCP_CONGESTION_H_
+
+//
+// Values of PcdTcpCongestionControl.
+//
+#define TCP_CONGESTION_NEWRENO     0
+#define TCP_CONGESTION_CUBIC       1
+
+//
+// CUBIC constants, RFC8312. C is 0.4 and beta is 0.7.
+//
+#define TCP_CUBIC_BETA_NUM         7   ///< Multiplicative decrease factor, numerator.
+#define TCP_CUBIC_BETA_DEN         10  ///< Multiplicative decrease factor, denominator.
+#define TCP_CUBIC_MAX_TIME         1000000 ///< Max time offset in the cubic function, in ms.
+
+/**
+  Initialize the congestion control state of a TCP connection.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+typedef
+VOID
+(*TCP_CONGESTION_INIT) (
+  IN OUT TCP_CB *Tcb
+  );
+
+/**
+  Open the congestion window when new data is acknowledged
+  outside of fast recovery.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Acked    The number of bytes newly acknowledged.
+
+**/
+typedef
+VOID
+(*TCP_CONGESTION_ON_ACK) (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Acked
+  );
+
+/**
+  Compute the slow start threshold when a loss is detected, either by
+  duplicate ACKs or by a retransmission timeout.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold, in bytes.
+
+**/
+typedef
+UINT32
+(*TCP_CONGESTION_SSTHRESH) (
+  IN OUT TCP_CB *Tcb
+  );
+
+///
+/// The operations of a congestion control algorithm. The loss recovery,
+/// NewReno fast recovery with the partial ACK handling of RFC6582 and the
+/// SACK based retransmission, is shared by all the algorithms.
+///
+struct _TCP_CONGESTION_OPS {
+  CHAR8                     *Name;
+  TCP_CONGESTION_INIT       Init;
+  TCP_CONGESTION_ON_ACK     OnAck;
+  TCP_CONGESTION_SSTHRESH   Ssthresh;
+};
+
+extern CONST TCP_CONGESTION_OPS  mTcpNewRenoOps;
+extern CONST TCP_CONGESTION_OPS  mTcpCubicOps;
+
+/**
+  Get the congestion control algorithm selected by PcdTcpCongestionControl.
+
+  @return The operations of the congestion control algorithm.
+
+**/
+CONST TCP_CONGESTION_OPS *
+TcpGetCongestionOps (
+  VOID
+  );
+
+/**
+  Open the congestion window in slow start, by the number of bytes
+  acknowledged as specified in RFC3465.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Acked    The number of bytes newly acknowledged.
+
+**/
+VOID
+TcpSlowStart (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Acked
+  );
+
+#endif
@@ -0,0 +1,275 @@
+/** @file
+  CUBIC congestion control as specified in RFC8312.
+
+  The congestion window grows as a cubic function of the time since the last
+  reduction, so it quickly returns to the window where the loss happened,
+  stays around it for a while, then probes for more bandwidth. The growth
+  does not depend on the RTT, which suits long fat networks.
+
+  Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php.
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "TcpMain.h"
+
+/**
+  Compute the integer cube root of a value.
+
+  @param[in]  Value    The value, less than 2^63.
+
+  @return The largest integer whose cube is not above Value.
+
+**/
+UINT32
+TcpCubicRoot (
+  IN UINT64 Value
+  )
+{
+  UINT64  Low;
+  UINT64  High;
+  UINT64  Mid;
+
+  //
+  // The cube of 2^21 is 2^63.
+  //
+  Low   = 0;
+  High  = 1 << 21;
+
+  while (Low + 1 < High) {
+    Mid = (Low + High) >> 1;
+
+    if (MultU64x64 (MultU64x64 (Mid, Mid), Mid) <= Value) {
+      Low = Mid;
+    } else {
+      High = Mid;
+    }
+  }
+
+  return (UINT32) Low;
+}
+
+/**
+  Initialize the CUBIC state of a TCP connection.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpCubicInit (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  Tcb->CubicWMax    = 0;
+  Tcb->CubicOrigin  = 0;
+  Tcb->CubicK       = 0;
+  Tcb->CubicEpoch   = 0;
+  Tcb->CubicEpochOn = FALSE;
+  Tcb->CubicWEst    = 0;
+}
+
+/**
+  Start a congestion avoidance epoch, that is, place the cubic
+  function so that it reaches CubicWMax after CubicK ms.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Now      The current time, in ms.
+
+**/
+VOID
+TcpCubicStartEpoch (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Now
+  )
+{
+  Tcb->CubicEpochOn = TRUE;
+  Tcb->CubicEpoch   = Now;
+  Tcb->CubicWEst    = Tcb->CWnd;
+
+  if (Tcb->CWnd < Tcb->CubicWMax) {
+    //
+    // K = cubic_root ((WMax - CWnd) / C) seconds with the windows
+    // in segments. In ms, K^3 = (WMax - CWnd) / SMSS * 2.5 * 10^9.
+    //
+    Tcb->CubicK = TcpCubicRoot (
+                    DivU64x32 (
+                      MultU64x32 (Tcb->CubicWMax - Tcb->CWnd, 2500000000U),
+                      Tcb->SndMss
+                      )
+                    );
+    Tcb->CubicOrigin = Tcb->CubicWMax;
+  } else {
+    Tcb->CubicK      = 0;
+    Tcb->CubicOrigin = Tcb->CWnd;
+  }
+}
+
+/**
+  Compute the window of the cubic function, W(t) = C * (t - K)^3 + WMax.
+
+  @param[in]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]  Time     The time t since the start of the epoch, in ms.
+
+  @return The window, in bytes.
+
+**/
+UINT32
+TcpCubicWindow (
+  IN TCP_CB *Tcb,
+  IN UINT32 Time
+  )
+{
+  UINT64  Offset;
+  UINT64  Delta;
+  BOOLEAN Below;
+
+  Below = (BOOLEAN) (Time < Tcb->CubicK);
+  if (Below) {
+    Offset = Tcb->CubicK - Time;
+  } else {
+    Offset = Time - Tcb->CubicK;
+  }
+
+  Offset = MIN (Offset, TCP_CUBIC_MAX_TIME);
+
+  //
+  // C * Offset^3 in segments is Offset^3 / (2.5 * 10^9) with Offset in
+  // ms. Divide early to keep the product in 64 bits.
+  //
+  Delta = DivU64x32 (MultU64x64 (MultU64x64 (Offset, Offset), Offset), 1000000);
+  Delta = DivU64x32 (MultU64x32 (Delta, Tcb->SndMss), 2500);
+
+  if (Below) {
+    return (UINT32) (Tcb->CubicOrigin - MIN (Delta, Tcb->CubicOrigin));
+  }
+
+  return (UINT32) MIN (Tcb->CubicOrigin + Delta, MAX_UINT32);
+}
+
+/**
+  Open the congestion window as specified in RFC8312.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Acked    The number of bytes newly acknowledged.
+
+**/
+VOID
+TcpCubicOnAck (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Acked
+  )
+{
+  UINT32  Now;
+  UINT32  Target;
+  UINT32  Increase;
+
+  if (Tcb->CWnd < Tcb->Ssthresh) {
+
+    TcpSlowStart (Tcb, Acked);
+    return;
+  }
+
+  Now = TcpGetTimeMs ();
+
+  if (!Tcb->CubicEpochOn) {
+    TcpCubicStartEpoch (Tcb, Now);
+  }
+
+  //
+  // Aim at the window the cubic function gives one RTT
+  // from now, but grow by at most half of CWnd per RTT.
+  //
+  Target = TcpCubicWindow (
+             Tcb,
+             TCP_SUB_TIME (Now, Tcb->CubicEpoch) + (Tcb->SRttMs >> TCP_RTT_SHIFT)
+             );
+
+  Target = MIN (Target, Tcb->CWnd + (Tcb->CWnd >> 1));
+
+  if (Target > Tcb->CWnd) {
+    //
+    // Concave and convex regions: increase by
+    // (Target - CWnd) / CWnd per segment acknowledged.
+    //
+    Increase = (UINT32) DivU64x32 (
+                          MultU64x32 (Target - Tcb->CWnd, MIN (Acked, Tcb->CWnd)),
+                          Tcb->CWnd
+                          );
+  } else {
+    //
+    // Around WMax: probe slowly, 1% of SMSS per RTT.
+    //
+    Increase = Tcb->SndMss * Tcb->SndMss / (100 * Tcb->CWnd);
+  }
+
+  Tcb->CWnd += Increase;
+
+  //
+  // TCP friendly region: never grow slower than standard
+  // TCP would with the same decrease factor, that is, by
+  // 3 * (1 - beta) / (1 + beta) = 9 / 17 SMSS per RTT.
+  //
+  Tcb->CubicWEst += (UINT32) MAX (
+                               DivU64x32 (
+                                 MultU64x32 (9 * Tcb->SndMss, MIN (Acked, Tcb->CubicWEst)),
+                                 17 * Tcb->CubicWEst
+                                 ),
+                               1
+                               );
+
+  if (Tcb->CubicWEst > Tcb->CWnd) {
+    Tcb->CWnd = Tcb->CubicWEst;
+  }
+}
+
+/**
+  Compute the slow start threshold as specified in RFC8312, and
+  remember the window where the loss happened.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold, in bytes.
+
+**/
+UINT32
+TcpCubicSsthresh (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  Tcb->CubicEpochOn = FALSE;
+
+  //
+  // Fast convergence: if the loss happened below the previous
+  // WMax, another flow is taking bandwidth, release more.
+  //
+  if (Tcb->CWnd < Tcb->CubicWMax) {
+    Tcb->CubicWMax = (UINT32) DivU64x32 (
+                                MultU64x32 (Tcb->CWnd, TCP_CUBIC_BETA_DEN + TCP_CUBIC_BETA_NUM),
+                                2 * TCP_CUBIC_BETA_DEN
+                                );
+  } else {
+    Tcb->CubicWMax = Tcb->CWnd;
+  }
+
+  return MAX (
+           (UINT32) DivU64x32 (
+                      MultU64x32 (Tcb->CWnd, TCP_CUBIC_BETA_NUM),
+                      TCP_CUBIC_BETA_DEN
+                      ),
+           (UINT32) (2 * Tcb->SndMss)
+           );
+}
+
+CONST TCP_CONGESTION_OPS  mTcpCubicOps = {
+  "cubic",
+  TcpCubicInit,
+  TcpCubicOnAck,
+  TcpCubicSsthresh
+};
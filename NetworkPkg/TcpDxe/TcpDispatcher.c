@@ -567,12 +567,15 @@ TcpConfigurePcb (
   Tcb->RcvMss           = TcpGetRcvMss (Sk);
 
   Tcb->SRtt             = 0;
+  Tcb->SRttMs           = 0;
   Tcb->Rto              = 3 * TCP_TICK_HZ;
 
   Tcb->CWnd             = Tcb->SndMss;
   Tcb->Ssthresh         = 0xffffffff;
 
   Tcb->CongestState     = TCP_CONGEST_OPEN;
+  Tcb->CongestOps       = TcpGetCongestionOps ();
+  Tcb->CongestOps->Init (Tcb);
 
   Tcb->KeepAliveIdle    = TCP_KEEPALIVE_IDLE_MIN;
   Tcb->KeepAlivePeriod  = TCP_KEEPALIVE_PERIOD;
@@ -620,7 +623,7 @@ TcpConfigurePcb (
       Sk,
       (UINT32) (TCP_COMP_VAL (
                   TCP_RCV_BUF_SIZE_MIN,
-                  TCP_RCV_BUF_SIZE,
+                  TCP_RCV_BUF_SIZE_MAX,
                   TCP_RCV_BUF_SIZE,
                   Option->ReceiveBufferSize
                   )
@@ -630,7 +633,7 @@ TcpConfigurePcb (
       Sk,
       (UINT32) (TCP_COMP_VAL (
                   TCP_SND_BUF_SIZE_MIN,
-                  TCP_SND_BUF_SIZE,
+                  TCP_SND_BUF_SIZE_MAX,
                   TCP_SND_BUF_SIZE,
                   Option->SendBufferSize
                   )
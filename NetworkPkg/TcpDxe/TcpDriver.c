@@ -89,6 +89,10 @@ EFI_SERVICE_BINDING_PROTOCOL  gTcpServiceBinding = {
   TcpServiceBindingDestroyChild
 };
 
+EDKII_TCP_STATISTICS_PROTOCOL mTcpStatistics = {
+  TcpStatisticsGetConnections
+};
+
 
 /**
   Create and start the heartbeat timer for the TCP driver.
@@ -223,6 +227,57 @@ TcpDriverEntryPoint (
   mTcp4RandomPort = (UINT16) (TCP_PORT_KNOWN + (NET_RANDOM (Seed) % TCP_PORT_KNOWN));
   mTcp6RandomPort = mTcp4RandomPort;
 
+  //
+  // The statistics are optional, don't fail the driver if they can't be installed.
+  //
+  gBS->InstallMultipleProtocolInterfaces (
+         &ImageHandle,
+         &gEdkiiTcpStatisticsProtocolGuid,
+         &mTcpStatistics,
+         NULL
+         );
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Unload the Tcp driver: stop the driver on all the controllers, uninstall
+  the driver bindings and the TCP statistics protocol.
+
+  @param[in]  ImageHandle   The driver's image handle.
+
+  @retval EFI_SUCCESS   The driver was unloaded.
+  @retval other         The driver could not be unloaded.
+
+**/
+EFI_STATUS
+EFIAPI
+TcpDriverUnload (
+  IN EFI_HANDLE  ImageHandle
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Statistics;
+
+  Status = NetLibDefaultUnload (ImageHandle);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->HandleProtocol (
+                  ImageHandle,
+                  &gEdkiiTcpStatisticsProtocolGuid,
+                  &Statistics
+                  );
+  if (!EFI_ERROR (Status)) {
+    gBS->UninstallMultipleProtocolInterfaces (
+           ImageHandle,
+           &gEdkiiTcpStatisticsProtocolGuid,
+           &mTcpStatistics,
+           NULL
+           );
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -70,6 +70,22 @@ TcpDriverEntryPoint (
   IN EFI_SYSTEM_TABLE  *SystemTable
   );
 
+/**
+  Unload the Tcp driver: stop the driver on all the controllers, uninstall
+  the driver bindings and the TCP statistics protocol.
+
+  @param[in]  ImageHandle   The driver's image handle.
+
+  @retval EFI_SUCCESS   The driver was unloaded.
+  @retval other         The driver could not be unloaded.
+
+**/
+EFI_STATUS
+EFIAPI
+TcpDriverUnload (
+  IN EFI_HANDLE  ImageHandle
+  );
+
 //
 // Function prototypes for the Driver Binding Protocol
 //
@@ -17,6 +17,7 @@
 #define _TCP_FUNC_H_
 
 #include "TcpOption.h"
+#include "TcpCongestion.h"
 
 #define TCP_COMP_VAL(Min, Max, Default, Val) \
   ((((Val) <= (Max)) && ((Val) >= (Min))) ? (Val) : (Default))
@@ -214,6 +215,17 @@ TcpOnAppConnect (
   IN OUT TCP_CB  *Tcb
   );
 
+/**
+  Grow the receive buffer if the application consumes data fast.
+
+  @param[in, out]  Tcb        Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpRcvAutoTune (
+  IN OUT TCP_CB *Tcb
+  );
+
 /**
   Application has consumed some data, check whether
   to send a window update ack or a delayed ack.
@@ -366,6 +378,23 @@ TcpRetransmit (
   IN TCP_SEQNO Seq
   );
 
+/**
+  Retransmit the next hole in the data SACKed by the peer, RFC6675.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Una     The first unacknowledged sequence number.
+
+  @retval 1       A segment was retransmitted.
+  @retval 0       There is no hole to retransmit.
+  @retval -1      An error condition occurred.
+
+**/
+INTN
+TcpSackRetransmit (
+  IN OUT TCP_CB    *Tcb,
+  IN     TCP_SEQNO Una
+  );
+
 /**
   Check whether to send data/SYN/FIN and piggyback an ACK.
 
@@ -595,6 +624,17 @@ TcpSetKeepaliveTimer (
   IN OUT TCP_CB *Tcb
   );
 
+/**
+  Get the current time of the millisecond clock of TCP.
+
+  @return The current time, in ms. It wraps around as the sequence number does.
+
+**/
+UINT32
+TcpGetTimeMs (
+  VOID
+  );
+
 //
 // Functions in TcpIo.c
 //
@@ -59,10 +59,9 @@ TcpFastRecover (
     //
     // Step 1A: Invoking fast retransmission.
     //
-    FlightSize        = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
-
-    Tcb->Ssthresh     = MAX (FlightSize >> 1, (UINT32) (2 * Tcb->SndMss));
+    Tcb->Ssthresh     = Tcb->CongestOps->Ssthresh (Tcb);
     Tcb->Recover      = Tcb->SndNxt;
+    Tcb->FastRetxCount++;
 
     Tcb->CongestState = TCP_CONGEST_RECOVER;
     TCP_CLEAR_FLG (Tcb->CtrlFlag, TCP_CTRL_RTT_ON);
@@ -70,7 +69,13 @@ TcpFastRecover (
     //
     // Step 2: Entering fast retransmission
     //
-    TcpRetransmit (Tcb, Tcb->SndUna);
+    if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK)) {
+      Tcb->SndSackRetx = Tcb->SndUna;
+      TcpSackRetransmit (Tcb, Tcb->SndUna);
+    } else {
+      TcpRetransmit (Tcb, Tcb->SndUna);
+    }
+
     Tcb->CWnd = Tcb->Ssthresh + 3 * Tcb->SndMss;
 
     DEBUG (
@@ -90,12 +95,18 @@ TcpFastRecover (
     //
     // Step 3: Fast Recovery,
     // If this is a duplicated ACK, increse Cwnd by SMSS.
+    // With SACK, retransmit the next hole instead, the
+    // duplicated ACK tells that a segment left the network.
     //
 
     // Step 4 is skipped here only to be executed later
     // by TcpToSendData
     //
-    Tcb->CWnd += Tcb->SndMss;
+    if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK) ||
+        (TcpSackRetransmit (Tcb, Tcb->SndUna) != 1)) {
+
+      Tcb->CWnd += Tcb->SndMss;
+    }
     DEBUG (
       (EFI_D_NET,
       "TcpFastRecover: received another duplicated ACK (%d) for TCB %p\n",
@@ -132,9 +143,16 @@ TcpFastRecover (
       //
       // Step 5 - Partial ACK:
       // fast retransmit the first unacknowledge field
-      // , then deflate the CWnd
+      // , then deflate the CWnd. With SACK, the first
+      // unacknowledged field may have been retransmitted
+      // already, retransmit the next hole then.
       //
-      TcpRetransmit (Tcb, Seg->Ack);
+      if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK)) {
+        TcpSackRetransmit (Tcb, Seg->Ack);
+      } else {
+        TcpRetransmit (Tcb, Seg->Ack);
+      }
+
       Acked = TCP_SUB_SEQ (Seg->Ack, Tcb->SndUna);
 
       //
@@ -147,7 +165,15 @@ TcpFastRecover (
 
       }
 
-      Tcb->CWnd -= Acked;
+      //
+      // The CWnd is not inflated for the holes retransmitted
+      // with SACK, don't deflate it below one SMSS.
+      //
+      if (Tcb->CWnd > Acked + Tcb->SndMss) {
+        Tcb->CWnd -= Acked;
+      } else {
+        Tcb->CWnd = Tcb->SndMss;
+      }
 
       DEBUG (
         (EFI_D_NET,
@@ -211,20 +237,105 @@ TcpFastLossRecover (
   }
 }
 
+/**
+  Update the SACK scoreboard with the SACK blocks received from the peer,
+  as specified in RFC2018 and RFC6675.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Seg      The segment that carries the SACK blocks.
+  @param[in]       Option   The options parsed from the segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_SEG    *Seg,
+  IN     TCP_OPTION *Option
+  )
+{
+  LIST_ENTRY      *Entry;
+  NET_BUF         *Node;
+  TCP_SEG         *SndSeg;
+  TCP_SACK_BLOCK  *Block;
+  TCP_SEQNO       MaxSndNxt;
+  UINTN           Index;
+
+  if (TCP_SEQ_LT (Tcb->SndSackHigh, Seg->Ack)) {
+    Tcb->SndSackHigh = Seg->Ack;
+  }
+
+  if (!TCP_FLG_ON (Option->Flag, TCP_OPTION_RCVD_SACK)) {
+    return;
+  }
+
+  MaxSndNxt = TcpGetMaxSndNxt (Tcb);
+
+  for (Index = 0; Index < Option->SackNum; Index++) {
+    Block = &Option->SackBlock[Index];
+
+    //
+    // Ignore the blocks that are malformed, acknowledged
+    // already, or beyond the data sent.
+    //
+    if (TCP_SEQ_GEQ (Block->Start, Block->End) ||
+        TCP_SEQ_LEQ (Block->Start, Seg->Ack) ||
+        TCP_SEQ_GT (Block->End, MaxSndNxt)) {
+
+      continue;
+    }
+
+    //
+    // Mark the segments that are covered by the block. The
+    // segments partly covered are retransmitted as a whole.
+    //
+    NET_LIST_FOR_EACH (Entry, &Tcb->SndQue) {
+      Node    = NET_LIST_USER_STRUCT (Entry, NET_BUF, List);
+      SndSeg  = TCPSEG_NETBUF (Node);
+
+      if (TCP_SEQ_GEQ (SndSeg->Seq, Block->End)) {
+        break;
+      }
+
+      if (TCP_SEQ_GEQ (SndSeg->Seq, Block->Start) && TCP_SEQ_LEQ (SndSeg->End, Block->End)) {
+        SndSeg->Sacked = TRUE;
+      }
+    }
+
+    if (TCP_SEQ_GT (Block->End, Tcb->SndSackHigh)) {
+      Tcb->SndSackHigh = Block->End;
+    }
+  }
+}
+
 /**
   Compute the RTT as specified in RFC2988.
 
   @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
-  @param[in]       Measure  Currently measured RTT in heartbeats.
+  @param[in]       MeasureMs  Currently measured RTT in milliseconds.
 
 **/
 VOID
 TcpComputeRtt (
   IN OUT TCP_CB *Tcb,
-  IN     UINT32 Measure
+  IN     UINT32 MeasureMs
   )
 {
-  INT32 Var;
+  INT32   Var;
+  INT32   VarMs;
+  UINT32  Measure;
+
+  //
+  // The smoothed RTT in milliseconds is kept for the congestion
+  // control and the statistics, the RTO stays in heartbeats.
+  //
+  if (Tcb->SRttMs != 0) {
+    VarMs       = (INT32) MeasureMs - (INT32) (Tcb->SRttMs >> TCP_RTT_SHIFT);
+    Tcb->SRttMs = (UINT32) ((INT32) Tcb->SRttMs + VarMs);
+  } else {
+    Tcb->SRttMs = MAX (MeasureMs, 1) << TCP_RTT_SHIFT;
+  }
+
+  Measure = (MeasureMs + TCP_TICK / 2) / TCP_TICK;
 
   //
   // Step 2.3: Compute the RTO for subsequent RTT measurement.
@@ -599,6 +710,12 @@ TcpQueueData (
   Seg   = TCPSEG_NETBUF (Nbuf);
   Head  = &Tcb->RcvQue;
 
+  //
+  // Remember the latest segment, the SACK block that
+  // contains it is reported first.
+  //
+  Tcb->RcvSackSeq = Seg->Seq;
+
   //
   // Fast path to process normal case. That is,
   // no out-of-order segments are received.
@@ -1005,7 +1122,7 @@ TcpInput (
             TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RTT_ON))
         {
 
-          TcpComputeRtt (Tcb, Tcb->RttMeasure);
+          TcpComputeRtt (Tcb, Tcb->RttMeasure * TCP_TICK);
           TCP_CLEAR_FLG (Tcb->CtrlFlag, TCP_CTRL_RTT_ON);
         }
 
@@ -1250,13 +1367,13 @@ TcpInput (
       Tcb->TsRecentAge  = mTcpTick;
     }
 
-    TcpComputeRtt (Tcb, TCP_SUB_TIME (mTcpTick, Option.TSEcr));
+    TcpComputeRtt (Tcb, TCP_SUB_TIME (TcpGetTimeMs (), Option.TSEcr));
 
   } else if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RTT_ON)) {
 
     ASSERT (Tcb->CongestState == TCP_CONGEST_OPEN);
 
-    TcpComputeRtt (Tcb, Tcb->RttMeasure);
+    TcpComputeRtt (Tcb, Tcb->RttMeasure * TCP_TICK);
     TCP_CLEAR_FLG (Tcb->CtrlFlag, TCP_CTRL_RTT_ON);
   }
 
@@ -1268,6 +1385,10 @@ TcpInput (
     TcpSetTimer (Tcb, TCP_TIMER_REXMIT, Tcb->Rto);
   }
 
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK)) {
+    TcpSackUpdate (Tcb, Seg, &Option);
+  }
+
   //
   // Count duplicate acks.
   //
@@ -1292,13 +1413,7 @@ TcpInput (
 
     if (TCP_SEQ_GT (Seg->Ack, Tcb->SndUna)) {
 
-      if (Tcb->CWnd < Tcb->Ssthresh) {
-
-        Tcb->CWnd += Tcb->SndMss;
-      } else {
-
-        Tcb->CWnd += MAX (Tcb->SndMss * Tcb->SndMss / Tcb->CWnd, 1);
-      }
+      Tcb->CongestOps->OnAck (Tcb, TCP_SUB_SEQ (Seg->Ack, Tcb->SndUna));
 
       Tcb->CWnd = MIN (Tcb->CWnd, TCP_MAX_WIN << Tcb->SndWndScale);
     }
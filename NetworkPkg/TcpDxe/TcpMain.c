@@ -1110,3 +1110,118 @@ Tcp6Poll (
   return Status;
 }
 
+
+/**
+  Fill the statistics of one TCP connection.
+
+  @param[in]   Tcb               Pointer to the TCP_CB of the connection.
+  @param[out]  Stats             The statistics to fill.
+
+**/
+VOID
+TcpFillStatistics (
+  IN  TCP_CB                           *Tcb,
+  OUT EDKII_TCP_CONNECTION_STATISTICS  *Stats
+  )
+{
+  Stats->IpVersion          = Tcb->Sk->IpVersion;
+  Stats->State              = Tcb->State;
+  Stats->LocalPort          = NTOHS (Tcb->LocalEnd.Port);
+  Stats->RemotePort         = NTOHS (Tcb->RemoteEnd.Port);
+  Stats->Mss                = Tcb->SndMss;
+  CopyMem (&Stats->LocalAddress, &Tcb->LocalEnd.Ip, sizeof (EFI_IP_ADDRESS));
+  CopyMem (&Stats->RemoteAddress, &Tcb->RemoteEnd.Ip, sizeof (EFI_IP_ADDRESS));
+
+  if (Tcb->CongestOps != NULL) {
+    AsciiStrCpyS (
+      Stats->CongestionControl,
+      EDKII_TCP_CONGESTION_CONTROL_NAME_SIZE,
+      Tcb->CongestOps->Name
+      );
+  }
+
+  Stats->CongestionWindow   = Tcb->CWnd;
+  Stats->SlowStartThreshold = Tcb->Ssthresh;
+  Stats->SendWindow         = Tcb->SndWnd;
+  Stats->ReceiveWindow      = Tcb->RcvWnd;
+  Stats->SmoothedRtt        = Tcb->SRttMs >> TCP_RTT_SHIFT;
+  Stats->Rto                = Tcb->Rto * TCP_TICK;
+  Stats->Retransmits        = Tcb->RetxCount;
+  Stats->FastRetransmits    = Tcb->FastRetxCount;
+  Stats->Timeouts           = Tcb->TimeoutCount;
+}
+
+/**
+  Get the statistics of the TCP connections.
+
+  @param[in]  This               Pointer to the EDKII_TCP_STATISTICS_PROTOCOL instance.
+  @param[out] Count              On return, the number of entries in Connections.
+  @param[out] Connections        On return, the statistics of each connection. The
+                                 caller frees the buffer with FreePool().
+
+  @retval EFI_SUCCESS            The statistics were returned.
+  @retval EFI_NOT_FOUND          There is no TCP connection.
+  @retval EFI_INVALID_PARAMETER  Count or Connections is NULL.
+  @retval EFI_OUT_OF_RESOURCES   Failed to allocate the statistics.
+
+**/
+EFI_STATUS
+EFIAPI
+TcpStatisticsGetConnections (
+  IN  EDKII_TCP_STATISTICS_PROTOCOL     *This,
+  OUT UINTN                             *Count,
+  OUT EDKII_TCP_CONNECTION_STATISTICS   **Connections
+  )
+{
+  LIST_ENTRY                       *Entry;
+  TCP_CB                           *Tcb;
+  UINTN                            Number;
+  UINTN                            Index;
+  EDKII_TCP_CONNECTION_STATISTICS  *Stats;
+  EFI_TPL                          OldTpl;
+
+  if ((Count == NULL) || (Connections == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // The queues are changed at TPL_CALLBACK, by the DPCs of TCP.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  Number = 0;
+  NET_LIST_FOR_EACH (Entry, &mTcpRunQue) {
+    Number++;
+  }
+  NET_LIST_FOR_EACH (Entry, &mTcpListenQue) {
+    Number++;
+  }
+
+  if (Number == 0) {
+    gBS->RestoreTPL (OldTpl);
+    return EFI_NOT_FOUND;
+  }
+
+  Stats = AllocateZeroPool (Number * sizeof (EDKII_TCP_CONNECTION_STATISTICS));
+  if (Stats == NULL) {
+    gBS->RestoreTPL (OldTpl);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Index = 0;
+  NET_LIST_FOR_EACH (Entry, &mTcpListenQue) {
+    Tcb = NET_LIST_USER_STRUCT (Entry, TCP_CB, List);
+    TcpFillStatistics (Tcb, &Stats[Index++]);
+  }
+  NET_LIST_FOR_EACH (Entry, &mTcpRunQue) {
+    Tcb = NET_LIST_USER_STRUCT (Entry, TCP_CB, List);
+    TcpFillStatistics (Tcb, &Stats[Index++]);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  *Count       = Number;
+  *Connections = Stats;
+
+  return EFI_SUCCESS;
+}
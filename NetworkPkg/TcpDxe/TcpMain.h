@@ -19,9 +19,12 @@
 
 #include <Protocol/ServiceBinding.h>
 #include <Protocol/DriverBinding.h>
+#include <Protocol/TcpStatistics.h>
 #include <Library/IpIoLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
 
 #include "Socket.h"
 #include "TcpProto.h"
@@ -780,4 +783,26 @@ Tcp6Poll (
   IN EFI_TCP6_PROTOCOL        *This
   );
 
+/**
+  Get the statistics of the TCP connections.
+
+  @param[in]  This               Pointer to the EDKII_TCP_STATISTICS_PROTOCOL instance.
+  @param[out] Count              On return, the number of entries in Connections.
+  @param[out] Connections        On return, the statistics of each connection. The
+                                 caller frees the buffer with FreePool().
+
+  @retval EFI_SUCCESS            The statistics were returned.
+  @retval EFI_NOT_FOUND          There is no TCP connection.
+  @retval EFI_INVALID_PARAMETER  Count or Connections is NULL.
+  @retval EFI_OUT_OF_RESOURCES   Failed to allocate the statistics.
+
+**/
+EFI_STATUS
+EFIAPI
+TcpStatisticsGetConnections (
+  IN  EDKII_TCP_STATISTICS_PROTOCOL     *This,
+  OUT UINTN                             *Count,
+  OUT EDKII_TCP_CONNECTION_STATISTICS   **Connections
+  );
+
 #endif
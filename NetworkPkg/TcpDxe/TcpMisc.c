@@ -80,6 +80,9 @@ TcpInitTcbLocal (
   Tcb->SndWl2 = Tcb->Iss;
   Tcb->SndWnd = 536;
 
+  Tcb->SndSackHigh = Tcb->Iss;
+  Tcb->SndSackRetx = Tcb->Iss;
+
   Tcb->RcvWnd = GET_RCV_BUFFSIZE (Tcb->Sk);
 
   //
@@ -143,6 +146,10 @@ TcpInitTcbPeer (
 
   Tcb->RcvWl2 = Tcb->RcvNxt;
 
+  Tcb->RcvSackSeq  = Tcb->RcvNxt;
+  Tcb->RcvAutoSeq  = Tcb->RcvNxt;
+  Tcb->RcvAutoTime = mTcpTick;
+
   if (TCP_FLG_ON (Opt->Flag, TCP_OPTION_RCVD_WS) && !TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_WS)) {
 
     Tcb->SndWndScale  = Opt->WndScale;
@@ -171,6 +178,11 @@ TcpInitTcbPeer (
     //
     Tcb->SndMss -= TCP_OPTION_TS_ALIGNED_LEN;
   }
+
+  if (TCP_FLG_ON (Opt->Flag, TCP_OPTION_RCVD_SACK_PERM)) {
+
+    TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_SACK);
+  }
 }
 
 /**
@@ -841,6 +853,72 @@ TcpOnAppSend (
   return 0;
 }
 
+/**
+  Grow the receive buffer if the application consumes data fast.
+
+  Once per RTT, the data consumed by the application is compared to the
+  receive buffer. If it consumed more than half of the buffer, the buffer
+  is the limit of the throughput, so it is grown to twice the data consumed,
+  up to TCP_RCV_BUF_SIZE_MAX and to the largest window the window scale can
+  advertise.
+
+  @param[in, out]  Tcb        Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpRcvAutoTune (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  SOCKET    *Sk;
+  TCP_SEQNO Consumed;
+  UINT32    Copied;
+  UINT32    BufSize;
+  UINT32    MaxSize;
+  UINT32    Rtt;
+
+  Sk  = Tcb->Sk;
+
+  //
+  // SRtt is measured in heartbeats, sample at least once per heartbeat.
+  //
+  Rtt = MAX (Tcb->SRtt >> TCP_RTT_SHIFT, 1);
+  if (TCP_SUB_TIME (mTcpTick, Tcb->RcvAutoTime) < Rtt) {
+    return;
+  }
+
+  //
+  // Everything before RcvNxt that is no longer in the
+  // socket buffer is consumed by the application.
+  //
+  Consumed  = Tcb->RcvNxt - GET_RCV_DATASIZE (Sk);
+  Copied    = TCP_SUB_SEQ (Consumed, Tcb->RcvAutoSeq);
+
+  Tcb->RcvAutoSeq  = Consumed;
+  Tcb->RcvAutoTime = mTcpTick;
+
+  BufSize = GET_RCV_BUFFSIZE (Sk);
+  MaxSize = MIN (TCP_RCV_BUF_SIZE_MAX, (UINT32) TCP_OPTION_MAX_WIN << Tcb->RcvWndScale);
+
+  if ((Copied <= BufSize / 2) || (BufSize >= MaxSize)) {
+    return;
+  }
+
+  BufSize = MaxSize;
+  if (Copied < MaxSize / 2) {
+    BufSize = 2 * Copied;
+  }
+
+  SET_RCV_BUFFSIZE (Sk, BufSize);
+
+  DEBUG (
+    (EFI_D_NET,
+    "TcpRcvAutoTune: grow the receive buffer to %d for Tcb %p\n",
+    BufSize,
+    Tcb)
+    );
+}
+
 /**
   Application has consumed some data. Check whether
   to send a window update ack or a delayed ack.
@@ -857,6 +935,8 @@ TcpOnAppConsume (
 
   switch (Tcb->State) {
   case TCP_ESTABLISHED:
+    TcpRcvAutoTune (Tcb);
+
     TcpOld = TcpRcvWinOld (Tcb);
     if (TcpRcvWinNow (Tcb) > TcpOld) {
 
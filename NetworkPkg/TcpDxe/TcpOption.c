@@ -86,7 +86,11 @@ TcpComputeScale (
 
   ASSERT ((Tcb != NULL) && (Tcb->Sk != NULL));
 
-  BufSize = GET_RCV_BUFFSIZE (Tcb->Sk);
+  //
+  // The receive buffer is auto-tuned up to TCP_RCV_BUF_SIZE_MAX after the
+  // connection is established, so scale for that size.
+  //
+  BufSize = MAX (GET_RCV_BUFFSIZE (Tcb->Sk), TCP_RCV_BUF_SIZE_MAX);
 
   Scale   = 0;
   while ((Scale < TCP_OPTION_MAX_WS) && ((UINT32) (TCP_OPTION_MAX_WIN << Scale) < BufSize)) {
@@ -139,7 +143,7 @@ TcpSynBuildOption (
     Len += TCP_OPTION_TS_ALIGNED_LEN;
 
     TcpPutUint32 (Data, TCP_OPTION_TS_FAST);
-    TcpPutUint32 (Data + 4, mTcpTick);
+    TcpPutUint32 (Data + 4, TcpGetTimeMs ());
     TcpPutUint32 (Data + 8, 0);
   }
 
@@ -165,6 +169,26 @@ TcpSynBuildOption (
     TcpPutUint32 (Data, TCP_OPTION_WS_FAST | TcpComputeScale (Tcb));
   }
 
+  //
+  // Build SACK permitted option if we are doing active
+  // open or we have received it from peer.
+  //
+  if (!TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_ACK) ||
+      TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK)
+      ) {
+
+    Data = NetbufAllocSpace (
+             Nbuf,
+             TCP_OPTION_SACK_PERM_ALIGNED_LEN,
+             NET_BUF_HEAD
+             );
+
+    ASSERT (Data != NULL);
+
+    Len += TCP_OPTION_SACK_PERM_ALIGNED_LEN;
+    TcpPutUint32 (Data, TCP_OPTION_SACK_PERM_FAST);
+  }
+
   //
   // Build the MSS option.
   //
@@ -177,6 +201,109 @@ TcpSynBuildOption (
   return Len;
 }
 
+/**
+  Add a block to the SACK blocks to report. The block that contains the
+  latest out-of-order segment is put first, as required by RFC2018.
+
+  @param[in]       Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in, out]  Block   The SACK blocks collected so far.
+  @param[in]       Num     The number of blocks in Block.
+  @param[in]       MaxNum  The maximum number of blocks in Block.
+  @param[in]       Start   The sequence of the first byte of the block.
+  @param[in]       End     The sequence of the last byte + 1 of the block.
+
+  @return                  The number of blocks in Block.
+
+**/
+UINT8
+TcpSackAddBlock (
+  IN     TCP_CB         *Tcb,
+  IN OUT TCP_SACK_BLOCK *Block,
+  IN     UINT8          Num,
+  IN     UINT8          MaxNum,
+  IN     TCP_SEQNO      Start,
+  IN     TCP_SEQNO      End
+  )
+{
+  //
+  // Data at RcvNxt is delivered, never report it.
+  //
+  if (TCP_SEQ_LEQ (Start, Tcb->RcvNxt)) {
+    return Num;
+  }
+
+  if (TCP_SEQ_LEQ (Start, Tcb->RcvSackSeq) && TCP_SEQ_LT (Tcb->RcvSackSeq, End)) {
+
+    if (Num == MaxNum) {
+      Num--;
+    }
+
+    CopyMem (&Block[1], &Block[0], Num * sizeof (TCP_SACK_BLOCK));
+    Block[0].Start = Start;
+    Block[0].End   = End;
+    return (UINT8) (Num + 1);
+  }
+
+  if (Num < MaxNum) {
+    Block[Num].Start = Start;
+    Block[Num].End   = End;
+    Num++;
+  }
+
+  return Num;
+}
+
+/**
+  Build the SACK blocks to report from the out-of-order
+  segments in the reassemble queue.
+
+  @param[in]   Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[out]  Block   The SACK blocks.
+  @param[in]   MaxNum  The maximum number of blocks in Block.
+
+  @return              The number of blocks in Block.
+
+**/
+UINT8
+TcpSackBuildBlocks (
+  IN  TCP_CB         *Tcb,
+  OUT TCP_SACK_BLOCK *Block,
+  IN  UINT8          MaxNum
+  )
+{
+  LIST_ENTRY  *Entry;
+  TCP_SEG     *Seg;
+  TCP_SEQNO   Start;
+  TCP_SEQNO   End;
+  UINT8       Num;
+
+  Num   = 0;
+  Start = Tcb->RcvNxt;
+  End   = Tcb->RcvNxt;
+
+  //
+  // The reassemble queue is sorted and its segments don't
+  // overlap, merge the adjacent ones into a block.
+  //
+  NET_LIST_FOR_EACH (Entry, &Tcb->RcvQue) {
+    Seg = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+
+    if (TCP_SEQ_LEQ (Seg->Seq, End)) {
+      if (TCP_SEQ_GT (Seg->End, End)) {
+        End = Seg->End;
+      }
+
+      continue;
+    }
+
+    Num   = TcpSackAddBlock (Tcb, Block, Num, MaxNum, Start, End);
+    Start = Seg->Seq;
+    End   = Seg->End;
+  }
+
+  return TcpSackAddBlock (Tcb, Block, Num, MaxNum, Start, End);
+}
+
 /**
   Build the TCP option in synchronized states.
 
@@ -192,8 +319,12 @@ TcpBuildOption (
   IN NET_BUF *Nbuf
   )
 {
-  UINT8   *Data;
-  UINT16  Len;
+  UINT8           *Data;
+  UINT16          Len;
+  TCP_SACK_BLOCK  Block[TCP_OPTION_MAX_SACK_BLOCK];
+  UINT8           MaxNum;
+  UINT8           Num;
+  UINT8           Index;
 
   ASSERT ((Tcb != NULL) && (Nbuf != NULL) && (Nbuf->Tcp == NULL));
   Len = 0;
@@ -215,10 +346,49 @@ TcpBuildOption (
     Len += TCP_OPTION_TS_ALIGNED_LEN;
 
     TcpPutUint32 (Data, TCP_OPTION_TS_FAST);
-    TcpPutUint32 (Data + 4, mTcpTick);
+    TcpPutUint32 (Data + 4, TcpGetTimeMs ());
     TcpPutUint32 (Data + 8, Tcb->TsRecent);
   }
 
+  //
+  // Build the SACK option if the peer permits it and there are
+  // out-of-order segments. Only segments without data carry it,
+  // the size of data segments is computed without the option.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK) &&
+      (Nbuf->TotalSize == 0) &&
+      !IsListEmpty (&Tcb->RcvQue) &&
+      !TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_RST)
+      ) {
+
+    MaxNum = TCP_OPTION_MAX_SACK_BLOCK;
+    if (Len != 0) {
+      MaxNum = TCP_OPTION_MAX_SACK_BLOCK_TS;
+    }
+
+    Num = TcpSackBuildBlocks (Tcb, Block, MaxNum);
+
+    if (Num != 0) {
+      Data = NetbufAllocSpace (
+              Nbuf,
+              TCP_OPTION_SACK_ALIGNED_LEN + Num * TCP_OPTION_SACK_BLOCK_LEN,
+              NET_BUF_HEAD
+              );
+
+      ASSERT (Data != NULL);
+      Len = (UINT16) (Len + TCP_OPTION_SACK_ALIGNED_LEN + Num * TCP_OPTION_SACK_BLOCK_LEN);
+
+      TcpPutUint32 (Data, TCP_OPTION_SACK_FAST | (TCP_OPTION_SACK_LEN + Num * TCP_OPTION_SACK_BLOCK_LEN));
+      Data += TCP_OPTION_SACK_ALIGNED_LEN;
+
+      for (Index = 0; Index < Num; Index++) {
+        TcpPutUint32 (Data, Block[Index].Start);
+        TcpPutUint32 (Data + 4, Block[Index].End);
+        Data += TCP_OPTION_SACK_BLOCK_LEN;
+      }
+    }
+  }
+
   return Len;
 }
 
@@ -244,6 +414,7 @@ TcpParseOption (
   UINT8 Cur;
   UINT8 Type;
   UINT8 Len;
+  UINTN Index;
 
   ASSERT ((Tcp != NULL) && (Option != NULL));
 
@@ -319,6 +490,44 @@ TcpParseOption (
       Cur += TCP_OPTION_TS_LEN;
       break;
 
+    case TCP_OPTION_SACK_PERM:
+      Len = Head[Cur + 1];
+
+      if ((Len != TCP_OPTION_SACK_PERM_LEN) || (TotalLen - Cur < TCP_OPTION_SACK_PERM_LEN)) {
+
+        return -1;
+      }
+
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK_PERM);
+
+      Cur += TCP_OPTION_SACK_PERM_LEN;
+      break;
+
+    case TCP_OPTION_SACK:
+      Len = Head[Cur + 1];
+
+      if ((Len < TCP_OPTION_SACK_LEN + TCP_OPTION_SACK_BLOCK_LEN) ||
+          ((Len - TCP_OPTION_SACK_LEN) % TCP_OPTION_SACK_BLOCK_LEN != 0) ||
+          (TotalLen - Cur < Len)) {
+
+        return -1;
+      }
+
+      Option->SackNum = 0;
+      for (Index = Cur + TCP_OPTION_SACK_LEN;
+           (Index < Cur + Len) && (Option->SackNum < TCP_OPTION_MAX_SACK_BLOCK);
+           Index += TCP_OPTION_SACK_BLOCK_LEN) {
+
+        Option->SackBlock[Option->SackNum].Start = TcpGetUint32 (&Head[Index]);
+        Option->SackBlock[Option->SackNum].End   = TcpGetUint32 (&Head[Index + 4]);
+        Option->SackNum++;
+      }
+
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK);
+
+      Cur = (UINT8) (Cur + Len);
+      break;
+
     case TCP_OPTION_NOP:
       Cur++;
       break;
@@ -721,6 +721,8 @@ TcpRetransmit (
     Tcb->RetxmitSeqMax = Seq;
   }
 
+  Tcb->RetxCount++;
+
   //
   // The retransmitted buffer may be on the SndQue,
   // trim TCP head because all the buffers on SndQue
@@ -741,6 +743,73 @@ OnError:
   return -1;
 }
 
+/**
+  Retransmit the next hole in the data SACKed by the peer, RFC6675.
+
+  The data below the highest SACKed sequence that the peer has not SACKed
+  is considered lost. It is retransmitted one segment per call, in order,
+  starting from Una. The first unacknowledged segment is always considered
+  lost, as in NewReno.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Una     The first unacknowledged sequence number.
+
+  @retval 1       A segment was retransmitted.
+  @retval 0       There is no hole to retransmit.
+  @retval -1      An error condition occurred.
+
+**/
+INTN
+TcpSackRetransmit (
+  IN OUT TCP_CB    *Tcb,
+  IN     TCP_SEQNO Una
+  )
+{
+  LIST_ENTRY      *Entry;
+  NET_BUF         *Node;
+  TCP_SEG         *Seg;
+  TCP_SEQNO       Seq;
+
+  Seq = Tcb->SndSackRetx;
+  if (TCP_SEQ_LT (Seq, Una)) {
+    Seq = Una;
+  }
+
+  NET_LIST_FOR_EACH (Entry, &Tcb->SndQue) {
+    Node  = NET_LIST_USER_STRUCT (Entry, NET_BUF, List);
+    Seg   = TCPSEG_NETBUF (Node);
+
+    if (Seg->Sacked || TCP_SEQ_LEQ (Seg->End, Seq)) {
+      continue;
+    }
+
+    if (TCP_SEQ_LT (Seq, Seg->Seq)) {
+      Seq = Seg->Seq;
+    }
+
+    if ((Seq != Una) && TCP_SEQ_GEQ (Seq, Tcb->SndSackHigh)) {
+      break;
+    }
+
+    Tcb->SndSackRetx = Seq + MIN (Tcb->SndMss, TCP_SUB_SEQ (Seg->End, Seq));
+
+    DEBUG (
+      (EFI_D_NET,
+      "TcpSackRetransmit: retransmit the hole at %d for TCB %p\n",
+      Seq,
+      Tcb)
+      );
+
+    if (TcpRetransmit (Tcb, Seq) != 0) {
+      return -1;
+    }
+
+    return 1;
+  }
+
+  return 0;
+}
+
 /**
   Verify that all the segments in SndQue are in good shape.
 
@@ -78,6 +78,7 @@
 #define TCP_CTRL_TIMER_ON        0x1000 ///< At least one of the timer is on.
 #define TCP_CTRL_RTT_ON          0x2000 ///< The RTT measurement is on.
 #define TCP_CTRL_ACK_NOW         0x4000 ///< Send the ACK now, don't delay.
+#define TCP_CTRL_SACK            0x8000 ///< Received a SACK-permitted option in syn.
 
 //
 // Timer related values
@@ -119,8 +120,10 @@
 //
 #define TCP_RCV_BUF_SIZE         (2 * 1024 * 1024)
 #define TCP_RCV_BUF_SIZE_MIN     (8 * 1024)
+#define TCP_RCV_BUF_SIZE_MAX     (8 * 1024 * 1024)  ///< Limit of receive buffer auto-tuning.
 #define TCP_SND_BUF_SIZE         (2 * 1024 * 1024)
 #define TCP_SND_BUF_SIZE_MIN     (8 * 1024)
+#define TCP_SND_BUF_SIZE_MAX     (8 * 1024 * 1024)
 #define TCP_BACKLOG              10
 #define TCP_BACKLOG_MIN          5
 #define TCP_MAX_LOSS_MIN         6
@@ -221,6 +224,7 @@ typedef struct _TCP_SEG {
   TCP_SEQNO End;  ///< The sequence of the last byte + 1, include SYN/FIN. End-Seq = SEG.LEN.
   TCP_SEQNO Ack;  ///< ACK field in the segment.
   UINT8     Flag; ///< TCP header flags.
+  BOOLEAN   Sacked; ///< The peer has selectively acknowledged it (SndQue only).
   UINT16    Urg;  ///< Valid if URG flag is set.
   UINT32    Wnd;  ///< TCP window size field.
 } TCP_SEG;
@@ -235,6 +239,8 @@ typedef struct _TCP_PEER {
 
 typedef struct _TCP_CONTROL_BLOCK  TCP_CB;
 
+typedef struct _TCP_CONGESTION_OPS TCP_CONGESTION_OPS;
+
 ///
 /// TCP control block: it includes various states.
 ///
@@ -302,6 +308,7 @@ struct _TCP_CONTROL_BLOCK {
   UINT32            SRtt;       ///< Smoothed RTT, scaled by 8.
   UINT32            RttVar;     ///< RTT variance, scaled by 8.
   UINT32            Rto;        ///< Current RTO, not scaled.
+  UINT32            SRttMs;     ///< Smoothed RTT in milliseconds, scaled by 8.
 
   //
   // RFC2581, and 3782 variables.
@@ -314,6 +321,38 @@ struct _TCP_CONTROL_BLOCK {
   UINT8             CongestState; ///< The current congestion state(RFC3782).
   UINT8             LossTimes;    ///< Number of retxmit timeouts in a row.
   TCP_SEQNO         LossRecover;  ///< Recover point for retxmit.
+  CONST TCP_CONGESTION_OPS *CongestOps; ///< The congestion control algorithm.
+
+  //
+  // RFC8312 CUBIC variables, used when CUBIC is the
+  // congestion control algorithm.
+  //
+  UINT32            CubicWMax;    ///< CWnd before the last reduction.
+  UINT32            CubicOrigin;  ///< CWnd at the plateau of the cubic function.
+  UINT32            CubicK;       ///< Time to reach CubicOrigin, in ms.
+  UINT32            CubicEpoch;   ///< When the current epoch started, in ms.
+  BOOLEAN           CubicEpochOn; ///< If TRUE, the current epoch has started.
+  UINT32            CubicWEst;    ///< CWnd standard TCP would have.
+
+  //
+  // Statistics reported by the EDKII TCP Statistics Protocol.
+  //
+  UINT32            RetxCount;      ///< Number of segments retransmitted.
+  UINT32            FastRetxCount;  ///< Number of fast retransmissions.
+  UINT32            TimeoutCount;   ///< Number of retxmit timeouts.
+
+  //
+  // RFC2018 and RFC6675 variables, about selective acknowledgment.
+  //
+  TCP_SEQNO         RcvSackSeq;   ///< Seq of the latest out-of-order segment received.
+  TCP_SEQNO         SndSackHigh;  ///< Highest sequence SACKed by the peer.
+  TCP_SEQNO         SndSackRetx;  ///< Next sequence to retransmit in SACK recovery.
+
+  //
+  // Receive buffer auto-tuning.
+  //
+  TCP_SEQNO         RcvAutoSeq;   ///< Sequence consumed by the application at sample start.
+  UINT32            RcvAutoTime;  ///< When the current sample started.
 
   //
   // RFC7323
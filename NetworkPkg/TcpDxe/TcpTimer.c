@@ -17,6 +17,70 @@
 
 UINT32    mTcpTick = 1000;
 
+//
+// The millisecond clock used for the timestamps and the RTT samples,
+// see TcpGetTimeMs ().
+//
+UINT64    mTcpTimeNs;
+UINT64    mTcpLastCounter;
+BOOLEAN   mTcpCounterOn = FALSE;
+
+/**
+  Get the current time of the millisecond clock of TCP.
+
+  The clock runs on the performance counter, so the RTT samples taken through
+  the timestamp option are much finer than the 200ms TCP tick. It falls back
+  to the TCP tick if the platform has no performance counter.
+
+  @return The current time, in ms. It wraps around as the sequence number does.
+
+**/
+UINT32
+TcpGetTimeMs (
+  VOID
+  )
+{
+  UINT64  Counter;
+  UINT64  Start;
+  UINT64  End;
+  UINT64  Delta;
+
+  if (GetPerformanceCounterProperties (&Start, &End) == 0) {
+    return mTcpTick * TCP_TICK;
+  }
+
+  Counter = GetPerformanceCounter ();
+
+  if (!mTcpCounterOn) {
+    mTcpCounterOn   = TRUE;
+    mTcpLastCounter = Counter;
+    mTcpTimeNs      = MultU64x32 (mTcpTick, TCP_TICK * 1000000);
+  }
+
+  //
+  // The counter may count down, and it wraps around between Start and End.
+  // TcpTickingDpc () reads the clock every tick, so it wraps at most once.
+  //
+  if (Start < End) {
+    if (Counter >= mTcpLastCounter) {
+      Delta = Counter - mTcpLastCounter;
+    } else {
+      Delta = (End - mTcpLastCounter) + (Counter - Start);
+    }
+  } else {
+    if (Counter <= mTcpLastCounter) {
+      Delta = mTcpLastCounter - Counter;
+    } else {
+      Delta = (mTcpLastCounter - End) + (Start - Counter);
+    }
+  }
+
+  mTcpLastCounter  = Counter;
+  mTcpTimeNs      += GetTimeInNanoSecond (Delta);
+
+  return (UINT32) DivU64x32 (mTcpTimeNs, 1000000);
+}
+
 /**
   Connect timeout handler.
 
@@ -190,8 +254,6 @@ TcpRexmitTimeout (
   IN OUT TCP_CB *Tcb
   )
 {
-  UINT32  FlightSize;
-
   DEBUG (
     (EFI_D_WARN,
     "TcpRexmitTimeout: transmission timeout for TCB %p\n",
@@ -199,12 +261,11 @@ TcpRexmitTimeout (
     );
 
   //
-  // Set the congestion window. FlightSize is the
-  // amount of data that has been sent but not
-  // yet ACKed.
+  // Set the congestion window, the congestion control
+  // algorithm computes the slow start threshold.
   //
-  FlightSize        = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
-  Tcb->Ssthresh     = MAX ((UINT32) (2 * Tcb->SndMss), FlightSize / 2);
+  Tcb->Ssthresh     = Tcb->CongestOps->Ssthresh (Tcb);
+  Tcb->TimeoutCount++;
 
   Tcb->CWnd         = Tcb->SndMss;
   Tcb->LossRecover  = Tcb->SndNxt;
@@ -505,6 +566,12 @@ TcpTickingDpc (
   mTcpTick++;
   mTcpGlobalIss += TCP_ISS_INCREMENT_2;
 
+  //
+  // Read the millisecond clock so that it follows the wrap
+  // around of the performance counter.
+  //
+  TcpGetTimeMs ();
+
   //
   // Don't use LIST_FOR_EACH, which isn't delete safe.
   //
@@ -225,6 +225,8 @@ EfiPxeBcStart (
     Private->BlockSize   = (UINTN) PcdGet64 (PcdTftpBlockSize);
   }
 
+  Private->WindowSize = PcdGet16 (PcdTftpWindowSize);
+
   //
   // Create event for UdpRead/UdpWrite timeout since they are both blocking API.
   //
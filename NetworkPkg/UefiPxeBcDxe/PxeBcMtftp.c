@@ -19,7 +19,8 @@ CHAR8 *mMtftpOptions[PXE_MTFTP_OPTION_MAXIMUM_INDEX] = {
   "blksize",
   "timeout",
   "tsize",
-  "multicast"
+  "multicast",
+  "windowsize"
 };
 
 
@@ -257,14 +258,16 @@ PxeBcMtftp6ReadFile (
 {
   EFI_MTFTP6_PROTOCOL                 *Mtftp6;
   EFI_MTFTP6_TOKEN                    Token;
-  EFI_MTFTP6_OPTION                   ReqOpt[1];
+  EFI_MTFTP6_OPTION                   ReqOpt[2];
   UINT32                              OptCnt;
   UINT8                               OptBuf[128];
+  UINTN                               OptLen;
   EFI_STATUS                          Status;
 
   Status                    = EFI_DEVICE_ERROR;
   Mtftp6                    = Private->Mtftp6;
   OptCnt                    = 0;
+  OptLen                    = 0;
   Config->InitialServerPort = PXEBC_BS_DOWNLOAD_PORT;
 
   Status = Mtftp6->Configure (Mtftp6, Config);
@@ -276,6 +279,18 @@ PxeBcMtftp6ReadFile (
     ReqOpt[0].OptionStr = (UINT8 *) mMtftpOptions[PXE_MTFTP_OPTION_BLKSIZE_INDEX];
     ReqOpt[0].ValueStr  = OptBuf;
     PxeBcUintnToAscDec (*BlockSize, ReqOpt[0].ValueStr, PXE_MTFTP_OPTBUF_MAXNUM_INDEX);
+    OptLen = AsciiStrLen ((CHAR8 *) ReqOpt[0].ValueStr) + 1;
+    OptCnt++;
+  }
+
+  //
+  // Ask the server to send several blocks per ACK. A server which doesn't
+  // support the windowsize option ignores it and sends one block per ACK.
+  //
+  if (Private->WindowSize > 1) {
+    ReqOpt[OptCnt].OptionStr = (UINT8 *) mMtftpOptions[PXE_MTFTP_OPTION_WINDOWSIZE_INDEX];
+    ReqOpt[OptCnt].ValueStr  = OptBuf + OptLen;
+    PxeBcUintnToAscDec (Private->WindowSize, ReqOpt[OptCnt].ValueStr, PXE_MTFTP_OPTBUF_MAXNUM_INDEX - OptLen);
     OptCnt++;
   }
 
@@ -703,14 +718,16 @@ PxeBcMtftp4ReadFile (
 {
   EFI_MTFTP4_PROTOCOL *Mtftp4;
   EFI_MTFTP4_TOKEN    Token;
-  EFI_MTFTP4_OPTION   ReqOpt[1];
+  EFI_MTFTP4_OPTION   ReqOpt[2];
   UINT32              OptCnt;
   UINT8               OptBuf[128];
+  UINTN               OptLen;
   EFI_STATUS          Status;
 
   Status                    = EFI_DEVICE_ERROR;
   Mtftp4                    = Private->Mtftp4;
   OptCnt                    = 0;
+  OptLen                    = 0;
   Config->InitialServerPort = PXEBC_BS_DOWNLOAD_PORT;
 
   Status = Mtftp4->Configure (Mtftp4, Config);
@@ -722,6 +739,18 @@ PxeBcMtftp4ReadFile (
     ReqOpt[0].OptionStr = (UINT8 *) mMtftpOptions[PXE_MTFTP_OPTION_BLKSIZE_INDEX];
     ReqOpt[0].ValueStr  = OptBuf;
     PxeBcUintnToAscDec (*BlockSize, ReqOpt[0].ValueStr, PXE_MTFTP_OPTBUF_MAXNUM_INDEX);
+    OptLen = AsciiStrLen ((CHAR8 *) ReqOpt[0].ValueStr) + 1;
+    OptCnt++;
+  }
+
+  //
+  // Ask the server to send several blocks per ACK. A server which doesn't
+  // support the windowsize option ignores it and sends one block per ACK.
+  //
+  if (Private->WindowSize > 1) {
+    ReqOpt[OptCnt].OptionStr = (UINT8 *) mMtftpOptions[PXE_MTFTP_OPTION_WINDOWSIZE_INDEX];
+    ReqOpt[OptCnt].ValueStr  = OptBuf + OptLen;
+    PxeBcUintnToAscDec (Private->WindowSize, ReqOpt[OptCnt].ValueStr, PXE_MTFTP_OPTBUF_MAXNUM_INDEX - OptLen);
     OptCnt++;
   }
 
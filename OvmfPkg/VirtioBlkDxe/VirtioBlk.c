@@ -1,14 +1,15 @@
 /** @file
 
-  This driver produces Block I/O Protocol instances for virtio-blk devices.
+  This driver produces Block I/O and Block I/O 2 Protocol instances for
+  virtio-blk devices.
 
   The implementation is basic:
 
   - No attach/detach (ie. removable media).
 
-  - Although the non-blocking interfaces of EFI_BLOCK_IO2_PROTOCOL could be a
-    good match for multiple in-flight virtio-blk requests, we stick to
-    synchronous requests and EFI_BLOCK_IO_PROTOCOL for now.
+  - The used ring is polled; the device never interrupts us. Several requests
+    are kept in flight together, both for large EFI_BLOCK_IO_PROTOCOL
+    transfers and for the non-blocking EFI_BLOCK_IO2_PROTOCOL interfaces.
 
   Copyright (C) 2012, Red Hat, Inc.
   Copyright (c) 2012 - 2018, Intel Corporation. All rights reserved.<BR>
@@ -184,204 +185,105 @@ VerifyReadWriteRequest (
 
 /**
 
-  Format a read / write / flush request as three consecutive virtio
-  descriptors, push them to the host, and poll for the response.
+  Submit one virtio-blk request of a transfer, and append its head descriptor
+  to the available ring. The caller publishes the new available ring entries
+  and notifies the device.
 
-  This is the main workhorse function. Two use cases are supported, read/write
-  and flush. The function may only be called after the request parameters have
-  been verified by
-  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks(), and
-  - VerifyReadWriteRequest() (for read/write only).
-
-  Parameters handled commonly:
-
-    @param[in] Dev             The virtio-blk device the request is targeted
-                               at.
-
-  Flush request:
-
-    @param[in] Lba             Must be zero.
-
-    @param[in] BufferSize      Must be zero.
-
-    @param[in out] Buffer      Ignored by the function.
-
-    @param[in] RequestIsWrite  Must be TRUE.
+  @param[in out] Dev        The virtio-blk device.
 
-  Read/Write request:
-
-    @param[in] Lba             Logical Block Address: number of logical blocks
-                               to skip from the beginning of the device.
-
-    @param[in] BufferSize      Size of buffer to transfer, in bytes. The caller
-                               is responsible to ensure this parameter is
-                               positive.
+  @param[in out] Transfer   The transfer the request belongs to. The request
+                            starts at Transfer->Lba and Transfer->Buffer.
 
-    @param[in out] Buffer      The guest side area to read data from the device
-                               into, or write data to the device from.
-
-    @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
-                               device.
+  @param[in] BufferSize     The size of the data buffer of the request, in
+                            bytes. Zero for a flush request.
 
-  Return values are common to both use cases, and are appropriate to be
-  forwarded by the EFI_BLOCK_IO_PROTOCOL functions (ReadBlocks(),
-  WriteBlocks(), FlushBlocks()).
+  @param[in out] AvailIdx   The index of the next available ring entry.
 
 
-  @retval EFI_SUCCESS          Transfer complete.
+  @retval EFI_SUCCESS       The request has been submitted.
 
-  @retval EFI_DEVICE_ERROR     Failed to notify host side via VirtIo write, or
-                               unable to parse host response, or host response
-                               is not VIRTIO_BLK_S_OK or failed to map Buffer
-                               for a bus master operation.
+  @retval EFI_DEVICE_ERROR  Failed to map the data buffer of the request for a
+                            bus master operation.
 
 **/
 
 STATIC
 EFI_STATUS
 EFIAPI
-SynchronousRequest (
-  IN              VBLK_DEV *Dev,
-  IN              EFI_LBA  Lba,
-  IN              UINTN    BufferSize,
-  IN OUT volatile VOID     *Buffer,
-  IN              BOOLEAN  RequestIsWrite
+VirtioBlkSubmitRequest (
+  IN OUT VBLK_DEV      *Dev,
+  IN OUT VBLK_TRANSFER *Transfer,
+  IN     UINTN         BufferSize,
+  IN OUT UINT16        *AvailIdx
   )
 {
-  UINT32                  BlockSize;
-  volatile VIRTIO_BLK_REQ Request;
-  volatile UINT8          *HostStatus;
-  VOID                    *HostStatusBuffer;
-  DESC_INDICES            Indices;
-  VOID                    *RequestMapping;
-  VOID                    *StatusMapping;
-  VOID                    *BufferMapping;
-  EFI_PHYSICAL_ADDRESS    BufferDeviceAddress;
-  EFI_PHYSICAL_ADDRESS    HostStatusDeviceAddress;
-  EFI_PHYSICAL_ADDRESS    RequestDeviceAddress;
-  EFI_STATUS              Status;
-  EFI_STATUS              UnmapStatus;
-
-  BlockSize = Dev->BlockIoMedia.BlockSize;
-
-  //
-  // Set BufferMapping and BufferDeviceAddress to suppress incorrect
-  // compiler/analyzer warnings.
-  //
-  BufferMapping       = NULL;
-  BufferDeviceAddress = 0;
-
-  //
-  // ensured by VirtioBlkInit()
-  //
-  ASSERT (BlockSize > 0);
-  ASSERT (BlockSize % 512 == 0);
+  UINT16               ReqIdx;
+  volatile VBLK_SHARED_REQ *SharedReq;
+  EFI_PHYSICAL_ADDRESS SharedReqDeviceAddress;
+  EFI_PHYSICAL_ADDRESS BufferDeviceAddress;
+  VOID                 *BufferMapping;
+  DESC_INDICES         Indices;
+  EFI_STATUS           Status;
 
   //
-  // ensured by contract above, plus VerifyReadWriteRequest()
+  // ensured by the callers -- a free request exists
   //
-  ASSERT (BufferSize % BlockSize == 0);
+  ASSERT (Dev->CurPending < Dev->MaxPending);
+  for (ReqIdx = 0; Dev->PendingReq[ReqIdx].Transfer != NULL; ++ReqIdx) {
+    ASSERT (ReqIdx + 1 < Dev->MaxPending);
+  }
 
   //
   // Prepare virtio-blk request header, setting zero size for flush.
   // IO Priority is homogeneously 0.
   //
-  Request.Type   = RequestIsWrite ?
-                   (BufferSize == 0 ? VIRTIO_BLK_T_FLUSH : VIRTIO_BLK_T_OUT) :
-                   VIRTIO_BLK_T_IN;
-  Request.IoPrio = 0;
-  Request.Sector = MultU64x32(Lba, BlockSize / 512);
+  SharedReq = &Dev->SharedReq[ReqIdx];
+  SharedReq->Request.Type   = Transfer->RequestIsWrite ?
+                              (BufferSize == 0 ? VIRTIO_BLK_T_FLUSH :
+                               VIRTIO_BLK_T_OUT) :
+                              VIRTIO_BLK_T_IN;
+  SharedReq->Request.IoPrio = 0;
+  SharedReq->Request.Sector = MultU64x32 (Transfer->Lba,
+                                Dev->BlockIoMedia.BlockSize / 512);
 
   //
-  // Host status is bi-directional (we preset with a value and expect the
-  // device to update it). Allocate a host status buffer which can be mapped
-  // to access equally by both processor and the device.
+  // preset a host status for ourselves that we do not accept as success
   //
-  Status = Dev->VirtIo->AllocateSharedPages (
-                          Dev->VirtIo,
-                          EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                          &HostStatusBuffer
-                          );
-  if (EFI_ERROR (Status)) {
-    return EFI_DEVICE_ERROR;
-  }
-
-  HostStatus = HostStatusBuffer;
-
-  //
-  // Map virtio-blk request header (must be done after request header is
-  // populated)
-  //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterRead,
-             (VOID *) &Request,
-             sizeof Request,
-             &RequestDeviceAddress,
-             &RequestMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto FreeHostStatusBuffer;
-  }
+  SharedReq->HostStatus = VIRTIO_BLK_S_IOERR;
 
   //
   // Map data buffer
   //
+  BufferMapping       = NULL;
+  BufferDeviceAddress = 0;
   if (BufferSize > 0) {
     Status = VirtioMapAllBytesInSharedBuffer (
                Dev->VirtIo,
-               (RequestIsWrite ?
+               (Transfer->RequestIsWrite ?
                 VirtioOperationBusMasterRead :
                 VirtioOperationBusMasterWrite),
-               (VOID *) Buffer,
+               (VOID *) Transfer->Buffer,
                BufferSize,
                &BufferDeviceAddress,
                &BufferMapping
                );
     if (EFI_ERROR (Status)) {
-      Status = EFI_DEVICE_ERROR;
-      goto UnmapRequestBuffer;
+      return EFI_DEVICE_ERROR;
     }
   }
 
-  //
-  // preset a host status for ourselves that we do not accept as success
-  //
-  *HostStatus = VIRTIO_BLK_S_IOERR;
-
-  //
-  // Map the Status Buffer with VirtioOperationBusMasterCommonBuffer so that
-  // both processor and device can access it.
-  //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterCommonBuffer,
-             HostStatusBuffer,
-             sizeof *HostStatus,
-             &HostStatusDeviceAddress,
-             &StatusMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto UnmapDataBuffer;
-  }
-
-  VirtioPrepare (&Dev->Ring, &Indices);
-
-  //
-  // ensured by VirtioBlkInit() -- this predicate, in combination with the
-  // lock-step progress, ensures we don't have to track free descriptors.
-  //
-  ASSERT (Dev->Ring.QueueSize >= 3);
+  SharedReqDeviceAddress = Dev->SharedReqBase +
+                           ReqIdx * sizeof (VBLK_SHARED_REQ);
+  Indices.HeadDescIdx    = (UINT16) (3 * ReqIdx);
+  Indices.NextDescIdx    = Indices.HeadDescIdx;
 
   //
   // virtio-blk header in first desc
   //
   VirtioAppendDesc (
     &Dev->Ring,
-    RequestDeviceAddress,
-    sizeof Request,
+    SharedReqDeviceAddress + OFFSET_OF (VBLK_SHARED_REQ, Request),
+    sizeof SharedReq->Request,
     VRING_DESC_F_NEXT,
     &Indices
     );
@@ -394,11 +296,11 @@ SynchronousRequest (
     // From virtio-0.9.5, 2.3.2 Descriptor Table:
     // "no descriptor chain may be more than 2^32 bytes long in total".
     //
-    // The predicate is ensured by the call contract above (for flush), or
-    // VerifyReadWriteRequest() (for read/write). It also implies that
+    // The predicate is ensured by the callers, which split transfers into
+    // requests of at most VBLK_MAX_REQUEST_SIZE bytes. It also implies that
     // converting BufferSize to UINT32 will not truncate it.
     //
-    ASSERT (BufferSize <= SIZE_1GB);
+    ASSERT (BufferSize <= VBLK_MAX_REQUEST_SIZE);
 
     //
     // VRING_DESC_F_WRITE is interpreted from the host's point of view.
@@ -407,7 +309,7 @@ SynchronousRequest (
       &Dev->Ring,
       BufferDeviceAddress,
       (UINT32) BufferSize,
-      VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
+      VRING_DESC_F_NEXT | (Transfer->RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
       &Indices
       );
   }
@@ -417,47 +319,465 @@ SynchronousRequest (
   //
   VirtioAppendDesc (
     &Dev->Ring,
-    HostStatusDeviceAddress,
-    sizeof *HostStatus,
+    SharedReqDeviceAddress + OFFSET_OF (VBLK_SHARED_REQ, HostStatus),
+    sizeof SharedReq->HostStatus,
     VRING_DESC_F_WRITE,
     &Indices
     );
 
   //
-  // virtio-blk's only virtqueue is #0, called "requestq" (see Appendix D).
+  // virtio-0.9.5, 2.4.1.2 Updating the Available Ring -- each entry
+  // references only the head descriptor of the chain.
   //
-  if (VirtioFlush (Dev->VirtIo, 0, &Dev->Ring, &Indices,
-        NULL) == EFI_SUCCESS &&
-      *HostStatus == VIRTIO_BLK_S_OK) {
-    Status = EFI_SUCCESS;
+  Dev->Ring.Avail.Ring[(*AvailIdx)++ % Dev->Ring.QueueSize] =
+    Indices.HeadDescIdx;
+
+  Dev->PendingReq[ReqIdx].Transfer      = Transfer;
+  Dev->PendingReq[ReqIdx].BufferMapping = BufferMapping;
+  Dev->CurPending++;
+  Transfer->InFlight++;
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Remove a transfer whose requests have all completed from the queue of
+  transfers, and report its status.
+
+  @param[in out] Transfer  The transfer to complete. An asynchronous transfer
+                           is freed after its token has been signaled.
+
+**/
+
+STATIC
+VOID
+EFIAPI
+VirtioBlkCompleteTransfer (
+  IN OUT VBLK_TRANSFER *Transfer
+  )
+{
+  RemoveEntryList (&Transfer->Link);
+
+  if (Transfer->Token != NULL) {
+    Transfer->Token->TransactionStatus = Transfer->Status;
+    gBS->SignalEvent (Transfer->Token->Event);
+    FreePool (Transfer);
   } else {
-    Status = EFI_DEVICE_ERROR;
+    Transfer->Done = TRUE;
   }
+}
 
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, StatusMapping);
 
-UnmapDataBuffer:
-  if (BufferSize > 0) {
-    UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, BufferMapping);
-    if (EFI_ERROR (UnmapStatus) && !RequestIsWrite && !EFI_ERROR (Status)) {
+/**
+
+  Submit requests for the queued transfers, in order, as long as there are
+  free requests. The device is notified once about all the new requests.
+
+  Must be called at TPL_NOTIFY.
+
+  @param[in out] Dev  The virtio-blk device.
+
+**/
+
+STATIC
+VOID
+EFIAPI
+VirtioBlkSubmitTransfers (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  LIST_ENTRY    *Link;
+  LIST_ENTRY    *NextLink;
+  VBLK_TRANSFER *Transfer;
+  UINT16        AvailIdx;
+  UINT16        NewRequests;
+  UINTN         BufferSize;
+  EFI_STATUS    Status;
+
+  AvailIdx    = *Dev->Ring.Avail.Idx;
+  NewRequests = 0;
+
+  for (Link = GetFirstNode (&Dev->Transfers);
+       !IsNull (&Dev->Transfers, Link) && Dev->CurPending < Dev->MaxPending;
+       Link = NextLink) {
+    NextLink = GetNextNode (&Dev->Transfers, Link);
+    Transfer = VBLK_TRANSFER_FROM_LINK (Link);
+
+    if (Transfer->FlushPending) {
       //
-      // Data from the bus master may not reach the caller; fail the request.
+      // A flush only covers the writes completed before it; wait for the
+      // requests in flight.
       //
-      Status = EFI_DEVICE_ERROR;
+      if (Dev->CurPending > 0) {
+        break;
+      }
+
+      Status = VirtioBlkSubmitRequest (Dev, Transfer, 0, &AvailIdx);
+      ASSERT_EFI_ERROR (Status);
+      Transfer->FlushPending = FALSE;
+      NewRequests++;
+      continue;
+    }
+
+    while (Transfer->BufferSize > 0 && Dev->CurPending < Dev->MaxPending) {
+      BufferSize = MIN (Transfer->BufferSize, VBLK_MAX_REQUEST_SIZE);
+      Status = VirtioBlkSubmitRequest (Dev, Transfer, BufferSize, &AvailIdx);
+      if (EFI_ERROR (Status)) {
+        //
+        // Don't submit the rest of the transfer.
+        //
+        Transfer->Status     = Status;
+        Transfer->BufferSize = 0;
+        break;
+      }
+
+      Transfer->Lba        += BufferSize / Dev->BlockIoMedia.BlockSize;
+      Transfer->Buffer     += BufferSize;
+      Transfer->BufferSize -= BufferSize;
+      NewRequests++;
+    }
+
+    if (Transfer->BufferSize == 0 && Transfer->InFlight == 0) {
+      VirtioBlkCompleteTransfer (Transfer);
     }
   }
 
-UnmapRequestBuffer:
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, RequestMapping);
+  if (NewRequests == 0) {
+    return;
+  }
 
-FreeHostStatusBuffer:
-  Dev->VirtIo->FreeSharedPages (
-                 Dev->VirtIo,
-                 EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                 HostStatusBuffer
-                 );
+  //
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field
+  //
+  MemoryFence ();
+  *Dev->Ring.Avail.Idx = AvailIdx;
 
-  return Status;
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device -- one notification for all
+  // the new requests.
+  //
+  MemoryFence ();
+  Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, 0);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: SetQueueNotify(): %r\n", __FUNCTION__, Status));
+  }
+}
+
+
+/**
+
+  Collect the requests the device has completed, complete the transfers all
+  the requests of which have completed, and submit new requests for the queued
+  transfers.
+
+  Must be called at TPL_NOTIFY.
+
+  @param[in out] Dev  The virtio-blk device.
+
+  @return  The number of completed requests.
+
+**/
+
+STATIC
+UINTN
+EFIAPI
+VirtioBlkProcessRequests (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  volatile CONST VRING_USED_ELEM *UsedElem;
+  UINT16                         ReqIdx;
+  UINTN                          Completed;
+  VBLK_TRANSFER                  *Transfer;
+  EFI_STATUS                     UnmapStatus;
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  Completed = 0;
+  MemoryFence ();
+  while (Dev->LastUsedIdx != *Dev->Ring.Used.Idx) {
+    MemoryFence ();
+    UsedElem = &Dev->Ring.Used.UsedElem[Dev->LastUsedIdx++ %
+                                        Dev->Ring.QueueSize];
+    ReqIdx   = (UINT16) (UsedElem->Id / 3);
+    ASSERT (ReqIdx < Dev->MaxPending);
+    ASSERT (Dev->PendingReq[ReqIdx].Transfer != NULL);
+
+    Transfer = Dev->PendingReq[ReqIdx].Transfer;
+    if (Dev->SharedReq[ReqIdx].HostStatus != VIRTIO_BLK_S_OK) {
+      Transfer->Status = EFI_DEVICE_ERROR;
+    }
+
+    if (Dev->PendingReq[ReqIdx].BufferMapping != NULL) {
+      UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (
+                                   Dev->VirtIo,
+                                   Dev->PendingReq[ReqIdx].BufferMapping
+                                   );
+      if (EFI_ERROR (UnmapStatus) && !Transfer->RequestIsWrite) {
+        //
+        // Data from the bus master may not reach the caller; fail the
+        // request.
+        //
+        Transfer->Status = EFI_DEVICE_ERROR;
+      }
+    }
+
+    Dev->PendingReq[ReqIdx].Transfer      = NULL;
+    Dev->PendingReq[ReqIdx].BufferMapping = NULL;
+    Dev->CurPending--;
+    Completed++;
+
+    Transfer->InFlight--;
+    if (Transfer->InFlight == 0 && Transfer->BufferSize == 0 &&
+        !Transfer->FlushPending) {
+      VirtioBlkCompleteTransfer (Transfer);
+    }
+  }
+
+  VirtioBlkSubmitTransfers (Dev);
+
+  if (IsListEmpty (&Dev->Transfers)) {
+    gBS->SetTimer (Dev->PollTimer, TimerCancel, 0);
+  }
+  return Completed;
+}
+
+
+/**
+
+  Timer notification function polling the used ring while asynchronous
+  transfers are in progress.
+
+  @param[in] Event    Event whose notification function is being invoked.
+
+  @param[in] Context  Pointer to the VBLK_DEV structure.
+
+**/
+
+STATIC
+VOID
+EFIAPI
+VirtioBlkPollTimer (
+  IN  EFI_EVENT Event,
+  IN  VOID      *Context
+  )
+{
+  VirtioBlkProcessRequests (Context);
+}
+
+
+/**
+
+  Queue a read / write / flush transfer, and submit as many of its requests
+  as the free requests permit. Transfers larger than VBLK_MAX_REQUEST_SIZE are
+  split into several requests, kept in flight together.
+
+  The function may only be called after the transfer parameters have been
+  verified by
+  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks() and their
+    EFI_BLOCK_IO2_PROTOCOL counterparts, and
+  - VerifyReadWriteRequest() (for read/write only).
+
+  @param[in] Dev             The virtio-blk device the transfer is targeted
+                             at.
+
+  @param[in] Transfer        The transfer, with Token, Lba, Buffer, BufferSize,
+                             RequestIsWrite and FlushPending set. Other fields
+                             are initialized by this function.
+
+**/
+
+STATIC
+VOID
+EFIAPI
+QueueTransfer (
+  IN     VBLK_DEV      *Dev,
+  IN OUT VBLK_TRANSFER *Transfer
+  )
+{
+  EFI_TPL OldTpl;
+
+  Transfer->Signature = VBLK_TRANSFER_SIG;
+  Transfer->InFlight  = 0;
+  Transfer->Done      = FALSE;
+  Transfer->Status    = EFI_SUCCESS;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  InsertTailList (&Dev->Transfers, &Transfer->Link);
+  VirtioBlkSubmitTransfers (Dev);
+  if (Transfer->Token != NULL && !IsListEmpty (&Dev->Transfers)) {
+    gBS->SetTimer (Dev->PollTimer, TimerPeriodic, VBLK_POLL_PERIOD);
+  }
+  gBS->RestoreTPL (OldTpl);
+}
+
+
+/**
+
+  Perform a read / write / flush transfer, and poll for its completion.
+
+  This is the main workhorse function for EFI_BLOCK_IO_PROTOCOL, and for
+  blocking EFI_BLOCK_IO2_PROTOCOL transfers. Two use cases are supported,
+  read/write and flush. The function may only be called after the request
+  parameters have been verified, see QueueTransfer().
+
+  Parameters handled commonly:
+
+    @param[in] Dev             The virtio-blk device the request is targeted
+                               at.
+
+  Flush request:
+
+    @param[in] Lba             Must be zero.
+
+    @param[in] BufferSize      Must be zero.
+
+    @param[in out] Buffer      Ignored by the function.
+
+    @param[in] RequestIsWrite  Must be TRUE.
+
+  Read/Write request:
+
+    @param[in] Lba             Logical Block Address: number of logical blocks
+                               to skip from the beginning of the device.
+
+    @param[in] BufferSize      Size of buffer to transfer, in bytes. The caller
+                               is responsible to ensure this parameter is
+                               positive.
+
+    @param[in out] Buffer      The guest side area to read data from the device
+                               into, or write data to the device from.
+
+    @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
+                               device.
+
+  Return values are common to both use cases, and are appropriate to be
+  forwarded by the EFI_BLOCK_IO_PROTOCOL functions (ReadBlocks(),
+  WriteBlocks(), FlushBlocks()).
+
+
+  @retval EFI_SUCCESS          Transfer complete.
+
+  @retval EFI_DEVICE_ERROR     Unable to parse host response, or host response
+                               is not VIRTIO_BLK_S_OK or failed to map Buffer
+                               for a bus master operation.
+
+**/
+
+STATIC
+EFI_STATUS
+EFIAPI
+SynchronousRequest (
+  IN              VBLK_DEV *Dev,
+  IN              EFI_LBA  Lba,
+  IN              UINTN    BufferSize,
+  IN OUT volatile VOID     *Buffer,
+  IN              BOOLEAN  RequestIsWrite
+  )
+{
+  VBLK_TRANSFER Transfer;
+  EFI_TPL       OldTpl;
+  BOOLEAN       Done;
+  UINTN         Completed;
+  UINTN         PollPeriodUsecs;
+
+  //
+  // ensured by VirtioBlkInit()
+  //
+  ASSERT (Dev->BlockIoMedia.BlockSize > 0);
+  ASSERT (Dev->BlockIoMedia.BlockSize % 512 == 0);
+
+  //
+  // ensured by contract above, plus VerifyReadWriteRequest()
+  //
+  ASSERT (BufferSize % Dev->BlockIoMedia.BlockSize == 0);
+
+  Transfer.Token          = NULL;
+  Transfer.Lba            = Lba;
+  Transfer.Buffer         = Buffer;
+  Transfer.BufferSize     = BufferSize;
+  Transfer.RequestIsWrite = RequestIsWrite;
+  Transfer.FlushPending   = (BOOLEAN) (BufferSize == 0);
+  QueueTransfer (Dev, &Transfer);
+
+  //
+  // Keep slowing down until we reach a poll period of slightly above 1 ms,
+  // and start over whenever requests complete.
+  //
+  PollPeriodUsecs = 1;
+  for (;;) {
+    OldTpl    = gBS->RaiseTPL (TPL_NOTIFY);
+    Completed = VirtioBlkProcessRequests (Dev);
+    Done      = Transfer.Done;
+    gBS->RestoreTPL (OldTpl);
+
+    if (Done) {
+      break;
+    }
+
+    if (Completed > 0) {
+      PollPeriodUsecs = 1;
+    }
+    gBS->Stall (PollPeriodUsecs); // calls AcpiTimerLib::MicroSecondDelay
+
+    if (PollPeriodUsecs < 1024) {
+      PollPeriodUsecs *= 2;
+    }
+  }
+
+  return Transfer.Status;
+}
+
+
+/**
+
+  Queue a read / write / flush transfer, which completes asynchronously.
+  Parameters are as for SynchronousRequest(), plus:
+
+  @param[in out] Token  The EFI_BLOCK_IO2_TOKEN of the transfer. Token->Event
+                        is signaled when all its requests complete, with the
+                        status of the transfer in Token->TransactionStatus.
+
+
+  @retval EFI_SUCCESS           The transfer has been queued.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+**/
+
+STATIC
+EFI_STATUS
+EFIAPI
+AsynchronousRequest (
+  IN              VBLK_DEV            *Dev,
+  IN              EFI_LBA             Lba,
+  IN              UINTN               BufferSize,
+  IN OUT volatile VOID                *Buffer,
+  IN              BOOLEAN             RequestIsWrite,
+  IN OUT          EFI_BLOCK_IO2_TOKEN *Token
+  )
+{
+  VBLK_TRANSFER *Transfer;
+
+  ASSERT (BufferSize % Dev->BlockIoMedia.BlockSize == 0);
+
+  Transfer = AllocatePool (sizeof *Transfer);
+  if (Transfer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Token->TransactionStatus = EFI_SUCCESS;
+
+  Transfer->Token          = Token;
+  Transfer->Lba            = Lba;
+  Transfer->Buffer         = Buffer;
+  Transfer->BufferSize     = BufferSize;
+  Transfer->RequestIsWrite = RequestIsWrite;
+  Transfer->FlushPending   = (BOOLEAN) (BufferSize == 0);
+  QueueTransfer (Dev, Transfer);
+  return EFI_SUCCESS;
 }
 
 
@@ -610,6 +930,198 @@ VirtioBlkFlushBlocks (
 }
 
 
+//
+// UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol
+//
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  //
+  // See VirtioBlkReset().
+  //
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Common implementation of ReadBlocksEx() and WriteBlocksEx(). Without a
+  Token, or with a Token that has no Event, the transfer is blocking.
+
+**/
+
+STATIC
+EFI_STATUS
+EFIAPI
+ReadWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN OUT VOID                   *Buffer,
+  IN     BOOLEAN                RequestIsWrite
+  )
+{
+  VBLK_DEV   *Dev;
+  EFI_STATUS Status;
+
+  if (BufferSize == 0) {
+    if (Token != NULL && Token->Event != NULL) {
+      Token->TransactionStatus = EFI_SUCCESS;
+      gBS->SignalEvent (Token->Event);
+    }
+    return EFI_SUCCESS;
+  }
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Token == NULL || Token->Event == NULL) {
+    return SynchronousRequest (Dev, Lba, BufferSize, Buffer, RequestIsWrite);
+  }
+  return AsynchronousRequest (
+           Dev,
+           Lba,
+           BufferSize,
+           Buffer,
+           RequestIsWrite,
+           Token
+           );
+}
+
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.2. ReadBlocks() and
+    ReadBlocksEx() Implementation.
+
+  Parameter checks and conformant return values are implemented in
+  VerifyReadWriteRequest(), SynchronousRequest() and AsynchronousRequest().
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  return ReadWriteBlocksEx (
+           This,
+           Lba,
+           Token,
+           BufferSize,
+           Buffer,
+           FALSE       // RequestIsWrite
+           );
+}
+
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.3 WriteBlocks() and
+    WriteBlockEx() Implementation.
+
+  Parameter checks and conformant return values are implemented in
+  VerifyReadWriteRequest(), SynchronousRequest() and AsynchronousRequest().
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  return ReadWriteBlocksEx (
+           This,
+           Lba,
+           Token,
+           BufferSize,
+           Buffer,
+           TRUE        // RequestIsWrite
+           );
+}
+
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.4 FlushBlocks() and
+    FlushBlocksEx() Implementation.
+
+  The flush request is only submitted after all the requests queued before it
+  have completed. See also VirtioBlkFlushBlocks().
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  VBLK_DEV *Dev;
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  if (Token == NULL || Token->Event == NULL) {
+    return VirtioBlkFlushBlocks (&Dev->BlockIo);
+  }
+
+  if (!Dev->BlockIoMedia.WriteCaching) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  return AsynchronousRequest (
+           Dev,
+           0,    // Lba
+           0,    // BufferSize
+           NULL, // Buffer
+           TRUE, // RequestIsWrite
+           Token
+           );
+}
+
+
 /**
 
   Device probe function for this driver.
@@ -691,6 +1203,161 @@ VirtioBlkDriverBindingSupported (
 }
 
 
+/**
+
+  Set up the tracking of the virtio-blk requests that are kept in flight
+  together:
+  - three consecutive descriptors for each possibly pending request,
+  - one request header and host status per pending request, in a buffer that
+    is mapped with BusMasterCommonBuffer,
+  - the queue of transfers, and the timer that polls the used ring for the
+    asynchronous ones. The device never interrupts us.
+
+  @param[in out] Dev  The virtio-blk device, with its virtio ring set up.
+
+
+  @retval EFI_SUCCESS           Setup complete.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Status codes from VIRTIO_DEVICE_PROTOCOL.
+                                AllocateSharedPages(),
+                                VirtioMapAllBytesInSharedBuffer() or the
+                                CreateEvent() boot service.
+
+**/
+
+STATIC
+EFI_STATUS
+EFIAPI
+VirtioBlkInitRequests (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  UINTN      SharedReqSize;
+  VOID       *SharedReqBuffer;
+  EFI_STATUS Status;
+
+  Dev->MaxPending  = (UINT16) MIN (Dev->Ring.QueueSize / 3, VBLK_MAX_PENDING);
+  Dev->CurPending  = 0;
+  Dev->LastUsedIdx = 0;
+  InitializeListHead (&Dev->Transfers);
+
+  Dev->PendingReq = AllocateZeroPool (Dev->MaxPending *
+                      sizeof *Dev->PendingReq);
+  if (Dev->PendingReq == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Allocate the request headers and host statuses, and map them with
+  // BusMasterCommonBuffer so that they can be accessed equally by both
+  // processor and device.
+  //
+  SharedReqSize = Dev->MaxPending * sizeof *Dev->SharedReq;
+  Status = Dev->VirtIo->AllocateSharedPages (
+                          Dev->VirtIo,
+                          EFI_SIZE_TO_PAGES (SharedReqSize),
+                          &SharedReqBuffer
+                          );
+  if (EFI_ERROR (Status)) {
+    goto FreePendingReq;
+  }
+
+  ZeroMem (SharedReqBuffer, SharedReqSize);
+
+  Status = VirtioMapAllBytesInSharedBuffer (
+             Dev->VirtIo,
+             VirtioOperationBusMasterCommonBuffer,
+             SharedReqBuffer,
+             SharedReqSize,
+             &Dev->SharedReqBase,
+             &Dev->SharedReqMap
+             );
+  if (EFI_ERROR (Status)) {
+    goto FreeSharedReqBuffer;
+  }
+
+  Dev->SharedReq = SharedReqBuffer;
+
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_NOTIFY,
+                  &VirtioBlkPollTimer, Dev, &Dev->PollTimer);
+  if (EFI_ERROR (Status)) {
+    goto UnmapSharedReqBuffer;
+  }
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device -- we poll the
+  // used ring.
+  //
+  *Dev->Ring.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  return EFI_SUCCESS;
+
+UnmapSharedReqBuffer:
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->SharedReqMap);
+
+FreeSharedReqBuffer:
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (SharedReqSize),
+                 SharedReqBuffer
+                 );
+
+FreePendingReq:
+  FreePool (Dev->PendingReq);
+
+  return Status;
+}
+
+
+/**
+
+  Release the resources set up by VirtioBlkInitRequests(). The device must have
+  been reset. Queued transfers are aborted.
+
+  @param[in out] Dev  The virtio-blk device.
+
+**/
+
+STATIC
+VOID
+EFIAPI
+VirtioBlkUninitRequests (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  UINT16        ReqIdx;
+  VBLK_TRANSFER *Transfer;
+
+  gBS->CloseEvent (Dev->PollTimer);
+
+  for (ReqIdx = 0; ReqIdx < Dev->MaxPending; ++ReqIdx) {
+    if (Dev->PendingReq[ReqIdx].BufferMapping != NULL) {
+      Dev->VirtIo->UnmapSharedBuffer (
+                     Dev->VirtIo,
+                     Dev->PendingReq[ReqIdx].BufferMapping
+                     );
+    }
+  }
+
+  while (!IsListEmpty (&Dev->Transfers)) {
+    Transfer = VBLK_TRANSFER_FROM_LINK (GetFirstNode (&Dev->Transfers));
+    Transfer->Status       = EFI_ABORTED;
+    Transfer->BufferSize   = 0;
+    Transfer->FlushPending = FALSE;
+    VirtioBlkCompleteTransfer (Transfer);
+  }
+
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->SharedReqMap);
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (Dev->MaxPending * sizeof *Dev->SharedReq),
+                 (VOID *) Dev->SharedReq
+                 );
+  FreePool (Dev->PendingReq);
+}
+
+
 /**
 
   Set up all BlockIo and virtio-blk aspects of this driver for the specified
@@ -847,7 +1514,7 @@ VirtioBlkInit (
   if (EFI_ERROR (Status)) {
     goto Failed;
   }
-  if (QueueSize < 3) { // SynchronousRequest() uses at most three descriptors
+  if (QueueSize < 3) { // each request uses at most three descriptors
     Status = EFI_UNSUPPORTED;
     goto Failed;
   }
@@ -896,6 +1563,15 @@ VirtioBlkInit (
     goto UnmapQueue;
   }
 
+  //
+  // Set up the descriptors and the request headers of the requests that may
+  // be pending together.
+  //
+  Status = VirtioBlkInitRequests (Dev);
+  if (EFI_ERROR (Status)) {
+    goto UnmapQueue;
+  }
+
 
   //
   // step 5 -- Report understood features.
@@ -904,7 +1580,7 @@ VirtioBlkInit (
     Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM);
     Status = Dev->VirtIo->SetGuestFeatures (Dev->VirtIo, Features);
     if (EFI_ERROR (Status)) {
-      goto UnmapQueue;
+      goto UninitRequests;
     }
   }
 
@@ -914,7 +1590,7 @@ VirtioBlkInit (
   NextDevStat |= VSTAT_DRIVER_OK;
   Status = Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, NextDevStat);
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto UninitRequests;
   }
 
   //
@@ -927,6 +1603,11 @@ VirtioBlkInit (
   Dev->BlockIo.ReadBlocks            = &VirtioBlkReadBlocks;
   Dev->BlockIo.WriteBlocks           = &VirtioBlkWriteBlocks;
   Dev->BlockIo.FlushBlocks           = &VirtioBlkFlushBlocks;
+  Dev->BlockIo2.Media                = &Dev->BlockIoMedia;
+  Dev->BlockIo2.Reset                = &VirtioBlkResetEx;
+  Dev->BlockIo2.ReadBlocksEx         = &VirtioBlkReadBlocksEx;
+  Dev->BlockIo2.WriteBlocksEx        = &VirtioBlkWriteBlocksEx;
+  Dev->BlockIo2.FlushBlocksEx        = &VirtioBlkFlushBlocksEx;
   Dev->BlockIoMedia.MediaId          = 0;
   Dev->BlockIoMedia.RemovableMedia   = FALSE;
   Dev->BlockIoMedia.MediaPresent     = TRUE;
@@ -957,6 +1638,9 @@ VirtioBlkInit (
   }
   return EFI_SUCCESS;
 
+UninitRequests:
+  VirtioBlkUninitRequests (Dev);
+
 UnmapQueue:
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
 
@@ -998,10 +1682,12 @@ VirtioBlkUninit (
   //
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
 
+  VirtioBlkUninitRequests (Dev);
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
   VirtioRingUninit (Dev->VirtIo, &Dev->Ring);
 
   SetMem (&Dev->BlockIo,      sizeof Dev->BlockIo,      0x00);
+  SetMem (&Dev->BlockIo2,     sizeof Dev->BlockIo2,     0x00);
   SetMem (&Dev->BlockIoMedia, sizeof Dev->BlockIoMedia, 0x00);
 }
 
@@ -1057,13 +1743,15 @@ VirtioBlkExitBoot (
 
   @retval EFI_SUCCESS           Driver instance has been created and
                                 initialized  for the virtio-blk device, it
-                                is now accessible via EFI_BLOCK_IO_PROTOCOL.
+                                is now accessible via EFI_BLOCK_IO_PROTOCOL and
+                                EFI_BLOCK_IO2_PROTOCOL.
 
   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
 
   @return                       Error codes from the OpenProtocol() boot
                                 service, the VirtIo protocol, VirtioBlkInit(),
-                                or the InstallProtocolInterface() boot service.
+                                or the InstallMultipleProtocolInterfaces() boot
+                                service.
 
 **/
 
@@ -1108,9 +1796,10 @@ VirtioBlkDriverBindingStart (
   // Setup complete, attempt to export the driver instance's BlockIo interface.
   //
   Dev->Signature = VBLK_SIG;
-  Status = gBS->InstallProtocolInterface (&DeviceHandle,
-                  &gEfiBlockIoProtocolGuid, EFI_NATIVE_INTERFACE,
-                  &Dev->BlockIo);
+  Status = gBS->InstallMultipleProtocolInterfaces (&DeviceHandle,
+                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
   if (EFI_ERROR (Status)) {
     goto CloseExitBoot;
   }
@@ -1187,8 +1876,10 @@ VirtioBlkDriverBindingStop (
   //
   // Handle Stop() requests for in-use driver instances gracefully.
   //
-  Status = gBS->UninstallProtocolInterface (DeviceHandle,
-                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo);
+  Status = gBS->UninstallMultipleProtocolInterfaces (DeviceHandle,
+                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -1,7 +1,7 @@
 /** @file
 
   Internal definitions for the virtio-blk driver, which produces Block I/O
-  Protocol instances for virtio-blk devices.
+  and Block I/O 2 Protocol instances for virtio-blk devices.
 
   Copyright (C) 2012, Red Hat, Inc.
 
@@ -19,14 +19,72 @@
 #define _VIRTIO_BLK_DXE_H_
 
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
 
-#include <IndustryStandard/Virtio.h>
+#include <IndustryStandard/VirtioBlk.h>
 
 
 #define VBLK_SIG SIGNATURE_32 ('V', 'B', 'L', 'K')
 
+//
+// The maximum number of virtio-blk requests in flight, and the maximum size of
+// the data buffer of a request. Larger transfers are split into requests of
+// this size, which the device is notified about together.
+//
+#define VBLK_MAX_PENDING      32
+#define VBLK_MAX_REQUEST_SIZE SIZE_1MB
+
+//
+// The period of polling the used ring while EFI_BLOCK_IO2_PROTOCOL transfers
+// are in progress.
+//
+#define VBLK_POLL_PERIOD      EFI_TIMER_PERIOD_MILLISECONDS (1)
+
+//
+// The parts of a virtio-blk request that the device accesses, apart from the
+// data buffer. One is allocated for each possibly pending request, and they are
+// all mapped with BusMasterCommonBuffer once.
+//
+typedef struct {
+  VIRTIO_BLK_REQ Request;
+  UINT8          HostStatus;
+  UINT8          Reserved[7];
+} VBLK_SHARED_REQ;
+
+//
+// A read, write or flush transfer requested through EFI_BLOCK_IO_PROTOCOL or
+// EFI_BLOCK_IO2_PROTOCOL. Transfers are submitted to the device in order.
+//
+#define VBLK_TRANSFER_SIG SIGNATURE_32 ('V', 'B', 'L', 'T')
+
+typedef struct {
+  UINT32              Signature;
+  LIST_ENTRY          Link;           // in VBLK_DEV.Transfers
+  EFI_BLOCK_IO2_TOKEN *Token;         // NULL for blocking transfers
+  EFI_LBA             Lba;            // of the next request to submit
+  volatile UINT8      *Buffer;        // of the next request to submit
+  UINTN               BufferSize;     // not submitted yet
+  BOOLEAN             RequestIsWrite;
+  BOOLEAN             FlushPending;   // flush request not submitted yet
+  UINTN               InFlight;       // requests submitted, not completed
+  BOOLEAN             Done;           // blocking transfers only
+  EFI_STATUS          Status;
+} VBLK_TRANSFER;
+
+#define VBLK_TRANSFER_FROM_LINK(TransferLink) \
+        CR (TransferLink, VBLK_TRANSFER, Link, VBLK_TRANSFER_SIG)
+
+//
+// A possibly pending virtio-blk request. Request #N uses descriptors #3*N to
+// #3*N+2, and VBLK_DEV.SharedReq[N].
+//
+typedef struct {
+  VBLK_TRANSFER *Transfer;            // NULL if the request is free
+  VOID          *BufferMapping;       // NULL for flush requests
+} VBLK_PENDING_REQ;
+
 typedef struct {
   //
   // Parts of this structure are initialized / torn down in various functions
@@ -40,13 +98,26 @@ typedef struct {
   EFI_EVENT              ExitBoot;             // DriverBindingStart  0
   VRING                  Ring;                 // VirtioRingInit      2
   EFI_BLOCK_IO_PROTOCOL  BlockIo;              // VirtioBlkInit       1
+  EFI_BLOCK_IO2_PROTOCOL BlockIo2;             // VirtioBlkInit       1
   EFI_BLOCK_IO_MEDIA     BlockIoMedia;         // VirtioBlkInit       1
   VOID                   *RingMap;             // VirtioRingMap       2
+  UINT16                 MaxPending;           // VirtioBlkInitReqs   2
+  UINT16                 CurPending;           // VirtioBlkInitReqs   2
+  UINT16                 LastUsedIdx;          // VirtioBlkInitReqs   2
+  VBLK_PENDING_REQ       *PendingReq;          // VirtioBlkInitReqs   2
+  VBLK_SHARED_REQ        *SharedReq;           // VirtioBlkInitReqs   2
+  EFI_PHYSICAL_ADDRESS   SharedReqBase;        // VirtioBlkInitReqs   2
+  VOID                   *SharedReqMap;        // VirtioBlkInitReqs   2
+  LIST_ENTRY             Transfers;            // VirtioBlkInitReqs   2
+  EFI_EVENT              PollTimer;            // VirtioBlkInitReqs   2
 } VBLK_DEV;
 
 #define VIRTIO_BLK_FROM_BLOCK_IO(BlockIoPointer) \
         CR (BlockIoPointer, VBLK_DEV, BlockIo, VBLK_SIG)
 
+#define VIRTIO_BLK_FROM_BLOCK_IO2(BlockIo2Pointer) \
+        CR (BlockIo2Pointer, VBLK_DEV, BlockIo2, VBLK_SIG)
+
 
 /**
 
@@ -112,7 +183,8 @@ VirtioBlkDriverBindingSupported (
 
   @retval EFI_SUCCESS           Driver instance has been created and
                                 initialized  for the virtio-blk device, it
-                                is now accessible via EFI_BLOCK_IO_PROTOCOL.
+                                is now accessible via EFI_BLOCK_IO_PROTOCOL
+                                and EFI_BLOCK_IO2_PROTOCOL.
 
   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
 
@@ -259,6 +331,87 @@ VirtioBlkFlushBlocks (
   );
 
 
+//
+// UEFI Spec 2.7, 13.10 Block I/O 2 Protocol
+//
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  );
+
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.7, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+
+  If Token is NULL, or Token->Event is NULL, the read is blocking, as
+  VirtioBlkReadBlocks(). Otherwise the function returns once the requests of
+  the read are queued, and Token->Event is signaled when they complete.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  );
+
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.7, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+
+  If Token is NULL, or Token->Event is NULL, the write is blocking, as
+  VirtioBlkWriteBlocks(). Otherwise the function returns once the requests of
+  the write are queued, and Token->Event is signaled when they complete.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  );
+
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.7, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+
+  The flush request is submitted once the requests in flight complete, so that
+  it covers all the writes queued before it.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  );
+
+
 //
 // The purpose of the following scaffolding (EFI_COMPONENT_NAME_PROTOCOL and
 // EFI_COMPONENT_NAME2_PROTOCOL implementation) is to format the driver's name
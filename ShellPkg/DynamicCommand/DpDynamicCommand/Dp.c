@@ -90,6 +90,7 @@ STATIC CONST SHELL_PARAM_ITEM ParamList[] = {
 #endif // PROFILING_IMPLEMENTED
   {L"-x", TypeFlag},   // -x   eXclude Cumulative Items
   {L"-i", TypeFlag},   // -i   Display Identifier
+  {L"-u", TypeFlag},   // -u   Display boot services profile
   {L"-c", TypeValue},  // -c   Display cumulative data.
   {L"-n", TypeValue},  // -n # Number of records to display for A and R
   {L"-t", TypeValue},  // -t # Threshold of interest
@@ -707,6 +708,7 @@ RunDp (
   BOOLEAN                   ProfileMode;
   BOOLEAN                   ExcludeMode;
   BOOLEAN                   CumulativeMode;
+  BOOLEAN                   BootServicesMode;
   CONST CHAR16              *CustomCumulativeToken;
   PERF_CUM_DATA             *CustomCumulativeData;
   UINTN                     NameSize;
@@ -722,6 +724,7 @@ RunDp (
   ProfileMode = FALSE;
   ExcludeMode = FALSE;
   CumulativeMode = FALSE;
+  BootServicesMode = FALSE;
   CustomCumulativeData = NULL;
   ShellStatus = SHELL_SUCCESS;
 
@@ -783,6 +786,7 @@ RunDp (
   ExcludeMode = ShellCommandLineGetFlag (ParamPackage, L"-x");
   mShowId     = ShellCommandLineGetFlag (ParamPackage, L"-i");
   CumulativeMode = ShellCommandLineGetFlag (ParamPackage, L"-c");
+  BootServicesMode = ShellCommandLineGetFlag (ParamPackage, L"-u");
 
   // Options with Values
   CmdLineArg  = ShellCommandLineGetValue (ParamPackage, L"-n");
@@ -903,6 +907,8 @@ RunDp (
   GatherStatistics (CustomCumulativeData);
   if (CumulativeMode) {                       
     ProcessCumulative (CustomCumulativeData);
+  } else if (BootServicesMode) {
+    DumpBootServicesProfile (Number2Display);
   } else if (AllMode) {
     if (TraceMode) {
       Status = DumpAllTrace( Number2Display, ExcludeMode);
@@ -27,6 +27,7 @@
 #include <Protocol/DevicePath.h>
 #include <Protocol/LoadedImage.h>
 #include <Protocol/UnicodeCollation.h>
+#include <Protocol/BootServicesProfile.h>
 
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -328,6 +328,23 @@ DumpAllProfile(
   IN BOOLEAN        ExcludeFlag
   );
 
+/**
+  Print the boot services profile collected by the DXE Core.
+
+  Displays the call count and the time spent in each measured boot service,
+  followed by the callers that spent the most time in the boot services.
+
+  @pre    The mGaugeString global array is used for temporary string storage.
+          It must not be in use by a calling function.
+
+  @param[in]    Limit         The number of callers to print.  Zero is ALL.
+
+**/
+VOID
+DumpBootServicesProfile (
+  IN UINTN          Limit
+  );
+
 /** 
   Gather and print Raw Profile Records.
   
@@ -98,3 +98,122 @@ DumpRawProfile(
   FreePool (StringPtr);
   FreePool (StringPtrUnknown);
 }
+
+/**
+  Compare the durations of two boot service callers, for sorting them from the
+  longest to the shortest.
+
+  @param[in]  Buffer1   The first EDKII_BOOT_SERVICE_PROFILE_CALLER.
+  @param[in]  Buffer2   The second EDKII_BOOT_SERVICE_PROFILE_CALLER.
+
+  @retval <0            Buffer1 has the longer duration.
+  @retval 0             Both have the same duration.
+  @retval >0            Buffer2 has the longer duration.
+**/
+INTN
+EFIAPI
+CompareBootServiceCallers (
+  IN CONST VOID *Buffer1,
+  IN CONST VOID *Buffer2
+  )
+{
+  CONST EDKII_BOOT_SERVICE_PROFILE_CALLER   *Caller1;
+  CONST EDKII_BOOT_SERVICE_PROFILE_CALLER   *Caller2;
+
+  Caller1 = (CONST EDKII_BOOT_SERVICE_PROFILE_CALLER *) Buffer1;
+  Caller2 = (CONST EDKII_BOOT_SERVICE_PROFILE_CALLER *) Buffer2;
+  if (Caller1->Duration == Caller2->Duration) {
+    return 0;
+  }
+  return (Caller1->Duration > Caller2->Duration) ? -1 : 1;
+}
+
+/**
+  Print the boot services profile collected by the DXE Core.
+
+  Displays the call count and the time spent in each measured boot service,
+  followed by the callers that spent the most time in the boot services.
+
+  @pre    The mGaugeString global array is used for temporary string storage.
+          It must not be in use by a calling function.
+
+  @param[in]    Limit         The number of callers to print.  Zero is ALL.
+
+**/
+VOID
+DumpBootServicesProfile (
+  IN UINTN      Limit
+  )
+{
+  EFI_STATUS                            Status;
+  EDKII_BOOT_SERVICES_PROFILE_PROTOCOL  *Profile;
+  EDKII_BOOT_SERVICE_PROFILE_SERVICE    *Services;
+  EDKII_BOOT_SERVICE_PROFILE_CALLER     *Callers;
+  UINTN                                 ServiceCount;
+  UINTN                                 CallerCount;
+  UINTN                                 Index;
+  UINT64                                AvgDur;
+  EFI_STRING                            StringPtr;
+  EFI_STRING                            StringPtrUnknown;
+
+  StringPtrUnknown = HiiGetString (mDpHiiHandle, STRING_TOKEN (STR_ALIT_UNKNOWN), NULL);
+  StringPtr = HiiGetString (mDpHiiHandle, STRING_TOKEN (STR_DP_SECTION_BSPROFILE), NULL);
+  ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_SECTION_HEADER), mDpHiiHandle,
+              (StringPtr == NULL) ? StringPtrUnknown: StringPtr);
+  SHELL_FREE_NON_NULL (StringPtr);
+
+  Status = gBS->LocateProtocol (&gEdkiiBootServicesProfileProtocolGuid, NULL, (VOID **) &Profile);
+  if (!EFI_ERROR (Status)) {
+    Status = Profile->GetData (Profile, &ServiceCount, &Services, &CallerCount, &Callers);
+  }
+  if (EFI_ERROR (Status)) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_BSPROFILE_NOT_AVAILABLE), mDpHiiHandle);
+    SHELL_FREE_NON_NULL (StringPtrUnknown);
+    return;
+  }
+
+  ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_BSPROFILE_SECT_1), mDpHiiHandle);
+  ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_BSPROFILE_SECT_2), mDpHiiHandle);
+  ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_DASHES), mDpHiiHandle);
+  for (Index = 0; Index < ServiceCount; Index++) {
+    if (Services[Index].CallCount == 0) {
+      continue;
+    }
+    AvgDur = DivU64x64Remainder (Services[Index].Duration, Services[Index].CallCount, NULL);
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_BSPROFILE_STATS), mDpHiiHandle,
+                Services[Index].Name,
+                Services[Index].CallCount,
+                DurationInMicroSeconds (Services[Index].Duration),
+                DurationInMicroSeconds (AvgDur)
+                );
+  }
+
+  StringPtr = HiiGetString (mDpHiiHandle, STRING_TOKEN (STR_DP_SECTION_BSCALLERS), NULL);
+  ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_SECTION_HEADER), mDpHiiHandle,
+              (StringPtr == NULL) ? StringPtrUnknown: StringPtr);
+  SHELL_FREE_NON_NULL (StringPtr);
+
+  ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_BSCALLERS_SECT), mDpHiiHandle);
+  ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_DASHES), mDpHiiHandle);
+  PerformQuickSort (Callers, CallerCount, sizeof (EDKII_BOOT_SERVICE_PROFILE_CALLER), CompareBootServiceCallers);
+  for (Index = 0; Index < CallerCount; Index++) {
+    if (Limit != 0 && Index >= Limit) {
+      break;
+    }
+    if (Callers[Index].ImageHandle == NULL) {
+      StrCpyS (mGaugeString, DP_GAUGE_STRING_LENGTH + 1, (StringPtrUnknown == NULL) ? L"" : StringPtrUnknown);
+    } else {
+      DpGetNameFromHandle (Callers[Index].ImageHandle);
+    }
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_BSCALLERS_STATS), mDpHiiHandle,
+                mGaugeString,
+                (Callers[Index].ServiceIndex < ServiceCount) ? Services[Callers[Index].ServiceIndex].Name : "",
+                Callers[Index].CallCount,
+                DurationInMicroSeconds (Callers[Index].Duration)
+                );
+  }
+
+  FreePool (Services);
+  FreePool (Callers);
+  SHELL_FREE_NON_NULL (StringPtrUnknown);
+}
@@ -0,0 +1,156 @@
+/** @file
+  The implementation for Shell command httpcache based on the EDKII HTTP
+  Boot Image Cache protocol.
+
+  Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php.
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "UefiShellNetwork1CommandsLib.h"
+
+STATIC CONST SHELL_PARAM_ITEM    HttpCacheParamList[] = {
+  {
+    L"-c",
+    TypeFlag
+  },
+  {
+    NULL,
+    TypeMax
+  },
+};
+
+/**
+  Function for 'httpcache' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+
+  @retval SHELL_SUCCESS            The cached files were displayed or cleared.
+  @retval SHELL_INVALID_PARAMETER  A parameter was not valid.
+  @retval SHELL_NOT_FOUND          The HTTP boot image cache is not available.
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunHttpCache (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                            Status;
+  SHELL_STATUS                          ShellStatus;
+  LIST_ENTRY                            *ParamPackage;
+  CHAR16                                *ProblemParam;
+  EDKII_HTTP_BOOT_IMAGE_CACHE_PROTOCOL  *ImageCache;
+  EDKII_HTTP_BOOT_IMAGE_CACHE_ENTRY     *Entries;
+  EDKII_HTTP_BOOT_IMAGE_CACHE_ENTRY     *Entry;
+  UINTN                                 Count;
+  UINTN                                 Index;
+  UINT64                                UsedSize;
+  UINT64                                MaxSize;
+
+  ShellStatus  = SHELL_SUCCESS;
+  ProblemParam = NULL;
+
+  Status = ShellCommandLineParse (HttpCacheParamList, &ParamPackage, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if ((Status == EFI_VOLUME_CORRUPTED) && (ProblemParam != NULL)) {
+      ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_PROBLEM), gShellNetwork1HiiHandle, L"httpcache", ProblemParam);
+      FreePool (ProblemParam);
+    }
+
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  if (ShellCommandLineGetCount (ParamPackage) > 1) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_TOO_MANY), gShellNetwork1HiiHandle, L"httpcache");
+    ShellStatus = SHELL_INVALID_PARAMETER;
+    goto ON_EXIT;
+  }
+
+  Status = gBS->LocateProtocol (&gEdkiiHttpBootImageCacheProtocolGuid, NULL, (VOID **) &ImageCache);
+  if (EFI_ERROR (Status)) {
+    ShellPrintHiiEx (
+      -1,
+      -1,
+      NULL,
+      STRING_TOKEN (STR_GEN_PROTOCOL_NF),
+      gShellNetwork1HiiHandle,
+      L"httpcache",
+      L"EdkiiHttpBootImageCache",
+      &gEdkiiHttpBootImageCacheProtocolGuid
+      );
+    ShellStatus = SHELL_NOT_FOUND;
+    goto ON_EXIT;
+  }
+
+  if (ShellCommandLineGetFlag (ParamPackage, L"-c")) {
+    Status = ImageCache->Remove (ImageCache, NULL);
+    if (EFI_ERROR (Status)) {
+      ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_ERR_UK), gShellNetwork1HiiHandle, L"httpcache", Status);
+      ShellStatus = SHELL_DEVICE_ERROR;
+    }
+    goto ON_EXIT;
+  }
+
+  Status = ImageCache->GetEntries (ImageCache, &Count, &Entries, &UsedSize, &MaxSize);
+  if (Status == EFI_NOT_FOUND) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_HTTPCACHE_NONE), gShellNetwork1HiiHandle, L"httpcache");
+    goto ON_EXIT;
+  }
+
+  if (EFI_ERROR (Status)) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_ERR_UK), gShellNetwork1HiiHandle, L"httpcache", Status);
+    ShellStatus = SHELL_DEVICE_ERROR;
+    goto ON_EXIT;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Entry = &Entries[Index];
+
+    ShellPrintHiiEx (
+      -1,
+      -1,
+      NULL,
+      STRING_TOKEN (STR_HTTPCACHE_ENTRY),
+      gShellNetwork1HiiHandle,
+      Entry->Uri
+      );
+    ShellPrintHiiEx (
+      -1,
+      -1,
+      NULL,
+      STRING_TOKEN (STR_HTTPCACHE_DETAIL),
+      gShellNetwork1HiiHandle,
+      Entry->Size,
+      Entry->Hits,
+      Entry->Crc32,
+      Entry->ETag,
+      Entry->LastModified
+      );
+  }
+
+  ShellPrintHiiEx (
+    -1,
+    -1,
+    NULL,
+    STRING_TOKEN (STR_HTTPCACHE_USAGE),
+    gShellNetwork1HiiHandle,
+    Count,
+    UsedSize,
+    MaxSize
+    );
+
+  FreePool (Entries);
+
+ON_EXIT:
+  ShellCommandLineFreeVarList (ParamPackage);
+  return ShellStatus;
+}
@@ -0,0 +1,214 @@
+/** @file
+  The implementation for Shell command tcpstat based on the EDKII TCP
+  Statistics protocol.
+
+  Copyright (c) 2018, The EDK II Contributors. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php.
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "UefiShellNetwork1CommandsLib.h"
+
+//
+// IPv6 address, brackets and port.
+//
+#define TCPSTAT_ENDPOINT_SIZE  64
+
+CHAR16 *mTcpStatStateName[] = {
+  L"CLOSED",
+  L"LISTEN",
+  L"SYN_SENT",
+  L"SYN_RCVD",
+  L"ESTABLISHED",
+  L"FIN_WAIT_1",
+  L"FIN_WAIT_2",
+  L"CLOSING",
+  L"TIME_WAIT",
+  L"CLOSE_WAIT",
+  L"LAST_ACK"
+};
+
+/**
+  Format an endpoint of a TCP connection as Address:Port.
+
+  @param[in]   IpVersion   IP_VERSION_4 or IP_VERSION_6.
+  @param[in]   Address     The IP address of the endpoint.
+  @param[in]   Port        The port of the endpoint.
+  @param[out]  String      The formatted endpoint, TCPSTAT_ENDPOINT_SIZE characters.
+
+**/
+VOID
+TcpStatFormatEndPoint (
+  IN  UINT8           IpVersion,
+  IN  EFI_IP_ADDRESS  *Address,
+  IN  UINT16          Port,
+  OUT CHAR16          *String
+  )
+{
+  CHAR16  Ip6Str[TCPSTAT_ENDPOINT_SIZE];
+
+  if (IpVersion == IP_VERSION_4) {
+    UnicodeSPrint (
+      String,
+      TCPSTAT_ENDPOINT_SIZE * sizeof (CHAR16),
+      L"%d.%d.%d.%d:%d",
+      Address->v4.Addr[0],
+      Address->v4.Addr[1],
+      Address->v4.Addr[2],
+      Address->v4.Addr[3],
+      Port
+      );
+  } else {
+    if (EFI_ERROR (NetLibIp6ToStr (&Address->v6, Ip6Str, sizeof (Ip6Str)))) {
+      StrCpyS (Ip6Str, TCPSTAT_ENDPOINT_SIZE, L"?");
+    }
+
+    UnicodeSPrint (
+      String,
+      TCPSTAT_ENDPOINT_SIZE * sizeof (CHAR16),
+      L"[%s]:%d",
+      Ip6Str,
+      Port
+      );
+  }
+}
+
+/**
+  Function for 'tcpstat' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+
+  @retval SHELL_SUCCESS            The statistics were displayed.
+  @retval SHELL_INVALID_PARAMETER  A parameter was not valid.
+  @retval SHELL_NOT_FOUND          The TCP statistics are not available.
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunTcpStat (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                       Status;
+  SHELL_STATUS                     ShellStatus;
+  LIST_ENTRY                       *ParamPackage;
+  CHAR16                           *ProblemParam;
+  EDKII_TCP_STATISTICS_PROTOCOL    *TcpStatistics;
+  EDKII_TCP_CONNECTION_STATISTICS  *Connections;
+  EDKII_TCP_CONNECTION_STATISTICS  *Conn;
+  UINTN                            Count;
+  UINTN                            Index;
+  CHAR16                           Local[TCPSTAT_ENDPOINT_SIZE];
+  CHAR16                           Remote[TCPSTAT_ENDPOINT_SIZE];
+  CHAR16                           *State;
+
+  ShellStatus  = SHELL_SUCCESS;
+  ProblemParam = NULL;
+
+  Status = ShellCommandLineParse (EmptyParamList, &ParamPackage, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if ((Status == EFI_VOLUME_CORRUPTED) && (ProblemParam != NULL)) {
+      ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_PROBLEM), gShellNetwork1HiiHandle, L"tcpstat", ProblemParam);
+      FreePool (ProblemParam);
+    }
+
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  if (ShellCommandLineGetCount (ParamPackage) > 1) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_TOO_MANY), gShellNetwork1HiiHandle, L"tcpstat");
+    ShellStatus = SHELL_INVALID_PARAMETER;
+    goto ON_EXIT;
+  }
+
+  Status = gBS->LocateProtocol (&gEdkiiTcpStatisticsProtocolGuid, NULL, (VOID **) &TcpStatistics);
+  if (EFI_ERROR (Status)) {
+    ShellPrintHiiEx (
+      -1,
+      -1,
+      NULL,
+      STRING_TOKEN (STR_GEN_PROTOCOL_NF),
+      gShellNetwork1HiiHandle,
+      L"tcpstat",
+      L"EdkiiTcpStatistics",
+      &gEdkiiTcpStatisticsProtocolGuid
+      );
+    ShellStatus = SHELL_NOT_FOUND;
+    goto ON_EXIT;
+  }
+
+  Status = TcpStatistics->GetConnections (TcpStatistics, &Count, &Connections);
+  if (Status == EFI_NOT_FOUND) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_TCPSTAT_NONE), gShellNetwork1HiiHandle, L"tcpstat");
+    goto ON_EXIT;
+  }
+
+  if (EFI_ERROR (Status)) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_ERR_UK), gShellNetwork1HiiHandle, L"tcpstat", Status);
+    ShellStatus = SHELL_DEVICE_ERROR;
+    goto ON_EXIT;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Conn = &Connections[Index];
+
+    TcpStatFormatEndPoint (Conn->IpVersion, &Conn->LocalAddress, Conn->LocalPort, Local);
+    TcpStatFormatEndPoint (Conn->IpVersion, &Conn->RemoteAddress, Conn->RemotePort, Remote);
+
+    if (Conn->State < ARRAY_SIZE (mTcpStatStateName)) {
+      State = mTcpStatStateName[Conn->State];
+    } else {
+      State = L"?";
+    }
+
+    ShellPrintHiiEx (
+      -1,
+      -1,
+      NULL,
+      STRING_TOKEN (STR_TCPSTAT_CONNECTION),
+      gShellNetwork1HiiHandle,
+      Local,
+      Remote,
+      State,
+      Conn->CongestionControl
+      );
+    ShellPrintHiiEx (
+      -1,
+      -1,
+      NULL,
+      STRING_TOKEN (STR_TCPSTAT_WINDOW),
+      gShellNetwork1HiiHandle,
+      Conn->CongestionWindow,
+      Conn->SlowStartThreshold,
+      Conn->SendWindow,
+      Conn->ReceiveWindow,
+      Conn->Mss
+      );
+    ShellPrintHiiEx (
+      -1,
+      -1,
+      NULL,
+      STRING_TOKEN (STR_TCPSTAT_RTT),
+      gShellNetwork1HiiHandle,
+      Conn->SmoothedRtt,
+      Conn->Rto,
+      Conn->Retransmits,
+      Conn->FastRetransmits,
+      Conn->Timeouts
+      );
+  }
+
+  FreePool (Connections);
+
+ON_EXIT:
+  ShellCommandLineFreeVarList (ParamPackage);
+  return ShellStatus;
+}
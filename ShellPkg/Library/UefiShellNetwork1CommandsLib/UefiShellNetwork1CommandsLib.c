@@ -66,6 +66,8 @@ ShellNetwork1CommandsLibConstructor (
   //
   ShellCommandRegisterCommandName(L"ping",    ShellCommandRunPing     , ShellCommandGetManFileNameNetwork1, 0, L"network1", TRUE , gShellNetwork1HiiHandle, STRING_TOKEN(STR_GET_HELP_PING));
   ShellCommandRegisterCommandName(L"ifconfig",ShellCommandRunIfconfig , ShellCommandGetManFileNameNetwork1, 0, L"network1", TRUE , gShellNetwork1HiiHandle, STRING_TOKEN(STR_GET_HELP_IFCONFIG));
+  ShellCommandRegisterCommandName(L"tcpstat", ShellCommandRunTcpStat  , ShellCommandGetManFileNameNetwork1, 0, L"network1", TRUE , gShellNetwork1HiiHandle, STRING_TOKEN(STR_GET_HELP_TCPSTAT));
+  ShellCommandRegisterCommandName(L"httpcache", ShellCommandRunHttpCache, ShellCommandGetManFileNameNetwork1, 0, L"network1", TRUE , gShellNetwork1HiiHandle, STRING_TOKEN(STR_GET_HELP_HTTPCACHE));
 
   return (EFI_SUCCESS);
 }
@@ -27,6 +27,9 @@
 #include <Protocol/Ip4.h>
 #include <Protocol/Ip4Config2.h>
 #include <Protocol/Arp.h>
+#include <Protocol/Tcp4.h>
+#include <Protocol/TcpStatistics.h>
+#include <Protocol/HttpBootImageCache.h>
 
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -72,5 +75,31 @@ ShellCommandRunIfconfig (
   IN EFI_SYSTEM_TABLE  *SystemTable
   );
 
+/**
+  Function for 'tcpstat' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunTcpStat (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
+/**
+  Function for 'httpcache' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunHttpCache (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
 #endif
 
@@ -906,10 +906,41 @@ Pp2SnpGetStatus (
   ReturnUnlock(SavedTpl, EFI_SUCCESS);
 }
 
+STATIC
 EFI_STATUS
-EFIAPI
-Pp2SnpTransmit (
-  IN EFI_SIMPLE_NETWORK_PROTOCOL *This,
+Pp2DxeTxStateCheck (
+  IN PP2DXE_CONTEXT *Pp2Context
+  )
+{
+  EFI_SIMPLE_NETWORK_PROTOCOL *This = &Pp2Context->Snp;
+
+  /* Check that driver was started and initialised */
+  switch (This->Mode->State) {
+  case EfiSimpleNetworkInitialized:
+    break;
+  case EfiSimpleNetworkStopped:
+    DEBUG((DEBUG_WARN, "Pp2Dxe%d: not started\n", Pp2Context->Instance));
+    return EFI_NOT_STARTED;
+  case EfiSimpleNetworkStarted:
+  /* Fall through */
+  default:
+    DEBUG((DEBUG_ERROR, "Pp2Dxe%d: wrong state\n", Pp2Context->Instance));
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (!This->Mode->MediaPresent) {
+    DEBUG((DEBUG_ERROR, "Pp2Dxe: link not ready\n"));
+    return EFI_NOT_READY;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/* Fill in the media header if needed and queue the packet in the aggregated Txq */
+STATIC
+VOID
+Pp2DxeTxDescFill (
+  IN PP2DXE_CONTEXT              *Pp2Context,
   IN UINTN                       HeaderSize,
   IN UINTN                       BufferSize,
   IN VOID                        *Buffer,
@@ -918,62 +949,20 @@ Pp2SnpTransmit (
   IN UINT16                      *EtherTypePtr OPTIONAL
   )
 {
-  PP2DXE_CONTEXT *Pp2Context = INSTANCE_FROM_SNP(This);
+  EFI_SIMPLE_NETWORK_PROTOCOL *This = &Pp2Context->Snp;
   PP2DXE_PORT *Port = &Pp2Context->Port;
   MVPP2_SHARED *Mvpp2Shared = Pp2Context->Port.Priv;
   MVPP2_TX_QUEUE *AggrTxq = Mvpp2Shared->AggrTxqs;
   MVPP2_TX_DESC *TxDesc;
-  EFI_STATUS Status;
-  INTN PollingCount;
-  INTN TxSent;
   UINT8 *DataPtr = Buffer;
   UINT16 EtherType;
-  UINT32 State = This->Mode->State;
-  EFI_TPL SavedTpl;
-
-  if (This == NULL || Buffer == NULL) {
-    DEBUG((DEBUG_ERROR, "Pp2Dxe: NULL Snp or Buffer\n"));
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (HeaderSize != 0) {
-    ASSERT (HeaderSize == This->Mode->MediaHeaderSize);
-    ASSERT (EtherTypePtr != NULL);
-    ASSERT (DestAddr != NULL);
-  }
-
-  SavedTpl = gBS->RaiseTPL (TPL_CALLBACK);
-
-  /* Check that driver was started and initialised */
-  if (State != EfiSimpleNetworkInitialized) {
-    switch (State) {
-    case EfiSimpleNetworkStopped:
-      DEBUG((DEBUG_WARN, "Pp2Dxe%d: not started\n", Pp2Context->Instance));
-      ReturnUnlock (SavedTpl, EFI_NOT_STARTED);
-    case EfiSimpleNetworkStarted:
-    /* Fall through */
-    default:
-      DEBUG((DEBUG_ERROR, "Pp2Dxe%d: wrong state\n", Pp2Context->Instance));
-      ReturnUnlock (SavedTpl, EFI_DEVICE_ERROR);
-    }
-  }
-
-  if (!This->Mode->MediaPresent) {
-    DEBUG((DEBUG_ERROR, "Pp2Dxe: link not ready\n"));
-    ReturnUnlock(SavedTpl, EFI_NOT_READY);
-  }
-
-  EtherType = HTONS (*EtherTypePtr);
 
   /* Fetch next descriptor */
   TxDesc = Mvpp2TxqNextDescGet(AggrTxq);
 
-  if (!TxDesc) {
-    DEBUG((DEBUG_ERROR, "No tx descriptor to use\n"));
-    ReturnUnlock(SavedTpl, EFI_OUT_OF_RESOURCES);
-  }
-
   if (HeaderSize != 0) {
+    EtherType = HTONS (*EtherTypePtr);
+
     CopyMem(DataPtr, DestAddr, NET_ETHER_ADDR_LEN);
 
     if (SrcAddr != NULL)
@@ -993,13 +982,27 @@ Pp2SnpTransmit (
   TxDesc->PhysTxq = Mvpp2TxqPhys(Port->Id, 0);
 
   InvalidateDataCacheRange (DataPtr, BufferSize);
+}
+
+/* Issue send of the Count queued descriptors and wait until HW sent them */
+STATIC
+EFI_STATUS
+Pp2DxeTxSend (
+  IN PP2DXE_CONTEXT *Pp2Context,
+  IN INTN           Count
+  )
+{
+  PP2DXE_PORT *Port = &Pp2Context->Port;
+  MVPP2_SHARED *Mvpp2Shared = Pp2Context->Port.Priv;
+  INTN PollingCount;
+  INTN TxSent;
 
   /* Issue send */
-  Mvpp2AggrTxqPendDescAdd(Port, 1);
+  Mvpp2AggrTxqPendDescAdd(Port, Count);
 
   /*
    * Egress processing:
-   * Wait until packet is passed from per-cpu aggregated queue
+   * Wait until packets are passed from per-cpu aggregated queue
    * to physical per-port TXQ.
    */
   PollingCount = 0;
@@ -1007,20 +1010,66 @@ Pp2SnpTransmit (
   do {
     if (PollingCount++ > MVPP2_TX_SEND_MAX_POLLING_COUNT) {
       DEBUG((DEBUG_ERROR, "Pp2Dxe: transmit polling failed\n"));
-      ReturnUnlock(SavedTpl, EFI_TIMEOUT);
+      return EFI_TIMEOUT;
     }
     TxSent = Mvpp2AggrTxqPendDescNumGet(Mvpp2Shared, 0);
   } while (TxSent);
 
-  /* Wait for packet to be transmitted by hardware. */
+  /* Wait for packets to be transmitted by hardware. */
   PollingCount = 0;
   TxSent = Mvpp2TxqSentDescProc(Port, &Port->Txqs[0]);
-  while (!TxSent) {
+  while (TxSent < Count) {
     if (PollingCount++ > MVPP2_TX_SEND_MAX_POLLING_COUNT) {
       DEBUG((DEBUG_ERROR, "Pp2Dxe: transmit polling failed\n"));
-      ReturnUnlock(SavedTpl, EFI_TIMEOUT);
+      return EFI_TIMEOUT;
     }
-    TxSent = Mvpp2TxqSentDescProc(Port, &Port->Txqs[0]);
+    TxSent += Mvpp2TxqSentDescProc(Port, &Port->Txqs[0]);
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+Pp2SnpTransmit (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL *This,
+  IN UINTN                       HeaderSize,
+  IN UINTN                       BufferSize,
+  IN VOID                        *Buffer,
+  IN EFI_MAC_ADDRESS             *SrcAddr  OPTIONAL,
+  IN EFI_MAC_ADDRESS             *DestAddr OPTIONAL,
+  IN UINT16                      *EtherTypePtr OPTIONAL
+  )
+{
+  PP2DXE_CONTEXT *Pp2Context;
+  EFI_STATUS Status;
+  EFI_TPL SavedTpl;
+
+  if (This == NULL || Buffer == NULL) {
+    DEBUG((DEBUG_ERROR, "Pp2Dxe: NULL Snp or Buffer\n"));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Pp2Context = INSTANCE_FROM_SNP(This);
+
+  if (HeaderSize != 0) {
+    ASSERT (HeaderSize == This->Mode->MediaHeaderSize);
+    ASSERT (EtherTypePtr != NULL);
+    ASSERT (DestAddr != NULL);
+  }
+
+  SavedTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  Status = Pp2DxeTxStateCheck (Pp2Context);
+  if (EFI_ERROR (Status)) {
+    ReturnUnlock (SavedTpl, Status);
+  }
+
+  Pp2DxeTxDescFill (Pp2Context, HeaderSize, BufferSize, Buffer, SrcAddr, DestAddr, EtherTypePtr);
+
+  Status = Pp2DxeTxSend (Pp2Context, 1);
+  if (EFI_ERROR (Status)) {
+    ReturnUnlock (SavedTpl, Status);
   }
 
   /*
@@ -1031,6 +1080,101 @@ Pp2SnpTransmit (
   ReturnUnlock (SavedTpl, Status);
 }
 
+EFI_STATUS
+EFIAPI
+Pp2SnpTransmitBatch (
+  IN     EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL *This,
+  IN OUT UINTN                                        *PacketCount,
+  IN     EDKII_SIMPLE_NETWORK_TRANSMIT_PACKET         *Packets
+  )
+{
+  PP2DXE_CONTEXT *Pp2Context;
+  EFI_STATUS Status;
+  EFI_TPL SavedTpl;
+  UINTN Count;
+  UINTN Done;
+  UINTN Chunk;
+  UINTN Free;
+  UINTN Index;
+
+  if (This == NULL || PacketCount == NULL || (Packets == NULL && *PacketCount != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Pp2Context = INSTANCE_FROM_BATCH_TX(This);
+  Count = *PacketCount;
+  *PacketCount = 0;
+
+  for (Index = 0; Index < Count; Index++) {
+    if (Packets[Index].Buffer == NULL) {
+      return EFI_INVALID_PARAMETER;
+    }
+    if (Packets[Index].HeaderSize != 0 &&
+        (Packets[Index].HeaderSize != Pp2Context->Snp.Mode->MediaHeaderSize ||
+         Packets[Index].DestAddr == NULL || Packets[Index].Protocol == NULL)) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  SavedTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  Status = Pp2DxeTxStateCheck (Pp2Context);
+  if (EFI_ERROR (Status)) {
+    ReturnUnlock (SavedTpl, Status);
+  }
+
+  /*
+   * Hand the packets to HW in chunks, so that the cost of kicking the
+   * aggregated Txq and of waiting for HW is shared by the whole chunk.
+   * A chunk is limited by the room left in the completion queue, as the
+   * buffers can only be returned by GetStatus from there.
+   */
+  Done = 0;
+  while (Done < Count) {
+    Free = (Pp2Context->CompletionQueueHead + QUEUE_DEPTH - 1 -
+            Pp2Context->CompletionQueueTail) % QUEUE_DEPTH;
+    Chunk = MIN (Count - Done, MIN (Free, MVPP2_TX_BATCH_MAX));
+    if (Chunk == 0) {
+      Status = EFI_NOT_READY;
+      break;
+    }
+
+    for (Index = Done; Index < Done + Chunk; Index++) {
+      Pp2DxeTxDescFill (
+        Pp2Context,
+        Packets[Index].HeaderSize,
+        Packets[Index].BufferSize,
+        Packets[Index].Buffer,
+        Packets[Index].SrcAddr,
+        Packets[Index].DestAddr,
+        Packets[Index].Protocol
+        );
+    }
+
+    Status = Pp2DxeTxSend (Pp2Context, Chunk);
+    if (EFI_ERROR (Status)) {
+      /*
+       * The chunk was posted to HW, so it is reported as handed over. As in
+       * Transmit, its buffers are not put on the completion queue, since
+       * HW may still be using them.
+       */
+      *PacketCount = Done + Chunk;
+      Status = EFI_DEVICE_ERROR;
+      break;
+    }
+
+    for (Index = Done; Index < Done + Chunk; Index++) {
+      Status = QueueInsert (Pp2Context, Packets[Index].Buffer);
+      ASSERT_EFI_ERROR (Status);
+    }
+
+    Done += Chunk;
+    *PacketCount = Done;
+  }
+
+  ReturnUnlock (SavedTpl, Status);
+}
+
 EFI_STATUS
 EFIAPI
 Pp2SnpReceive (
@@ -1173,6 +1317,8 @@ Pp2DxeSnpInstall (
 
   /* Copy SNP data from templates */
   CopyMem (&Pp2Context->Snp, &Pp2SnpTemplate, sizeof (EFI_SIMPLE_NETWORK_PROTOCOL));
+  Pp2Context->BatchTx.Revision = EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL_REVISION;
+  Pp2Context->BatchTx.TransmitBatch = Pp2SnpTransmitBatch;
   CopyMem (SnpMode, &Pp2SnpModeTemplate, sizeof (EFI_SIMPLE_NETWORK_MODE));
 
   /*
@@ -1217,6 +1363,7 @@ Pp2DxeSnpInstall (
   Status = gBS->InstallMultipleProtocolInterfaces (
       &Handle,
       &gEfiSimpleNetworkProtocolGuid, &Pp2Context->Snp,
+      &gEdkiiSimpleNetworkBatchTransmitProtocolGuid, &Pp2Context->BatchTx,
       &gEfiDevicePathProtocolGuid, Pp2DevicePath,
       NULL
       );
@@ -42,6 +42,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Protocol/Ip6.h>
 #include <Protocol/MvPhy.h>
 #include <Protocol/SimpleNetwork.h>
+#include <Protocol/SimpleNetworkBatchTransmit.h>
 
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -60,6 +61,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define PP2DXE_SIGNATURE                    SIGNATURE_32('P', 'P', '2', 'D')
 #define INSTANCE_FROM_SNP(a)                CR((a), PP2DXE_CONTEXT, Snp, PP2DXE_SIGNATURE)
+#define INSTANCE_FROM_BATCH_TX(a)           CR((a), PP2DXE_CONTEXT, BatchTx, PP2DXE_SIGNATURE)
 
 /* OS API */
 #define Mvpp2Alloc(v)                       AllocateZeroPool(v)
@@ -173,6 +175,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #define MVPP2_TX_SEND_MAX_POLLING_COUNT   10000
 
+/*
+ * Maximum number of packets handed to HW at once by TransmitBatch.
+ * Must not exceed the size of the physical Txq.
+ */
+#define MVPP2_TX_BATCH_MAX                16
+
 /* Structures */
 typedef struct {
   /* Physical number of this Tx queue */
@@ -355,6 +363,7 @@ typedef struct {
   EFI_HANDLE                  Controller;
   EFI_LOCK                    Lock;
   EFI_SIMPLE_NETWORK_PROTOCOL Snp;
+  EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL BatchTx;
   MARVELL_PHY_PROTOCOL        *Phy;
   PHY_DEVICE                  *PhyDev;
   PP2DXE_PORT                 Port;
@@ -609,6 +618,14 @@ Pp2SnpTransmit (
   IN UINT16                      *EtherTypePtr OPTIONAL
   );
 
+EFI_STATUS
+EFIAPI
+Pp2SnpTransmitBatch (
+  IN     EDKII_SIMPLE_NETWORK_BATCH_TRANSMIT_PROTOCOL *This,
+  IN OUT UINTN                                        *PacketCount,
+  IN     EDKII_SIMPLE_NETWORK_TRANSMIT_PACKET         *Packets
+  );
+
 EFI_STATUS
 EFIAPI
 Pp2SnpReceive (